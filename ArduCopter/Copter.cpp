@@ -231,7 +231,8 @@ void Copter::fast_loop()
     // update INS immediately to get current gyro data populated
     ins.update();
 
-    // run low level rate controllers that only require IMU data
+    // run low level rate controllers that only require IMU data, or
+    // take the latest outputs of the fast rate thread's rate PIDs
     attitude_control->rate_controller_run();
 
     // send outputs to the motors library immediately
@@ -255,6 +256,13 @@ void Copter::fast_loop()
     // run the attitude controllers
     update_flight_mode();
 
+#if FAST_RATE_THREAD_ENABLED
+    if (rate_thread_active) {
+        // hand the new rate targets to the fast rate thread
+        attitude_control->publish_rate_targets();
+    }
+#endif
+
     // update home from EKF if necessary
     update_home_from_EKF();
 
@@ -323,7 +331,7 @@ void Copter::update_batt_compass(void)
 // should be run at 400hz
 void Copter::fourhundred_hz_logging()
 {
-    if (should_log(MASK_LOG_ATTITUDE_FAST)) {
+    if (should_log(MASK_LOG_ATTITUDE_FAST) || flightmode->logs_attitude()) {
         Log_Write_Attitude();
     }
 }
@@ -333,7 +341,7 @@ void Copter::fourhundred_hz_logging()
 void Copter::ten_hz_logging_loop()
 {
     // log attitude data if we're not already logging at the higher rate
-    if (should_log(MASK_LOG_ATTITUDE_MED) && !should_log(MASK_LOG_ATTITUDE_FAST)) {
+    if (should_log(MASK_LOG_ATTITUDE_MED) && !should_log(MASK_LOG_ATTITUDE_FAST) && !flightmode->logs_attitude()) {
         Log_Write_Attitude();
         Log_Write_EKF_POS();
     }
@@ -367,6 +375,11 @@ void Copter::ten_hz_logging_loop()
 #if FRAME_CONFIG == HELI_FRAME
     Log_Write_Heli();
 #endif
+#if FAST_RATE_THREAD_ENABLED
+    if (rate_thread_active) {
+        Log_Write_Rate_Thread();
+    }
+#endif
 }
 
 // twentyfive_hz_logging - should be run at 25hz
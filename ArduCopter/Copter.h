@@ -226,6 +226,7 @@ public:
     friend class ModeFlip;
     friend class ModeFlowHold;
     friend class ModeFollow;
+    friend class ModeSystemId;
     friend class ModeGuided;
     friend class ModeLand;
     friend class ModeLoiter;
@@ -494,6 +495,11 @@ private:
     // arm_time_ms - Records when vehicle was armed. Will be Zero if we are disarmed.
     uint32_t arm_time_ms;
 
+#if FAST_RATE_THREAD_ENABLED
+    // true once the rate PIDs are run by the fast rate thread instead of the main loop
+    bool rate_thread_active;
+#endif
+
     // Used to exit the roll and pitch auto trim function
     uint8_t auto_trim_counter;
 
@@ -773,6 +779,9 @@ private:
 #endif
     void Log_Write_Precland();
     void Log_Write_GuidedTarget(uint8_t target_type, const Vector3f& pos_target, const Vector3f& vel_target);
+    void Log_Write_SysID_Setup(uint8_t sweep, uint8_t systemID_axis, float waveform_magnitude, float frequency_start, float frequency_stop, float time_fade_in, float time_const_freq, float time_record, float time_fade_out);
+    void Log_Write_SysID_Data(float waveform_time, float waveform_freq, float waveform_sample, const Vector3f &gyro, const Vector3f &accel);
+    void Log_Write_Rate_Thread();
     void Log_Write_Vehicle_Startup_Messages();
     void log_init(void);
 
@@ -812,6 +821,12 @@ private:
     void init_precland();
     void update_precland();
 
+#if FAST_RATE_THREAD_ENABLED
+    // rate_thread.cpp
+    void rate_thread_init();
+    void rate_controller_thread();
+#endif
+
     // radio.cpp
     void default_dead_zones();
     void init_rc_in();
@@ -957,6 +972,9 @@ private:
 #if MODE_ZIGZAG_ENABLED == ENABLED
     ModeZigZag mode_zigzag;
 #endif
+#if MODE_SYSTEMID_ENABLED == ENABLED
+    ModeSystemId mode_systemid;
+#endif
 
     // mode.cpp
     Mode *mode_from_mode_num(const uint8_t mode);
@@ -200,38 +200,43 @@ void GCS_MAVLINK_Copter::send_pid_tuning()
         if (!HAVE_PAYLOAD_SPACE(chan, PID_TUNING)) {
             return;
         }
-        const AP_Logger::PID_Info *pid_info = nullptr;
+        // the rate PID info is copied as the fast rate thread may be updating it
+        AP_Logger::PID_Info pid_info;
         float achieved;
         switch (axes[i]) {
-        case PID_TUNING_ROLL:
-            pid_info = &copter.attitude_control->get_rate_roll_pid().get_pid_info();
+        case PID_TUNING_ROLL: {
+            WITH_SEMAPHORE(copter.attitude_control->get_rate_pid_semaphore());
+            pid_info = copter.attitude_control->get_rate_roll_pid().get_pid_info();
             achieved = degrees(gyro.x);
             break;
-        case PID_TUNING_PITCH:
-            pid_info = &copter.attitude_control->get_rate_pitch_pid().get_pid_info();
+        }
+        case PID_TUNING_PITCH: {
+            WITH_SEMAPHORE(copter.attitude_control->get_rate_pid_semaphore());
+            pid_info = copter.attitude_control->get_rate_pitch_pid().get_pid_info();
             achieved = degrees(gyro.y);
             break;
-        case PID_TUNING_YAW:
-            pid_info = &copter.attitude_control->get_rate_yaw_pid().get_pid_info();
+        }
+        case PID_TUNING_YAW: {
+            WITH_SEMAPHORE(copter.attitude_control->get_rate_pid_semaphore());
+            pid_info = copter.attitude_control->get_rate_yaw_pid().get_pid_info();
             achieved = degrees(gyro.z);
             break;
+        }
         case PID_TUNING_ACCZ:
-            pid_info = &copter.pos_control->get_accel_z_pid().get_pid_info();
+            pid_info = copter.pos_control->get_accel_z_pid().get_pid_info();
             achieved = -(AP::ahrs().get_accel_ef_blended().z + GRAVITY_MSS);
             break;
         default:
             continue;
         }
-        if (pid_info != nullptr) {
-            mavlink_msg_pid_tuning_send(chan,
-                                        axes[i],
-                                        pid_info->target*0.01f,
-                                        achieved,
-                                        pid_info->FF*0.01f,
-                                        pid_info->P*0.01f,
-                                        pid_info->I*0.01f,
-                                        pid_info->D*0.01f);
-        }
+        mavlink_msg_pid_tuning_send(chan,
+                                    axes[i],
+                                    pid_info.target*0.01f,
+                                    achieved,
+                                    pid_info.FF*0.01f,
+                                    pid_info.P*0.01f,
+                                    pid_info.I*0.01f,
+                                    pid_info.D*0.01f);
     }
 }
 
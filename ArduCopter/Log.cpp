@@ -66,9 +66,17 @@ void Copter::Log_Write_Attitude()
     logger.Write_Attitude(ahrs, targets);
     logger.Write_Rate(ahrs_view, *motors, *attitude_control, *pos_control);
     if (should_log(MASK_LOG_PID)) {
-        logger.Write_PID(LOG_PIDR_MSG, attitude_control->get_rate_roll_pid().get_pid_info());
-        logger.Write_PID(LOG_PIDP_MSG, attitude_control->get_rate_pitch_pid().get_pid_info());
-        logger.Write_PID(LOG_PIDY_MSG, attitude_control->get_rate_yaw_pid().get_pid_info());
+        AP_Logger::PID_Info pid_roll, pid_pitch, pid_yaw;
+        {
+            // copy the rate PID info as the fast rate thread may be updating it
+            WITH_SEMAPHORE(attitude_control->get_rate_pid_semaphore());
+            pid_roll = attitude_control->get_rate_roll_pid().get_pid_info();
+            pid_pitch = attitude_control->get_rate_pitch_pid().get_pid_info();
+            pid_yaw = attitude_control->get_rate_yaw_pid().get_pid_info();
+        }
+        logger.Write_PID(LOG_PIDR_MSG, pid_roll);
+        logger.Write_PID(LOG_PIDP_MSG, pid_pitch);
+        logger.Write_PID(LOG_PIDY_MSG, pid_yaw);
         logger.Write_PID(LOG_PIDA_MSG, pos_control->get_accel_z_pid().get_pid_info() );
     }
 }
@@ -378,6 +386,98 @@ void Copter::Log_Write_GuidedTarget(uint8_t target_type, const Vector3f& pos_tar
     logger.WriteBlock(&pkt, sizeof(pkt));
 }
 
+// system identification settings logging
+struct PACKED log_SysIdS {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint8_t sweep;
+    uint8_t systemID_axis;
+    float waveform_magnitude;
+    float frequency_start;
+    float frequency_stop;
+    float time_fade_in;
+    float time_const_freq;
+    float time_record;
+    float time_fade_out;
+};
+
+// Write the settings of a system identification sweep
+void Copter::Log_Write_SysID_Setup(uint8_t sweep, uint8_t systemID_axis, float waveform_magnitude, float frequency_start, float frequency_stop, float time_fade_in, float time_const_freq, float time_record, float time_fade_out)
+{
+    struct log_SysIdS pkt = {
+        LOG_PACKET_HEADER_INIT(LOG_SYSIDS_MSG),
+        time_us         : AP_HAL::micros64(),
+        sweep           : sweep,
+        systemID_axis   : systemID_axis,
+        waveform_magnitude : waveform_magnitude,
+        frequency_start : frequency_start,
+        frequency_stop  : frequency_stop,
+        time_fade_in    : time_fade_in,
+        time_const_freq : time_const_freq,
+        time_record     : time_record,
+        time_fade_out   : time_fade_out
+    };
+    logger.WriteBlock(&pkt, sizeof(pkt));
+}
+
+// system identification data logging
+struct PACKED log_SysIdD {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    float waveform_time;
+    float waveform_sample;
+    float waveform_freq;
+    float gyro_x;
+    float gyro_y;
+    float gyro_z;
+    float accel_x;
+    float accel_y;
+    float accel_z;
+};
+
+// Write the injected system identification signal and the vehicle's response
+void Copter::Log_Write_SysID_Data(float waveform_time, float waveform_freq, float waveform_sample, const Vector3f &gyro, const Vector3f &accel)
+{
+    struct log_SysIdD pkt = {
+        LOG_PACKET_HEADER_INIT(LOG_SYSIDD_MSG),
+        time_us         : AP_HAL::micros64(),
+        waveform_time   : waveform_time,
+        waveform_sample : waveform_sample,
+        waveform_freq   : waveform_freq,
+        gyro_x          : degrees(gyro.x),
+        gyro_y          : degrees(gyro.y),
+        gyro_z          : degrees(gyro.z),
+        accel_x         : accel.x,
+        accel_y         : accel.y,
+        accel_z         : accel.z
+    };
+    logger.WriteBlock(&pkt, sizeof(pkt));
+}
+
+#if FAST_RATE_THREAD_ENABLED
+// fast rate thread logging
+struct PACKED log_RateThread {
+    LOG_PACKET_HEADER;
+    uint64_t time_us;
+    uint32_t latency_us;
+    uint32_t latency_max_us;
+};
+
+// Write the time from the fast rate thread's rate PID outputs being calculated to being sent to the motors
+void Copter::Log_Write_Rate_Thread()
+{
+    uint32_t latency_us, latency_max_us;
+    attitude_control->get_rate_thread_latency(latency_us, latency_max_us);
+    struct log_RateThread pkt = {
+        LOG_PACKET_HEADER_INIT(LOG_RATE_THREAD_MSG),
+        time_us         : AP_HAL::micros64(),
+        latency_us      : latency_us,
+        latency_max_us  : latency_max_us
+    };
+    logger.WriteBlock(&pkt, sizeof(pkt));
+}
+#endif
+
 // type and unit information can be found in
 // libraries/AP_Logger/Logstructure.h; search for "log_Units" for
 // units and "Format characters" for field type information
@@ -409,6 +509,14 @@ const struct LogStructure Copter::log_structure[] = {
 #endif
     { LOG_GUIDEDTARGET_MSG, sizeof(log_GuidedTarget),
       "GUID",  "QBffffff",    "TimeUS,Type,pX,pY,pZ,vX,vY,vZ", "s-mmmnnn", "F-000000" },
+    { LOG_SYSIDS_MSG, sizeof(log_SysIdS),
+      "SIDS",  "QBBfffffff",  "TimeUS,Sweep,Ax,Mag,FSt,FSp,TFin,TC,TR,TFout", "s---zzssss", "F---000000" },
+    { LOG_SYSIDD_MSG, sizeof(log_SysIdD),
+      "SIDD",  "Qfffffffff",  "TimeUS,Time,Targ,F,Gx,Gy,Gz,Ax,Ay,Az", "ss-zkkkooo", "F000000000" },
+#if FAST_RATE_THREAD_ENABLED
+    { LOG_RATE_THREAD_MSG, sizeof(log_RateThread),
+      "FSTR",  "QII",         "TimeUS,Lat,LatMax", "sss", "FFF" },
+#endif
 };
 
 void Copter::Log_Write_Vehicle_Startup_Messages()
@@ -443,6 +551,9 @@ void Copter::Log_Write_Parameter_Tuning(uint8_t param, float tuning_val, float t
 void Copter::Log_Sensor_Health() {}
 void Copter::Log_Write_Precland() {}
 void Copter::Log_Write_GuidedTarget(uint8_t target_type, const Vector3f& pos_target, const Vector3f& vel_target) {}
+void Copter::Log_Write_SysID_Setup(uint8_t sweep, uint8_t systemID_axis, float waveform_magnitude, float frequency_start, float frequency_stop, float time_fade_in, float time_const_freq, float time_record, float time_fade_out) {}
+void Copter::Log_Write_SysID_Data(float waveform_time, float waveform_freq, float waveform_sample, const Vector3f &gyro, const Vector3f &accel) {}
+void Copter::Log_Write_Rate_Thread() {}
 void Copter::Log_Write_Vehicle_Startup_Messages() {}
 
 #if FRAME_CONFIG == HELI_FRAME
@@ -601,6 +601,17 @@ public:
     // object avoidance path planning
     AP_OAPathPlanner oa;
 #endif
+
+#if FAST_RATE_THREAD_ENABLED
+    // fast rate thread
+    AP_Int8 fstrate_enable;
+    AP_Int8 fstrate_div;
+#endif
+
+#if MODE_SYSTEMID_ENABLED == ENABLED
+    // we need a pointer to the mode for the G2 table
+    void *mode_systemid_ptr;
+#endif
 };
 
 extern const AP_Param::Info        var_info[];
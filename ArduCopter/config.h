@@ -365,6 +365,12 @@
 # define MODE_ZIGZAG_ENABLED !HAL_MINIMIZE_FEATURES
 #endif
 
+//////////////////////////////////////////////////////////////////////////////
+// System ID - conduct system identification tests on vehicle
+#ifndef MODE_SYSTEMID_ENABLED
+# define MODE_SYSTEMID_ENABLED (!HAL_MINIMIZE_FEATURES && FRAME_CONFIG != HELI_FRAME)
+#endif
+
 //////////////////////////////////////////////////////////////////////////////
 // Beacon support - support for local positioning systems
 #ifndef BEACON_ENABLED
@@ -681,6 +687,16 @@
  #define AC_OAPATHPLANNER_ENABLED   !HAL_MINIMIZE_FEATURES
 #endif
 
+//////////////////////////////////////////////////////////////////////////////
+// Fast rate thread - runs the rate controllers in their own thread on each gyro sample
+#ifndef FAST_RATE_THREAD_ENABLED
+ # define FAST_RATE_THREAD_ENABLED (FRAME_CONFIG != HELI_FRAME && (CONFIG_HAL_BOARD == HAL_BOARD_LINUX || CONFIG_HAL_BOARD == HAL_BOARD_SITL))
+#endif
+
+#if FAST_RATE_THREAD_ENABLED && FRAME_CONFIG == HELI_FRAME
+  #error The fast rate thread is not supported on traditional helicopters
+#endif
+
 #if AC_AVOID_ENABLED && !PROXIMITY_ENABLED
   #error AC_Avoidance relies on PROXIMITY_ENABLED which is disabled
 #endif
@@ -159,6 +159,12 @@ Mode *Copter::mode_from_mode_num(const uint8_t mode)
             break;
 #endif
 
+#if MODE_SYSTEMID_ENABLED == ENABLED
+        case SYSTEMID:
+            ret = (Mode *)g2.mode_systemid_ptr;
+            break;
+#endif
+
         default:
             break;
     }
@@ -286,6 +292,12 @@ void Copter::exit_mode(Mode *&old_flightmode,
     }
 #endif
 
+#if MODE_SYSTEMID_ENABLED == ENABLED
+    if (old_flightmode == &mode_systemid) {
+        mode_systemid.exit();
+    }
+#endif
+
     // stop mission when we leave auto mode
 #if MODE_AUTO_ENABLED == ENABLED
     if (old_flightmode == &mode_auto) {
@@ -33,6 +33,9 @@ public:
     virtual bool is_taking_off() const;
     static void takeoff_stop() { takeoff.stop(); }
 
+    // true if the mode needs the attitude and rate controllers logged at the main loop rate
+    virtual bool logs_attitude() const { return false; }
+
     virtual bool landing_gear_should_be_deployed() const { return false; }
     virtual bool is_landing() const { return false; }
 
@@ -1294,3 +1297,78 @@ private:
 
     uint32_t reach_wp_time_ms = 0;  // time since vehicle reached destination (or zero if not yet reached)
 };
+
+#if MODE_SYSTEMID_ENABLED == ENABLED
+class ModeSystemId : public Mode {
+
+public:
+    // need a constructor for parameters
+    ModeSystemId(void);
+
+    bool init(bool ignore_checks) override;
+    void run() override;
+    void exit();
+
+    bool requires_GPS() const override { return false; }
+    bool has_manual_throttle() const override { return true; }
+    bool allows_arming(bool from_gcs) const override { return false; };
+    bool is_autopilot() const override { return false; }
+    bool logs_attitude() const override { return true; }
+
+    static const struct AP_Param::GroupInfo var_info[];
+
+protected:
+
+    const char *name() const override { return "SYSTEMID"; }
+    const char *name4() const override { return "SYSI"; }
+
+private:
+
+    // start the next sweep, logging its settings
+    void start_sweep();
+
+    // log the settings of the sweep being started
+    void log_setup() const;
+
+    // log the injected signal and the vehicle's response
+    void log_data(float sweep_time) const;
+
+    enum AxisType {
+        NONE = 0,           // none
+        INPUT_ROLL = 1,     // angle input roll axis is being excited
+        INPUT_PITCH = 2,    // angle input pitch axis is being excited
+        INPUT_YAW = 3,      // angle input yaw axis is being excited
+        RATE_ROLL = 4,      // rate roll axis is being excited
+        RATE_PITCH = 5,     // rate pitch axis is being excited
+        RATE_YAW = 6,       // rate yaw axis is being excited
+        MIX_ROLL = 7,       // mixer roll axis is being excited
+        MIX_PITCH = 8,      // mixer pitch axis is being excited
+        MIX_YAW = 9,        // mixer yaw axis is being excited
+        MIX_THROTTLE = 10,  // mixer throttle axis is being excited
+        NUM_AXES
+    };
+
+    // parameters
+    AP_Int8 axis;                   // controls which axis and controller the chirp is injected into
+    AP_Float waveform_magnitude;    // magnitude of the chirp
+    AP_Float frequency_start;       // frequency at the start of the sweep in Hz
+    AP_Float frequency_stop;        // frequency at the end of the sweep in Hz
+    AP_Float time_fade_in;          // time the magnitude is faded in over at the start of each sweep
+    AP_Float time_record;           // length of each sweep in seconds
+    AP_Float time_fade_out;         // time the magnitude is faded out over at the end of each sweep
+    AP_Float time_const_freq;       // time the start frequency is held for at the start of each sweep
+    AP_Int8 repeat;                 // number of sweeps run each time the mode is entered
+    AP_Float time_gap;              // time between sweeps in seconds
+
+    enum class SystemIDState {
+        SWEEPING,       // a sweep is being injected
+        WAITING,        // waiting between sweeps
+        FINISHED,       // all sweeps are done, the pilot has stabilize control
+    } state;
+
+    Chirp chirp;                    // frequency sweep generator
+    uint32_t sweep_start_ms;        // system time the current sweep started
+    uint8_t sweep_count;            // number of sweeps started since entering the mode
+    float waveform_sample;          // chirp injected on the current loop
+};
+#endif
@@ -1159,6 +1159,11 @@ void ModeAuto::do_nav_wp(const AP_Mission::Mission_Command& cmd)
                 break;
         }
         copter.wp_nav->set_fast_waypoint(fast_waypoint);
+
+        // limit the speed through the waypoint to what the turn towards the next waypoint allows
+        if (fast_waypoint && (temp_cmd.id == MAV_CMD_NAV_WAYPOINT)) {
+            copter.wp_nav->set_wp_destination_next(loc_from_cmd(temp_cmd));
+        }
     }
 }
 
@@ -108,9 +108,17 @@ void AutoTune::init_z_limits()
 
 void AutoTune::log_pids()
 {
-    copter.logger.Write_PID(LOG_PIDR_MSG, copter.attitude_control->get_rate_roll_pid().get_pid_info());
-    copter.logger.Write_PID(LOG_PIDP_MSG, copter.attitude_control->get_rate_pitch_pid().get_pid_info());
-    copter.logger.Write_PID(LOG_PIDY_MSG, copter.attitude_control->get_rate_yaw_pid().get_pid_info());
+    AP_Logger::PID_Info pid_roll, pid_pitch, pid_yaw;
+    {
+        // copy the rate PID info as the fast rate thread may be updating it
+        WITH_SEMAPHORE(copter.attitude_control->get_rate_pid_semaphore());
+        pid_roll = copter.attitude_control->get_rate_roll_pid().get_pid_info();
+        pid_pitch = copter.attitude_control->get_rate_pitch_pid().get_pid_info();
+        pid_yaw = copter.attitude_control->get_rate_yaw_pid().get_pid_info();
+    }
+    copter.logger.Write_PID(LOG_PIDR_MSG, pid_roll);
+    copter.logger.Write_PID(LOG_PIDP_MSG, pid_pitch);
+    copter.logger.Write_PID(LOG_PIDY_MSG, pid_yaw);
 }
 
 
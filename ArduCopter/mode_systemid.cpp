@@ -0,0 +1,291 @@
+#include "Copter.h"
+
+#if MODE_SYSTEMID_ENABLED == ENABLED
+
+/*
+  implement SYSTEMID mode, for injecting frequency sweeps (chirps) into the
+  attitude or rate controllers, or directly into the mixer, while the pilot
+  flies as in stabilize.  The injected signal and the vehicle's response are
+  logged at the main loop rate for frequency response analysis.
+ */
+
+const AP_Param::GroupInfo ModeSystemId::var_info[] = {
+
+    // @Param: _AXIS
+    // @DisplayName: System identification axis
+    // @Description: Controls which axis and controller the chirp is injected into
+    // @Values: 0:None,1:Input Roll Angle,2:Input Pitch Angle,3:Input Yaw Angle,4:Rate Roll,5:Rate Pitch,6:Rate Yaw,7:Mixer Roll,8:Mixer Pitch,9:Mixer Yaw,10:Mixer Thrust
+    // @User: Standard
+    AP_GROUPINFO("_AXIS", 1, ModeSystemId, axis, 0),
+
+    // @Param: _MAGNITUDE
+    // @DisplayName: System identification chirp magnitude
+    // @Description: Magnitude of the chirp. In degrees for angle inputs, degrees/s for rate inputs and normalised (-1 to 1) for mixer inputs
+    // @User: Standard
+    AP_GROUPINFO("_MAGNITUDE", 2, ModeSystemId, waveform_magnitude, 15),
+
+    // @Param: _F_START_HZ
+    // @DisplayName: System identification start frequency
+    // @Description: Frequency at the start of the sweep
+    // @Range: 0.01 100
+    // @Units: Hz
+    // @User: Standard
+    AP_GROUPINFO("_F_START_HZ", 3, ModeSystemId, frequency_start, 0.5f),
+
+    // @Param: _F_STOP_HZ
+    // @DisplayName: System identification stop frequency
+    // @Description: Frequency at the end of the sweep
+    // @Range: 0.01 100
+    // @Units: Hz
+    // @User: Standard
+    AP_GROUPINFO("_F_STOP_HZ", 4, ModeSystemId, frequency_stop, 40),
+
+    // @Param: _T_FADE_IN
+    // @DisplayName: System identification fade in time
+    // @Description: Time over which the magnitude is faded in at the start of each sweep
+    // @Range: 0 20
+    // @Units: s
+    // @User: Standard
+    AP_GROUPINFO("_T_FADE_IN", 5, ModeSystemId, time_fade_in, 5),
+
+    // @Param: _T_REC
+    // @DisplayName: System identification sweep time
+    // @Description: Length of each sweep including the fade in, constant frequency and fade out times
+    // @Range: 0 255
+    // @Units: s
+    // @User: Standard
+    AP_GROUPINFO("_T_REC", 6, ModeSystemId, time_record, 70),
+
+    // @Param: _T_FADE_OUT
+    // @DisplayName: System identification fade out time
+    // @Description: Time over which the magnitude is faded out at the end of each sweep
+    // @Range: 0 5
+    // @Units: s
+    // @User: Standard
+    AP_GROUPINFO("_T_FADE_OUT", 7, ModeSystemId, time_fade_out, 2),
+
+    // @Param: _T_CONST
+    // @DisplayName: System identification constant frequency time
+    // @Description: Time the start frequency is held for at the start of each sweep so the response can settle
+    // @Range: 0 20
+    // @Units: s
+    // @User: Standard
+    AP_GROUPINFO("_T_CONST", 8, ModeSystemId, time_const_freq, 4),
+
+    // @Param: _REPEAT
+    // @DisplayName: System identification number of sweeps
+    // @Description: Number of sweeps run one after the other each time the mode is entered
+    // @Range: 1 100
+    // @User: Standard
+    AP_GROUPINFO("_REPEAT", 9, ModeSystemId, repeat, 1),
+
+    // @Param: _T_GAP
+    // @DisplayName: System identification time between sweeps
+    // @Description: Time between the end of one sweep and the start of the next when running more than one sweep
+    // @Range: 0 30
+    // @Units: s
+    // @User: Standard
+    AP_GROUPINFO("_T_GAP", 10, ModeSystemId, time_gap, 2),
+
+    AP_GROUPEND
+};
+
+ModeSystemId::ModeSystemId(void) : Mode()
+{
+    AP_Param::setup_object_defaults(this, var_info);
+}
+
+// systemid_init - initialise systemid controller
+bool ModeSystemId::init(bool ignore_checks)
+{
+    // only allow entry while flying
+    if (!motors->armed() || copter.ap.land_complete) {
+        gcs().send_text(MAV_SEVERITY_WARNING, "SystemID: must be flying");
+        return false;
+    }
+    if (axis <= 0 || axis >= AxisType::NUM_AXES) {
+        gcs().send_text(MAV_SEVERITY_WARNING, "SystemID: invalid SID_AXIS");
+        return false;
+    }
+    if (!is_positive(time_record)) {
+        gcs().send_text(MAV_SEVERITY_WARNING, "SystemID: invalid SID_T_REC");
+        return false;
+    }
+
+    chirp.init(time_record, frequency_start, frequency_stop, time_fade_in, time_fade_out, time_const_freq);
+    sweep_count = 0;
+    start_sweep();
+
+    gcs().send_text(MAV_SEVERITY_INFO, "SystemID: starting %u sweeps", (unsigned)MAX(repeat.get(), 1));
+    return true;
+}
+
+// stop the sweeps when leaving the mode
+void ModeSystemId::exit()
+{
+    if (state != SystemIDState::FINISHED) {
+        gcs().send_text(MAV_SEVERITY_INFO, "SystemID: stopped after %u sweeps", (unsigned)sweep_count);
+    }
+    state = SystemIDState::FINISHED;
+}
+
+// start the next sweep, logging its settings
+void ModeSystemId::start_sweep()
+{
+    state = SystemIDState::SWEEPING;
+    sweep_start_ms = millis();
+    sweep_count++;
+    log_setup();
+}
+
+// systemid_run - runs the systemid controller
+// should be called at 100hz or more
+void ModeSystemId::run()
+{
+    // apply simple mode transform to pilot inputs
+    update_simple_mode();
+
+    // convert pilot input to lean angles
+    float target_roll, target_pitch;
+    get_pilot_desired_lean_angles(target_roll, target_pitch, copter.aparm.angle_max, copter.aparm.angle_max);
+
+    // get pilot's desired yaw rate
+    float target_yaw_rate = get_pilot_desired_yaw_rate(channel_yaw->get_control_in());
+
+    // get pilot's desired throttle
+    float pilot_throttle_scaled = get_pilot_desired_throttle();
+
+    if (!motors->armed()) {
+        // Motors should be Stopped
+        motors->set_desired_spool_state(AP_Motors::DesiredSpoolState::SHUT_DOWN);
+    } else if (copter.ap.throttle_zero) {
+        // Attempting to Land
+        motors->set_desired_spool_state(AP_Motors::DesiredSpoolState::GROUND_IDLE);
+    } else {
+        motors->set_desired_spool_state(AP_Motors::DesiredSpoolState::THROTTLE_UNLIMITED);
+    }
+
+    switch (motors->get_spool_state()) {
+    case AP_Motors::SpoolState::SHUT_DOWN:
+    case AP_Motors::SpoolState::GROUND_IDLE:
+        // Motors Stopped or landed, the sweeps can't continue
+        attitude_control->set_yaw_target_to_current_heading();
+        attitude_control->reset_rate_controller_I_terms();
+        if (state != SystemIDState::FINISHED) {
+            gcs().send_text(MAV_SEVERITY_WARNING, "SystemID: stopped on landing");
+            state = SystemIDState::FINISHED;
+        }
+        break;
+    case AP_Motors::SpoolState::THROTTLE_UNLIMITED:
+        // clear landing flag above zero throttle
+        if (!motors->limit.throttle_lower) {
+            set_land_complete(false);
+        }
+        break;
+    case AP_Motors::SpoolState::SPOOLING_UP:
+    case AP_Motors::SpoolState::SPOOLING_DOWN:
+        // do nothing
+        break;
+    }
+
+    // calculate the chirp and move between sweeps
+    waveform_sample = 0.0f;
+    const float sweep_time = (millis() - sweep_start_ms) * 0.001f;
+    switch (state) {
+    case SystemIDState::SWEEPING:
+        if (chirp.completed(sweep_time)) {
+            if (sweep_count >= repeat) {
+                gcs().send_text(MAV_SEVERITY_INFO, "SystemID: finished %u sweeps", (unsigned)sweep_count);
+                state = SystemIDState::FINISHED;
+            } else {
+                state = SystemIDState::WAITING;
+            }
+            break;
+        }
+        waveform_sample = chirp.update(sweep_time, waveform_magnitude);
+        break;
+    case SystemIDState::WAITING:
+        if (sweep_time >= chirp.get_time_record() + time_gap) {
+            start_sweep();
+        }
+        break;
+    case SystemIDState::FINISHED:
+        break;
+    }
+
+    // inject the chirp into the selected axis
+    switch (axis) {
+    case AxisType::NONE:
+    case AxisType::NUM_AXES:
+        break;
+    case AxisType::INPUT_ROLL:
+        target_roll += waveform_sample * 100.0f;
+        break;
+    case AxisType::INPUT_PITCH:
+        target_pitch += waveform_sample * 100.0f;
+        break;
+    case AxisType::INPUT_YAW:
+        target_yaw_rate += waveform_sample * 100.0f;
+        break;
+    case AxisType::RATE_ROLL:
+        attitude_control->rate_bf_roll_sysid(radians(waveform_sample));
+        break;
+    case AxisType::RATE_PITCH:
+        attitude_control->rate_bf_pitch_sysid(radians(waveform_sample));
+        break;
+    case AxisType::RATE_YAW:
+        attitude_control->rate_bf_yaw_sysid(radians(waveform_sample));
+        break;
+    case AxisType::MIX_ROLL:
+        attitude_control->actuator_roll_sysid(waveform_sample);
+        break;
+    case AxisType::MIX_PITCH:
+        attitude_control->actuator_pitch_sysid(waveform_sample);
+        break;
+    case AxisType::MIX_YAW:
+        attitude_control->actuator_yaw_sysid(waveform_sample);
+        break;
+    case AxisType::MIX_THROTTLE:
+        pilot_throttle_scaled += waveform_sample;
+        break;
+    }
+
+    // call attitude controller
+    attitude_control->input_euler_angle_roll_pitch_euler_rate_yaw(target_roll, target_pitch, target_yaw_rate);
+
+    // output pilot's throttle
+    attitude_control->set_throttle_out(pilot_throttle_scaled, axis != AxisType::MIX_THROTTLE, g.throttle_filt);
+
+    if (state == SystemIDState::SWEEPING) {
+        log_data(sweep_time);
+    }
+}
+
+// log the settings of the sweep being started
+void ModeSystemId::log_setup() const
+{
+    copter.Log_Write_SysID_Setup(sweep_count, axis, waveform_magnitude, frequency_start, frequency_stop,
+                                 time_fade_in, time_const_freq, time_record, time_fade_out);
+}
+
+// log the injected signal and the vehicle's response
+void ModeSystemId::log_data(float sweep_time) const
+{
+    // the average rates and accelerations since the last sample are logged so they are aligned with the injected signal
+    Vector3f gyro = copter.ins.get_gyro();
+    Vector3f accel = copter.ins.get_accel();
+    Vector3f delta_angle;
+    const float delta_angle_dt = copter.ins.get_delta_angle_dt(copter.ins.get_primary_gyro());
+    if (copter.ins.get_delta_angle(delta_angle) && is_positive(delta_angle_dt)) {
+        gyro = delta_angle / delta_angle_dt;
+    }
+    Vector3f delta_velocity;
+    const float delta_velocity_dt = copter.ins.get_delta_velocity_dt();
+    if (copter.ins.get_delta_velocity(delta_velocity) && is_positive(delta_velocity_dt)) {
+        accel = delta_velocity / delta_velocity_dt;
+    }
+
+    copter.Log_Write_SysID_Data(sweep_time, chirp.get_frequency_hz(), waveform_sample, gyro, accel);
+}
+
+#endif
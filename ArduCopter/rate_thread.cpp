@@ -0,0 +1,78 @@
+#include "Copter.h"
+
+#if FAST_RATE_THREAD_ENABLED
+
+/*
+  fast rate thread
+
+  When enabled the rate PIDs are run in their own high priority thread
+  on each new primary gyro sample rather than once per main loop. The
+  main loop continues to run the attitude and position controllers,
+  hands the resulting rate targets to the thread and sends the thread's
+  latest rate PID outputs to the motors, so everything that drives the
+  motors and servos stays on the main loop. The gyro samples and rate
+  targets are handed over in lock-free single producer, single consumer
+  buffers, and the thread sleeps until the IMU backend pushes a sample.
+
+  The PIDs and their filters see every gyro sample, but their outputs
+  only reach the motors at the main loop rate, up to one main loop
+  period after the gyro sample they were calculated from. This latency
+  is logged in the FSTR message so it can be compared with running the
+  rate PIDs on the main loop.
+ */
+
+#define RATE_THREAD_STACK_SIZE      8192
+#define RATE_THREAD_WAIT_US         10000   // longest wait for a gyro sample before checking again
+
+// start the fast rate thread if it is enabled
+void Copter::rate_thread_init()
+{
+    if (g2.fstrate_enable <= 0) {
+        return;
+    }
+
+    if (!ins.enable_rate_loop_buffer() || !attitude_control->enable_rate_thread()) {
+        gcs().send_text(MAV_SEVERITY_WARNING, "Fast rate thread: out of memory");
+        return;
+    }
+
+    rate_thread_active = true;
+    if (!hal.scheduler->thread_create(FUNCTOR_BIND_MEMBER(&Copter::rate_controller_thread, void),
+                                      "rate",
+                                      RATE_THREAD_STACK_SIZE, AP_HAL::Scheduler::PRIORITY_BOOST, 1)) {
+        rate_thread_active = false;
+        attitude_control->disable_rate_thread();
+        gcs().send_text(MAV_SEVERITY_WARNING, "Fast rate thread: failed to start");
+    }
+}
+
+// run the rate PIDs on each new gyro sample
+void Copter::rate_controller_thread()
+{
+    const uint8_t div = constrain_int16(g2.fstrate_div, 1, 8);
+
+    // samples and time since the rate PIDs last ran. Samples which
+    // arrive while the thread is busy are counted, so the PIDs get the
+    // real time step and the divider counts gyro samples, not wake ups
+    uint16_t sample_count = 0;
+    float dt = 0;
+    while (true) {
+        Vector3f gyro;
+        float sample_dt;
+        const uint16_t n = ins.get_next_gyro_sample(gyro, sample_dt, RATE_THREAD_WAIT_US);
+        if (n == 0) {
+            continue;
+        }
+        sample_count += n;
+        dt += sample_dt;
+        if (sample_count < div || !is_positive(dt)) {
+            continue;
+        }
+
+        attitude_control->rate_controller_run_thread(gyro, dt);
+        sample_count = 0;
+        dt = 0;
+    }
+}
+
+#endif // FAST_RATE_THREAD_ENABLED
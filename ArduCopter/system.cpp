@@ -254,6 +254,11 @@ void Copter::init_ardupilot()
     // disable safety if requested
     BoardConfig.init_safety();
 
+#if FAST_RATE_THREAD_ENABLED
+    // start the fast rate thread if enabled
+    rate_thread_init();
+#endif
+
     hal.console->printf("\nReady to FLY ");
 
     // flag that initialisation has completed
@@ -0,0 +1,337 @@
+#!/usr/bin/env python
+
+'''
+Run many SITL scenarios in parallel and collect their results.
+
+Each scenario is flown by its own SITL process in its own temporary
+directory with its own instance number, so scenarios share no storage,
+logs or ports and a pool of them can saturate every core. A scenario
+loads parameter files plus parameter overrides, uploads a mission,
+arms, flies the mission in AUTO and passes if the last mission item is
+reached (and the vehicle disarms, if required) before the timeout in
+simulated seconds. A scenario also fails if it takes longer than
+"wall_timeout" seconds of real time, by default the timeout plus 60.
+
+Scenarios are described in a JSON file, for example:
+
+{
+    "defaults": {
+        "binary": "build/sitl/bin/arducopter",
+        "model": "quad",
+        "home": "CMAC",
+        "params": ["Tools/autotest/default_params/copter.parm"],
+        "mission": "Tools/autotest/copter_mission.txt",
+        "rc_override": {"3": 1500},
+        "require_disarm": true,
+        "timeout": 900
+    },
+    "scenarios": [
+        {
+            "name": "rate_gains",
+            "set": {"SIM_WIND_DIR": 180},
+            "sweep": {
+                "ATC_RAT_RLL_P": [0.1, 0.135, 0.2],
+                "SIM_WIND_SPD": [0, 5, 10]
+            }
+        }
+    ]
+}
+
+Each entry of "sweep" is expanded into every combination of values, so
+the example above runs nine scenarios. Results are printed as they
+complete and written to a JSON and a CSV file.
+'''
+
+from __future__ import print_function
+
+import argparse
+import csv
+import itertools
+import json
+import math
+import multiprocessing
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+from pymavlink import mavutil, mavwp
+
+topdir = os.path.abspath(os.path.join(os.path.dirname(__file__), '..', '..'))
+
+# each instance offsets all SITL ports by 10 times its instance number
+BASE_PORT = 5760
+
+# workers take instance numbers from this counter, see init_worker()
+worker_instance = None
+
+
+class ScenarioFailed(Exception):
+    pass
+
+
+def expand_scenarios(config):
+    '''expand each scenario's sweep into one scenario per combination of values'''
+    defaults = config.get("defaults", {})
+    ret = []
+    for scenario in config["scenarios"]:
+        base = dict(defaults)
+        base.update(scenario)
+        base_set = dict(defaults.get("set", {}))
+        base_set.update(scenario.get("set", {}))
+        sweep = scenario.get("sweep", {})
+        names = sorted(sweep.keys())
+        for values in itertools.product(*[sweep[n] for n in names]):
+            s = dict(base)
+            s["set"] = dict(base_set)
+            s["set"].update(zip(names, values))
+            s["sweep"] = dict(zip(names, values))
+            suffix = ",".join(["%s=%s" % (n, v) for (n, v) in zip(names, values)])
+            s["name"] = base.get("name", "scenario")
+            if suffix:
+                s["name"] += "[%s]" % suffix
+            ret.append(s)
+    return ret
+
+
+def find_location(name):
+    '''convert a named location from locations.txt into a home string'''
+    if "," in name:
+        return name
+    with open(os.path.join(topdir, "Tools", "autotest", "locations.txt")) as f:
+        for line in f:
+            line = line.strip()
+            if line.startswith("#") or "=" not in line:
+                continue
+            (loc_name, loc) = line.split("=", 1)
+            if loc_name == name:
+                return loc
+    raise ScenarioFailed("unknown location %s" % name)
+
+
+def write_defaults(scenario, path):
+    '''combine the scenario's parameter files and overrides into one defaults file'''
+    with open(path, "w") as out:
+        for fname in scenario.get("params", []):
+            with open(os.path.join(topdir, fname)) as f:
+                out.write(f.read())
+            out.write("\n")
+        for (name, value) in sorted(scenario["set"].items()):
+            out.write("%s %s\n" % (name, value))
+
+
+def upload_mission(conn, filename, timeout):
+    '''upload a waypoint file, returning the number of items'''
+    loader = mavwp.MAVWPLoader()
+    loader.target_system = conn.target_system
+    loader.target_component = conn.target_component
+    count = loader.load(os.path.join(topdir, filename))
+    conn.waypoint_count_send(count)
+    tstart = time.time()
+    while True:
+        if time.time() - tstart > timeout:
+            raise ScenarioFailed("mission upload timed out")
+        m = conn.recv_match(type=['MISSION_REQUEST', 'MISSION_ACK'], blocking=True, timeout=1)
+        if m is None:
+            continue
+        if m.get_type() == 'MISSION_ACK':
+            if m.type != mavutil.mavlink.MAV_MISSION_ACCEPTED:
+                raise ScenarioFailed("mission rejected (%u)" % m.type)
+            return count
+        conn.mav.send(loader.wp(m.seq))
+
+
+def arm(conn, timeout):
+    '''arm once the vehicle passes its arming checks'''
+    tstart = time.time()
+    while not conn.motors_armed():
+        if time.time() - tstart > timeout:
+            raise ScenarioFailed("failed to arm")
+        conn.arducopter_arm()
+        conn.recv_match(type='HEARTBEAT', blocking=True, timeout=1)
+
+
+def send_rc_override(conn, rc_override):
+    '''override the RC channels given as a dictionary of channel number to PWM'''
+    if not rc_override:
+        return
+    overrides = [65535] * 8
+    for (chan, pwm) in rc_override.items():
+        overrides[int(chan) - 1] = pwm
+    conn.mav.rc_channels_override_send(conn.target_system, conn.target_component, *overrides)
+
+
+class Flight(object):
+    '''monitor a flight, tracking simulated time and summary metrics'''
+    def __init__(self, conn, scenario):
+        self.conn = conn
+        self.fail_text = scenario.get("fail_text", ["Crash", "failsafe"])
+        self.sim_time_s = 0
+        self.last_item = -1
+        self.max_tilt_deg = 0
+        self.text = []
+
+    def update(self, timeout=1):
+        m = self.conn.recv_match(blocking=True, timeout=timeout)
+        if m is None:
+            return None
+        mtype = m.get_type()
+        if mtype == 'ATTITUDE':
+            self.sim_time_s = m.time_boot_ms * 0.001
+            tilt = math.degrees(math.acos(max(-1, min(1, math.cos(m.roll) * math.cos(m.pitch)))))
+            self.max_tilt_deg = max(self.max_tilt_deg, tilt)
+        elif mtype == 'MISSION_ITEM_REACHED':
+            self.last_item = max(self.last_item, m.seq)
+        elif mtype == 'STATUSTEXT':
+            self.text.append(m.text)
+            for t in self.fail_text:
+                if t.lower() in m.text.lower():
+                    raise ScenarioFailed("vehicle reported: %s" % m.text)
+        return m
+
+
+def fly_scenario(scenario, instance, workdir):
+    '''fly one scenario, returning a dictionary of metrics'''
+    defaults_path = os.path.join(workdir, "defaults.parm")
+    write_defaults(scenario, defaults_path)
+
+    cmd = [os.path.join(topdir, scenario["binary"]),
+           "-S", "-w",
+           "-I", str(instance),
+           "--model", scenario.get("model", "quad"),
+           "--home", find_location(scenario.get("home", "CMAC")),
+           "--speedup", str(scenario.get("speedup", 100)),
+           "--defaults", defaults_path]
+    if scenario.get("lockstep", True):
+        cmd.append("--lockstep")
+
+    log = open(os.path.join(workdir, "sitl.log"), "w")
+    sitl = subprocess.Popen(cmd, cwd=workdir, stdout=log, stderr=subprocess.STDOUT)
+    metrics = {}
+    try:
+        conn = mavutil.mavlink_connection("tcp:127.0.0.1:%u" % (BASE_PORT + 10 * instance),
+                                          retries=30, robust_parsing=True)
+        if conn.wait_heartbeat(timeout=60) is None:
+            raise ScenarioFailed("no heartbeat")
+        conn.mav.request_data_stream_send(conn.target_system, conn.target_component,
+                                          mavutil.mavlink.MAV_DATA_STREAM_ALL, 10, 1)
+
+        count = upload_mission(conn, scenario["mission"], 30)
+        arm(conn, scenario.get("arm_timeout", 120))
+        conn.set_mode("AUTO")
+
+        flight = Flight(conn, scenario)
+        t_start = flight.sim_time_s
+        timeout = scenario.get("timeout", 600)
+        require_disarm = scenario.get("require_disarm", False)
+        # with a speedup of at least 1 this only trips if SITL hangs
+        # without exiting, which the simulated time can't detect
+        wall_deadline = time.time() + scenario.get("wall_timeout", timeout + 60)
+        last_override = 0
+        while True:
+            # overrides expire after RC_OVERRIDE_TIME, so keep sending them
+            now = time.time()
+            if now - last_override > 1:
+                send_rc_override(conn, scenario.get("rc_override", {}))
+                last_override = now
+            if now > wall_deadline:
+                raise ScenarioFailed("wall clock timeout at mission item %d of %u" % (flight.last_item, count - 1))
+            flight.update()
+            if flight.sim_time_s - t_start > timeout and flight.sim_time_s > 0:
+                raise ScenarioFailed("timed out at mission item %d of %u" % (flight.last_item, count - 1))
+            if flight.last_item >= count - 1 and (not require_disarm or not conn.motors_armed()):
+                break
+            if sitl.poll() is not None:
+                raise ScenarioFailed("SITL exited with %d" % sitl.returncode)
+
+        metrics["sim_time_s"] = round(flight.sim_time_s, 1)
+        metrics["max_tilt_deg"] = round(flight.max_tilt_deg, 1)
+    finally:
+        sitl.kill()
+        sitl.wait()
+        log.close()
+    return metrics
+
+
+def init_worker(counter):
+    '''give each worker process its own SITL instance number'''
+    global worker_instance
+    with counter.get_lock():
+        worker_instance = counter.value
+        counter.value += 1
+
+
+def run_scenario(args):
+    (scenario, keep) = args
+    workdir = tempfile.mkdtemp(prefix="scenario-%u-" % worker_instance)
+    result = {
+        "name": scenario["name"],
+        "instance": worker_instance,
+        "workdir": workdir,
+        "result": "PASS",
+        "reason": "",
+    }
+    result.update(scenario.get("sweep", {}))
+    tstart = time.time()
+    try:
+        result.update(fly_scenario(scenario, worker_instance, workdir))
+    except Exception as e:
+        result["result"] = "FAIL"
+        result["reason"] = str(e)
+    result["wall_time_s"] = round(time.time() - tstart, 1)
+    if "sim_time_s" in result and result["wall_time_s"] > 0:
+        result["speedup"] = round(result["sim_time_s"] / result["wall_time_s"], 1)
+    if not keep and result["result"] == "PASS":
+        shutil.rmtree(workdir, ignore_errors=True)
+    return result
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Run SITL scenarios in parallel")
+    parser.add_argument("config", help="JSON file describing the scenarios")
+    parser.add_argument("-j", "--jobs", type=int, default=multiprocessing.cpu_count(),
+                        help="number of scenarios to run at once")
+    parser.add_argument("--first-instance", type=int, default=10,
+                        help="SITL instance number of the first worker")
+    parser.add_argument("--results", default="scenario-results",
+                        help="base name of the JSON and CSV result files")
+    parser.add_argument("--keep", action="store_true",
+                        help="keep the directories of passing scenarios as well as failing ones")
+    args = parser.parse_args()
+
+    with open(args.config) as f:
+        scenarios = expand_scenarios(json.load(f))
+    print("Running %u scenarios with %u workers" % (len(scenarios), args.jobs))
+
+    counter = multiprocessing.Value('i', args.first_instance)
+    pool = multiprocessing.Pool(processes=args.jobs, initializer=init_worker, initargs=(counter,))
+    results = []
+    tstart = time.time()
+    for result in pool.imap_unordered(run_scenario, [(s, args.keep) for s in scenarios]):
+        results.append(result)
+        print("%u/%u %s %s %s" % (len(results), len(scenarios),
+                                  result["result"], result["name"], result["reason"]))
+        sys.stdout.flush()
+    pool.close()
+    pool.join()
+
+    results.sort(key=lambda r: r["name"])
+    with open(args.results + ".json", "w") as f:
+        json.dump(results, f, indent=2)
+    fields = []
+    for r in results:
+        fields.extend([k for k in r.keys() if k not in fields])
+    with open(args.results + ".csv", "w") as f:
+        writer = csv.DictWriter(f, fieldnames=fields)
+        writer.writeheader()
+        writer.writerows(results)
+
+    passed = len([r for r in results if r["result"] == "PASS"])
+    print("%u of %u scenarios passed in %.0fs" % (passed, len(results), time.time() - tstart))
+    sys.exit(0 if passed == len(results) else 1)
+
+
+if __name__ == '__main__':
+    main()
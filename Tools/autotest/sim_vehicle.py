@@ -582,6 +582,8 @@ def start_vehicle(binary, autotest, opts, stuff, loc=None):
         cmd.append("-w")
     cmd.extend(["--model", stuff["model"]])
     cmd.extend(["--speedup", str(opts.speedup)])
+    if opts.lockstep:
+        cmd.append("--lockstep")
     if opts.sitl_instance_args:
         # this could be a lot better:
         cmd.extend(opts.sitl_instance_args.split(" "))
@@ -867,6 +869,11 @@ group_sim.add_option("-S", "--speedup",
                      default=1,
                      type='int',
                      help="set simulation speedup (1 for wall clock time)")
+group_sim.add_option("", "--lockstep",
+                     action='store_true',
+                     default=False,
+                     help="run as fast as possible with threads stepped "
+                     "in lockstep with the simulation (ignores speedup)")
 group_sim.add_option("-t", "--tracker-location",
                      default='CMAC_PILOTSBOX',
                      type='string',
@@ -0,0 +1,384 @@
+#!/usr/bin/env python
+
+'''
+propose Copter rate controller gains from logged flight data
+
+The rate controller loop of each axis is identified from the RATE log
+messages of a flight containing stick or chirp (SYSID) inputs on that
+axis.  The frequency response of the vehicle from the rate controller
+output to the measured rate is estimated using the rate target as the
+excitation, which keeps the estimate unbiased by the closed loop.  When
+the log contains SYSID chirps the logged SIDD target is added to the
+RATE target for rate injection, or used on its own for mixer injection,
+as RATE only logs the target before the chirp is injected.  A
+model of an integrator with a time delay is fitted to the coherent part
+of the response and the P, I and D gains (in the ratios of the current
+gains, with the D ratio optimised for roll and pitch) are chosen to give
+the highest crossover frequency which meets the phase and gain margins.
+
+The logs must be recorded with ATTITUDE_FAST in LOG_BITMASK so that RATE
+is logged at the loop rate.  Several logs are processed in parallel.
+
+Requires numpy and pymavlink, e.g. "pip install numpy pymavlink".
+
+  offline_autotune.py [options] <LOGFILE|DIRECTORY...>
+'''
+
+from __future__ import print_function
+
+import argparse
+import math
+import multiprocessing
+import os
+import sys
+
+try:
+    import numpy as np
+except ImportError:
+    print("offline_autotune.py requires numpy: pip install numpy")
+    sys.exit(1)
+
+parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+parser.add_argument("logs", nargs='+', help="log files or directories of log files")
+parser.add_argument("--jobs", type=int, default=multiprocessing.cpu_count(), help="number of logs to process in parallel")
+parser.add_argument("--axes", default="roll,pitch,yaw", help="comma separated axes to tune")
+parser.add_argument("--phase-margin", type=float, default=45.0, help="minimum phase margin in degrees")
+parser.add_argument("--gain-margin", type=float, default=6.0, help="minimum gain margin in dB")
+parser.add_argument("--min-coherence", type=float, default=0.6, help="minimum coherence of frequencies used in the fit")
+parser.add_argument("--freq-min", type=float, default=1.0, help="lowest frequency used in the fit in Hz")
+parser.add_argument("--freq-max", type=float, default=40.0, help="highest frequency used in the fit in Hz")
+parser.add_argument("--window", type=float, default=4.0, help="spectral estimate window length in seconds")
+parser.add_argument("--min-throttle", type=float, default=0.1, help="minimum throttle output for data to be used")
+parser.add_argument("--param-out", default=None, help="directory to write a parameter file of proposed gains for each log")
+args = parser.parse_args()
+
+AXES = {
+    # axis name: (RATE target field, RATE measured field, RATE output field, parameter prefix,
+    #             SYSID_AXIS for rate injection, SYSID_AXIS for mixer injection)
+    'roll':  ('RDes', 'R', 'ROut', 'ATC_RAT_RLL_', 4, 7),
+    'pitch': ('PDes', 'P', 'POut', 'ATC_RAT_PIT_', 5, 8),
+    'yaw':   ('YDes', 'Y', 'YOut', 'ATC_RAT_YAW_', 6, 9),
+}
+
+# default gains used when a log doesn't contain the parameters
+DEFAULT_GAINS = {
+    'roll':  {'P': 0.135, 'I': 0.135, 'D': 0.0036, 'FLTE': 0.0, 'FLTD': 20.0},
+    'pitch': {'P': 0.135, 'I': 0.135, 'D': 0.0036, 'FLTE': 0.0, 'FLTD': 20.0},
+    'yaw':   {'P': 0.18, 'I': 0.018, 'D': 0.0, 'FLTE': 2.5, 'FLTD': 20.0},
+}
+
+# ratios of D to P searched for roll and pitch, yaw keeps its current ratio
+D_RATIOS = np.linspace(0.0, 0.05, 11)
+
+# P gains searched
+P_GAINS = np.geomspace(0.005, 2.0, 400)
+
+MIN_SAMPLE_RATE = 100.0     # RATE must be logged at least this fast
+MIN_FIT_BINS = 5            # minimum number of coherent frequencies needed for a fit
+SIDD_MAX_GAP = 0.1          # SIDD samples further apart than this in seconds are separate chirps
+
+
+def find_logs(paths):
+    '''expand directories into the log files they contain'''
+    logs = []
+    for path in paths:
+        if os.path.isdir(path):
+            for name in sorted(os.listdir(path)):
+                if name.lower().endswith(('.bin', '.log')):
+                    logs.append(os.path.join(path, name))
+        else:
+            logs.append(path)
+    return logs
+
+
+def load_log(filename):
+    '''load the RATE and SIDD messages and rate controller parameters from a log'''
+    from pymavlink import mavutil
+
+    mlog = mavutil.mavlink_connection(filename)
+    fields = ['TimeUS', 'AOut']
+    for axis in AXES.values():
+        fields.extend(axis[0:3])
+    rate = {f: [] for f in fields}
+    sidd = {'TimeUS': [], 'Targ': [], 'Ax': []}
+    sysid_axis = 0
+    params = {}
+    while True:
+        m = mlog.recv_match(type=['RATE', 'SIDS', 'SIDD', 'PARM'])
+        if m is None:
+            break
+        mtype = m.get_type()
+        if mtype == 'PARM':
+            params[m.Name] = m.Value
+        elif mtype == 'SIDS':
+            sysid_axis = m.Ax
+        elif mtype == 'SIDD':
+            sidd['TimeUS'].append(m.TimeUS)
+            sidd['Targ'].append(m.Targ)
+            sidd['Ax'].append(sysid_axis)
+        else:
+            for f in fields:
+                rate[f].append(getattr(m, f))
+    rate = {f: np.array(v, dtype=float) for f, v in rate.items()}
+    sidd = {f: np.array(v, dtype=float) for f, v in sidd.items()}
+    return rate, sidd, params
+
+
+def instrument_field(axis):
+    '''name of the RATE field holding the excitation used to identify an axis'''
+    return AXES[axis][0] + 'Inst'
+
+
+def add_instruments(rate, sidd):
+    '''add the excitation of each axis to the RATE data: the rate target, with any SYSID chirp included'''
+    t = rate['TimeUS']
+    for axis, (target, _, _, _, rate_ax, mix_ax) in AXES.items():
+        inst = rate[target].copy()
+        for ax in (rate_ax, mix_ax):
+            sel = sidd['Ax'] == ax
+            if np.count_nonzero(sel) < 2:
+                continue
+            t_sidd = sidd['TimeUS'][sel]
+            # the chirp is running between SIDD samples which are not from separate SYSID runs
+            idx = np.clip(np.searchsorted(t_sidd, t), 1, len(t_sidd) - 1)
+            running = ((t >= t_sidd[0]) & (t <= t_sidd[-1]) &
+                       ((t_sidd[idx] - t_sidd[idx - 1]) * 1.0e-6 <= SIDD_MAX_GAP))
+            chirp = np.where(running, np.interp(t, t_sidd, sidd['Targ'][sel]), 0.0)
+            if ax == rate_ax:
+                # injected into the rate target, in deg/s like RDes
+                inst += chirp
+            else:
+                # injected into the mixer, so the chirp alone is the excitation while it runs
+                inst = np.where(running, chirp, inst)
+        rate[instrument_field(axis)] = inst
+
+
+def flying_segments(rate, fs, min_len):
+    '''resample the RATE data onto a uniform time base and split it into segments where the vehicle is flying'''
+    t = rate['TimeUS'] * 1.0e-6
+    t_uniform = np.arange(t[0], t[-1], 1.0 / fs)
+    data = {f: np.interp(t_uniform, t, v) for f, v in rate.items() if f != 'TimeUS'}
+
+    flying = data['AOut'] > args.min_throttle
+    segments = []
+    start = None
+    for i, f in enumerate(np.append(flying, False)):
+        if f and start is None:
+            start = i
+        elif not f and start is not None:
+            if i - start >= min_len:
+                segments.append({k: v[start:i] for k, v in data.items()})
+            start = None
+    return segments
+
+
+def cross_spectra(segments, fields, nfft):
+    '''Welch estimate of the auto and cross spectra of the fields over all segments'''
+    window = np.hanning(nfft)
+    step = nfft // 2
+    spectra = {}
+    count = 0
+    for seg in segments:
+        n = len(seg[fields[0]])
+        if n < nfft:
+            continue
+        starts = np.arange(0, n - nfft + 1, step)
+        index = starts[:, None] + np.arange(nfft)[None, :]
+        ffts = {}
+        for f in fields:
+            frames = seg[f][index]
+            frames = frames - frames.mean(axis=1, keepdims=True)
+            ffts[f] = np.fft.rfft(frames * window, axis=1)
+        for a in fields:
+            for b in fields:
+                s = np.sum(np.conj(ffts[a]) * ffts[b], axis=0)
+                spectra[(a, b)] = spectra.get((a, b), 0) + s
+        count += len(starts)
+    return spectra, count
+
+
+def identify(segments, fs, axis):
+    '''estimate the frequency response from rate controller output to measured rate and fit an integrator with delay'''
+    target = instrument_field(axis)
+    measured, output = AXES[axis][1:3]
+    nfft = int(2 ** round(math.log(args.window * fs, 2)))
+    spectra, count = cross_spectra(segments, [target, measured, output], nfft)
+    if count == 0:
+        return None
+
+    # the rate target is the excitation, so the plant is the ratio of its cross spectra with the output and measurement
+    s_rr = spectra[(target, target)].real
+    s_ru = spectra[(target, output)]
+    s_ry = spectra[(target, measured)]
+    s_uu = spectra[(output, output)].real
+    s_yy = spectra[(measured, measured)].real
+    with np.errstate(divide='ignore', invalid='ignore'):
+        # measured rates are logged in deg/s, the controllers work in rad/s
+        response = (s_ry / s_ru) * (math.pi / 180.0)
+        coherence = np.minimum(np.abs(s_ru) ** 2 / (s_rr * s_uu), np.abs(s_ry) ** 2 / (s_rr * s_yy))
+
+    freq = np.fft.rfftfreq(nfft, 1.0 / fs)
+    use = ((freq >= args.freq_min) & (freq <= min(args.freq_max, fs * 0.4)) &
+           np.isfinite(response) & (coherence >= args.min_coherence))
+    if np.count_nonzero(use) < MIN_FIT_BINS:
+        return None
+    w = 2.0 * math.pi * freq[use]
+    h = response[use]
+    weight = coherence[use]
+
+    # gain of an integrator: |H| = K / w
+    gain = np.exp(np.sum(weight * np.log(np.abs(h) * w)) / np.sum(weight))
+
+    # phase of an integrator with delay: -pi/2 - w * delay
+    phase = np.unwrap(np.angle(h * 1j))
+    delay = -np.sum(weight * w * phase) / np.sum(weight * w * w)
+    delay = max(delay, 1.0 / fs)
+
+    return {'gain': gain, 'delay': delay, 'coherence': float(np.mean(weight)),
+            'freq_min': float(freq[use][0]), 'freq_max': float(freq[use][-1])}
+
+
+def loop_response(model, w, i_ratio, d_ratio, flte, fltd):
+    '''magnitude and continuous phase of the loop response with a P gain of one'''
+    # plant: K e^(-jw delay) / jw
+    mag = model['gain'] / w
+    phase = -math.pi / 2.0 - w * model['delay']
+
+    # AC_PID: (P + I / jw + D jw / (1 + jw / wd)) / (1 + jw / we)
+    jw = 1j * w
+    d_filter = 1.0 / (1.0 + jw / (2.0 * math.pi * fltd)) if fltd > 0 else 1.0
+    pid = 1.0 + i_ratio / jw + d_ratio * jw * d_filter
+    mag = mag * np.abs(pid)
+    phase = phase + np.angle(pid)
+    if flte > 0:
+        e_filter = 1.0 / (1.0 + jw / (2.0 * math.pi * flte))
+        mag = mag * np.abs(e_filter)
+        phase = phase + np.angle(e_filter)
+    return mag, phase
+
+
+def margins(mag, phase, w, p):
+    '''crossover frequency, phase margin and gain margin of the loop with P gain p'''
+    loop_mag = mag * p
+    above = np.nonzero(loop_mag >= 1.0)[0]
+    if len(above) == 0 or above[-1] == len(w) - 1:
+        return None
+    crossover = above[-1]
+    phase_margin = math.degrees(phase[crossover]) + 180.0
+    beyond = np.nonzero(phase[crossover:] <= -math.pi)[0]
+    if len(beyond) == 0:
+        gain_margin = float('inf')
+    else:
+        gain_margin = -20.0 * math.log10(loop_mag[crossover + beyond[0]])
+    return w[crossover] / (2.0 * math.pi), phase_margin, gain_margin
+
+
+def design(model, fs, current, axis):
+    '''find the gains giving the highest crossover frequency which meets the margins'''
+    w = 2.0 * math.pi * np.geomspace(0.1, fs * 0.5, 2000)
+    i_ratio = current['I'] / current['P'] if current['P'] > 0 else 1.0
+    if axis == 'yaw':
+        d_ratios = [current['D'] / current['P'] if current['P'] > 0 else 0.0]
+    else:
+        d_ratios = D_RATIOS
+
+    best = None
+    for d_ratio in d_ratios:
+        mag, phase = loop_response(model, w, i_ratio, d_ratio, current['FLTE'], current['FLTD'])
+        for p in P_GAINS:
+            m = margins(mag, phase, w, p)
+            if m is None or m[1] < args.phase_margin or m[2] < args.gain_margin:
+                continue
+            if best is None or m[0] > best['crossover']:
+                best = {'P': p, 'I': p * i_ratio, 'D': p * d_ratio,
+                        'crossover': m[0], 'phase_margin': m[1], 'gain_margin': m[2]}
+
+    # margins of the current gains for comparison
+    mag, phase = loop_response(model, w, i_ratio, current['D'] / current['P'] if current['P'] > 0 else 0.0,
+                               current['FLTE'], current['FLTD'])
+    return best, margins(mag, phase, w, current['P'])
+
+
+def tune_log(filename):
+    '''propose gains for each axis from one log'''
+    try:
+        rate, sidd, params = load_log(filename)
+    except Exception as ex:
+        return filename, "failed to load: %s" % ex
+    if len(rate['TimeUS']) < 2:
+        return filename, "no RATE messages"
+
+    fs = 1.0e6 / np.median(np.diff(rate['TimeUS']))
+    if fs < MIN_SAMPLE_RATE:
+        return filename, "RATE logged at %.0fHz, enable ATTITUDE_FAST logging" % fs
+    add_instruments(rate, sidd)
+    segments = flying_segments(rate, fs, int(args.window * fs))
+    if len(segments) == 0:
+        return filename, "no flying data"
+
+    results = {}
+    for axis in args.axes.split(','):
+        prefix = AXES[axis][3]
+        current = {}
+        for k, default in DEFAULT_GAINS[axis].items():
+            current[k] = params.get(prefix + k, default)
+        model = identify(segments, fs, axis)
+        if model is None:
+            results[axis] = {'error': "insufficient excitation"}
+            continue
+        best, now = design(model, fs, current, axis)
+        results[axis] = {'model': model, 'current': current, 'current_margins': now, 'proposed': best}
+    return filename, results
+
+
+def report(filename, results):
+    '''print the proposed gains and optionally write them to a parameter file'''
+    print("%s:" % filename)
+    if not isinstance(results, dict):
+        print("  %s" % results)
+        return
+    lines = []
+    for axis, r in results.items():
+        if 'error' in r:
+            print("  %-5s %s" % (axis, r['error']))
+            continue
+        model = r['model']
+        print("  %-5s plant gain %.1f delay %.1fms coherence %.2f (%.1f-%.1fHz)" %
+              (axis, model['gain'], model['delay'] * 1000.0, model['coherence'], model['freq_min'], model['freq_max']))
+        current = r['current']
+        now = r['current_margins']
+        if now is not None:
+            print("        current  P %.4f I %.4f D %.5f crossover %.1fHz PM %.0fdeg GM %.1fdB" %
+                  (current['P'], current['I'], current['D'], now[0], now[1], now[2]))
+        best = r['proposed']
+        if best is None:
+            print("        no gains meet the margins")
+            continue
+        print("        proposed P %.4f I %.4f D %.5f crossover %.1fHz PM %.0fdeg GM %.1fdB" %
+              (best['P'], best['I'], best['D'], best['crossover'], best['phase_margin'], best['gain_margin']))
+        prefix = AXES[axis][3]
+        for k in ('P', 'I', 'D'):
+            lines.append("%s%s %.5f\n" % (prefix, k, best[k]))
+
+    if args.param_out is not None and len(lines) > 0:
+        if not os.path.isdir(args.param_out):
+            os.makedirs(args.param_out)
+        name = os.path.splitext(os.path.basename(filename))[0] + ".param"
+        with open(os.path.join(args.param_out, name), 'w') as f:
+            f.writelines(lines)
+
+
+if __name__ == '__main__':
+    for axis in args.axes.split(','):
+        if axis not in AXES:
+            print("Unknown axis %s" % axis)
+            sys.exit(1)
+
+    logs = find_logs(args.logs)
+    if args.jobs > 1 and len(logs) > 1:
+        pool = multiprocessing.Pool(min(args.jobs, len(logs)))
+        results = pool.imap(tune_log, logs)
+    else:
+        results = map(tune_log, logs)
+    for filename, result in results:
+        report(filename, result)
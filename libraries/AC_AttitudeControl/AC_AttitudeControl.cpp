@@ -164,9 +164,12 @@ void AC_AttitudeControl::relax_attitude_controllers()
     _thrust_error_angle = 0.0f;
 
     // Reset the PID filters
-    get_rate_roll_pid().reset_filter();
-    get_rate_pitch_pid().reset_filter();
-    get_rate_yaw_pid().reset_filter();
+    {
+        WITH_SEMAPHORE(_rate_pid_sem);
+        get_rate_roll_pid().reset_filter();
+        get_rate_pitch_pid().reset_filter();
+        get_rate_yaw_pid().reset_filter();
+    }
 
     // Reset the I terms
     reset_rate_controller_I_terms();
@@ -174,6 +177,8 @@ void AC_AttitudeControl::relax_attitude_controllers()
 
 void AC_AttitudeControl::reset_rate_controller_I_terms()
 {
+    WITH_SEMAPHORE(_rate_pid_sem);
+
     get_rate_roll_pid().reset_I();
     get_rate_pitch_pid().reset_I();
     get_rate_yaw_pid().reset_I();
@@ -4,6 +4,7 @@
 /// @brief   ArduCopter attitude control library
 
 #include <AP_Common/AP_Common.h>
+#include <AP_HAL/AP_HAL.h>
 #include <AP_Param/AP_Param.h>
 #include <AP_Math/AP_Math.h>
 #include <AP_AHRS/AP_AHRS_View.h>
@@ -74,6 +75,10 @@ public:
     virtual AC_PID& get_rate_pitch_pid() = 0;
     virtual AC_PID& get_rate_yaw_pid() = 0;
 
+    // semaphore protecting the rate PIDs' state when they are updated outside the main loop
+    //  should be held while calling any rate PID method other than the gain accessors
+    HAL_Semaphore &get_rate_pid_semaphore() { return _rate_pid_sem; }
+
     // get the roll acceleration limit in centidegrees/s/s or radians/s/s
     float get_accel_roll_max() const { return _accel_roll_max; }
     float get_accel_roll_max_radss() const { return radians(_accel_roll_max * 0.01f); }
@@ -192,6 +197,24 @@ public:
     // Set z-axis angular velocity in centidegrees/s
     void rate_bf_yaw_target(float rate_cds) { _rate_target_ang_vel.z = radians(rate_cds * 0.01f); }
 
+    // Set x-axis system identification angular velocity in radians/s, added to the rate target of the next rate controller run
+    void rate_bf_roll_sysid(float rate) { _sysid_ang_vel_body.x = rate; }
+
+    // Set y-axis system identification angular velocity in radians/s, added to the rate target of the next rate controller run
+    void rate_bf_pitch_sysid(float rate) { _sysid_ang_vel_body.y = rate; }
+
+    // Set z-axis system identification angular velocity in radians/s, added to the rate target of the next rate controller run
+    void rate_bf_yaw_sysid(float rate) { _sysid_ang_vel_body.z = rate; }
+
+    // Set x-axis system identification actuator, added to the roll output of the next rate controller run
+    void actuator_roll_sysid(float command) { _actuator_sysid.x = command; }
+
+    // Set y-axis system identification actuator, added to the pitch output of the next rate controller run
+    void actuator_pitch_sysid(float command) { _actuator_sysid.y = command; }
+
+    // Set z-axis system identification actuator, added to the yaw output of the next rate controller run
+    void actuator_yaw_sysid(float command) { _actuator_sysid.z = command; }
+
     // Return roll rate step size in radians/s that results in maximum output after 4 time steps
     float max_rate_step_bf_roll();
 
@@ -380,6 +403,14 @@ protected:
     // velocity controller.
     Vector3f            _rate_target_ang_vel;
 
+    // This represents the system identification angular velocity in radians per second in the body frame,
+    // added to the angular velocity controller's target.  Cleared each time the rate controller runs.
+    Vector3f            _sysid_ang_vel_body;
+
+    // This represents the system identification commands added to the roll, pitch and yaw outputs
+    // of the angular velocity controller.  Cleared each time the rate controller runs.
+    Vector3f            _actuator_sysid;
+
     // This represents a quaternion attitude error in the body frame, used for inertial frame reset handling.
     Quaternion          _attitude_ang_error;
 
@@ -411,6 +442,9 @@ protected:
     const AP_Vehicle::MultiCopter &_aparm;
     AP_Motors&          _motors;
 
+    // protects the rate PIDs' state
+    HAL_Semaphore       _rate_pid_sem;
+
 protected:
     /*
       state of control monitoring
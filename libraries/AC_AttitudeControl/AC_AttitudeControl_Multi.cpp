@@ -327,20 +327,141 @@ void AC_AttitudeControl_Multi::rate_controller_run()
     // move throttle vs attitude mixing towards desired (called from here because this is conveniently called on every iteration)
     update_throttle_rpy_mix();
 
+    WITH_SEMAPHORE(_rate_pid_sem);
+
+    if (_rate_target_buffer != nullptr) {
+        // the rate thread runs the rate PIDs, send its latest outputs to the motors
+        if (_rate_thread_output.sample_us != 0) {
+            const uint32_t latency_us = AP_HAL::micros() - _rate_thread_output.sample_us;
+            _rate_thread_latency.sum_us += latency_us;
+            _rate_thread_latency.max_us = MAX(_rate_thread_latency.max_us, latency_us);
+            _rate_thread_latency.count++;
+        }
+        _motors.set_roll(_rate_thread_output.out.x);
+        _motors.set_roll_ff(_rate_thread_output.ff.x);
+        _motors.set_pitch(_rate_thread_output.out.y);
+        _motors.set_pitch_ff(_rate_thread_output.ff.y);
+        _motors.set_yaw(_rate_thread_output.out.z);
+        _motors.set_yaw_ff(_rate_thread_output.ff.z);
+        control_monitor_update();
+        return;
+    }
+
     Vector3f gyro_latest = _ahrs.get_gyro_latest();
+    const Vector3f rate_target = _rate_target_ang_vel + _sysid_ang_vel_body;
 
-    _motors.set_roll(get_rate_roll_pid().update_all(_rate_target_ang_vel.x, gyro_latest.x, _motors.limit.roll));
+    _motors.set_roll(get_rate_roll_pid().update_all(rate_target.x, gyro_latest.x, _motors.limit.roll) + _actuator_sysid.x);
     _motors.set_roll_ff(get_rate_roll_pid().get_ff());
 
-    _motors.set_pitch(get_rate_pitch_pid().update_all(_rate_target_ang_vel.y, gyro_latest.y, _motors.limit.pitch));
+    _motors.set_pitch(get_rate_pitch_pid().update_all(rate_target.y, gyro_latest.y, _motors.limit.pitch) + _actuator_sysid.y);
     _motors.set_pitch_ff(get_rate_pitch_pid().get_ff());
 
-    _motors.set_yaw(get_rate_yaw_pid().update_all(_rate_target_ang_vel.z, gyro_latest.z, _motors.limit.yaw));
+    _motors.set_yaw(get_rate_yaw_pid().update_all(rate_target.z, gyro_latest.z, _motors.limit.yaw) + _actuator_sysid.z);
     _motors.set_yaw_ff(get_rate_yaw_pid().get_ff());
 
+    _sysid_ang_vel_body.zero();
+    _actuator_sysid.zero();
+
     control_monitor_update();
 }
 
+// start handing rate targets to rate PIDs running in their own thread
+bool AC_AttitudeControl_Multi::enable_rate_thread(void)
+{
+    if (_rate_target_buffer != nullptr) {
+        return true;
+    }
+    ObjectBuffer<rate_thread_target> *buffer = new ObjectBuffer<rate_thread_target>(AC_ATTITUDE_CONTROL_RATE_THREAD_BUFFER_SIZE);
+    if (buffer == nullptr || buffer->space() == 0) {
+        delete buffer;
+        return false;
+    }
+    _rate_thread_target.rate_target = _rate_target_ang_vel;
+    _rate_thread_target.gyro_drift = _ahrs.get_gyro_drift();
+    _rate_thread_target.actuator_sysid.zero();
+    _rate_thread_dt = _dt;
+    _rate_target_buffer = buffer;
+    return true;
+}
+
+// go back to running the rate PIDs in rate_controller_run()
+void AC_AttitudeControl_Multi::disable_rate_thread(void)
+{
+    delete _rate_target_buffer;
+    _rate_target_buffer = nullptr;
+}
+
+// publish the latest rate targets to the rate thread
+void AC_AttitudeControl_Multi::publish_rate_targets()
+{
+    if (_rate_target_buffer == nullptr) {
+        return;
+    }
+    const rate_thread_target target {
+        _rate_target_ang_vel + _sysid_ang_vel_body,
+        _ahrs.get_gyro_drift(),
+        _actuator_sysid,
+        _motors.limit.roll,
+        _motors.limit.pitch,
+        _motors.limit.yaw
+    };
+    _rate_target_buffer->push(target);
+
+    _sysid_ang_vel_body.zero();
+    _actuator_sysid.zero();
+}
+
+// run the rate PIDs from the rate thread using a gyro sample taken dt seconds after the previous one
+//  the rate thread is the only reader of the target buffer and the only caller of the rate PIDs' update
+void AC_AttitudeControl_Multi::rate_controller_run_thread(const Vector3f &gyro, float dt)
+{
+    if (_rate_target_buffer == nullptr) {
+        return;
+    }
+
+    // use the newest targets published by the main loop
+    rate_thread_target target;
+    while (_rate_target_buffer->pop(target)) {
+        _rate_thread_target = target;
+    }
+    const rate_thread_target &t = _rate_thread_target;
+    const Vector3f gyro_corrected = _ahrs.correct_gyro_sample(gyro, t.gyro_drift);
+
+    WITH_SEMAPHORE(_rate_pid_sem);
+
+    _rate_thread_output.sample_us = AP_HAL::micros();
+
+    // rate PIDs run at the rate thread's rate rather than the main loop rate
+    if (!is_equal(dt, _rate_thread_dt)) {
+        get_rate_roll_pid().set_dt(dt);
+        get_rate_pitch_pid().set_dt(dt);
+        get_rate_yaw_pid().set_dt(dt);
+        _rate_thread_dt = dt;
+    }
+
+    _rate_thread_output.out.x = get_rate_roll_pid().update_all(t.rate_target.x, gyro_corrected.x, t.limit_roll) + t.actuator_sysid.x;
+    _rate_thread_output.ff.x = get_rate_roll_pid().get_ff();
+
+    _rate_thread_output.out.y = get_rate_pitch_pid().update_all(t.rate_target.y, gyro_corrected.y, t.limit_pitch) + t.actuator_sysid.y;
+    _rate_thread_output.ff.y = get_rate_pitch_pid().get_ff();
+
+    _rate_thread_output.out.z = get_rate_yaw_pid().update_all(t.rate_target.z, gyro_corrected.z, t.limit_yaw) + t.actuator_sysid.z;
+    _rate_thread_output.ff.z = get_rate_yaw_pid().get_ff();
+}
+
+// get the mean and maximum time from the rate thread running the rate PIDs
+// to their outputs being sent to the motors since the last call
+void AC_AttitudeControl_Multi::get_rate_thread_latency(uint32_t &mean_us, uint32_t &max_us)
+{
+    WITH_SEMAPHORE(_rate_pid_sem);
+
+    mean_us = _rate_thread_latency.count > 0 ? _rate_thread_latency.sum_us / _rate_thread_latency.count : 0;
+    max_us = _rate_thread_latency.max_us;
+    _rate_thread_latency.sum_us = 0;
+    _rate_thread_latency.max_us = 0;
+    _rate_thread_latency.count = 0;
+}
+
 // sanity check parameters.  should be called once before takeoff
 void AC_AttitudeControl_Multi::parameter_sanity_check()
 {
@@ -5,6 +5,7 @@
 
 #include "AC_AttitudeControl.h"
 #include <AP_Motors/AP_MotorsMulticopter.h>
+#include <AP_HAL/utility/RingBuffer.h>
 
 // default rate controller PID gains
 #ifndef AC_ATC_MULTI_RATE_RP_P
@@ -38,6 +39,8 @@
  # define AC_ATC_MULTI_RATE_YAW_FILT_HZ     2.5f
 #endif
 
+#define AC_ATTITUDE_CONTROL_RATE_THREAD_BUFFER_SIZE 4   // rate targets queued for the rate thread
+
 
 class AC_AttitudeControl_Multi : public AC_AttitudeControl {
 public:
@@ -75,6 +78,24 @@ public:
     // run lowest level body-frame rate controller and send outputs to the motors
     void rate_controller_run() override;
 
+    // start handing rate targets to rate PIDs running in their own thread
+    //  once enabled rate_controller_run() sends the thread's latest outputs to the motors
+    bool enable_rate_thread(void);
+
+    // go back to running the rate PIDs in rate_controller_run().  must not be called once the rate thread is running
+    void disable_rate_thread(void);
+
+    // publish the latest rate targets to the rate thread.  should be called by the main loop after the attitude controllers have run
+    void publish_rate_targets();
+
+    // run the rate PIDs from the rate thread using a gyro sample taken dt seconds after the previous one
+    //  the outputs are only stored for the main loop, the thread never touches the motors
+    void rate_controller_run_thread(const Vector3f &gyro, float dt);
+
+    // get the mean and maximum time from the rate thread running the rate PIDs to their outputs
+    //  being sent to the motors by rate_controller_run(), and start measuring again
+    void get_rate_thread_latency(uint32_t &mean_us, uint32_t &max_us);
+
     // sanity check parameters.  should be called once before take-off
     void parameter_sanity_check() override;
 
@@ -97,4 +118,31 @@ protected:
     AP_Float              _thr_mix_man;     // throttle vs attitude control prioritisation used when using manual throttle (higher values mean we prioritise attitude control over throttle)
     AP_Float              _thr_mix_min;     // throttle vs attitude control prioritisation used when landing (higher values mean we prioritise attitude control over throttle)
     AP_Float              _thr_mix_max;     // throttle vs attitude control prioritisation used during active flight (higher values mean we prioritise attitude control over throttle)
+
+    // rate targets handed from the main loop to the rate thread without locking
+    struct rate_thread_target {
+        Vector3f rate_target;       // body frame rate targets in radians/s
+        Vector3f gyro_drift;        // gyro drift estimate to be added to the gyro samples
+        Vector3f actuator_sysid;    // system identification commands added to the roll, pitch and yaw outputs
+        bool limit_roll;            // motor limits as of the last motor output, used to stop the I terms winding up
+        bool limit_pitch;
+        bool limit_yaw;
+    };
+    ObjectBuffer<rate_thread_target> *_rate_target_buffer;
+    rate_thread_target    _rate_thread_target;  // latest targets received by the rate thread
+    float                 _rate_thread_dt;      // time step last used by the rate PIDs in the rate thread
+
+    // latest rate PID outputs from the rate thread, protected by the rate PID semaphore
+    struct {
+        Vector3f out;               // roll, pitch and yaw outputs including the system identification commands
+        Vector3f ff;                // roll, pitch and yaw feed forward
+        uint32_t sample_us;         // system time the outputs were calculated
+    } _rate_thread_output;
+
+    // time from the rate thread's outputs being calculated to being sent to the motors
+    struct {
+        uint32_t sum_us;
+        uint32_t max_us;
+        uint32_t count;
+    } _rate_thread_latency;
 };
@@ -224,6 +224,10 @@ public:
     /// freeze_ff_z - used to stop the feed forward being calculated during a known discontinuity
     void freeze_ff_z() { _flags.freeze_ff_z = true; }
 
+    /// freeze_desired_vel_to_pos - stop the next update_xy_controller moving the position target by the desired velocity
+    ///     used when the position target is set each iteration along with the desired velocity it already accounts for
+    void freeze_desired_vel_to_pos() { _flags.reset_desired_vel_to_pos = true; }
+
     // is_active_xy - returns true if the xy position controller has been run very recently
     bool is_active_xy() const;
 
@@ -397,12 +397,13 @@ void AC_Avoid::adjust_velocity_polygon_fence(float kP, float accel_cmss, Vector2
         return;
     }
 
-    // get polygon boundary
-    uint16_t num_points;
-    const Vector2f* boundary = _fence.get_boundary_points(num_points);
+    // exit if there is no valid polygon fence
+    if (!_fence.is_polygon_valid()) {
+        return;
+    }
 
-    // adjust velocity using polygon
-    adjust_velocity_polygon(kP, accel_cmss, desired_vel_cms, boundary, num_points, true, _fence.get_margin(), dt);
+    // adjust velocity using the fence zones
+    adjust_velocity_zones(kP, accel_cmss, desired_vel_cms, _fence.get_zones(), _fence.get_margin(), dt);
 }
 
 /*
@@ -449,7 +450,9 @@ void AC_Avoid::adjust_velocity_proximity(float kP, float accel_cmss, Vector2f &d
         return;
     }
 
-    // get boundary from proximity sensor
+    // get boundary from proximity sensor.  This is the horizontal polygon of the sensor's 3D
+    // boundary, holding the closest object in each sector from all but the top and bottom layers,
+    // and is maintained by the sensor driver as readings arrive so no per-loop work is needed here
     uint16_t num_points;
     const Vector2f *boundary = _proximity.get_boundary_points(num_points);
     adjust_velocity_polygon(kP, accel_cmss, desired_vel_cms, boundary, num_points, false, _margin, dt);
@@ -511,45 +514,10 @@ void AC_Avoid::adjust_velocity_polygon(float kP, float accel_cmss, Vector2f &des
             j = 0;
         }
         // end points of current edge
-        Vector2f start = boundary[j];
-        Vector2f end = boundary[i];
-        if ((AC_Avoid::BehaviourType)_behavior.get() == BEHAVIOR_SLIDE) {
-            // vector from current position to closest point on current edge
-            Vector2f limit_direction = Vector2f::closest_point(position_xy, start, end) - position_xy;
-            // distance to closest point
-            const float limit_distance_cm = limit_direction.length();
-            if (!is_zero(limit_distance_cm)) {
-                // We are strictly inside the given edge.
-                // Adjust velocity to not violate this edge.
-                limit_direction /= limit_distance_cm;
-                limit_velocity(kP, accel_cmss, safe_vel, limit_direction, MAX(limit_distance_cm - margin_cm, 0.0f), dt);
-            } else {
-                // We are exactly on the edge - treat this as a fence breach.
-                // i.e. do not adjust velocity.
-                return;
-            }
-        } else {
-            // find intersection with line segment
-            Vector2f intersection;
-            if (Vector2f::segment_intersection(position_xy, stopping_point_plus_margin, start, end, intersection)) {
-                // vector from current position to point on current edge
-                Vector2f limit_direction = intersection - position_xy;
-                const float limit_distance_cm = limit_direction.length();
-                if (!is_zero(limit_distance_cm)) {
-                    if (limit_distance_cm <= margin_cm) {
-                        // we are within the margin so stop vehicle
-                        safe_vel.zero();
-                    } else {
-                        // vehicle inside the given edge, adjust velocity to not violate this edge
-                        limit_direction /= limit_distance_cm;
-                        limit_velocity(kP, accel_cmss, safe_vel, limit_direction, MAX(limit_distance_cm - margin_cm, 0.0f), dt);
-                    }
-                } else {
-                    // We are exactly on the edge - treat this as a fence breach.
-                    // i.e. do not adjust velocity.
-                    return;
-                }
-            }
+        if (!limit_velocity_edge(kP, accel_cmss, safe_vel, position_xy, stopping_point_plus_margin, boundary[j], boundary[i], margin_cm, dt)) {
+            // We are exactly on the edge - treat this as a fence breach.
+            // i.e. do not adjust velocity.
+            return;
         }
     }
 
@@ -563,6 +531,115 @@ void AC_Avoid::adjust_velocity_polygon(float kP, float accel_cmss, Vector2f &des
     }
 }
 
+/*
+ * Limits safe_vel so the vehicle does not cross the edge from start to end.
+ * Returns false if the vehicle is exactly on the edge
+ */
+bool AC_Avoid::limit_velocity_edge(float kP, float accel_cmss, Vector2f &safe_vel, const Vector2f &position_xy, const Vector2f &stopping_point_plus_margin,
+                                   const Vector2f &start, const Vector2f &end, float margin_cm, float dt) const
+{
+    if ((AC_Avoid::BehaviourType)_behavior.get() == BEHAVIOR_SLIDE) {
+        // vector from current position to closest point on current edge
+        Vector2f limit_direction = Vector2f::closest_point(position_xy, start, end) - position_xy;
+        // distance to closest point
+        const float limit_distance_cm = limit_direction.length();
+        if (is_zero(limit_distance_cm)) {
+            return false;
+        }
+        // We are strictly inside the given edge.
+        // Adjust velocity to not violate this edge.
+        limit_direction /= limit_distance_cm;
+        limit_velocity(kP, accel_cmss, safe_vel, limit_direction, MAX(limit_distance_cm - margin_cm, 0.0f), dt);
+        return true;
+    }
+
+    // find intersection with line segment
+    Vector2f intersection;
+    if (Vector2f::segment_intersection(position_xy, stopping_point_plus_margin, start, end, intersection)) {
+        // vector from current position to point on current edge
+        Vector2f limit_direction = intersection - position_xy;
+        const float limit_distance_cm = limit_direction.length();
+        if (is_zero(limit_distance_cm)) {
+            return false;
+        }
+        if (limit_distance_cm <= margin_cm) {
+            // we are within the margin so stop vehicle
+            safe_vel.zero();
+        } else {
+            // vehicle inside the given edge, adjust velocity to not violate this edge
+            limit_direction /= limit_distance_cm;
+            limit_velocity(kP, accel_cmss, safe_vel, limit_direction, MAX(limit_distance_cm - margin_cm, 0.0f), dt);
+        }
+    }
+    return true;
+}
+
+/*
+ * Adjusts the desired velocity for the fence inclusion and exclusion zones.
+ * The spatial index limits the search to edges the vehicle could reach
+ * before stopping, so the cost does not grow with the size of the fence
+ */
+void AC_Avoid::adjust_velocity_zones(float kP, float accel_cmss, Vector2f &desired_vel_cms, const AC_FenceZones &zones, float margin, float dt)
+{
+    // exit immediately if no desired velocity
+    if (desired_vel_cms.is_zero()) {
+        return;
+    }
+
+    Vector2f position_xy;
+    if (!AP::ahrs().get_relative_position_NE_origin(position_xy)) {
+        // zones are in earth frame but we have no idea where we are
+        return;
+    }
+    position_xy = position_xy * 100.0f;  // m to cm
+
+    // do not adjust velocity if vehicle is outside the fence
+    if (zones.breached(position_xy)) {
+        return;
+    }
+
+    Vector2f safe_vel(desired_vel_cms);
+
+    // calc margin in cm
+    const float margin_cm = MAX(margin * 100.0f, 0.0f);
+
+    // for stopping
+    const float speed = safe_vel.length();
+    const float search_dist_cm = 2.0f + margin_cm + get_stopping_distance(kP, accel_cmss, speed);
+    const Vector2f stopping_point_plus_margin = position_xy + safe_vel*(search_dist_cm/speed);
+
+    bool on_edge = false;
+    zones.for_each_edge_near(position_xy, search_dist_cm, [&](const Vector2f &start, const Vector2f &end, uint8_t) {
+        if (!on_edge &&
+            !limit_velocity_edge(kP, accel_cmss, safe_vel, position_xy, stopping_point_plus_margin, start, end, margin_cm, dt)) {
+            on_edge = true;
+        }
+    });
+    if (on_edge) {
+        // We are exactly on an edge - treat this as a fence breach.
+        // i.e. do not adjust velocity.
+        return;
+    }
+
+    // circles are limited along the line through their centre
+    for (uint8_t i=0; i<zones.num_circles(); i++) {
+        const AC_FenceZones::Circle &circle = zones.circle(i);
+        Vector2f limit_direction = position_xy - circle.center;
+        const float dist_to_center = limit_direction.length();
+        const float limit_distance_cm = circle.inclusion ? circle.radius - dist_to_center : dist_to_center - circle.radius;
+        if (is_zero(dist_to_center) || limit_distance_cm > search_dist_cm) {
+            continue;
+        }
+        limit_direction /= dist_to_center;
+        if (!circle.inclusion) {
+            limit_direction = -limit_direction;
+        }
+        limit_velocity(kP, accel_cmss, safe_vel, limit_direction, MAX(limit_distance_cm - margin_cm, 0.0f), dt);
+    }
+
+    desired_vel_cms = safe_vel;
+}
+
 /*
  * Computes distance required to stop, given current speed.
  *
@@ -112,6 +112,20 @@ private:
      */
     void adjust_velocity_polygon(float kP, float accel_cmss, Vector2f &desired_vel_cms, const Vector2f* boundary, uint16_t num_points, bool earth_frame, float margin, float dt);
 
+    /*
+     * Adjusts the desired velocity for the fence inclusion and exclusion zones.
+     * Only edges within stopping distance of the vehicle are considered
+     *   margin is the distance (in meters) that the vehicle should stop short of the zones
+     */
+    void adjust_velocity_zones(float kP, float accel_cmss, Vector2f &desired_vel_cms, const class AC_FenceZones &zones, float margin, float dt);
+
+    /*
+     * Limits safe_vel so the vehicle does not cross the edge from start to end.
+     * Returns false if the vehicle is exactly on the edge
+     */
+    bool limit_velocity_edge(float kP, float accel_cmss, Vector2f &safe_vel, const Vector2f &position_xy, const Vector2f &stopping_point_plus_margin,
+                             const Vector2f &start, const Vector2f &end, float margin_cm, float dt) const;
+
     /*
      * Computes distance required to stop, given current speed.
      */
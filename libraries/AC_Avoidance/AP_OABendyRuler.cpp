@@ -19,11 +19,18 @@
 #include <AP_AHRS/AP_AHRS.h>
 #include <AP_Logger/AP_Logger.h>
 
-const int16_t OA_BENDYRULER_BEARING_INC = 5;            // check every 5 degrees around vehicle
 const float OA_BENDYRULER_LOOKAHEAD_STEP2_RATIO = 1.0f; // step2's lookahead length as a ratio of step1's lookahead length
 const float OA_BENDYRULER_LOOKAHEAD_STEP2_MIN = 2.0f;   // step2 checks at least this many meters past step1's location
 const float OA_BENDYRULER_LOOKAHEAD_PAST_DEST = 2.0f;   // lookahead length will be at least this many meters past the destination
 const float OA_BENDYRULER_LOW_SPEED_SQUARED = (0.2f * 0.2f);    // when ground course is below this speed squared, vehicle's heading will be used
+const float OA_BENDYRULER_OBSTACLE_SEARCH_MARGIN = 1.0f;    // obstacles are gathered this many meters beyond the furthest point that could affect the result
+const uint16_t OA_BENDYRULER_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK = 32;  // obstacle arrays grow in increments of this many elements
+
+AP_OABendyRuler::AP_OABendyRuler() :
+    _fence_edges(OA_BENDYRULER_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK),
+    _objects(OA_BENDYRULER_EXPANDING_ARRAY_ELEMENTS_PER_CHUNK)
+{
+}
 
 // run background task to find best path and update avoidance_results
 // returns true and updates origin_new and destination_new if a best path has been found
@@ -58,69 +65,96 @@ bool AP_OABendyRuler::update(const Location& current_loc, const Location& destin
     // check OA_BEARING_INC definition allows checking in all directions
     static_assert(360 % OA_BENDYRULER_BEARING_INC == 0, "check 360 is a multiple of OA_BEARING_INC");
 
-    // search in OA_BENDYRULER_BEARING_INC degree increments around the vehicle alternating left
-    // and right. For each direction check if vehicle would avoid all obstacles
-    float best_bearing = bearing_to_dest;
-    bool have_best_bearing = false;
-    float best_margin = -FLT_MAX;
-    float best_margin_bearing = best_bearing;
-
+    // calculate bearings to probe in OA_BENDYRULER_BEARING_INC degree increments around the vehicle alternating
+    // left and right, and the step1 test positions as offsets (in meters) from the vehicle
+    float bearings[OA_BENDYRULER_BEARINGS_MAX];
+    Vector2f test_pos[OA_BENDYRULER_BEARINGS_MAX];
+    uint8_t num_bearings = 0;
     for (uint8_t i = 0; i <= (170 / OA_BENDYRULER_BEARING_INC); i++) {
         for (uint8_t bdir = 0; bdir <= 1; bdir++) {
             // skip duplicate check of bearing straight towards destination
             if ((i==0) && (bdir > 0)) {
                 continue;
             }
-            // bearing that we are probing
             const float bearing_delta = i * OA_BENDYRULER_BEARING_INC * (bdir == 0 ? -1.0f : 1.0f);
-            const float bearing_test = wrap_180(bearing_to_dest + bearing_delta);
+            bearings[num_bearings] = wrap_180(bearing_to_dest + bearing_delta);
+            const float bearing_rad = radians(bearings[num_bearings]);
+            test_pos[num_bearings] = Vector2f(cosf(bearing_rad), sinf(bearing_rad)) * lookahead_step1_dist;
+            num_bearings++;
+        }
+    }
+
+    // gather obstacles once. No test segment reaches further than the step1 and step2 lookaheads
+    // so obstacles further than this plus the maximum margin cannot change the result. Object
+    // margins are reduced by the database accuracy, so objects up to that much further can
+#if !HAL_MINIMIZE_FEATURES
+    const AP_OADatabase *oaDb = AP::oadatabase();
+    const float object_accuracy = (oaDb != nullptr) ? oaDb->get_accuracy() : 0.0f;
+#else
+    const float object_accuracy = 0.0f;
+#endif
+    const float obstacle_radius = lookahead_step1_dist + MAX(lookahead_step2_dist, OA_BENDYRULER_LOOKAHEAD_STEP2_MIN) + _margin_max + object_accuracy + OA_BENDYRULER_OBSTACLE_SEARCH_MARGIN;
+    update_obstacles(current_loc, obstacle_radius, test_pos, num_bearings);
+
+    // calculate margin from obstacles for all step1 bearings in one pass
+    float margins[OA_BENDYRULER_BEARINGS_MAX];
+    calc_avoidance_margins(Vector2f(), _vehicle_outside_polygons, test_pos, num_bearings, margins);
+
+    // for each direction check if vehicle would avoid all obstacles
+    const Vector2f destination_NE = current_loc.get_distance_NE(destination);
+    float best_bearing = bearing_to_dest;
+    bool have_best_bearing = false;
+    float best_margin = -FLT_MAX;
+    float best_margin_bearing = best_bearing;
 
-            // ToDo: add effective groundspeed calculations using airspeed
-            // ToDo: add prediction of vehicle's position change as part of turn to desired heading
+    for (uint8_t k = 0; k < num_bearings; k++) {
+        // bearing that we are probing
+        const float bearing_test = bearings[k];
+        const float margin = margins[k];
 
-            // test location is projected from current location at test bearing
-            Location test_loc = current_loc;
-            test_loc.offset_bearing(bearing_test, lookahead_step1_dist);
+        // ToDo: add effective groundspeed calculations using airspeed
+        // ToDo: add prediction of vehicle's position change as part of turn to desired heading
 
-            // calculate margin from fence for this scenario
-            float margin = calc_avoidance_margin(current_loc, test_loc);
-            if (margin > best_margin) {
-                best_margin_bearing = bearing_test;
-                best_margin = margin;
+        if (margin > best_margin) {
+            best_margin_bearing = bearing_test;
+            best_margin = margin;
+        }
+        if (margin > _margin_max) {
+            // this bearing avoids obstacles out to the lookahead_step1_dist
+            // now check in there is a clear path in three directions towards the destination
+            if (!have_best_bearing) {
+                best_bearing = bearing_test;
+                have_best_bearing = true;
+            } else if (fabsf(wrap_180(ground_course_deg - bearing_test)) <
+                       fabsf(wrap_180(ground_course_deg - best_bearing))) {
+                // replace bearing with one that is closer to our current ground course
+                best_bearing = bearing_test;
+            }
+
+            // perform second stage test in three directions looking for obstacles
+            const float test_bearings[] { 0.0f, 45.0f, -45.0f };
+            const Vector2f test_to_dest = destination_NE - test_pos[k];
+            const float bearing_to_dest2 = degrees(atan2f(test_to_dest.y, test_to_dest.x));
+            const float distance2 = constrain_float(lookahead_step2_dist, OA_BENDYRULER_LOOKAHEAD_STEP2_MIN, test_to_dest.length());
+            Vector2f test_pos2[ARRAY_SIZE(test_bearings)];
+            for (uint8_t j = 0; j < ARRAY_SIZE(test_bearings); j++) {
+                const float bearing_rad2 = radians(wrap_180(bearing_to_dest2 + test_bearings[j]));
+                test_pos2[j] = test_pos[k] + Vector2f(cosf(bearing_rad2), sinf(bearing_rad2)) * distance2;
             }
-            if (margin > _margin_max) {
-                // this bearing avoids obstacles out to the lookahead_step1_dist
-                // now check in there is a clear path in three directions towards the destination
-                if (!have_best_bearing) {
-                    best_bearing = bearing_test;
-                    have_best_bearing = true;
-                } else if (fabsf(wrap_180(ground_course_deg - bearing_test)) <
-                           fabsf(wrap_180(ground_course_deg - best_bearing))) {
-                    // replace bearing with one that is closer to our current ground course
-                    best_bearing = bearing_test;
-                }
 
-                // perform second stage test in three directions looking for obstacles
-                const float test_bearings[] { 0.0f, 45.0f, -45.0f };
-                const float bearing_to_dest2 = test_loc.get_bearing_to(destination) * 0.01f;
-                float distance2 = constrain_float(lookahead_step2_dist, OA_BENDYRULER_LOOKAHEAD_STEP2_MIN, test_loc.get_distance(destination));
-                for (uint8_t j = 0; j < ARRAY_SIZE(test_bearings); j++) {
-                    float bearing_test2 = wrap_180(bearing_to_dest2 + test_bearings[j]);
-                    Location test_loc2 = test_loc;
-                    test_loc2.offset_bearing(bearing_test2, distance2);
-
-                    // calculate minimum margin to fence and obstacles for this scenario
-                    float margin2 = calc_avoidance_margin(test_loc, test_loc2);
-                    if (margin2 > _margin_max) {
-                        // all good, now project in the chosen direction by the full distance
-                        destination_new = current_loc;
-                        destination_new.offset_bearing(bearing_test, distance_to_dest);
-                        _current_lookahead = MIN(_lookahead, _current_lookahead * 1.1f);
-                        // if the chosen direction is directly towards the destination turn off avoidance
-                        const bool active = (i != 0 || j != 0);
-                        AP::logger().Write_OABendyRuler(active, bearing_to_dest, margin, destination, destination_new);
-                        return active;
-                    }
+            // calculate minimum margin to fence and obstacles for these scenarios
+            float margins2[ARRAY_SIZE(test_bearings)];
+            calc_avoidance_margins(test_pos[k], _position_outside_polygons[k], test_pos2, ARRAY_SIZE(test_bearings), margins2);
+            for (uint8_t j = 0; j < ARRAY_SIZE(test_bearings); j++) {
+                if (margins2[j] > _margin_max) {
+                    // all good, now project in the chosen direction by the full distance
+                    destination_new = current_loc;
+                    destination_new.offset_bearing(bearing_test, distance_to_dest);
+                    _current_lookahead = MIN(_lookahead, _current_lookahead * 1.1f);
+                    // if the chosen direction is directly towards the destination turn off avoidance
+                    const bool active = (k != 0 || j != 0);
+                    AP::logger().Write_OABendyRuler(active, bearing_to_dest, margin, destination, destination_new);
+                    return active;
                 }
             }
         }
@@ -149,129 +183,226 @@ bool AP_OABendyRuler::update(const Location& current_loc, const Location& destin
     return true;
 }
 
-// calculate minimum distance between a segment and any obstacle
-float AP_OABendyRuler::calc_avoidance_margin(const Location &start, const Location &end)
+// gather the fence and proximity sensor obstacles within radius_m of current_loc as offsets (in meters) from current_loc.
+// also records which side of each polygon fence the num_positions positions are
+void AP_OABendyRuler::update_obstacles(const Location &current_loc, float radius_m, const Vector2f *positions, uint8_t num_positions)
 {
-    float circular_fence_margin;
-    if (!calc_margin_from_circular_fence(start, end, circular_fence_margin)) {
-        circular_fence_margin = FLT_MAX;
+    _num_fence_edges = 0;
+    _num_fence_polygons = 0;
+    _num_fence_circles = 0;
+    _num_objects = 0;
+    _vehicle_outside_polygons = 0;
+    num_positions = MIN(num_positions, OA_BENDYRULER_BEARINGS_MAX);
+    for (uint8_t i = 0; i < num_positions; i++) {
+        _position_outside_polygons[i] = 0;
     }
 
-    float polygon_fence_margin;
-    if (!calc_margin_from_polygon_fence(start, end, polygon_fence_margin)) {
-        polygon_fence_margin = FLT_MAX;
-    }
-
-    float proximity_margin;
-    if (!calc_margin_from_object_database(start, end, proximity_margin)) {
-        proximity_margin = FLT_MAX;
-    }
+    AC_Fence *fence = AC_Fence::get_singleton();
+    if (fence != nullptr) {
+        // circular fence centered on home
+        if ((fence->get_enabled_fences() & AC_FENCE_TYPE_CIRCLE) != 0) {
+            _fence_circles[_num_fence_circles++] = {current_loc.get_distance_NE(AP::ahrs().get_home()), fence->get_radius(), true};
+        }
 
-    // return smallest margin from any obstacle
-    return MIN(MIN(circular_fence_margin, polygon_fence_margin), proximity_margin);
-}
+        // polygon fence and circle zones are held as offsets in cm from the EKF origin
+        Vector2f vehicle_NE;
+        if (((fence->get_enabled_fences() & AC_FENCE_TYPE_POLYGON) != 0) && current_loc.get_vector_xy_from_origin_NE(vehicle_NE)) {
+            // prevent the fence being reloaded while we use it
+            WITH_SEMAPHORE(fence->get_zones_semaphore());
 
-// calculate minimum distance between a path and the circular fence (centered on home)
-// on success returns true and updates margin
-bool AP_OABendyRuler::calc_margin_from_circular_fence(const Location &start, const Location &end, float &margin)
-{
-    // exit immediately if polygon fence is not enabled
-    const AC_Fence *fence = AC_Fence::get_singleton();
-    if (fence == nullptr) {
-        return false;
-    }
-    if ((fence->get_enabled_fences() & AC_FENCE_TYPE_CIRCLE) == 0) {
-        return false;
+            if (fence->is_polygon_valid()) {
+                update_fence_obstacles(fence->get_zones(), vehicle_NE, radius_m, positions, num_positions);
+            }
+        }
     }
 
-    // calculate start and end point's distance from home
-    const Location &ahrs_home = AP::ahrs().get_home();
-    const float start_dist_sq = ahrs_home.get_distance_NE(start).length_squared();
-    const float end_dist_sq = ahrs_home.get_distance_NE(end).length_squared();
-
-    // get circular fence radius
-    const float fence_radius = fence->get_radius();
-
-    // margin is fence radius minus the longer of start or end distance
-    margin = fence_radius - sqrtf(MAX(start_dist_sq, end_dist_sq));
-    return true;
+#if !HAL_MINIMIZE_FEATURES
+    AP_OADatabase *oaDb = AP::oadatabase();
+    if (oaDb != nullptr && oaDb->healthy()) {
+        _num_objects = oaDb->get_objects_near(current_loc, radius_m, _objects);
+        _object_radius = oaDb->get_accuracy();
+    }
+#endif
 }
 
-// calculate minimum distance between a path and the polygon fence
-// on success returns true and updates margin
-bool AP_OABendyRuler::calc_margin_from_polygon_fence(const Location &start, const Location &end, float &margin)
+// gather the polygon edges and circles of the fence zones within radius_m of vehicle_NE (an offset in cm from the EKF origin)
+// grouping the edges by polygon, and record which side of each polygon the vehicle and positions are
+void AP_OABendyRuler::update_fence_obstacles(const AC_FenceZones &zones, const Vector2f &vehicle_NE, float radius_m, const Vector2f *positions, uint8_t num_positions)
 {
-    // exit immediately if polygon fence is not enabled
-    const AC_Fence *fence = AC_Fence::get_singleton();
-    if (fence == nullptr) {
-        return false;
+    // count each polygon's nearby edges so they can be stored grouped by polygon
+    uint16_t edge_count[AC_FENCEZONES_MAX_POLYGONS] {};
+    zones.for_each_edge_near(vehicle_NE, radius_m * 100.0f, [&](const Vector2f &, const Vector2f &, uint8_t poly_idx) {
+        edge_count[poly_idx]++;
+    });
+
+    uint8_t fence_polygon_idx[AC_FENCEZONES_MAX_POLYGONS];
+    bool all_edges[AC_FENCEZONES_MAX_POLYGONS] {};
+    uint16_t num_edges = 0;
+    for (uint8_t p = 0; p < zones.num_polygons(); p++) {
+        // a position is on the wrong side of a polygon if it is outside an inclusion polygon or inside an exclusion polygon
+        const bool inclusion = zones.polygon(p).inclusion;
+        const bool vehicle_outside = zones.inside_polygon(p, vehicle_NE) != inclusion;
+        if (edge_count[p] == 0) {
+            if (!vehicle_outside) {
+                // no test segment can reach this polygon
+                continue;
+            }
+            // a breached polygon's margin is minus the distance back to it, which
+            // ranks the bearings however far away it is, so use all its edges
+            all_edges[p] = true;
+            edge_count[p] = zones.polygon(p).count;
+        }
+        const uint64_t bit = 1ULL << _num_fence_polygons;
+        if (vehicle_outside) {
+            _vehicle_outside_polygons |= bit;
+        }
+        for (uint8_t i = 0; i < num_positions; i++) {
+            if (zones.inside_polygon(p, vehicle_NE + positions[i] * 100.0f) != inclusion) {
+                _position_outside_polygons[i] |= bit;
+            }
+        }
+        _fence_polygons[_num_fence_polygons] = {num_edges, 0};
+        fence_polygon_idx[p] = _num_fence_polygons++;
+        num_edges += edge_count[p];
     }
-    if (((fence->get_enabled_fences() & AC_FENCE_TYPE_POLYGON) == 0) || !fence->is_polygon_valid()) {
-        return false;
+    if (!_fence_edges.expand_to_hold(num_edges)) {
+        _num_fence_polygons = 0;
+        return;
     }
-
-    // get polygon boundary
-    uint16_t num_points;
-    const Vector2f* boundary = fence->get_boundary_points(num_points);
-    if (num_points < 3) {
-        // this should have already been checked by is_polygon_valid() but just in case
-        return false;
+    zones.for_each_edge_near(vehicle_NE, radius_m * 100.0f, [&](const Vector2f &start, const Vector2f &end, uint8_t poly_idx) {
+        FencePolygon &poly = _fence_polygons[fence_polygon_idx[poly_idx]];
+        _fence_edges[poly.first_edge + poly.num_edges++] = {(start - vehicle_NE) * 0.01f, (end - vehicle_NE) * 0.01f};
+    });
+    for (uint8_t p = 0; p < zones.num_polygons(); p++) {
+        if (!all_edges[p]) {
+            continue;
+        }
+        FencePolygon &poly = _fence_polygons[fence_polygon_idx[p]];
+        const Vector2f *points = zones.polygon_points(p);
+        const uint16_t count = zones.polygon(p).count;
+        for (uint16_t i = 0; i < count; i++) {
+            _fence_edges[poly.first_edge + poly.num_edges++] = {(points[i] - vehicle_NE) * 0.01f, (points[(i+1) % count] - vehicle_NE) * 0.01f};
+        }
     }
+    _num_fence_edges = num_edges;
 
-    // convert start and end to offsets from EKF origin
-    Vector2f start_NE, end_NE;
-    if (!start.get_vector_xy_from_origin_NE(start_NE) || !end.get_vector_xy_from_origin_NE(end_NE)) {
-        return false;
+    for (uint8_t i = 0; i < zones.num_circles() && _num_fence_circles < ARRAY_SIZE(_fence_circles); i++) {
+        const AC_FenceZones::Circle &circle = zones.circle(i);
+        _fence_circles[_num_fence_circles++] = {(circle.center - vehicle_NE) * 0.01f, circle.radius * 0.01f, circle.inclusion};
     }
+}
 
-    // if outside the fence margin is the closest distance but with negative sign
-    const float sign = Polygon_outside(start_NE, boundary, num_points) ? -1.0f : 1.0f;
-
-    // calculate min distance (in meters) from line to polygon
-    margin = sign * Polygon_closest_distance_line(boundary, num_points, start_NE, end_NE) * 0.01f;
-    return true;
+// square of the closest distance between the line segment from w1 to w2 and the point p
+// written without calls or branches so the loops below can be vectorised
+static inline float segment_point_distance_sq(float w1x, float w1y, float w2x, float w2y, float px, float py)
+{
+    const float wx = w2x - w1x;
+    const float wy = w2y - w1y;
+    const float vx = px - w1x;
+    const float vy = py - w1y;
+    const float len_sq = wx * wx + wy * wy;
+    float t = (vx * wx + vy * wy) / MAX(len_sq, FLT_EPSILON);
+    t = MIN(MAX(t, 0.0f), 1.0f);
+    const float dx = vx - wx * t;
+    const float dy = vy - wy * t;
+    return dx * dx + dy * dy;
 }
 
-// calculate minimum distance between a path and proximity sensor obstacles
-// on success returns true and updates margin
-bool AP_OABendyRuler::calc_margin_from_object_database(const Location &start, const Location &end, float &margin)
+// calculate minimum distance between the segments from start to each of ends and any obstacle
+// bit n of start_outside_polygons should be set if start is outside inclusion polygon n or inside exclusion polygon n
+// requires update_obstacles to have been run
+void AP_OABendyRuler::calc_avoidance_margins(const Vector2f &start, uint64_t start_outside_polygons, const Vector2f *ends, uint8_t num_ends, float *margins) const
 {
-#if !HAL_MINIMIZE_FEATURES
-    // exit immediately if db is empty
-    AP_OADatabase *oaDb = AP::oadatabase();
-    if (oaDb == nullptr || !oaDb->healthy()) {
-        return false;
-    }
+    num_ends = MIN(num_ends, OA_BENDYRULER_BEARINGS_MAX);
 
-    // convert start and end to offsets (in cm) from EKF origin
-    Vector2f start_NE, end_NE;
-    if (!start.get_vector_xy_from_origin_NE(start_NE) || !end.get_vector_xy_from_origin_NE(end_NE)) {
-        return false;
+    for (uint8_t i = 0; i < num_ends; i++) {
+        margins[i] = FLT_MAX;
     }
 
-    // check each obstacle's distance from segment
-    float smallest_margin = FLT_MAX;
-    for (uint16_t i=0; i<oaDb->database_count(); i++) {
+    // circular fence and circle zones
+    for (uint8_t c = 0; c < _num_fence_circles; c++) {
+        const FenceCircle &circle = _fence_circles[c];
+        if (circle.inclusion) {
+            // margin is radius minus the further of start or end distance from the center
+            const float start_dist_sq = (start - circle.center).length_squared();
+            for (uint8_t i = 0; i < num_ends; i++) {
+                const float end_dist_sq = sq(ends[i].x - circle.center.x) + sq(ends[i].y - circle.center.y);
+                margins[i] = MIN(margins[i], circle.radius - sqrtf(MAX(start_dist_sq, end_dist_sq)));
+            }
+        } else {
+            // margin is the distance from the segment to the center less the radius
+            for (uint8_t i = 0; i < num_ends; i++) {
+                const float dist_sq = segment_point_distance_sq(start.x, start.y, ends[i].x, ends[i].y, circle.center.x, circle.center.y);
+                margins[i] = MIN(margins[i], sqrtf(dist_sq) - circle.radius);
+            }
+        }
+    }
 
-        // convert obstacle's location to offset (in cm) from EKF origin
-        Vector2f point;
-        if (!oaDb->get_item(i).loc.get_vector_xy_from_origin_NE(point)) {
-            continue;
+    // polygon fences, one at a time as the sign of the margin depends on which side of the polygon start is
+    for (uint8_t p = 0; p < _num_fence_polygons; p++) {
+        const FencePolygon &poly = _fence_polygons[p];
+        float fence_dist_sq[OA_BENDYRULER_BEARINGS_MAX];
+        float fence_cross[OA_BENDYRULER_BEARINGS_MAX];  // fraction along segment of the crossing closest to start, above 1 if none
+        for (uint8_t i = 0; i < num_ends; i++) {
+            fence_dist_sq[i] = FLT_MAX;
+            fence_cross[i] = 2.0f;
+        }
+        for (uint16_t e = poly.first_edge; e < poly.first_edge + poly.num_edges; e++) {
+            const FenceEdge &edge = _fence_edges[e];
+            const float qx = edge.end.x - edge.start.x;
+            const float qy = edge.end.y - edge.start.y;
+            const float sax = edge.start.x - start.x;
+            const float say = edge.start.y - start.y;
+            const float start_dist_sq = segment_point_distance_sq(edge.start.x, edge.start.y, edge.end.x, edge.end.y, start.x, start.y);
+            for (uint8_t i = 0; i < num_ends; i++) {
+                // if the segments do not cross the closest distance is from an end of one segment to the other segment
+                float dist_sq = MIN(start_dist_sq, segment_point_distance_sq(edge.start.x, edge.start.y, edge.end.x, edge.end.y, ends[i].x, ends[i].y));
+                dist_sq = MIN(dist_sq, segment_point_distance_sq(start.x, start.y, ends[i].x, ends[i].y, edge.start.x, edge.start.y));
+                dist_sq = MIN(dist_sq, segment_point_distance_sq(start.x, start.y, ends[i].x, ends[i].y, edge.end.x, edge.end.y));
+                fence_dist_sq[i] = MIN(fence_dist_sq[i], dist_sq);
+
+                // check if the segment crosses the edge
+                const float rx = ends[i].x - start.x;
+                const float ry = ends[i].y - start.y;
+                const float denom = rx * qy - ry * qx;
+                const float denom_inv = 1.0f / (fabsf(denom) > FLT_EPSILON ? denom : FLT_MAX);
+                const float t = (sax * qy - say * qx) * denom_inv;
+                const float u = (sax * ry - say * rx) * denom_inv;
+                const bool crosses = (fabsf(denom) > FLT_EPSILON) && (t >= 0.0f) && (t <= 1.0f) && (u >= 0.0f) && (u <= 1.0f);
+                fence_cross[i] = crosses ? MIN(fence_cross[i], t) : fence_cross[i];
+            }
         }
 
-        // margin is distance between line segment and obstacle minus obstacle's radius
-        const float m = Vector2f::closest_distance_between_line_and_point(start_NE, end_NE, point) * 0.01f - oaDb->get_accuracy();
-        if (m < smallest_margin) {
-            smallest_margin = m;
+        // as Polygon_closest_distance_line, if the segment crosses the polygon the distance is from the crossing
+        // closest to start to the end of the segment, with a negative sign.  If start is outside an inclusion
+        // polygon or inside an exclusion polygon the margin is this distance with its sign reversed
+        const float sign = ((start_outside_polygons & (1ULL << p)) != 0) ? -1.0f : 1.0f;
+        for (uint8_t i = 0; i < num_ends; i++) {
+            float fence_dist;
+            if (fence_cross[i] <= 1.0f) {
+                fence_dist = -(1.0f - fence_cross[i]) * (ends[i] - start).length();
+            } else {
+                fence_dist = sqrtf(fence_dist_sq[i]);
+            }
+            margins[i] = MIN(margins[i], sign * fence_dist);
         }
     }
 
-    // return smallest margin
-    if (smallest_margin < FLT_MAX) {
-        margin = smallest_margin;
-        return true;
+    // proximity sensor objects
+    if (_num_objects > 0) {
+        float object_dist_sq[OA_BENDYRULER_BEARINGS_MAX];
+        for (uint8_t i = 0; i < num_ends; i++) {
+            object_dist_sq[i] = FLT_MAX;
+        }
+        for (uint16_t o = 0; o < _num_objects; o++) {
+            const Vector2f &obj = _objects[o];
+            for (uint8_t i = 0; i < num_ends; i++) {
+                object_dist_sq[i] = MIN(object_dist_sq[i], segment_point_distance_sq(start.x, start.y, ends[i].x, ends[i].y, obj.x, obj.y));
+            }
+        }
+        // margin is distance between line segment and obstacle minus obstacle's radius
+        for (uint8_t i = 0; i < num_ends; i++) {
+            margins[i] = MIN(margins[i], sqrtf(object_dist_sq[i]) - _object_radius);
+        }
     }
-
-#endif
-    return false;
 }
@@ -1,9 +1,16 @@
 #pragma once
 
 #include <AP_Common/AP_Common.h>
+#include <AP_Common/AP_ExpandingArray.h>
 #include <AP_Common/Location.h>
 #include <AP_Math/AP_Math.h>
 #include <AP_HAL/AP_HAL.h>
+#include <AC_Fence/AC_FenceZones.h>
+
+#ifndef OA_BENDYRULER_BEARING_INC
+#define OA_BENDYRULER_BEARING_INC       5   // check every 5 degrees around vehicle
+#endif
+#define OA_BENDYRULER_BEARINGS_MAX      (2 * (170 / OA_BENDYRULER_BEARING_INC) + 1) // number of bearings checked in the first step
 
 /*
  * BendyRuler avoidance algorithm for avoiding the polygon and circular fence and dynamic objects detected by the proximity sensor
@@ -11,7 +18,7 @@
 class AP_OABendyRuler {
 public:
 
-    AP_OABendyRuler() {}
+    AP_OABendyRuler();
 
     /* Do not allow copies */
     AP_OABendyRuler(const AP_OABendyRuler &other) = delete;
@@ -26,20 +33,20 @@ public:
 
 private:
 
-    // calculate minimum distance between a path and any obstacle
-    float calc_avoidance_margin(const Location &start, const Location &end);
+    friend class AP_OABendyRuler_Test;
 
-    // calculate minimum distance between a path and the circular fence (centered on home)
-    // on success returns true and updates margin
-    bool calc_margin_from_circular_fence(const Location &start, const Location &end, float &margin);
+    // gather the fence and proximity sensor obstacles within radius_m of current_loc as offsets (in meters) from current_loc.
+    // also records which side of each polygon fence the num_positions positions are
+    void update_obstacles(const Location &current_loc, float radius_m, const Vector2f *positions, uint8_t num_positions);
 
-    // calculate minimum distance between a path and the polygon fence
-    // on success returns true and updates margin
-    bool calc_margin_from_polygon_fence(const Location &start, const Location &end, float &margin);
+    // gather the polygon edges and circles of the fence zones within radius_m of vehicle_NE (an offset in cm from the EKF origin)
+    // grouping the edges by polygon, and record which side of each polygon the vehicle and positions are
+    void update_fence_obstacles(const AC_FenceZones &zones, const Vector2f &vehicle_NE, float radius_m, const Vector2f *positions, uint8_t num_positions);
 
-    // calculate minimum distance between a path and proximity sensor obstacles
-    // on success returns true and updates margin
-    bool calc_margin_from_object_database(const Location &start, const Location &end, float &margin);
+    // calculate minimum distance between the segments from start to each of ends and any obstacle
+    // bit n of start_outside_polygons should be set if start is outside inclusion polygon n or inside exclusion polygon n
+    // requires update_obstacles to have been run
+    void calc_avoidance_margins(const Vector2f &start, uint64_t start_outside_polygons, const Vector2f *ends, uint8_t num_ends, float *margins) const;
 
     // configuration parameters
     float _lookahead;               // object avoidance will look this many meters ahead of vehicle
@@ -47,4 +54,31 @@ private:
 
     // internal variables used by background thread
     float _current_lookahead;       // distance (in meters) ahead of the vehicle we are looking for obstacles
+
+    // obstacles near the vehicle as offsets in meters from the vehicle, gathered once per update
+    struct FenceEdge {
+        Vector2f start;
+        Vector2f end;
+    };
+    struct FenceCircle {
+        Vector2f center;
+        float radius;
+        bool inclusion;
+    };
+    struct FencePolygon {
+        uint16_t first_edge;    // index of polygon's first edge in _fence_edges
+        uint16_t num_edges;
+    };
+    static_assert(AC_FENCEZONES_MAX_POLYGONS <= 64, "polygons must fit in a uint64_t bitmask");
+    AP_ExpandingArray<FenceEdge> _fence_edges;          // polygon fence edges, grouped by polygon
+    uint16_t _num_fence_edges;
+    FencePolygon _fence_polygons[AC_FENCEZONES_MAX_POLYGONS];   // polygons with edges near the vehicle
+    uint8_t _num_fence_polygons;
+    FenceCircle _fence_circles[AC_FENCEZONES_MAX_CIRCLES + 1];  // circle zones and the circular fence around home
+    uint8_t _num_fence_circles;
+    AP_ExpandingArray<Vector2f> _objects;               // proximity sensor objects
+    uint16_t _num_objects;
+    float _object_radius;                               // radius of proximity sensor objects
+    uint64_t _vehicle_outside_polygons;                 // bit n set if the vehicle is outside inclusion polygon n or inside exclusion polygon n
+    uint64_t _position_outside_polygons[OA_BENDYRULER_BEARINGS_MAX];    // as above for each position passed to update_obstacles
 };
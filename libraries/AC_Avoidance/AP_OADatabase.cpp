@@ -33,6 +33,10 @@ extern const AP_HAL::HAL& hal;
     #define AP_OADATABASE_QUEUE_SIZE_DEFAULT 80
 #endif
 
+#ifndef AP_OADATABASE_INDEX_CELL_SIZE_M
+    #define AP_OADATABASE_INDEX_CELL_SIZE_M     2.0f    // size of spatial index cells in meters
+#endif
+
 
 const AP_Param::GroupInfo AP_OADatabase::var_info[] = {
 
@@ -164,6 +168,15 @@ void AP_OADatabase::init_database()
     }
 
     _database.items = new OA_DbItem[_database.size];
+    if (_database.items == nullptr) {
+        return;
+    }
+
+    // index items by position so finding nearby items does not require checking every item
+    if (!_database.index.init(_database.size, AP_OADATABASE_INDEX_CELL_SIZE_M)) {
+        delete[] _database.items;
+        _database.items = nullptr;
+    }
 }
 
 void AP_OADatabase::optimize_db_filter()
@@ -266,17 +279,11 @@ bool AP_OADatabase::process_queue()
         item.radius = get_radius(item.importance);
         item.send_to_gcs = get_send_to_gcs_flags(item.importance);
 
-        // compare item to all items in database. If found a similar item, update the existing, else add it as a new one
-        bool found = false;
-        for (uint16_t i=0; i<_database.count; i++) {
-            if (is_close_to_item_in_database(i, item)) {
-                database_item_refresh(i, item.timestamp_ms, item.radius);
-                found = true;
-                break;
-            }
-        }
-
-        if (!found) {
+        // compare item to nearby items in database. If found a similar item, update the existing, else add it as a new one
+        const uint16_t close_idx = (_database.count > 0) ? find_close_item_in_database(_database.origin.get_distance_NE(item.loc), item) : AP_OASpatialHash::INDEX_NONE;
+        if (close_idx != AP_OASpatialHash::INDEX_NONE) {
+            database_item_refresh(close_idx, item.timestamp_ms, item.radius);
+        } else {
             database_item_add(item);
         }
     }
@@ -288,6 +295,11 @@ void AP_OADatabase::database_item_add(const OA_DbItem &item)
     if (_database.count >= _database.size) {
         return;
     }
+    // positions in the index are relative to the first item added to an empty database
+    if (_database.count == 0) {
+        _database.origin = item.loc;
+    }
+    _database.index.add(_database.count, _database.origin.get_distance_NE(item.loc));
     _database.items[_database.count] = item;
     _database.items[_database.count].send_to_gcs = get_send_to_gcs_flags(_database.items[_database.count].importance);
     _database.count++;
@@ -303,6 +315,7 @@ void AP_OADatabase::database_item_remove(const uint16_t index)
     // radius of 0 tells the GCS we don't care about it any more (aka it expired)
     _database.items[index].radius = 0;
     _database.items[index].send_to_gcs = get_send_to_gcs_flags(_database.items[index].importance);
+    _database.index.remove(index);
 
     _database.count--;
     if (_database.count == 0) {
@@ -312,6 +325,7 @@ void AP_OADatabase::database_item_remove(const uint16_t index)
     if (index != _database.count) {
         // copy last object in array over expired object
         _database.items[index] = _database.items[_database.count];
+        _database.index.move(_database.count, index);
         _database.items[index].send_to_gcs = get_send_to_gcs_flags(_database.items[index].importance);
     }
 }
@@ -364,15 +378,46 @@ void AP_OADatabase::database_items_remove_all_expired()
     }
 }
 
-// returns true if a similar object already exists in database. When true, the object timer is also reset
-bool AP_OADatabase::is_close_to_item_in_database(const uint16_t index, const OA_DbItem &item) const
+// find an item in the database within item's radius of pos. returns index or AP_OASpatialHash::INDEX_NONE
+uint16_t AP_OADatabase::find_close_item_in_database(const Vector2f &pos, const OA_DbItem &item) const
 {
-    if (index >= _database.count) {
-        // index out of range
+    const float radius_sq = sq(item.radius);
+    const Vector2f radius_vec(item.radius, item.radius);
+    uint16_t close_idx = AP_OASpatialHash::INDEX_NONE;
+    _database.index.for_each_in_box(pos - radius_vec, pos + radius_vec, [&](uint16_t i) {
+        if ((_database.index.position(i) - pos).length_squared() < radius_sq) {
+            close_idx = i;
+            return true;
+        }
         return false;
+    });
+    return close_idx;
+}
+
+// add positions of objects within radius_m of center to positions as offsets (in meters) from center
+// returns number of positions added, which is limited by the space positions can be expanded to
+uint16_t AP_OADatabase::get_objects_near(const Location &center, float radius_m, AP_ExpandingArray<Vector2f> &positions) const
+{
+    if (!healthy() || _database.count == 0) {
+        return 0;
     }
 
-    return (_database.items[index].loc.get_distance(item.loc) < item.radius);
+    const Vector2f center_NE = _database.origin.get_distance_NE(center);
+    const Vector2f radius_vec(radius_m, radius_m);
+    const float radius_sq = sq(radius_m);
+    uint16_t count = 0;
+    _database.index.for_each_in_box(center_NE - radius_vec, center_NE + radius_vec, [&](uint16_t i) {
+        const Vector2f pos = _database.index.position(i) - center_NE;
+        if (pos.length_squared() > radius_sq) {
+            return false;
+        }
+        if (!positions.expand_to_hold(count + 1)) {
+            return true;
+        }
+        positions[count++] = pos;
+        return false;
+    });
+    return count;
 }
 
 // send ADSB_VEHICLE mavlink messages
@@ -6,6 +6,8 @@
 
 #if !HAL_MINIMIZE_FEATURES
 #include <AP_Param/AP_Param.h>
+#include <AP_Common/AP_ExpandingArray.h>
+#include "AP_OASpatialHash.h"
 
 class AP_OADatabase {
 public:
@@ -54,6 +56,10 @@ public:
     // empty queue and try and put into database. Return true if there's more work to do
     bool process_queue();
 
+    // add positions of objects within radius_m of center to positions as offsets (in meters) from center
+    // returns number of positions added, which is limited by the space positions can be expanded to
+    uint16_t get_objects_near(const Location &center, float radius_m, AP_ExpandingArray<Vector2f> &positions) const;
+
     // send ADSB_VEHICLE mavlink messages
     void send_adsb_vehicle(mavlink_channel_t chan, uint16_t interval_ms);
 
@@ -81,8 +87,8 @@ private:
     // used to determine the filter radius
     float get_radius(const OA_DbItemImportance importance);
 
-    // returns true if database item "index" is close to "item"
-    bool is_close_to_item_in_database(const uint16_t index, const OA_DbItem &item) const;
+    // find an item in the database within item's radius of pos. returns index or AP_OASpatialHash::INDEX_NONE
+    uint16_t find_close_item_in_database(const Vector2f &pos, const OA_DbItem &item) const;
 
     // enum for use with _OUTPUT parameter
     enum class OA_DbOutputLevel {
@@ -114,6 +120,8 @@ private:
         const float     radius_grow_rate        = 1.10f;    // db item radius growth over time. Resets if refreshed, otherwise decaying items grow
         uint16_t        count;                              // number of objects in the items array
         uint16_t        size;                               // cached value of _database_size_param that sticks after initialized
+        AP_OASpatialHash index;                             // spatial index of items by position relative to origin
+        Location        origin;                             // reference location for index, set when the first item is added to an empty database
     } _database;
 
     uint16_t _next_index_to_send[MAVLINK_COMM_NUM_BUFFERS]; // index of next object in _database to send to GCS
@@ -7,13 +7,14 @@
 #include "AP_OAVisGraph.h"
 
 /*
- * Dijkstra's algorithm for path planning around polygon fence
+ * Dijkstra's algorithm for path planning around polygon fence and exclusion zones
  */
 
 class AP_OADijkstra {
 public:
 
     AP_OADijkstra();
+    ~AP_OADijkstra() { free(_polyfence_pts); }
 
     /* Do not allow copies */
     AP_OADijkstra(const AP_OADijkstra &other) = delete;
@@ -53,7 +54,7 @@ private:
     // calculate shortest path from origin to destination
     // returns true on success
     // requires create_polygon_fence_with_margin and create_polygon_fence_visgraph to have been run
-    // resulting path is stored in _shortest_path array as vector offsets from EKF origin
+    // resulting path is held in _visgraph as vector offsets from EKF origin
     bool calc_shortest_path(const Location &origin, const Location &destination);
 
     // shortest path state variables
@@ -62,53 +63,28 @@ private:
     bool _shortest_path_ok;
 
     Location _destination_prev;     // destination of previous iterations (used to determine if path should be re-calculated)
-    uint8_t _path_idx_returned;     // index into _path array which gives location vehicle should be currently moving towards
+    uint16_t _path_idx_returned;    // index into path which gives location vehicle should be currently moving towards
 
     // polygon fence (with margin) related variables
     float _polyfence_margin = 10;
-    AP_ExpandingArray<Vector2f> _polyfence_pts;
-    uint8_t _polyfence_numpoints;
+    Vector2f *_polyfence_pts = nullptr; // points just inside the fence, as offsets from EKF origin in cm
+    uint16_t _polyfence_pts_max;    // number of points _polyfence_pts has space for
+    uint16_t _polyfence_numpoints;
     uint32_t _polyfence_update_ms;  // system time of boundary update from AC_Fence (used to detect changes to polygon fence)
 
-    // visibility graphs
-    AP_OAVisGraph _polyfence_visgraph;
-    AP_OAVisGraph _source_visgraph;
-    AP_OAVisGraph _destination_visgraph;
-
-    // updates visibility graph for a given position which is an offset (in cm) from the ekf origin
-    // to add an additional position (i.e. the destination) set add_extra_position = true and provide the position in the extra_position argument
-    // requires create_polygon_fence_with_margin to have been run
-    // returns true on success
-    bool update_visgraph(AP_OAVisGraph& visgraph, const AP_OAVisGraph::OAItemID& oaid, const Vector2f &position, bool add_extra_position = false, Vector2f extra_position = Vector2f(0,0));
-
-    typedef uint8_t node_index;         // indices into short path data
-    struct ShortPathNode {
-        AP_OAVisGraph::OAItemID id;     // unique id for node (combination of type and id number)
-        bool visited;                   // true if all this node's neighbour's distances have been updated
-        node_index distance_from_idx;   // index into _short_path_data from where distance was updated (or 255 if not set)
-        float distance_cm;              // distance from source (number is tentative until this node is the current node and/or visited = true)
-    };
-    AP_ExpandingArray<ShortPathNode> _short_path_data;
-    node_index _short_path_data_numpoints;  // number of elements in _short_path_data array
-
-    // update total distance for all nodes visible from current node
-    // curr_node_idx is an index into the _short_path_data array
-    void update_visible_node_distances(node_index curr_node_idx);
-
-    // find a node's index into _short_path_data array from it's id (i.e. id type and id number)
-    // returns true if successful and node_idx is updated
-    bool find_node_from_id(const AP_OAVisGraph::OAItemID &id, node_index &node_idx) const;
-
-    // find index of node with lowest tentative distance (ignore visited nodes)
-    // returns true if successful and node_idx argument is updated
-    bool find_closest_node_idx(node_index &node_idx) const;
-
-    // final path variables and functions
-    AP_ExpandingArray<AP_OAVisGraph::OAItemID> _path;   // ids of points on return path in reverse order (i.e. destination is first element)
-    uint8_t _path_numpoints;                            // number of points on return path
-    Vector2f _path_source;                              // source point used in shortest path calculations (offset in cm from EKF origin)
-    Vector2f _path_destination;                         // destination position used in shortest path calculations (offset in cm from EKF origin)
+    // visibility graph of fence points, source and destination.  The
+    // fence points are only recalculated when the fence changes.
+    // The graph takes n^2/8 bytes for its bit matrix plus 24 bytes per
+    // node, about 150k for 1000 fence points.  The copy of the zones
+    // takes about 15k for 1000 vertices and the changed zones up to
+    // twice that, so the worst case is about 200k.  The zones' memory
+    // is kept between fence changes so a fence upload doesn't allocate
+    // and free it again
+    AP_OAVisGraph _visgraph;
+    AC_FenceZones _visgraph_zones;  // copy of the fence zones the visibility graph was calculated with
+    AC_FenceZones _visgraph_changed_zones;  // zones added or removed since the visibility graph was calculated
+    bool _visgraph_zones_ok;        // true if _visgraph_zones matches the visibility graph
 
     // return point from final path as an offset (in cm) from the ekf origin
-    bool get_shortest_path_point(uint8_t point_num, Vector2f& pos);
+    bool get_shortest_path_point(uint16_t point_num, Vector2f& pos) const;
 };
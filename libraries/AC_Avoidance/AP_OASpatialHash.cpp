@@ -0,0 +1,113 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AP_OASpatialHash.h"
+
+// allocate space for max_items objects in cells of cell_size_m.
+// returns false on allocation failure
+bool AP_OASpatialHash::init(uint16_t max_items, float cell_size_m)
+{
+    free_memory();
+    if (max_items == 0 || max_items == INDEX_NONE || !is_positive(cell_size_m)) {
+        return false;
+    }
+
+    // at least one bucket per object so lists stay short
+    uint32_t num_buckets = 16;
+    while (num_buckets < max_items) {
+        num_buckets *= 2;
+    }
+    if (num_buckets > 32768) {
+        return false;
+    }
+
+    _bucket_head = (uint16_t *)calloc(num_buckets, sizeof(uint16_t));
+    _next = (uint16_t *)calloc(max_items, sizeof(uint16_t));
+    _pos = (Vector2f *)calloc(max_items, sizeof(Vector2f));
+    if (_bucket_head == nullptr || _next == nullptr || _pos == nullptr) {
+        free_memory();
+        return false;
+    }
+    _num_buckets = num_buckets;
+    _max_items = max_items;
+    _cell_size_inv = 1.0f / cell_size_m;
+    clear();
+    return true;
+}
+
+void AP_OASpatialHash::free_memory()
+{
+    free(_bucket_head);
+    free(_next);
+    free(_pos);
+    _bucket_head = nullptr;
+    _next = nullptr;
+    _pos = nullptr;
+    _num_buckets = 0;
+    _max_items = 0;
+}
+
+// remove all objects
+void AP_OASpatialHash::clear()
+{
+    for (uint16_t b=0; b<_num_buckets; b++) {
+        _bucket_head[b] = INDEX_NONE;
+    }
+}
+
+// add object idx at pos.  idx must not already be in the hash
+void AP_OASpatialHash::add(uint16_t idx, const Vector2f &pos)
+{
+    if (idx >= _max_items) {
+        return;
+    }
+    const uint16_t b = bucket(cell(pos.x), cell(pos.y));
+    _pos[idx] = pos;
+    _next[idx] = _bucket_head[b];
+    _bucket_head[b] = idx;
+}
+
+// remove object idx from its bucket's list
+void AP_OASpatialHash::unlink(uint16_t idx)
+{
+    uint16_t *link = &_bucket_head[bucket(cell(_pos[idx].x), cell(_pos[idx].y))];
+    while (*link != INDEX_NONE) {
+        if (*link == idx) {
+            *link = _next[idx];
+            return;
+        }
+        link = &_next[*link];
+    }
+}
+
+// remove object idx
+void AP_OASpatialHash::remove(uint16_t idx)
+{
+    if (idx >= _max_items) {
+        return;
+    }
+    unlink(idx);
+}
+
+// object from is renumbered to to, e.g. when the last item in an array is
+// copied over a removed item.  to must not be in the hash
+void AP_OASpatialHash::move(uint16_t from, uint16_t to)
+{
+    if (from >= _max_items || to >= _max_items || from == to) {
+        return;
+    }
+    unlink(from);
+    add(to, _pos[from]);
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>
+
+/*
+ * Spatial hash of object positions used by the object avoidance database
+ *
+ * Objects are identified by their index in the caller's array and are
+ * placed in a uniform grid of cells keyed on their NE position (in meters
+ * from a reference point), with the cells hashed into a fixed number of
+ * buckets.  Each bucket holds a singly linked list of objects.
+ */
+class AP_OASpatialHash {
+public:
+    AP_OASpatialHash() {}
+    ~AP_OASpatialHash() { free_memory(); }
+
+    /* Do not allow copies */
+    AP_OASpatialHash(const AP_OASpatialHash &other) = delete;
+    AP_OASpatialHash &operator=(const AP_OASpatialHash&) = delete;
+
+    static const uint16_t INDEX_NONE = UINT16_MAX;
+
+    // allocate space for max_items objects in cells of cell_size_m.
+    // returns false on allocation failure
+    bool init(uint16_t max_items, float cell_size_m);
+
+    // remove all objects
+    void clear();
+
+    // add object idx at pos.  idx must not already be in the hash
+    void add(uint16_t idx, const Vector2f &pos);
+
+    // remove object idx
+    void remove(uint16_t idx);
+
+    // object from is renumbered to to, e.g. when the last item in an array is
+    // copied over a removed item.  to must not be in the hash
+    void move(uint16_t from, uint16_t to);
+
+    // position of object idx
+    const Vector2f &position(uint16_t idx) const { return _pos[idx]; }
+
+    // call fn(idx) for each object in cells overlapping the box from min to
+    // max. Each object is passed once.  Stops early and returns true if fn
+    // returns true
+    template <typename F>
+    bool for_each_in_box(const Vector2f &min, const Vector2f &max, F fn) const
+    {
+        if (_bucket_head == nullptr) {
+            return false;
+        }
+        const int32_t x0 = cell(min.x);
+        const int32_t y0 = cell(min.y);
+        const int32_t x1 = cell(max.x);
+        const int32_t y1 = cell(max.y);
+        if ((uint64_t)(x1 - x0 + 1) * (uint64_t)(y1 - y0 + 1) >= _num_buckets) {
+            // box covers more cells than there are buckets, check every object once
+            for (uint16_t b=0; b<_num_buckets; b++) {
+                for (uint16_t i=_bucket_head[b]; i!=INDEX_NONE; i=_next[i]) {
+                    const int32_t cx = cell(_pos[i].x);
+                    const int32_t cy = cell(_pos[i].y);
+                    if (cx >= x0 && cx <= x1 && cy >= y0 && cy <= y1 && fn(i)) {
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+        for (int32_t cy=y0; cy<=y1; cy++) {
+            for (int32_t cx=x0; cx<=x1; cx++) {
+                // other cells may share this bucket so only accept objects in this cell
+                for (uint16_t i=_bucket_head[bucket(cx, cy)]; i!=INDEX_NONE; i=_next[i]) {
+                    if (cell(_pos[i].x) == cx && cell(_pos[i].y) == cy && fn(i)) {
+                        return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+private:
+
+    void free_memory();
+
+    // cell column or row of a coordinate
+    int32_t cell(float v) const { return (int32_t)floorf(v * _cell_size_inv); }
+
+    // bucket holding a cell
+    uint16_t bucket(int32_t cx, int32_t cy) const {
+        return (((uint32_t)cx * 73856093U) ^ ((uint32_t)cy * 19349663U)) & (_num_buckets - 1);
+    }
+
+    // remove object idx from its bucket's list
+    void unlink(uint16_t idx);
+
+    float _cell_size_inv;               // inverse of cell size in meters
+    uint16_t _num_buckets;              // number of buckets, a power of two
+    uint16_t _max_items;
+    uint16_t *_bucket_head = nullptr;   // first object in each bucket, or INDEX_NONE
+    uint16_t *_next = nullptr;          // next object in the same bucket, or INDEX_NONE
+    Vector2f *_pos = nullptr;           // position of each object
+};
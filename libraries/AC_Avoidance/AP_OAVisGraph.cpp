@@ -15,22 +15,294 @@
 
 #include "AP_OAVisGraph.h"
 
-// constructor initialises expanding array to use 20 elements per chunk
-AP_OAVisGraph::AP_OAVisGraph() :
-    _items(20)
+// remove all nodes and free memory
+void AP_OAVisGraph::clear()
 {
+    free(_visible);
+    free(_pos);
+    free(_dist);
+    free(_cost);
+    free(_prev);
+    free(_heap);
+    free(_heap_idx);
+    free(_path);
+    _visible = nullptr;
+    _pos = nullptr;
+    _dist = nullptr;
+    _cost = nullptr;
+    _prev = nullptr;
+    _heap = nullptr;
+    _heap_idx = nullptr;
+    _path = nullptr;
+    _num_nodes = 0;
+    _row_words = 0;
+    _heap_size = 0;
+    _path_length = 0;
+    _endpoint_set[NODE_SOURCE] = false;
+    _endpoint_set[NODE_DESTINATION] = false;
 }
 
-// add item to visiblity graph, returns true on success, false if graph is full
-bool AP_OAVisGraph::add_item(const OAItemID &id1, const OAItemID &id2, float distance_cm)
+/*
+  replace the points the path may pass through and calculate the
+  visibility between them, copying the visibility of pairs of points
+  which have not moved from the previous graph unless a changed zone
+  lies between them
+ */
+bool AP_OAVisGraph::update_points(const Vector2f *points, uint16_t num_points, const AC_FenceZones &zones,
+                                  const AC_FenceZones *changed_zones)
 {
-    // ensure there is space in the array
-    if (!_items.expand_to_hold(_num_items+1)) {
+    // keep the previous visibility and positions until the new graph is built
+    uint32_t *old_visible = _visible;
+    Vector2f *old_pos = _pos;
+    const uint16_t old_num_nodes = (changed_zones != nullptr) ? _num_nodes : 0;
+    const uint16_t old_row_words = _row_words;
+    _visible = nullptr;
+    _pos = nullptr;
+    clear();
+    _num_tests = 0;
+
+    if (num_points > AP_OAVISGRAPH_MAX_POINTS) {
+        free(old_visible);
+        free(old_pos);
+        return false;
+    }
+
+    const uint16_t num_nodes = num_points + NODE_FIRST_POINT;
+    _row_words = (num_nodes + 31) / 32;
+    _visible = (uint32_t *)calloc(num_nodes * _row_words, sizeof(uint32_t));
+    _pos = (Vector2f *)calloc(num_nodes, sizeof(Vector2f));
+    _dist = (float *)calloc(num_nodes, sizeof(float));
+    _cost = (float *)calloc(num_nodes, sizeof(float));
+    _prev = (uint16_t *)calloc(num_nodes, sizeof(uint16_t));
+    _heap = (uint16_t *)calloc(num_nodes, sizeof(uint16_t));
+    _heap_idx = (uint16_t *)calloc(num_nodes, sizeof(uint16_t));
+    _path = (uint16_t *)calloc(num_nodes, sizeof(uint16_t));
+    if (_visible == nullptr || _pos == nullptr || _dist == nullptr || _cost == nullptr ||
+        _prev == nullptr || _heap == nullptr || _heap_idx == nullptr || _path == nullptr) {
+        free(old_visible);
+        free(old_pos);
+        clear();
         return false;
     }
+    _num_nodes = num_nodes;
+
+    for (uint16_t i=0; i<num_points; i++) {
+        _pos[NODE_FIRST_POINT + i] = points[i];
+    }
 
-    // add item
-    _items[_num_items] = {id1, id2, distance_cm};
-    _num_items++;
+    // find the previous node of each point which has not moved, held
+    // in _prev as NODE_SOURCE if there is none.  Points are usually
+    // in the same order as before, so the search starts after the last match
+    const uint16_t old_num_points = (old_num_nodes > NODE_FIRST_POINT) ? old_num_nodes - NODE_FIRST_POINT : 0;
+    uint16_t hint = NODE_FIRST_POINT;
+    for (uint16_t i=NODE_FIRST_POINT; i<_num_nodes; i++) {
+        _prev[i] = NODE_SOURCE;
+        for (uint16_t k=0; k<old_num_points; k++) {
+            uint16_t j = hint + k;
+            if (j >= old_num_nodes) {
+                j -= old_num_points;
+            }
+            if (old_pos[j] == _pos[i]) {
+                _prev[i] = j;
+                hint = (j + 1 < old_num_nodes) ? j + 1 : NODE_FIRST_POINT;
+                break;
+            }
+        }
+    }
+
+    // each pair of points is only tested once as visibility is symmetric
+    for (uint16_t i=NODE_FIRST_POINT; i<_num_nodes-1; i++) {
+        for (uint16_t j=i+1; j<_num_nodes; j++) {
+            const uint16_t old_i = _prev[i];
+            const uint16_t old_j = _prev[j];
+            if (old_i != NODE_SOURCE && old_j != NODE_SOURCE &&
+                !changed_zones->intersects(_pos[i], _pos[j])) {
+                if ((old_visible[old_i * old_row_words + old_j / 32] & (1U << (old_j % 32))) != 0) {
+                    set_visible(i, j, true);
+                }
+                continue;
+            }
+            _num_tests++;
+            if (!zones.intersects(_pos[i], _pos[j])) {
+                set_visible(i, j, true);
+            }
+        }
+    }
+
+    free(old_visible);
+    free(old_pos);
     return true;
 }
+
+// set or clear visibility between two nodes
+void AP_OAVisGraph::set_visible(uint16_t a, uint16_t b, bool visible)
+{
+    if (visible) {
+        _visible[a * _row_words + b / 32] |= (1U << (b % 32));
+        _visible[b * _row_words + a / 32] |= (1U << (a % 32));
+    } else {
+        _visible[a * _row_words + b / 32] &= ~(1U << (b % 32));
+        _visible[b * _row_words + a / 32] &= ~(1U << (a % 32));
+    }
+}
+
+// move the source or destination and recalculate its visibility
+bool AP_OAVisGraph::set_endpoint(uint16_t node, const Vector2f &pos, const AC_FenceZones &zones)
+{
+    if (_num_nodes == 0) {
+        return false;
+    }
+
+    // nothing to do if the endpoint has not moved
+    if (_endpoint_set[node] && (_pos[node] == pos)) {
+        return true;
+    }
+    _pos[node] = pos;
+
+    // only this node's row and column change
+    const uint16_t other = (node == NODE_SOURCE) ? NODE_DESTINATION : NODE_SOURCE;
+    for (uint16_t j=0; j<_num_nodes; j++) {
+        if (j == node) {
+            continue;
+        }
+        if (j == other && !_endpoint_set[other]) {
+            set_visible(node, j, false);
+            continue;
+        }
+        _num_tests++;
+        set_visible(node, j, !zones.intersects(pos, _pos[j]));
+    }
+    _endpoint_set[node] = true;
+
+    return true;
+}
+
+// find the shortest path from source to destination using an A*
+// search with a straight line distance heuristic.  returns true on success
+bool AP_OAVisGraph::find_path()
+{
+    _path_length = 0;
+    if (_num_nodes == 0 || !_endpoint_set[NODE_SOURCE] || !_endpoint_set[NODE_DESTINATION]) {
+        return false;
+    }
+
+    for (uint16_t i=0; i<_num_nodes; i++) {
+        _dist[i] = FLT_MAX;
+        _heap_idx[i] = HEAP_IDX_UNSEEN;
+    }
+    _heap_size = 0;
+
+    const Vector2f &dest = _pos[NODE_DESTINATION];
+    _dist[NODE_SOURCE] = 0;
+    _cost[NODE_SOURCE] = (dest - _pos[NODE_SOURCE]).length();
+    _prev[NODE_SOURCE] = NODE_SOURCE;
+    heap_push_or_update(NODE_SOURCE);
+
+    // the straight line distance never over-estimates and satisfies the
+    // triangle inequality so a node's distance is final once it is popped
+    while (_heap_size > 0) {
+        const uint16_t curr = heap_pop();
+        if (curr == NODE_DESTINATION) {
+            break;
+        }
+        const uint32_t *row = &_visible[curr * _row_words];
+        for (uint16_t w=0; w<_row_words; w++) {
+            uint32_t bits = row[w];
+            while (bits != 0) {
+                const uint16_t next = w * 32 + __builtin_ctz(bits);
+                bits &= bits - 1;
+                if (_heap_idx[next] == HEAP_IDX_CLOSED) {
+                    continue;
+                }
+                const float dist = _dist[curr] + (_pos[next] - _pos[curr]).length();
+                if (dist < _dist[next]) {
+                    _dist[next] = dist;
+                    _cost[next] = dist + (dest - _pos[next]).length();
+                    _prev[next] = curr;
+                    heap_push_or_update(next);
+                }
+            }
+        }
+    }
+
+    if (_dist[NODE_DESTINATION] >= FLT_MAX) {
+        return false;
+    }
+
+    // count nodes on path then fill in from the destination backwards
+    uint16_t count = 1;
+    for (uint16_t n = NODE_DESTINATION; n != NODE_SOURCE; n = _prev[n]) {
+        count++;
+    }
+    uint16_t n = NODE_DESTINATION;
+    for (uint16_t i=count; i>0; i--) {
+        _path[i-1] = n;
+        n = _prev[n];
+    }
+    _path_length = count;
+
+    return true;
+}
+
+// add a node to the heap or move it up after its cost has decreased
+void AP_OAVisGraph::heap_push_or_update(uint16_t node)
+{
+    if (_heap_idx[node] == HEAP_IDX_UNSEEN) {
+        _heap[_heap_size] = node;
+        _heap_idx[node] = _heap_size;
+        _heap_size++;
+    }
+    heap_sift_up(_heap_idx[node]);
+}
+
+// remove and return the node with the lowest cost
+uint16_t AP_OAVisGraph::heap_pop()
+{
+    const uint16_t top = _heap[0];
+    _heap_size--;
+    if (_heap_size > 0) {
+        _heap[0] = _heap[_heap_size];
+        _heap_idx[_heap[0]] = 0;
+        heap_sift_down(0);
+    }
+    _heap_idx[top] = HEAP_IDX_CLOSED;
+    return top;
+}
+
+void AP_OAVisGraph::heap_sift_up(uint16_t i)
+{
+    const uint16_t node = _heap[i];
+    while (i > 0) {
+        const uint16_t parent = (i - 1) / 2;
+        if (_cost[_heap[parent]] <= _cost[node]) {
+            break;
+        }
+        _heap[i] = _heap[parent];
+        _heap_idx[_heap[i]] = i;
+        i = parent;
+    }
+    _heap[i] = node;
+    _heap_idx[node] = i;
+}
+
+void AP_OAVisGraph::heap_sift_down(uint16_t i)
+{
+    const uint16_t node = _heap[i];
+    while (true) {
+        uint16_t child = 2 * i + 1;
+        if (child >= _heap_size) {
+            break;
+        }
+        if (child + 1 < _heap_size && _cost[_heap[child + 1]] < _cost[_heap[child]]) {
+            child++;
+        }
+        if (_cost[node] <= _cost[_heap[child]]) {
+            break;
+        }
+        _heap[i] = _heap[child];
+        _heap_idx[_heap[i]] = i;
+        i = child;
+    }
+    _heap[i] = node;
+    _heap_idx[node] = i;
+}
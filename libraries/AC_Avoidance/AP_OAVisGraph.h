@@ -1,59 +1,111 @@
 #pragma once
 
 #include <AP_Common/AP_Common.h>
-#include <AP_Common/AP_ExpandingArray.h>
-#include <AP_HAL/AP_HAL.h>
+#include <AP_Math/AP_Math.h>
+#include <AC_Fence/AC_FenceZones.h>
+
+#define AP_OAVISGRAPH_MAX_POINTS    1000    // maximum number of points (excluding source and destination) in the graph
 
 /*
  * Visibility graph used by Dijkstra's algorithm for path planning around fence, stay-out zones and moving obstacles
+ *
+ * Node 0 is the source, node 1 is the destination and the remaining
+ * nodes are points the path may pass through (i.e. points just inside
+ * the fence).  Visibility between nodes is held as a bit matrix so moving
+ * the source or destination only recalculates that node's row.
+ * Positions are offsets in cm from the EKF origin
  */
 class AP_OAVisGraph {
 public:
-    AP_OAVisGraph();
+    AP_OAVisGraph() {}
+    ~AP_OAVisGraph() { clear(); }
 
     /* Do not allow copies */
     AP_OAVisGraph(const AP_OAVisGraph &other) = delete;
     AP_OAVisGraph &operator=(const AP_OAVisGraph&) = delete;
 
-    // types of items held in graph
-    enum OAType : uint8_t {
-        OATYPE_SOURCE = 0,
-        OATYPE_DESTINATION,
-        OATYPE_FENCE_POINT
-    };
+    // node indexes
+    static const uint16_t NODE_SOURCE = 0;
+    static const uint16_t NODE_DESTINATION = 1;
+    static const uint16_t NODE_FIRST_POINT = 2;
+
+    // remove all nodes and free memory
+    void clear();
+
+    // set the points the path may pass through and calculate the
+    // visibility between them. Any source and destination must be set again
+    // returns false on allocation failure or too many points
+    bool set_points(const Vector2f *points, uint16_t num_points, const AC_FenceZones &zones) {
+        return update_points(points, num_points, zones, nullptr);
+    }
 
-    // support up to 255 items of each type
-    typedef uint8_t oaid_num;
+    // replace the points after a fence change.  Visibility between two
+    // points which have not moved is kept unless the segment between
+    // them intersects changed_zones, the zones added or removed since
+    // the previous points were set.  If changed_zones is nullptr all
+    // visibility is recalculated. Any source and destination must be set again
+    // returns false on allocation failure or too many points
+    bool update_points(const Vector2f *points, uint16_t num_points, const AC_FenceZones &zones,
+                       const AC_FenceZones *changed_zones);
 
-    // id for uniquely identifying objects held in visibility graphs and paths
-    class OAItemID {
-    public:
-        OAType id_type;
-        oaid_num id_num;
-        bool operator ==(const OAItemID &i) const { return ((id_type == i.id_type) && (id_num == i.id_num)); }
-    };
+    // set the source or destination. Visibility is only recalculated if the position has changed
+    // returns false if set_points has not been run
+    bool set_source(const Vector2f &pos, const AC_FenceZones &zones) { return set_endpoint(NODE_SOURCE, pos, zones); }
+    bool set_destination(const Vector2f &pos, const AC_FenceZones &zones) { return set_endpoint(NODE_DESTINATION, pos, zones); }
 
-    struct VisGraphItem {
-        OAItemID id1;       // first item's id
-        OAItemID id2;       // second item's id
-        float distance_cm;  // distance between the items
-    };
+    // find the shortest path from source to destination using an A*
+    // search with a straight line distance heuristic.  returns true on success
+    bool find_path();
 
-    // clear all elements from graph
-    void clear() { _num_items = 0; }
+    // number of nodes in the path found by find_path, including source and destination
+    uint16_t path_length() const { return _path_length; }
 
-    // get number of items in visibility graph table
-    uint8_t num_items() const { return _num_items; }
+    // returns position of a node on the path, 0 is the source
+    const Vector2f &path_point(uint16_t i) const { return _pos[_path[i]]; }
 
-    // add item to visiblity graph, returns true on success, false if graph is full
-    bool add_item(const OAItemID &id1, const OAItemID &id2, float distance_cm);
+    // number of points (excluding source and destination)
+    uint16_t num_points() const { return _num_nodes > NODE_FIRST_POINT ? _num_nodes - NODE_FIRST_POINT : 0; }
 
-    // allow accessing graph as an array, 0 indexed
-    // Note: no protection against out-of-bounds accesses so use with num_items()
-    const VisGraphItem& operator[](uint8_t i) const { return _items[i]; }
+    // returns true if two nodes are visible from each other
+    bool visible(uint16_t a, uint16_t b) const {
+        return (_visible[a * _row_words + b / 32] & (1U << (b % 32))) != 0;
+    }
+
+    // count of visibility tests performed, for benchmarking
+    uint32_t num_visibility_tests() const { return _num_tests; }
 
 private:
 
-    AP_ExpandingArray<VisGraphItem> _items;
-    uint8_t _num_items;
+    static const uint16_t HEAP_IDX_UNSEEN = UINT16_MAX;     // node has not been reached
+    static const uint16_t HEAP_IDX_CLOSED = UINT16_MAX-1;   // shortest distance to node is known
+
+    // set or clear visibility between two nodes
+    void set_visible(uint16_t a, uint16_t b, bool visible);
+
+    // move the source or destination and recalculate its visibility
+    bool set_endpoint(uint16_t node, const Vector2f &pos, const AC_FenceZones &zones);
+
+    // binary heap of open nodes ordered by estimated total distance
+    void heap_push_or_update(uint16_t node);
+    uint16_t heap_pop();
+    void heap_sift_up(uint16_t i);
+    void heap_sift_down(uint16_t i);
+
+    uint16_t _num_nodes = 0;            // number of nodes including source and destination
+    uint16_t _row_words = 0;            // number of 32 bit words in each row of the visibility matrix
+    uint32_t *_visible = nullptr;       // visibility matrix, one bit per pair of nodes
+    Vector2f *_pos = nullptr;           // node positions
+    bool _endpoint_set[2] {};           // true once source or destination has been set
+
+    // search state
+    float *_dist = nullptr;             // distance from source to each node
+    float *_cost = nullptr;             // distance from source plus estimated distance to destination
+    uint16_t *_prev = nullptr;          // previous node on shortest path to each node
+    uint16_t *_heap = nullptr;          // heap of open nodes
+    uint16_t *_heap_idx = nullptr;      // position of each node in heap, or HEAP_IDX_UNSEEN or HEAP_IDX_CLOSED
+    uint16_t _heap_size = 0;
+    uint16_t *_path = nullptr;          // nodes on path from source to destination
+    uint16_t _path_length = 0;
+
+    uint32_t _num_tests = 0;            // number of visibility tests performed
 };
@@ -0,0 +1,159 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <AP_gbenchmark.h>
+
+#include <AC_Avoidance/AP_OASpatialHash.h>
+
+#include <stdlib.h>
+
+/*
+  objects scattered over a 200m square, as returned by a lidar as the
+  vehicle moves around an area. Positions are in meters
+ */
+static const float AREA_SIZE_M = 200.0f;
+static const float FILTER_RADIUS_M = 0.2f;     // default object database filter radius
+static const float CELL_SIZE_M = 2.0f;
+
+static Vector2f random_position()
+{
+    return Vector2f(AREA_SIZE_M * rand() / (float)RAND_MAX, AREA_SIZE_M * rand() / (float)RAND_MAX);
+}
+
+static void fill(AP_OASpatialHash &hash, Vector2f *pos, uint16_t count)
+{
+    srand(1);
+    hash.init(count, CELL_SIZE_M);
+    for (uint16_t i=0; i<count; i++) {
+        pos[i] = random_position();
+        hash.add(i, pos[i]);
+    }
+}
+
+/* check if a new lidar return is close to an existing object, using the spatial hash */
+static void BM_OASpatialHashDedupe(benchmark::State& state)
+{
+    const uint16_t count = state.range(0);
+    AP_OASpatialHash hash;
+    Vector2f *pos = new Vector2f[count];
+    fill(hash, pos, count);
+    const Vector2f radius_vec(FILTER_RADIUS_M, FILTER_RADIUS_M);
+
+    while (state.KeepRunning()) {
+        const Vector2f p = random_position();
+        bool found = hash.for_each_in_box(p - radius_vec, p + radius_vec, [&](uint16_t i) {
+            return (hash.position(i) - p).length_squared() < sq(FILTER_RADIUS_M);
+        });
+        gbenchmark_escape(&found);
+    }
+    delete[] pos;
+}
+
+/* check if a new lidar return is close to an existing object by checking every object */
+static void BM_OASpatialHashDedupeLinear(benchmark::State& state)
+{
+    const uint16_t count = state.range(0);
+    AP_OASpatialHash hash;
+    Vector2f *pos = new Vector2f[count];
+    fill(hash, pos, count);
+
+    while (state.KeepRunning()) {
+        const Vector2f p = random_position();
+        bool found = false;
+        for (uint16_t i=0; i<count; i++) {
+            if ((pos[i] - p).length_squared() < sq(FILTER_RADIUS_M)) {
+                found = true;
+                break;
+            }
+        }
+        gbenchmark_escape(&found);
+    }
+    delete[] pos;
+}
+
+/* expire an object and replace it with a new one, as the database does */
+static void BM_OASpatialHashReplace(benchmark::State& state)
+{
+    const uint16_t count = state.range(0);
+    AP_OASpatialHash hash;
+    Vector2f *pos = new Vector2f[count];
+    fill(hash, pos, count);
+
+    uint16_t idx = 0;
+    while (state.KeepRunning()) {
+        // remove by moving the last object over the expired object, then add a new object at the end
+        hash.remove(idx);
+        hash.move(count - 1, idx);
+        hash.add(count - 1, random_position());
+        idx = (idx + 1) % (count - 1);
+    }
+    delete[] pos;
+}
+
+/* closest object to a 15m path segment, as BendyRuler checks for each bearing */
+static void BM_OASpatialHashSegment(benchmark::State& state)
+{
+    const uint16_t count = state.range(0);
+    AP_OASpatialHash hash;
+    Vector2f *pos = new Vector2f[count];
+    fill(hash, pos, count);
+    const float max_dist = 6.0f;
+    const Vector2f dist_vec(max_dist, max_dist);
+
+    float bearing = 0;
+    while (state.KeepRunning()) {
+        const Vector2f start(AREA_SIZE_M * 0.5f, AREA_SIZE_M * 0.5f);
+        const Vector2f end = start + Vector2f(cosf(bearing), sinf(bearing)) * 15.0f;
+        bearing += radians(5);
+        const Vector2f box_min = Vector2f(MIN(start.x, end.x), MIN(start.y, end.y)) - dist_vec;
+        const Vector2f box_max = Vector2f(MAX(start.x, end.x), MAX(start.y, end.y)) + dist_vec;
+        float smallest = FLT_MAX;
+        hash.for_each_in_box(box_min, box_max, [&](uint16_t i) {
+            smallest = MIN(smallest, Vector2f::closest_distance_between_line_and_point(start, end, hash.position(i)));
+            return false;
+        });
+        gbenchmark_escape(&smallest);
+    }
+    delete[] pos;
+}
+
+/* closest object to a 15m path segment by checking every object */
+static void BM_OASpatialHashSegmentLinear(benchmark::State& state)
+{
+    const uint16_t count = state.range(0);
+    AP_OASpatialHash hash;
+    Vector2f *pos = new Vector2f[count];
+    fill(hash, pos, count);
+
+    float bearing = 0;
+    while (state.KeepRunning()) {
+        const Vector2f start(AREA_SIZE_M * 0.5f, AREA_SIZE_M * 0.5f);
+        const Vector2f end = start + Vector2f(cosf(bearing), sinf(bearing)) * 15.0f;
+        bearing += radians(5);
+        float smallest = FLT_MAX;
+        for (uint16_t i=0; i<count; i++) {
+            smallest = MIN(smallest, Vector2f::closest_distance_between_line_and_point(start, end, pos[i]));
+        }
+        gbenchmark_escape(&smallest);
+    }
+    delete[] pos;
+}
+
+BENCHMARK(BM_OASpatialHashDedupe)->Arg(1000)->Arg(2000)->Arg(5000);
+BENCHMARK(BM_OASpatialHashDedupeLinear)->Arg(1000)->Arg(2000)->Arg(5000);
+BENCHMARK(BM_OASpatialHashReplace)->Arg(1000)->Arg(2000)->Arg(5000);
+BENCHMARK(BM_OASpatialHashSegment)->Arg(1000)->Arg(2000)->Arg(5000);
+BENCHMARK(BM_OASpatialHashSegmentLinear)->Arg(1000)->Arg(2000)->Arg(5000);
+
+BENCHMARK_MAIN()
@@ -0,0 +1,140 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <AP_gbenchmark.h>
+
+#include <AC_Avoidance/AP_OAVisGraph.h>
+
+/*
+  star shaped inclusion fence with num_vertices vertices alternating
+  between 100m and 60m from the origin, with a path point just inside
+  each vertex.  The concave vertices mean many pairs of points are not
+  visible from each other
+ */
+class StarFence {
+public:
+    explicit StarFence(uint16_t num_vertices) :
+        _num_points(num_vertices)
+    {
+        Vector2f *verts = new Vector2f[num_vertices];
+        _points = new Vector2f[num_vertices];
+        for (uint16_t i=0; i<num_vertices; i++) {
+            const float angle = M_2PI * i / num_vertices;
+            const float radius = (i % 2 == 0) ? 10000.0f : 6000.0f;
+            verts[i] = Vector2f(cosf(angle), sinf(angle)) * radius;
+            _points[i] = verts[i] * 0.97f;
+        }
+        zones.init(num_vertices, 1, 0);
+        zones.add_polygon(verts, num_vertices, true);
+        zones.build_index();
+        delete[] verts;
+    }
+
+    ~StarFence() { delete[] _points; }
+
+    const Vector2f *points() const { return _points; }
+    uint16_t num_points() const { return _num_points; }
+
+    // positions on opposite sides of the fence, between spikes
+    static Vector2f source() { return Vector2f(5000.0f, 100.0f); }
+    static Vector2f destination() { return Vector2f(-5000.0f, -100.0f); }
+
+    AC_FenceZones zones;
+
+private:
+    Vector2f *_points;
+    uint16_t _num_points;
+};
+
+/* full visibility graph calculation after a fence change */
+static void BM_OAVisGraphBuild(benchmark::State& state)
+{
+    StarFence fence(state.range(0));
+    AP_OAVisGraph visgraph;
+
+    while (state.KeepRunning()) {
+        bool ok = visgraph.set_points(fence.points(), fence.num_points(), fence.zones);
+        gbenchmark_escape(&ok);
+    }
+}
+
+/*
+  update after an exclusion zone in the middle of the fence moves,
+  recalculating only the segments which cross the old or new zone
+ */
+static void BM_OAVisGraphFenceChange(benchmark::State& state)
+{
+    StarFence fence(state.range(0));
+    const Vector2f square[] = {{-500, -500}, {500, -500}, {500, 500}, {-500, 500}};
+    Vector2f moved[ARRAY_SIZE(square)];
+    AC_FenceZones zones[2];
+    for (uint8_t z=0; z<2; z++) {
+        for (uint8_t i=0; i<ARRAY_SIZE(square); i++) {
+            moved[i] = square[i] + Vector2f(z * 2000.0f, 0);
+        }
+        zones[z].init(fence.zones.num_vertices() + ARRAY_SIZE(square), 2, 0);
+        zones[z].add_polygon(fence.zones.vertices(), fence.zones.num_vertices(), true);
+        zones[z].add_polygon(moved, ARRAY_SIZE(moved), false);
+        zones[z].build_index();
+    }
+    AC_FenceZones changed;
+    changed.set_difference(zones[0], zones[1]);
+
+    AP_OAVisGraph visgraph;
+    visgraph.set_points(fence.points(), fence.num_points(), zones[0]);
+    uint8_t z = 0;
+    while (state.KeepRunning()) {
+        z = 1 - z;
+        bool ok = visgraph.update_points(fence.points(), fence.num_points(), zones[z], &changed);
+        gbenchmark_escape(&ok);
+    }
+}
+
+/* incremental update as the vehicle moves */
+static void BM_OAVisGraphMoveSource(benchmark::State& state)
+{
+    StarFence fence(state.range(0));
+    AP_OAVisGraph visgraph;
+    visgraph.set_points(fence.points(), fence.num_points(), fence.zones);
+    visgraph.set_destination(StarFence::destination(), fence.zones);
+
+    Vector2f source = StarFence::source();
+    while (state.KeepRunning()) {
+        source.x += (source.x > 5500.0f) ? -1000.0f : 1.0f;
+        bool ok = visgraph.set_source(source, fence.zones);
+        gbenchmark_escape(&ok);
+    }
+}
+
+/* shortest path search */
+static void BM_OAVisGraphFindPath(benchmark::State& state)
+{
+    StarFence fence(state.range(0));
+    AP_OAVisGraph visgraph;
+    visgraph.set_points(fence.points(), fence.num_points(), fence.zones);
+    visgraph.set_source(StarFence::source(), fence.zones);
+    visgraph.set_destination(StarFence::destination(), fence.zones);
+
+    while (state.KeepRunning()) {
+        bool ok = visgraph.find_path();
+        gbenchmark_escape(&ok);
+    }
+}
+
+BENCHMARK(BM_OAVisGraphBuild)->Arg(50)->Arg(100)->Arg(200);
+BENCHMARK(BM_OAVisGraphFenceChange)->Arg(50)->Arg(100)->Arg(200);
+BENCHMARK(BM_OAVisGraphMoveSource)->Arg(50)->Arg(100)->Arg(200);
+BENCHMARK(BM_OAVisGraphFindPath)->Arg(50)->Arg(100)->Arg(200);
+
+BENCHMARK_MAIN()
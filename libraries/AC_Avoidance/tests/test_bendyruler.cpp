@@ -0,0 +1,132 @@
+#include <AP_gtest.h>
+
+#include <AC_Avoidance/AP_OABendyRuler.h>
+#include <AP_Math/AP_Math.h>
+
+const AP_HAL::HAL &hal = AP_HAL::get_HAL();
+
+class AP_OABendyRuler_Test
+{
+public:
+    // allocated with new so members are zeroed
+    AP_OABendyRuler_Test() : br(*new AP_OABendyRuler()) {}
+    ~AP_OABendyRuler_Test() { delete &br; }
+
+    // margins from the batch calculation for segments from the
+    // vehicle, with obstacles gathered from zones
+    void batch_margins(const AC_FenceZones &zones, const Vector2f &vehicle_NE, const Vector2f *ends, uint8_t num_ends, float *margins)
+    {
+        br._num_fence_edges = 0;
+        br._num_fence_polygons = 0;
+        br._num_fence_circles = 0;
+        br._num_objects = 0;
+        br._vehicle_outside_polygons = 0;
+        br.update_fence_obstacles(zones, vehicle_NE, 1000.0f, nullptr, 0);
+        br.calc_avoidance_margins(Vector2f(), br._vehicle_outside_polygons, ends, num_ends, margins);
+    }
+
+private:
+    AP_OABendyRuler &br;
+};
+
+/*
+  margin for a segment as calculated one polygon at a time before the
+  calculation was batched, in meters.  Positions are in cm
+ */
+static float scalar_margin(const AC_FenceZones &zones, const Vector2f &start, const Vector2f &end)
+{
+    float margin = FLT_MAX;
+    for (uint8_t p=0; p<zones.num_polygons(); p++) {
+        // closed copy of the polygon
+        const uint16_t n = zones.polygon(p).count;
+        Vector2f boundary[32];
+        if (n >= ARRAY_SIZE(boundary)) {
+            return -FLT_MAX;
+        }
+        memcpy(boundary, zones.polygon_points(p), n * sizeof(Vector2f));
+        boundary[n] = boundary[0];
+
+        // if outside the fence margin is the closest distance but with negative sign
+        const bool outside = Polygon_outside(start, boundary, n+1) == zones.polygon(p).inclusion;
+        const float sign = outside ? -1.0f : 1.0f;
+        margin = MIN(margin, sign * Polygon_closest_distance_line(boundary, n+1, start, end) * 0.01f);
+    }
+    return margin;
+}
+
+// probe every bearing from the vehicle, as the first step of BendyRuler does
+static void check_against_scalar(const AC_FenceZones &zones, const Vector2f &vehicle_NE)
+{
+    AP_OABendyRuler_Test test;
+    Vector2f ends[OA_BENDYRULER_BEARINGS_MAX];
+    float margins[OA_BENDYRULER_BEARINGS_MAX];
+    for (uint8_t i=0; i<OA_BENDYRULER_BEARINGS_MAX; i++) {
+        const float bearing = radians(i * OA_BENDYRULER_BEARING_INC);
+        ends[i] = Vector2f(cosf(bearing), sinf(bearing)) * 15.0f;
+    }
+    test.batch_margins(zones, vehicle_NE, ends, OA_BENDYRULER_BEARINGS_MAX, margins);
+    for (uint8_t i=0; i<OA_BENDYRULER_BEARINGS_MAX; i++) {
+        EXPECT_NEAR(margins[i], scalar_margin(zones, vehicle_NE, vehicle_NE + ends[i] * 100.0f), 0.01f);
+    }
+}
+
+// star shaped inclusion fence around the origin
+static bool setup_star(AC_FenceZones &zones)
+{
+    const uint16_t num_points = 24;
+    Vector2f star[num_points];
+    for (uint16_t i=0; i<num_points; i++) {
+        const float angle = M_2PI * i / num_points;
+        const float radius = (i % 2) ? 3000 : 4000;
+        star[i] = Vector2f(cosf(angle), sinf(angle)) * radius;
+    }
+    return zones.init(num_points, 1, 0) &&
+           zones.add_polygon(star, num_points, true) &&
+           zones.build_index();
+}
+
+TEST(AP_OABendyRuler, InsideFence)
+{
+    AC_FenceZones zones;
+    EXPECT_TRUE(setup_star(zones));
+    check_against_scalar(zones, Vector2f(0, 0));
+    check_against_scalar(zones, Vector2f(2500, 500));
+    check_against_scalar(zones, Vector2f(-1000, -2700));
+}
+
+// segments crossing back into the fence have a positive margin
+TEST(AP_OABendyRuler, OutsideFence)
+{
+    AC_FenceZones zones;
+    EXPECT_TRUE(setup_star(zones));
+    check_against_scalar(zones, Vector2f(4200, 0));
+    check_against_scalar(zones, Vector2f(0, -3500));
+    check_against_scalar(zones, Vector2f(-5000, 5000));
+
+    // beyond the search radius the fence still ranks the bearings back towards it
+    check_against_scalar(zones, Vector2f(150000, 0));
+}
+
+// each polygon's margin takes its sign from the side of that polygon the segment starts on
+TEST(AP_OABendyRuler, InsideExclusionZone)
+{
+    static const Vector2f outer[] = {{-5000, -5000}, {5000, -5000}, {5000, 5000}, {-5000, 5000}};
+    static const Vector2f inner[] = {{3500, -500}, {4500, -500}, {4500, 500}, {3500, 500}};
+    AC_FenceZones zones;
+    EXPECT_TRUE(zones.init(ARRAY_SIZE(outer) + ARRAY_SIZE(inner), 2, 0));
+    EXPECT_TRUE(zones.add_polygon(outer, ARRAY_SIZE(outer), true));
+    EXPECT_TRUE(zones.add_polygon(inner, ARRAY_SIZE(inner), false));
+    EXPECT_TRUE(zones.build_index());
+
+    check_against_scalar(zones, Vector2f(4000, 0));
+    check_against_scalar(zones, Vector2f(0, 0));
+
+    // leaving the exclusion zone through the inclusion fence is not clear
+    AP_OABendyRuler_Test test;
+    const Vector2f end(15.0f, 0.0f);
+    float margin;
+    test.batch_margins(zones, Vector2f(4000, 0), &end, 1, &margin);
+    EXPECT_LT(margin, 0.0f);
+}
+
+AP_GTEST_MAIN()
@@ -259,7 +259,7 @@ bool AC_Fence::polygon_fence_is_breached()
     }
 
     // check consistency of number of points
-    if (_boundary_num_points != _total) {
+    if (boundary_needs_reload()) {
         // Fence is currently not completely loaded.  Can't breach it?!
         load_polygon_from_eeprom();
         return false;
@@ -277,7 +277,7 @@ bool AC_Fence::polygon_fence_is_breached()
     }
 
     position = position * 100.0f;  // m to cm
-    return _poly_loader.boundary_breached(position, _boundary_num_points, _boundary);
+    return _zones.breached(position);
 }
 
 bool AC_Fence::check_fence_circle()
@@ -385,11 +385,11 @@ bool AC_Fence::check_destination_within_fence(const Location& loc)
     }
 
     // polygon fence check
-    if ((get_enabled_fences() & AC_FENCE_TYPE_POLYGON) && _boundary_num_points > 0) {
+    if ((get_enabled_fences() & AC_FENCE_TYPE_POLYGON) && _boundary_valid) {
         // check ekf has a good location
         Vector2f posNE;
         if (loc.get_vector_xy_from_origin_NE(posNE)) {
-            if (_poly_loader.boundary_breached(posNE, _boundary_num_points, _boundary)) {
+            if (_zones.breached(posNE)) {
                 return false;
             }
         }
@@ -449,22 +449,14 @@ void AC_Fence::manual_recovery_start()
 }
 
 /// returns pointer to array of polygon points and num_points is filled in with the total number
-Vector2f* AC_Fence::get_boundary_points(uint16_t& num_points) const
+const Vector2f* AC_Fence::get_boundary_points(uint16_t& num_points) const
 {
-    // return array minus the first point which holds the return location
-    if (_boundary == nullptr) {
-        return nullptr;
-    }
-    if (!_boundary_valid) {
-        return nullptr;
-    }
-    // minus one for return point, minus one for closing point
-    // (_boundary_valid is not true unless we have a closing point AND
-    // we have a minumum number of points)
-    if (_boundary_num_points < 2) {
+    // return the first inclusion polygon, copied after the return
+    // point of the boundary array as the zones are freed on reload
+    if (_boundary == nullptr || !_boundary_valid || _boundary_polygon_points == 0) {
         return nullptr;
     }
-    num_points = _boundary_num_points - 2;
+    num_points = _boundary_polygon_points;
     return &_boundary[1];
 }
 
@@ -485,6 +477,11 @@ void AC_Fence::handle_msg(GCS_MAVLINK &link, const mavlink_message_t &msg)
             if (!check_latlng(packet.lat,packet.lng)) {
                 link.send_text(MAV_SEVERITY_WARNING, "Invalid fence point, lat or lng too large");
             } else {
+                // legacy points replace any fence items
+                if (_poly_loader.num_saved_items() > 0) {
+                    _poly_loader.truncate_items(0);
+                    _poly_loader.save_items();
+                }
                 Vector2l point;
                 point.x = packet.lat*1.0e7f;
                 point.y = packet.lng*1.0e7f;
@@ -518,20 +515,17 @@ void AC_Fence::handle_msg(GCS_MAVLINK &link, const mavlink_message_t &msg)
     }
 }
 
+// returns true if the fence points or items have changed since they were loaded
+bool AC_Fence::boundary_needs_reload()
+{
+    return !_zones_loaded ||
+           _boundary_num_points != _total ||
+           _items_version != _poly_loader.items_version();
+}
+
 /// load polygon points stored in eeprom into boundary array and perform validation
 bool AC_Fence::load_polygon_from_eeprom()
 {
-    // check if we need to create array
-    if (!_boundary_create_attempted) {
-        _boundary = (Vector2f *)_poly_loader.create_point_array(sizeof(Vector2f));
-        _boundary_create_attempted = true;
-    }
-
-    // exit if we could not allocate RAM for the boundary
-    if (_boundary == nullptr) {
-        return false;
-    }
-
     // get current location from EKF
     Location temp_loc;
     if (!AP::ahrs_navekf().get_location(temp_loc)) {
@@ -545,6 +539,44 @@ bool AC_Fence::load_polygon_from_eeprom()
     // sanity check total
     _total = constrain_int16(_total, 0, _poly_loader.max_points());
 
+    WITH_SEMAPHORE(_zones_sem);
+
+    _boundary_polygon_points = 0;
+
+    // check if we need to create array
+    if (!_boundary_create_attempted) {
+        _boundary = (Vector2f *)_poly_loader.create_point_array(sizeof(Vector2f));
+        _boundary_create_attempted = true;
+    }
+
+    // fence items take priority over the legacy polygon
+    if (_poly_loader.num_saved_items() > 0) {
+        _boundary_valid = _poly_loader.load_zones(_zones, ekf_origin);
+        _boundary_num_points = _total;
+        _items_version = _poly_loader.items_version();
+        _boundary_update_ms = AP_HAL::millis();
+        _zones_loaded = true;
+        // keep a copy of the first inclusion polygon for get_boundary_points()
+        for (uint8_t i=0; i<_zones.num_polygons() && _boundary != nullptr; i++) {
+            const AC_FenceZones::Polygon &polygon = _zones.polygon(i);
+            if (polygon.inclusion) {
+                if (polygon.count < _poly_loader.max_points()) {
+                    memcpy(&_boundary[1], _zones.polygon_points(i), polygon.count * sizeof(Vector2f));
+                    _boundary_polygon_points = polygon.count;
+                }
+                break;
+            }
+        }
+        return true;
+    }
+
+    _zones.clear();
+
+    // exit if we could not allocate RAM for the boundary
+    if (_boundary == nullptr) {
+        return false;
+    }
+
     // load each point from eeprom
     Vector2l temp_latlon;
     for (uint16_t index=0; index<_total; index++) {
@@ -559,10 +591,33 @@ bool AC_Fence::load_polygon_from_eeprom()
     }
     _boundary_num_points = _total;
     _boundary_update_ms = AP_HAL::millis();
+    _items_version = _poly_loader.items_version();
+    _zones_loaded = true;
 
     // update validity of polygon
     _boundary_valid = _poly_loader.boundary_valid(_boundary_num_points, _boundary);
+    if (_boundary_valid) {
+        _boundary_valid = load_zones_from_boundary();
+    }
+    if (_boundary_valid) {
+        // minus one for return point, minus one for closing point
+        _boundary_polygon_points = _boundary_num_points - 2;
+    }
+
+    return true;
+}
 
+/// load the legacy polygon into the zones as a single inclusion zone
+bool AC_Fence::load_zones_from_boundary()
+{
+    // minus one for return point, minus one for closing point
+    const uint16_t num_points = _boundary_num_points - 2;
+    if (!_zones.init(num_points, 1, 0) ||
+        !_zones.add_polygon(&_boundary[1], num_points, true) ||
+        !_zones.build_index()) {
+        _zones.clear();
+        return false;
+    }
     return true;
 }
 
@@ -104,8 +104,16 @@ public:
     bool is_polygon_valid() const { return _boundary_valid; }
 
     /// returns pointer to array of polygon points and num_points is filled in with the total number
-    /// points are offsets from EKF origin in NE frame
-    Vector2f* get_boundary_points(uint16_t& num_points) const;
+    /// points are offsets from EKF origin in NE frame.  This is the first inclusion polygon
+    const Vector2f* get_boundary_points(uint16_t& num_points) const;
+
+    /// returns all inclusion and exclusion zones, as offsets from EKF origin in NE frame
+    /// callers outside the main thread must hold the zones semaphore
+    const AC_FenceZones &get_zones() const { return _zones; }
+    HAL_Semaphore &get_zones_semaphore() { return _zones_sem; }
+
+    /// returns the loader used to store fence points and items
+    AC_PolyFence_loader &polyfence() { return _poly_loader; }
 
     /// returns true if we've breached the polygon boundary.  simple passthrough to underlying _poly_loader object
     bool boundary_breached(const Vector2f& location, uint16_t num_points, const Vector2f* points) const;
@@ -152,6 +160,12 @@ private:
     /// load polygon points stored in eeprom into boundary array and perform validation.  returns true if load successfully completed
     bool load_polygon_from_eeprom();
 
+    // returns true if the fence points or items have changed since they were loaded
+    bool boundary_needs_reload();
+
+    // load the legacy polygon into the zones as a single inclusion zone
+    bool load_zones_from_boundary();
+
     // returns true if we have breached the fence:
     bool polygon_fence_is_breached();
 
@@ -191,7 +205,14 @@ private:
     uint8_t         _boundary_num_points = 0;       // number of points in the boundary array (should equal _total parameter after load has completed)
     bool            _boundary_create_attempted = false; // true if we have attempted to create the boundary array
     bool            _boundary_valid = false;        // true if boundary forms a closed polygon
+    uint16_t        _boundary_polygon_points = 0;   // number of points of the first inclusion polygon, copied to the boundary array from point 1
     uint32_t        _boundary_update_ms;            // system time of last update to the boundary
+
+    // inclusion and exclusion zones, loaded from fence items or the legacy polygon
+    AC_FenceZones   _zones;
+    HAL_Semaphore   _zones_sem;                     // protects _zones from updates while in use by other threads
+    bool            _zones_loaded;                  // true once the zones have been loaded
+    uint16_t        _items_version;                 // version of the fence items the zones were loaded from
 };
 
 namespace AP {
@@ -0,0 +1,481 @@
+#include "AC_FenceZones.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+  remove all zones and allocate space for the given number of
+  vertices, polygons and circles. Memory already allocated is reused
+  if it is large enough, so zones which are refilled repeatedly don't
+  churn the heap
+ */
+bool AC_FenceZones::init(uint16_t num_vertices, uint8_t num_polygons, uint8_t num_circles)
+{
+    num_polygons = MIN(num_polygons, AC_FENCEZONES_MAX_POLYGONS);
+    num_circles = MIN(num_circles, AC_FENCEZONES_MAX_CIRCLES);
+
+    // the index no longer matches the zones, but its memory is kept
+    _cells_x = _cells_y = 0;
+    if (num_vertices <= _max_vertices && num_polygons <= _max_polygons && num_circles <= _max_circles) {
+        _num_vertices = 0;
+        _num_polygons = 0;
+        _num_circles = 0;
+        return true;
+    }
+
+    free_memory();
+
+    if (num_vertices > 0) {
+        _vertices = (Vector2f *)calloc(num_vertices, sizeof(Vector2f));
+        _vertex_polygon = (uint8_t *)calloc(num_vertices, sizeof(uint8_t));
+    }
+    if (num_polygons > 0) {
+        _polygons = (Polygon *)calloc(num_polygons, sizeof(Polygon));
+    }
+    if (num_circles > 0) {
+        _circles = (Circle *)calloc(num_circles, sizeof(Circle));
+    }
+    if ((num_vertices > 0 && (_vertices == nullptr || _vertex_polygon == nullptr)) ||
+        (num_polygons > 0 && _polygons == nullptr) ||
+        (num_circles > 0 && _circles == nullptr)) {
+        free_memory();
+        return false;
+    }
+    _max_vertices = num_vertices;
+    _max_polygons = num_polygons;
+    _max_circles = num_circles;
+    return true;
+}
+
+// remove all zones and free memory
+void AC_FenceZones::clear()
+{
+    free_memory();
+}
+
+void AC_FenceZones::free_memory()
+{
+    free(_vertices);
+    _vertices = nullptr;
+    free(_vertex_polygon);
+    _vertex_polygon = nullptr;
+    free(_polygons);
+    _polygons = nullptr;
+    free(_circles);
+    _circles = nullptr;
+    free(_cell_start);
+    _cell_start = nullptr;
+    free(_cell_edges);
+    _cell_edges = nullptr;
+    _max_cells = 0;
+    _max_cell_edges = 0;
+    _num_vertices = _max_vertices = 0;
+    _num_polygons = _max_polygons = 0;
+    _num_circles = _max_circles = 0;
+    _cells_x = _cells_y = 0;
+}
+
+// add a polygon zone
+bool AC_FenceZones::add_polygon(const Vector2f *points, uint16_t num_points, bool inclusion)
+{
+    if (points == nullptr || num_points < 3 ||
+        _num_polygons >= _max_polygons ||
+        num_points > _max_vertices - _num_vertices) {
+        return false;
+    }
+
+    Polygon &poly = _polygons[_num_polygons];
+    poly.first = _num_vertices;
+    poly.count = num_points;
+    poly.inclusion = inclusion;
+    poly.min = points[0];
+    poly.max = points[0];
+    for (uint16_t i=0; i<num_points; i++) {
+        _vertices[_num_vertices + i] = points[i];
+        _vertex_polygon[_num_vertices + i] = _num_polygons;
+        poly.min.x = MIN(poly.min.x, points[i].x);
+        poly.min.y = MIN(poly.min.y, points[i].y);
+        poly.max.x = MAX(poly.max.x, points[i].x);
+        poly.max.y = MAX(poly.max.y, points[i].y);
+    }
+    _num_vertices += num_points;
+    _num_polygons++;
+    return true;
+}
+
+// add a circle zone
+bool AC_FenceZones::add_circle(const Vector2f &center, float radius_cm, bool inclusion)
+{
+    if (_num_circles >= _max_circles || !is_positive(radius_cm)) {
+        return false;
+    }
+    Circle &circle = _circles[_num_circles++];
+    circle.center = center;
+    circle.radius = radius_cm;
+    circle.inclusion = inclusion;
+    return true;
+}
+
+uint16_t AC_FenceZones::cell_x(float x) const
+{
+    const float cx = (x - _grid_min.x) * _cell_size_inv_x;
+    if (cx <= 0) {
+        return 0;
+    }
+    return MIN((uint16_t)cx, _cells_x-1);
+}
+
+uint16_t AC_FenceZones::cell_y(float y) const
+{
+    const float cy = (y - _grid_min.y) * _cell_size_inv_y;
+    if (cy <= 0) {
+        return 0;
+    }
+    return MIN((uint16_t)cy, _cells_y-1);
+}
+
+// range of cells overlapping a bounding box
+bool AC_FenceZones::cell_range(const Vector2f &min, const Vector2f &max, uint16_t &x0, uint16_t &y0, uint16_t &x1, uint16_t &y1) const
+{
+    if (_cells_x == 0 ||
+        max.x < _grid_min.x || max.y < _grid_min.y ||
+        min.x > _grid_max.x || min.y > _grid_max.y) {
+        return false;
+    }
+    x0 = cell_x(min.x);
+    y0 = cell_y(min.y);
+    x1 = cell_x(max.x);
+    y1 = cell_y(max.y);
+    return true;
+}
+
+/*
+  build the spatial index over the polygon edges. The grid covers the
+  bounding box of all polygons, with about one edge per cell for an
+  evenly spread fence. Each edge is registered in all cells its
+  bounding box overlaps, stored as a compressed array of edge indexes
+  per cell
+ */
+bool AC_FenceZones::build_index()
+{
+    _cells_x = _cells_y = 0;
+
+    if (_num_polygons == 0) {
+        return true;
+    }
+
+    _grid_min = _polygons[0].min;
+    _grid_max = _polygons[0].max;
+    for (uint8_t i=1; i<_num_polygons; i++) {
+        _grid_min.x = MIN(_grid_min.x, _polygons[i].min.x);
+        _grid_min.y = MIN(_grid_min.y, _polygons[i].min.y);
+        _grid_max.x = MAX(_grid_max.x, _polygons[i].max.x);
+        _grid_max.y = MAX(_grid_max.y, _polygons[i].max.y);
+    }
+
+    const uint16_t cells = constrain_int16(sqrtf(_num_vertices), 1, AC_FENCEZONES_GRID_CELLS_MAX);
+    const float size_x = MAX(_grid_max.x - _grid_min.x, 1.0f);
+    const float size_y = MAX(_grid_max.y - _grid_min.y, 1.0f);
+    _cells_x = cells;
+    _cells_y = cells;
+    _cell_size_inv_x = cells / size_x;
+    _cell_size_inv_y = cells / size_y;
+
+    const uint16_t num_cells = _cells_x * _cells_y;
+    if (num_cells > _max_cells) {
+        free(_cell_start);
+        _max_cells = 0;
+        _cell_start = (uint32_t *)calloc(num_cells + 1, sizeof(uint32_t));
+        if (_cell_start == nullptr) {
+            _cells_x = _cells_y = 0;
+            return false;
+        }
+        _max_cells = num_cells;
+    } else {
+        memset(_cell_start, 0, (num_cells + 1) * sizeof(uint32_t));
+    }
+
+    // count the edges in each cell, offset by one so the prefix sum
+    // below gives the start of each cell
+    for (uint16_t e=0; e<_num_vertices; e++) {
+        const Vector2f &v1 = _vertices[e];
+        const Vector2f &v2 = _vertices[next_vertex(e)];
+        const uint16_t x0 = cell_x(MIN(v1.x, v2.x));
+        const uint16_t x1 = cell_x(MAX(v1.x, v2.x));
+        const uint16_t y0 = cell_y(MIN(v1.y, v2.y));
+        const uint16_t y1 = cell_y(MAX(v1.y, v2.y));
+        for (uint16_t cy=y0; cy<=y1; cy++) {
+            for (uint16_t cx=x0; cx<=x1; cx++) {
+                _cell_start[cy * _cells_x + cx + 1]++;
+            }
+        }
+    }
+    for (uint16_t c=0; c<num_cells; c++) {
+        _cell_start[c+1] += _cell_start[c];
+    }
+
+    const uint32_t num_cell_edges = MAX(_cell_start[num_cells], 1U);
+    if (num_cell_edges > _max_cell_edges) {
+        free(_cell_edges);
+        _max_cell_edges = 0;
+        _cell_edges = (uint16_t *)calloc(num_cell_edges, sizeof(uint16_t));
+        if (_cell_edges == nullptr) {
+            _cells_x = _cells_y = 0;
+            return false;
+        }
+        _max_cell_edges = num_cell_edges;
+    }
+
+    // fill in the edges, using the start of each cell as a cursor
+    for (uint16_t e=0; e<_num_vertices; e++) {
+        const Vector2f &v1 = _vertices[e];
+        const Vector2f &v2 = _vertices[next_vertex(e)];
+        const uint16_t x0 = cell_x(MIN(v1.x, v2.x));
+        const uint16_t x1 = cell_x(MAX(v1.x, v2.x));
+        const uint16_t y0 = cell_y(MIN(v1.y, v2.y));
+        const uint16_t y1 = cell_y(MAX(v1.y, v2.y));
+        for (uint16_t cy=y0; cy<=y1; cy++) {
+            for (uint16_t cx=x0; cx<=x1; cx++) {
+                _cell_edges[_cell_start[cy * _cells_x + cx]++] = e;
+            }
+        }
+    }
+    // the cursors now hold the end of each cell, shift them back
+    for (uint16_t c=num_cells; c>0; c--) {
+        _cell_start[c] = _cell_start[c-1];
+    }
+    _cell_start[0] = 0;
+
+    return true;
+}
+
+// replace these zones with a copy of other
+bool AC_FenceZones::copy_from(const AC_FenceZones &other)
+{
+    if (!init(other._num_vertices, other._num_polygons, other._num_circles)) {
+        return false;
+    }
+    for (uint8_t i=0; i<other._num_polygons; i++) {
+        const Polygon &poly = other._polygons[i];
+        add_polygon(other.polygon_points(i), poly.count, poly.inclusion);
+    }
+    for (uint8_t i=0; i<other._num_circles; i++) {
+        const Circle &circle = other._circles[i];
+        add_circle(circle.center, circle.radius, circle.inclusion);
+    }
+    if (!build_index()) {
+        free_memory();
+        return false;
+    }
+    return true;
+}
+
+// returns true if these zones have a polygon identical to the given one
+bool AC_FenceZones::has_polygon(const Polygon &poly, const Vector2f *points) const
+{
+    for (uint8_t i=0; i<_num_polygons; i++) {
+        const Polygon &p = _polygons[i];
+        if (p.count == poly.count && p.inclusion == poly.inclusion &&
+            memcmp(polygon_points(i), points, poly.count * sizeof(Vector2f)) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// returns true if these zones have a circle identical to the given one
+bool AC_FenceZones::has_circle(const Circle &circle) const
+{
+    for (uint8_t i=0; i<_num_circles; i++) {
+        const Circle &c = _circles[i];
+        if (c.center == circle.center && is_equal(c.radius, circle.radius) && c.inclusion == circle.inclusion) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// add the zones of a which are not in b
+bool AC_FenceZones::add_missing(const AC_FenceZones &a, const AC_FenceZones &b)
+{
+    for (uint8_t i=0; i<a._num_polygons; i++) {
+        const Polygon &poly = a._polygons[i];
+        if (!b.has_polygon(poly, a.polygon_points(i)) &&
+            !add_polygon(a.polygon_points(i), poly.count, poly.inclusion)) {
+            return false;
+        }
+    }
+    for (uint8_t i=0; i<a._num_circles; i++) {
+        const Circle &circle = a._circles[i];
+        if (!b.has_circle(circle) &&
+            !add_circle(circle.center, circle.radius, circle.inclusion)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+  replace these zones with the zones which are in only one of a and b.
+  The number of zones is at most the sum of both, so space is
+  allocated for the vertices, polygons and circles of a and b
+ */
+bool AC_FenceZones::set_difference(const AC_FenceZones &a, const AC_FenceZones &b)
+{
+    if (!init(a._num_vertices + b._num_vertices,
+              MIN(a._num_polygons + b._num_polygons, AC_FENCEZONES_MAX_POLYGONS),
+              MIN(a._num_circles + b._num_circles, AC_FENCEZONES_MAX_CIRCLES))) {
+        return false;
+    }
+    if (!add_missing(a, b) || !add_missing(b, a) || !build_index()) {
+        free_memory();
+        return false;
+    }
+    return true;
+}
+
+/*
+  returns true if position is inside the given polygon, using an
+  even-odd crossing count
+ */
+bool AC_FenceZones::inside_polygon(uint8_t poly_idx, const Vector2f &pos) const
+{
+    if (poly_idx >= _num_polygons) {
+        return false;
+    }
+    const Polygon &poly = _polygons[poly_idx];
+    if (pos.x < poly.min.x || pos.x > poly.max.x ||
+        pos.y < poly.min.y || pos.y > poly.max.y) {
+        return false;
+    }
+    bool inside = false;
+    const Vector2f *v = &_vertices[poly.first];
+    for (uint16_t i=0, j=poly.count-1; i<poly.count; j=i++) {
+        if ((v[i].y > pos.y) != (v[j].y > pos.y) &&
+            pos.x < v[j].x + (pos.y - v[j].y) * (v[i].x - v[j].x) / (v[i].y - v[j].y)) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+/*
+  returns true if position is outside any inclusion zone or inside any
+  exclusion zone.
+
+  The polygons are tested together by casting a ray in the +x
+  direction along the cells of the row holding pos. An edge may be
+  registered in several of those cells, so a crossing is only counted
+  in the cell holding the crossing point
+ */
+bool AC_FenceZones::breached(const Vector2f &pos) const
+{
+    for (uint8_t i=0; i<_num_circles; i++) {
+        const bool inside = (pos - _circles[i].center).length_squared() < sq(_circles[i].radius);
+        if (inside != _circles[i].inclusion) {
+            return true;
+        }
+    }
+
+    if (_num_polygons == 0) {
+        return false;
+    }
+    if (_cells_x == 0) {
+        // no index, test each polygon in turn
+        for (uint8_t i=0; i<_num_polygons; i++) {
+            if (inside_polygon(i, pos) != _polygons[i].inclusion) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    uint64_t inside_mask = 0;
+    if (pos.y >= _grid_min.y && pos.y <= _grid_max.y) {
+        const uint16_t cy = cell_y(pos.y);
+        for (uint16_t cx=cell_x(pos.x); cx<_cells_x; cx++) {
+            const uint16_t cell = cy * _cells_x + cx;
+            for (uint32_t k=_cell_start[cell]; k<_cell_start[cell+1]; k++) {
+                const uint16_t e = _cell_edges[k];
+                const Vector2f &v1 = _vertices[e];
+                const Vector2f &v2 = _vertices[next_vertex(e)];
+                if ((v1.y > pos.y) == (v2.y > pos.y)) {
+                    continue;
+                }
+                const float x = v1.x + (pos.y - v1.y) * (v2.x - v1.x) / (v2.y - v1.y);
+                if (pos.x < x && cell_x(x) == cx) {
+                    inside_mask ^= 1ULL << _vertex_polygon[e];
+                }
+            }
+        }
+    }
+
+    for (uint8_t i=0; i<_num_polygons; i++) {
+        const bool inside = (inside_mask & (1ULL << i)) != 0;
+        if (inside != _polygons[i].inclusion) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+  returns true if the segment from start to end crosses any polygon
+  edge, enters an exclusion circle or leaves an inclusion circle
+ */
+bool AC_FenceZones::intersects(const Vector2f &start, const Vector2f &end) const
+{
+    for (uint8_t i=0; i<_num_circles; i++) {
+        const Circle &circle = _circles[i];
+        const bool start_inside = (start - circle.center).length_squared() < sq(circle.radius);
+        const bool end_inside = (end - circle.center).length_squared() < sq(circle.radius);
+        if (start_inside != end_inside) {
+            return true;
+        }
+        if (!start_inside &&
+            Vector2f::closest_distance_between_line_and_point_squared(start, end, circle.center) < sq(circle.radius)) {
+            // passes through the circle
+            return true;
+        }
+    }
+
+    if (_cells_x == 0) {
+        return false;
+    }
+    uint16_t x0, y0, x1, y1;
+    const Vector2f min(MIN(start.x, end.x), MIN(start.y, end.y));
+    const Vector2f max(MAX(start.x, end.x), MAX(start.y, end.y));
+    if (!cell_range(min, max, x0, y0, x1, y1)) {
+        return false;
+    }
+    for (uint16_t cy=y0; cy<=y1; cy++) {
+        for (uint16_t cx=x0; cx<=x1; cx++) {
+            const uint16_t cell = cy * _cells_x + cx;
+            for (uint32_t k=_cell_start[cell]; k<_cell_start[cell+1]; k++) {
+                const uint16_t e = _cell_edges[k];
+                Vector2f intersection;
+                if (Vector2f::segment_intersection(start, end, _vertices[e], _vertices[next_vertex(e)], intersection)) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+/*
+  returns distance in cm from pos to the closest polygon edge or circle
+  boundary, searching no further than max_dist_cm
+ */
+float AC_FenceZones::closest_boundary_distance(const Vector2f &pos, float max_dist_cm) const
+{
+    float closest_sq = sq(max_dist_cm);
+    for_each_edge_near(pos, max_dist_cm, [&](const Vector2f &v1, const Vector2f &v2, uint8_t) {
+        closest_sq = MIN(closest_sq, Vector2f::closest_distance_between_line_and_point_squared(v1, v2, pos));
+    });
+    float closest = sqrtf(closest_sq);
+    for (uint8_t i=0; i<_num_circles; i++) {
+        closest = MIN(closest, fabsf((pos - _circles[i].center).length() - _circles[i].radius));
+    }
+    return closest;
+}
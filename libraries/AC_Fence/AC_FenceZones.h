@@ -0,0 +1,169 @@
+#pragma once
+
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>
+
+#define AC_FENCEZONES_MAX_POLYGONS      64      // maximum number of polygons (inclusion plus exclusion)
+#define AC_FENCEZONES_MAX_CIRCLES       32      // maximum number of circles (inclusion plus exclusion)
+#define AC_FENCEZONES_GRID_CELLS_MAX    64      // maximum number of spatial index cells along each axis
+
+/*
+ * Fence zones held as offsets in cm from the EKF origin, with a uniform
+ * grid spatial index over the polygon edges.
+ *
+ * A position is inside the fence if it is inside every inclusion zone
+ * and outside every exclusion zone.  Polygons are "unclosed", i.e. the
+ * last vertex is not a copy of the first.
+ */
+class AC_FenceZones
+{
+public:
+    AC_FenceZones() {}
+    ~AC_FenceZones() { free_memory(); }
+
+    /* Do not allow copies */
+    AC_FenceZones(const AC_FenceZones &other) = delete;
+    AC_FenceZones &operator=(const AC_FenceZones&) = delete;
+
+    struct Polygon {
+        uint16_t first;         // index of first vertex in vertex array
+        uint16_t count;         // number of vertices
+        bool inclusion;         // true for inclusion, false for exclusion zone
+        Vector2f min;           // bounding box lower corner
+        Vector2f max;           // bounding box upper corner
+    };
+
+    struct Circle {
+        Vector2f center;        // centre as offset from EKF origin in cm
+        float radius;           // radius in cm
+        bool inclusion;         // true for inclusion, false for exclusion zone
+    };
+
+    // remove all zones and allocate space for the given number of
+    // vertices, polygons and circles, reusing memory already allocated
+    // if it is large enough.  returns false on allocation failure
+    bool init(uint16_t num_vertices, uint8_t num_polygons, uint8_t num_circles);
+
+    // remove all zones and free memory
+    void clear();
+
+    // add zones. Must be called after init and before build_index
+    // returns false if there is no space or the zone is invalid
+    bool add_polygon(const Vector2f *points, uint16_t num_points, bool inclusion);
+    bool add_circle(const Vector2f &center, float radius_cm, bool inclusion);
+
+    // build the spatial index over the polygon edges. Must be called
+    // after all zones have been added. returns false on allocation failure
+    bool build_index();
+
+    // replace these zones with a copy of other, including the index
+    // returns false on allocation failure
+    bool copy_from(const AC_FenceZones &other);
+
+    // replace these zones with the zones which are in only one of a and
+    // b. A segment which does not intersect them intersects a if and
+    // only if it intersects b.  returns false on allocation failure
+    bool set_difference(const AC_FenceZones &a, const AC_FenceZones &b);
+
+    // accessors
+    uint8_t num_polygons() const { return _num_polygons; }
+    const Polygon &polygon(uint8_t i) const { return _polygons[i]; }
+    uint8_t num_circles() const { return _num_circles; }
+    const Circle &circle(uint8_t i) const { return _circles[i]; }
+    uint16_t num_vertices() const { return _num_vertices; }
+    const Vector2f *vertices() const { return _vertices; }
+    const Vector2f *polygon_points(uint8_t i) const { return &_vertices[_polygons[i].first]; }
+
+    // returns true if there are no zones
+    bool empty() const { return _num_polygons == 0 && _num_circles == 0; }
+
+    // returns true if position is outside any inclusion zone or inside any exclusion zone
+    bool breached(const Vector2f &pos) const;
+
+    // returns true if position is inside the given polygon
+    bool inside_polygon(uint8_t poly_idx, const Vector2f &pos) const;
+
+    // returns true if the segment from start to end crosses any polygon
+    // edge, enters an exclusion circle or leaves an inclusion circle
+    bool intersects(const Vector2f &start, const Vector2f &end) const;
+
+    // returns distance in cm from pos to the closest polygon edge or
+    // circle boundary, searching no further than max_dist_cm.
+    // returns max_dist_cm if nothing is closer
+    float closest_boundary_distance(const Vector2f &pos, float max_dist_cm) const;
+
+    // call fn(start, end, poly_idx) for every polygon edge which may be
+    // within radius_cm of pos, where poly_idx is the index of the edge's
+    // polygon.  Edges are always passed with the polygon's vertex
+    // order.  An edge may be passed more than once
+    template <typename F>
+    void for_each_edge_near(const Vector2f &pos, float radius_cm, F fn) const
+    {
+        if (_cells_x == 0) {
+            return;
+        }
+        uint16_t x0, y0, x1, y1;
+        if (!cell_range(pos - Vector2f(radius_cm, radius_cm), pos + Vector2f(radius_cm, radius_cm), x0, y0, x1, y1)) {
+            return;
+        }
+        for (uint16_t cy=y0; cy<=y1; cy++) {
+            for (uint16_t cx=x0; cx<=x1; cx++) {
+                const uint16_t cell = cy * _cells_x + cx;
+                for (uint32_t k=_cell_start[cell]; k<_cell_start[cell+1]; k++) {
+                    const uint16_t e = _cell_edges[k];
+                    fn(_vertices[e], _vertices[next_vertex(e)], _vertex_polygon[e]);
+                }
+            }
+        }
+    }
+
+private:
+
+    void free_memory();
+
+    // returns true if zones has a polygon or circle identical to the given one
+    bool has_polygon(const Polygon &poly, const Vector2f *points) const;
+    bool has_circle(const Circle &circle) const;
+
+    // add the zones of a which are not in b
+    bool add_missing(const AC_FenceZones &a, const AC_FenceZones &b);
+
+    // index of the vertex following vertex v in its polygon
+    uint16_t next_vertex(uint16_t v) const {
+        const Polygon &poly = _polygons[_vertex_polygon[v]];
+        return (v+1 < poly.first + poly.count) ? v+1 : poly.first;
+    }
+
+    // spatial index cell column or row of a coordinate, clamped to the grid
+    uint16_t cell_x(float x) const;
+    uint16_t cell_y(float y) const;
+
+    // range of cells overlapping a bounding box. returns false if the
+    // box does not overlap the grid
+    bool cell_range(const Vector2f &min, const Vector2f &max, uint16_t &x0, uint16_t &y0, uint16_t &x1, uint16_t &y1) const;
+
+    // zones
+    Vector2f *_vertices = nullptr;
+    uint8_t *_vertex_polygon = nullptr;     // polygon index for each vertex
+    uint16_t _num_vertices = 0;
+    uint16_t _max_vertices = 0;
+    Polygon *_polygons = nullptr;
+    uint8_t _num_polygons = 0;
+    uint8_t _max_polygons = 0;
+    Circle *_circles = nullptr;
+    uint8_t _num_circles = 0;
+    uint8_t _max_circles = 0;
+
+    // spatial index. Edges are identified by their start vertex index.
+    // Edges in cell c are _cell_edges[_cell_start[c].._cell_start[c+1]-1]
+    Vector2f _grid_min;             // lower corner of the grid
+    Vector2f _grid_max;             // upper corner of the grid
+    float _cell_size_inv_x;
+    float _cell_size_inv_y;
+    uint16_t _cells_x = 0;
+    uint16_t _cells_y = 0;
+    uint32_t *_cell_start = nullptr;
+    uint16_t *_cell_edges = nullptr;
+    uint16_t _max_cells = 0;        // number of cells _cell_start has space for
+    uint32_t _max_cell_edges = 0;   // number of entries _cell_edges has space for
+};
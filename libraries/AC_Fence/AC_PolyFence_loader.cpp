@@ -1,9 +1,27 @@
 #include "AC_PolyFence_loader.h"
 
+#include <StorageManager/StorageManager.h>
+
 extern const AP_HAL::HAL& hal;
 
 static const StorageAccess fence_storage(StorageManager::StorageFence);
 
+// fence items start with this header.  The magic number is stored
+// where the legacy polygon's first latitude would be and can never be
+// a valid latitude, so legacy points and items can share storage
+#define AC_POLYFENCE_ITEMS_MAGIC 0x5A4F4E45
+
+#if AC_POLYFENCE_FILE_ENABLED
+#include <fcntl.h>
+#define AC_POLYFENCE_ITEMS_FILE HAL_BOARD_STORAGE_DIRECTORY "/fence.stg"
+#endif
+
+struct PACKED items_header {
+    uint32_t magic;
+    uint16_t count;
+    uint16_t reserved;
+};
+
 /*
   maximum number of fencepoints
  */
@@ -101,6 +119,345 @@ bool AC_PolyFence_loader::boundary_breached(const Vector2<T>& location, uint16_t
     return Polygon_outside(location, &points[start_num], num_points-start_num);
 }
 
+/*
+  maximum number of fence items
+ */
+uint16_t AC_PolyFence_loader::max_items() const
+{
+#if AC_POLYFENCE_FILE_ENABLED
+    return AC_POLYFENCE_FILE_MAX_ITEMS;
+#else
+    return (fence_storage.size() - sizeof(items_header)) / sizeof(AC_PolyFenceItem);
+#endif
+}
+
+// number of fence items stored
+uint16_t AC_PolyFence_loader::num_items()
+{
+    if (!load_items()) {
+        return 0;
+    }
+    return _num_items;
+}
+
+// number of fence items saved in storage
+uint16_t AC_PolyFence_loader::num_saved_items()
+{
+    if (!load_items()) {
+        return 0;
+    }
+    return _num_saved_items;
+}
+
+// get a single fence item, returns true on success
+bool AC_PolyFence_loader::get_item(uint16_t i, AC_PolyFenceItem &item)
+{
+    if (!load_items() || i >= _num_items) {
+        return false;
+    }
+    item = _items[i];
+    return true;
+}
+
+// set or append a single fence item, returns true on success
+bool AC_PolyFence_loader::set_item(uint16_t i, const AC_PolyFenceItem &item)
+{
+    if (!load_items() || i > _num_items || i >= max_items()) {
+        return false;
+    }
+    _items[i] = item;
+    if (i == _num_items) {
+        _num_items++;
+    }
+    return true;
+}
+
+// reduce the number of items to count
+void AC_PolyFence_loader::truncate_items(uint16_t count)
+{
+    if (!load_items()) {
+        return;
+    }
+    _num_items = MIN(_num_items, count);
+}
+
+/*
+  returns true if the items form complete zones. Each polygon is a run
+  of vertex items of the same type, each holding the vertex count
+ */
+bool AC_PolyFence_loader::items_valid(const AC_PolyFenceItem *items, uint16_t count)
+{
+    uint8_t num_polygons = 0;
+    uint8_t num_circles = 0;
+    uint16_t i = 0;
+    while (i < count) {
+        const AC_PolyFenceItem &item = items[i];
+        if (!check_latlng(item.lat, item.lng)) {
+            return false;
+        }
+        switch (item.type) {
+        case AC_PolyFenceType::POLYGON_INCLUSION:
+        case AC_PolyFenceType::POLYGON_EXCLUSION: {
+            const uint16_t num_vertices = item.param;
+            if (num_vertices < 3 || num_vertices > count - i) {
+                return false;
+            }
+            for (uint16_t j=1; j<num_vertices; j++) {
+                const AC_PolyFenceItem &vertex = items[i+j];
+                if (vertex.type != item.type ||
+                    vertex.param != num_vertices ||
+                    !check_latlng(vertex.lat, vertex.lng)) {
+                    return false;
+                }
+            }
+            if (++num_polygons > AC_FENCEZONES_MAX_POLYGONS) {
+                return false;
+            }
+            i += num_vertices;
+            break;
+        }
+        case AC_PolyFenceType::CIRCLE_INCLUSION:
+        case AC_PolyFenceType::CIRCLE_EXCLUSION:
+            if (item.param == 0 || ++num_circles > AC_FENCEZONES_MAX_CIRCLES) {
+                return false;
+            }
+            i++;
+            break;
+        case AC_PolyFenceType::RETURN_POINT:
+            i++;
+            break;
+        default:
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+  allocate the item array and read items from storage. Returns true if
+  the items are available
+ */
+bool AC_PolyFence_loader::load_items()
+{
+    if (_items != nullptr) {
+        return true;
+    }
+    if (_items_load_attempted) {
+        return false;
+    }
+    _items_load_attempted = true;
+
+    const uint32_t array_size = max_items() * sizeof(AC_PolyFenceItem);
+    if (hal.util->available_memory() < 100U + array_size) {
+        return false;
+    }
+    _items = (AC_PolyFenceItem *)calloc(1, array_size);
+    if (_items == nullptr) {
+        return false;
+    }
+    reload_items();
+    return true;
+}
+
+/*
+  read up to max_count saved items from storage into items, returning
+  false if there are no saved items or there are more than max_count
+ */
+bool AC_PolyFence_loader::read_items(AC_PolyFenceItem *items, uint16_t max_count, uint16_t &count) const
+{
+    count = 0;
+
+    struct items_header hdr {};
+#if AC_POLYFENCE_FILE_ENABLED
+    const int fd = AP::FS().open(AC_POLYFENCE_ITEMS_FILE, O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+    if (AP::FS().read(fd, &hdr, sizeof(hdr)) == sizeof(hdr) &&
+        hdr.magic == AC_POLYFENCE_ITEMS_MAGIC &&
+        hdr.count <= max_count) {
+        const ssize_t size = hdr.count * sizeof(AC_PolyFenceItem);
+        if (AP::FS().read(fd, items, size) == size) {
+            count = hdr.count;
+        }
+    }
+    AP::FS().close(fd);
+#else
+    if (fence_storage.read_block(&hdr, 0, sizeof(hdr)) &&
+        hdr.magic == AC_POLYFENCE_ITEMS_MAGIC &&
+        hdr.count <= max_count &&
+        fence_storage.read_block(items, sizeof(hdr), hdr.count * sizeof(AC_PolyFenceItem))) {
+        count = hdr.count;
+    }
+#endif
+    return count > 0;
+}
+
+/*
+  discard any unsaved changes, reading the items from storage
+ */
+void AC_PolyFence_loader::reload_items()
+{
+    if (_items == nullptr) {
+        return;
+    }
+    read_items(_items, max_items(), _num_items);
+    _num_saved_items = _num_items;
+}
+
+/*
+  validate and save the fence items
+ */
+bool AC_PolyFence_loader::save_items()
+{
+    if (!load_items() || !items_valid(_items, _num_items)) {
+        return false;
+    }
+
+    struct items_header hdr {};
+    hdr.magic = AC_POLYFENCE_ITEMS_MAGIC;
+    hdr.count = _num_items;
+#if AC_POLYFENCE_FILE_ENABLED
+    const int fd = AP::FS().open(AC_POLYFENCE_ITEMS_FILE, O_WRONLY|O_CREAT|O_TRUNC);
+    if (fd == -1) {
+        return false;
+    }
+    const ssize_t size = _num_items * sizeof(AC_PolyFenceItem);
+    const bool ok = AP::FS().write(fd, &hdr, sizeof(hdr)) == sizeof(hdr) &&
+                    AP::FS().write(fd, _items, size) == size &&
+                    AP::FS().fsync(fd) == 0;
+    AP::FS().close(fd);
+    if (!ok) {
+        return false;
+    }
+#else
+    if (_num_items == 0) {
+        // the header and items overwrote the legacy points.  Erase
+        // them all rather than leave stale items to be read back as a
+        // legacy return point and polygon
+        const uint8_t zeros[32] {};
+        for (uint16_t ofs=0; ofs<fence_storage.size(); ofs += sizeof(zeros)) {
+            fence_storage.write_block(ofs, zeros, MIN(sizeof(zeros), fence_storage.size() - ofs));
+        }
+    } else {
+        // write the items before the header so a partial write is
+        // not mistaken for a complete set of items
+        fence_storage.write_block(sizeof(hdr), _items, _num_items * sizeof(AC_PolyFenceItem));
+        fence_storage.write_block(0, &hdr, sizeof(hdr));
+    }
+#endif
+
+    _num_saved_items = _num_items;
+    _items_version++;
+    return true;
+}
+
+/*
+  load the saved fence items into zones as offsets in cm from origin
+ */
+bool AC_PolyFence_loader::load_zones(AC_FenceZones &zones, const Location &origin)
+{
+    zones.clear();
+
+    // read the items from storage rather than using the RAM copy,
+    // which may hold a partial upload
+    if (!load_items() || _num_saved_items == 0) {
+        return false;
+    }
+    AC_PolyFenceItem *items = (AC_PolyFenceItem *)calloc(_num_saved_items, sizeof(AC_PolyFenceItem));
+    if (items == nullptr) {
+        return false;
+    }
+    uint16_t num_items;
+    const bool ret = read_items(items, _num_saved_items, num_items) &&
+                     items_valid(items, num_items) &&
+                     load_zones(zones, origin, items, num_items);
+    free(items);
+    return ret;
+}
+
+/*
+  load validated fence items into zones as offsets in cm from origin
+ */
+bool AC_PolyFence_loader::load_zones(AC_FenceZones &zones, const Location &origin,
+                                     const AC_PolyFenceItem *items, uint16_t num_items)
+{
+    // count the zones and find the largest polygon
+    uint16_t num_vertices = 0;
+    uint16_t max_polygon_vertices = 0;
+    uint8_t num_polygons = 0;
+    uint8_t num_circles = 0;
+    for (uint16_t i=0; i<num_items; ) {
+        const AC_PolyFenceItem &item = items[i];
+        switch (item.type) {
+        case AC_PolyFenceType::POLYGON_INCLUSION:
+        case AC_PolyFenceType::POLYGON_EXCLUSION:
+            num_polygons++;
+            num_vertices += item.param;
+            max_polygon_vertices = MAX(max_polygon_vertices, item.param);
+            i += item.param;
+            break;
+        case AC_PolyFenceType::CIRCLE_INCLUSION:
+        case AC_PolyFenceType::CIRCLE_EXCLUSION:
+            num_circles++;
+            i++;
+            break;
+        default:
+            i++;
+            break;
+        }
+    }
+
+    if (!zones.init(num_vertices, num_polygons, num_circles)) {
+        return false;
+    }
+
+    Vector2f *points = nullptr;
+    if (max_polygon_vertices > 0) {
+        points = (Vector2f *)calloc(max_polygon_vertices, sizeof(Vector2f));
+        if (points == nullptr) {
+            zones.clear();
+            return false;
+        }
+    }
+
+    bool ret = true;
+    Location loc;
+    for (uint16_t i=0; i<num_items && ret; ) {
+        const AC_PolyFenceItem &item = items[i];
+        switch (item.type) {
+        case AC_PolyFenceType::POLYGON_INCLUSION:
+        case AC_PolyFenceType::POLYGON_EXCLUSION:
+            for (uint16_t j=0; j<item.param; j++) {
+                loc.lat = items[i+j].lat;
+                loc.lng = items[i+j].lng;
+                points[j] = origin.get_distance_NE(loc) * 100.0f;
+            }
+            ret = zones.add_polygon(points, item.param, item.type == AC_PolyFenceType::POLYGON_INCLUSION);
+            i += item.param;
+            break;
+        case AC_PolyFenceType::CIRCLE_INCLUSION:
+        case AC_PolyFenceType::CIRCLE_EXCLUSION:
+            loc.lat = item.lat;
+            loc.lng = item.lng;
+            ret = zones.add_circle(origin.get_distance_NE(loc) * 100.0f, item.param * 100.0f,
+                                   item.type == AC_PolyFenceType::CIRCLE_INCLUSION);
+            i++;
+            break;
+        default:
+            i++;
+            break;
+        }
+    }
+    free(points);
+
+    if (!ret || !zones.build_index()) {
+        zones.clear();
+        return false;
+    }
+    return true;
+}
+
 // declare type specific methods
 template bool AC_PolyFence_loader::boundary_valid<int32_t>(uint16_t num_points, const Vector2l* points) const;
 template bool AC_PolyFence_loader::boundary_valid<float>(uint16_t num_points, const Vector2f* points) const;
@@ -1,7 +1,43 @@
 #pragma once
 
 #include <AP_Common/AP_Common.h>
+#include <AP_Common/Location.h>
+#include <AP_Filesystem/AP_Filesystem.h>
 #include <AP_Math/AP_Math.h>
+#include "AC_FenceZones.h"
+
+// fence items are kept in a file on boards with a filesystem, as the
+// fence storage area only has space for a few dozen items
+#ifndef AC_POLYFENCE_FILE_ENABLED
+#if HAVE_FILESYSTEM_SUPPORT && defined(HAL_BOARD_STORAGE_DIRECTORY)
+#define AC_POLYFENCE_FILE_ENABLED 1
+#else
+#define AC_POLYFENCE_FILE_ENABLED 0
+#endif
+#endif
+
+#ifndef AC_POLYFENCE_FILE_MAX_ITEMS
+#define AC_POLYFENCE_FILE_MAX_ITEMS 1000
+#endif
+
+// types of fence items
+enum class AC_PolyFenceType : uint8_t {
+    END_OF_STORAGE    = 0,
+    POLYGON_INCLUSION = 1,     // polygon vertex, param is vertex count
+    POLYGON_EXCLUSION = 2,     // polygon vertex, param is vertex count
+    CIRCLE_INCLUSION  = 3,     // circle centre, param is radius in meters
+    CIRCLE_EXCLUSION  = 4,     // circle centre, param is radius in meters
+    RETURN_POINT      = 5,     // return point, not used for breach checks
+};
+
+// a fence item as uploaded with the mission item protocol
+struct PACKED AC_PolyFenceItem {
+    AC_PolyFenceType type;
+    uint8_t reserved;
+    uint16_t param;             // vertex count for polygons, radius in meters for circles
+    int32_t lat;
+    int32_t lng;
+};
 
 class AC_PolyFence_loader
 {
@@ -32,5 +68,61 @@ public:
     template <typename T>
     bool boundary_breached(const Vector2<T>& location, uint16_t num_points, const Vector2<T>* points) const;
 
+    ///
+    /// fence items (multiple inclusion and exclusion zones)
+    ///
+
+    // maximum number of fence items we can store
+    uint16_t max_items() const;
+
+    // number of fence items, including any unsaved changes
+    uint16_t num_items();
+
+    // number of fence items saved, zero if only the legacy polygon is in use
+    uint16_t num_saved_items();
+
+    // get or set a single fence item.  Items may be appended by
+    // setting the item at index num_items().  Changes are not saved
+    // or used for breach checks until save_items() is called
+    bool get_item(uint16_t i, AC_PolyFenceItem &item);
+    bool set_item(uint16_t i, const AC_PolyFenceItem &item);
+
+    // reduce the number of items to count
+    void truncate_items(uint16_t count);
+
+    // validate and save the fence items, returns false if the items
+    // do not form complete zones or could not be written
+    bool save_items();
+
+    // discard any unsaved changes to the fence items
+    void reload_items();
+
+    // returns a number which changes each time the fence items are saved
+    uint16_t items_version() const { return _items_version; }
+
+    // load the saved fence items into zones as offsets from origin
+    // returns false if there are no items or they are invalid
+    bool load_zones(AC_FenceZones &zones, const Location &origin);
+
+private:
+
+    // returns true if the items form complete zones
+    static bool items_valid(const AC_PolyFenceItem *items, uint16_t count);
+
+    // read the saved items from storage
+    bool read_items(AC_PolyFenceItem *items, uint16_t max_count, uint16_t &count) const;
+
+    // load validated items into zones as offsets from origin
+    bool load_zones(AC_FenceZones &zones, const Location &origin,
+                    const AC_PolyFenceItem *items, uint16_t num_items);
+
+    // allocate the item array and read items from storage
+    bool load_items();
+
+    AC_PolyFenceItem *_items;       // RAM copy of fence items
+    uint16_t _num_items;            // number of items in RAM copy
+    uint16_t _num_saved_items;      // number of items in storage
+    uint16_t _items_version;        // incremented each time the items are saved
+    bool _items_load_attempted;     // true if we have attempted to read the items from storage
 };
 
@@ -0,0 +1,176 @@
+#include <AP_gtest.h>
+#include <AP_Common/AP_Common.h>
+
+#include <AP_Math/AP_Math.h>
+#include <AC_Fence/AC_FenceZones.h>
+
+// square inclusion zone with a square exclusion zone in the middle
+static const Vector2f outer[] = {{0, 0}, {1000, 0}, {1000, 1000}, {0, 1000}};
+static const Vector2f inner[] = {{400, 400}, {600, 400}, {600, 600}, {400, 600}};
+
+static bool setup_zones(AC_FenceZones &zones)
+{
+    return zones.init(ARRAY_SIZE(outer) + ARRAY_SIZE(inner), 2, 1) &&
+           zones.add_polygon(outer, ARRAY_SIZE(outer), true) &&
+           zones.add_polygon(inner, ARRAY_SIZE(inner), false) &&
+           zones.add_circle(Vector2f(200, 800), 100, false) &&
+           zones.build_index();
+}
+
+TEST(AC_FenceZones, Breached)
+{
+    AC_FenceZones zones;
+    EXPECT_TRUE(setup_zones(zones));
+
+    EXPECT_FALSE(zones.breached(Vector2f(100, 100)));
+    EXPECT_FALSE(zones.breached(Vector2f(999, 1)));
+    EXPECT_TRUE(zones.breached(Vector2f(-1, 500)));
+    EXPECT_TRUE(zones.breached(Vector2f(500, 1001)));
+    EXPECT_TRUE(zones.breached(Vector2f(500, 500)));    // inside exclusion polygon
+    EXPECT_TRUE(zones.breached(Vector2f(210, 790)));    // inside exclusion circle
+    EXPECT_FALSE(zones.breached(Vector2f(200, 650)));
+}
+
+TEST(AC_FenceZones, Intersects)
+{
+    AC_FenceZones zones;
+    EXPECT_TRUE(setup_zones(zones));
+
+    EXPECT_FALSE(zones.intersects(Vector2f(100, 100), Vector2f(900, 100)));
+    EXPECT_TRUE(zones.intersects(Vector2f(100, 100), Vector2f(900, 900)));     // crosses exclusion polygon
+    EXPECT_TRUE(zones.intersects(Vector2f(100, 100), Vector2f(1100, 100)));    // leaves inclusion polygon
+    EXPECT_TRUE(zones.intersects(Vector2f(50, 800), Vector2f(350, 800)));      // passes through exclusion circle
+}
+
+TEST(AC_FenceZones, ClosestBoundary)
+{
+    AC_FenceZones zones;
+    EXPECT_TRUE(setup_zones(zones));
+
+    EXPECT_FLOAT_EQ(zones.closest_boundary_distance(Vector2f(900, 100), 1000), 100);
+    EXPECT_FLOAT_EQ(zones.closest_boundary_distance(Vector2f(200, 650), 1000), 50);
+    EXPECT_FLOAT_EQ(zones.closest_boundary_distance(Vector2f(700, 200), 50), 50);
+}
+
+// the indexed breach check must agree with testing each polygon in turn
+TEST(AC_FenceZones, IndexMatchesBruteForce)
+{
+    const uint16_t num_points = 200;
+    Vector2f ring[num_points];
+    for (uint16_t i=0; i<num_points; i++) {
+        const float angle = M_2PI * i / num_points;
+        // star shape to give concave edges
+        const float radius = (i % 2) ? 450 : 300;
+        ring[i] = Vector2f(500 + radius * cosf(angle), 500 + radius * sinf(angle));
+    }
+
+    AC_FenceZones zones;
+    EXPECT_TRUE(zones.init(num_points + ARRAY_SIZE(outer) + ARRAY_SIZE(inner), 3, 0));
+    EXPECT_TRUE(zones.add_polygon(outer, ARRAY_SIZE(outer), true));
+    EXPECT_TRUE(zones.add_polygon(ring, num_points, true));
+    EXPECT_TRUE(zones.add_polygon(inner, ARRAY_SIZE(inner), false));
+    EXPECT_TRUE(zones.build_index());
+
+    for (int16_t x=-50; x<=1050; x+=7) {
+        for (int16_t y=-50; y<=1050; y+=7) {
+            const Vector2f pos(x, y);
+            bool breached = false;
+            for (uint8_t i=0; i<zones.num_polygons(); i++) {
+                if (zones.inside_polygon(i, pos) != zones.polygon(i).inclusion) {
+                    breached = true;
+                }
+            }
+            EXPECT_EQ(breached, zones.breached(pos));
+        }
+    }
+}
+
+// only the zones in one of the two sets are in the difference
+TEST(AC_FenceZones, Difference)
+{
+    AC_FenceZones zones;
+    EXPECT_TRUE(setup_zones(zones));
+
+    AC_FenceZones copy;
+    EXPECT_TRUE(copy.copy_from(zones));
+    AC_FenceZones changed;
+    EXPECT_TRUE(changed.set_difference(zones, copy));
+    EXPECT_TRUE(changed.empty());
+
+    // move the exclusion polygon and keep the rest
+    static const Vector2f moved[] = {{700, 700}, {800, 700}, {800, 800}, {700, 800}};
+    AC_FenceZones zones2;
+    EXPECT_TRUE(zones2.init(ARRAY_SIZE(outer) + ARRAY_SIZE(moved), 2, 1));
+    EXPECT_TRUE(zones2.add_polygon(outer, ARRAY_SIZE(outer), true));
+    EXPECT_TRUE(zones2.add_polygon(moved, ARRAY_SIZE(moved), false));
+    EXPECT_TRUE(zones2.add_circle(Vector2f(200, 800), 100, false));
+    EXPECT_TRUE(zones2.build_index());
+
+    EXPECT_TRUE(changed.set_difference(zones, zones2));
+    EXPECT_EQ(changed.num_polygons(), 2);
+    EXPECT_EQ(changed.num_circles(), 0);
+    EXPECT_FALSE(changed.intersects(Vector2f(100, 100), Vector2f(900, 100)));
+    EXPECT_TRUE(changed.intersects(Vector2f(100, 500), Vector2f(900, 500)));     // old exclusion polygon
+    EXPECT_TRUE(changed.intersects(Vector2f(100, 750), Vector2f(900, 750)));     // new exclusion polygon
+
+    // segments missing the difference intersect both sets or neither
+    for (int16_t x=50; x<=950; x+=100) {
+        for (int16_t y=50; y<=950; y+=100) {
+            const Vector2f start(x, y);
+            const Vector2f end(y, 1000 - x);
+            if (!changed.intersects(start, end)) {
+                EXPECT_EQ(zones.intersects(start, end), zones2.intersects(start, end));
+            }
+        }
+    }
+}
+
+// refilling a set with fewer zones reuses its buffers without keeping stale data
+TEST(AC_FenceZones, Reuse)
+{
+    AC_FenceZones zones;
+    EXPECT_TRUE(setup_zones(zones));
+
+    static const Vector2f small[] = {{2000, 2000}, {2100, 2000}, {2100, 2100}, {2000, 2100}};
+    AC_FenceZones zones2;
+    EXPECT_TRUE(zones2.init(ARRAY_SIZE(small), 1, 0));
+    EXPECT_TRUE(zones2.add_polygon(small, ARRAY_SIZE(small), false));
+    EXPECT_TRUE(zones2.build_index());
+
+    AC_FenceZones copy;
+    EXPECT_TRUE(copy.copy_from(zones));
+    EXPECT_TRUE(copy.copy_from(zones2));
+    EXPECT_EQ(copy.num_polygons(), 1);
+    EXPECT_EQ(copy.num_circles(), 0);
+    EXPECT_FALSE(copy.breached(Vector2f(500, 500)));
+    EXPECT_FALSE(copy.intersects(Vector2f(100, 500), Vector2f(900, 500)));
+    EXPECT_TRUE(copy.breached(Vector2f(2050, 2050)));
+    EXPECT_TRUE(copy.intersects(Vector2f(1900, 2050), Vector2f(2200, 2050)));
+
+    // and grows again when needed
+    EXPECT_TRUE(copy.copy_from(zones));
+    EXPECT_EQ(copy.num_polygons(), 2);
+    EXPECT_EQ(copy.num_circles(), 1);
+    EXPECT_TRUE(copy.breached(Vector2f(500, 500)));
+    EXPECT_FALSE(copy.intersects(Vector2f(1900, 2050), Vector2f(2200, 2050)));
+}
+
+TEST(AC_FenceZones, Invalid)
+{
+    AC_FenceZones zones;
+    EXPECT_TRUE(zones.init(4, 1, 0));
+    EXPECT_FALSE(zones.add_polygon(outer, 2, true));
+    EXPECT_FALSE(zones.add_circle(Vector2f(0, 0), 100, true));
+    EXPECT_TRUE(zones.add_polygon(outer, ARRAY_SIZE(outer), true));
+    EXPECT_FALSE(zones.add_polygon(inner, ARRAY_SIZE(inner), false));
+    EXPECT_TRUE(zones.build_index());
+    EXPECT_FALSE(zones.empty());
+
+    zones.clear();
+    EXPECT_TRUE(zones.empty());
+    EXPECT_FALSE(zones.breached(Vector2f(5000, 5000)));
+}
+
+AP_GTEST_MAIN()
+
+int hal = 0; // bizarrely, this fixes an undefined-symbol error but doesn't raise a type exception.  Yay.
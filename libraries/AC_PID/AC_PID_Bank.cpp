@@ -0,0 +1,186 @@
+/// @file	AC_PID_Bank.cpp
+/// @brief	Three axis PID algorithm with the state of all axes updated together.
+
+#include <AP_Math/AP_Math.h>
+#include "AC_PID_Bank.h"
+
+// Constructor
+AC_PID_Bank::AC_PID_Bank(float dt) :
+    _dt(dt),
+    _reset_filter(true)
+{
+    memset(_kp, 0, sizeof(_kp));
+    memset(_ki, 0, sizeof(_ki));
+    memset(_kd, 0, sizeof(_kd));
+    memset(_kff, 0, sizeof(_kff));
+    memset(_kimax, 0, sizeof(_kimax));
+    memset(_filt_T_hz, 0, sizeof(_filt_T_hz));
+    memset(_filt_E_hz, 0, sizeof(_filt_E_hz));
+    memset(_filt_D_hz, 0, sizeof(_filt_D_hz));
+    memset(_integrator, 0, sizeof(_integrator));
+    memset(_target, 0, sizeof(_target));
+    memset(_error, 0, sizeof(_error));
+    memset(_derivative, 0, sizeof(_derivative));
+    memset(_actual, 0, sizeof(_actual));
+    memset(_pid_info, 0, sizeof(_pid_info));
+    calc_filt_alpha();
+}
+
+// set_dt - set time step in seconds
+void AC_PID_Bank::set_dt(float dt)
+{
+    _dt = dt;
+    calc_filt_alpha();
+}
+
+// set the gains of one axis
+void AC_PID_Bank::set_gains(uint8_t axis, float p, float i, float d, float ff, float imax, float filt_T_hz, float filt_E_hz, float filt_D_hz)
+{
+    if (axis >= NUM_AXES) {
+        return;
+    }
+    _kp[axis] = p;
+    _ki[axis] = i;
+    _kd[axis] = d;
+    _kff[axis] = ff;
+    _kimax[axis] = fabsf(imax);
+    _filt_T_hz[axis] = fabsf(filt_T_hz);
+    _filt_E_hz[axis] = fabsf(filt_E_hz);
+    _filt_D_hz[axis] = fabsf(filt_D_hz);
+    calc_filt_alpha();
+}
+
+// copy the gains of one axis from a PID controller
+void AC_PID_Bank::set_gains(uint8_t axis, AC_PID &pid)
+{
+    set_gains(axis, pid.kP(), pid.kI(), pid.kD(), pid.ff(), pid.imax(), pid.filt_T_hz(), pid.filt_E_hz(), pid.filt_D_hz());
+}
+
+// calculate a filter alpha, a zero frequency disables the filter
+float AC_PID_Bank::get_filt_alpha(float filt_hz) const
+{
+    if (is_zero(filt_hz)) {
+        return 1.0f;
+    }
+    const float rc = 1.0f / (M_2PI * filt_hz);
+    return _dt / (_dt + rc);
+}
+
+// recalculate the filter alphas from the filter frequencies and time step
+void AC_PID_Bank::calc_filt_alpha()
+{
+    for (uint8_t i = 0; i < NUM_AXES; i++) {
+        _filt_T_alpha[i] = get_filt_alpha(_filt_T_hz[i]);
+        _filt_E_alpha[i] = get_filt_alpha(_filt_E_hz[i]);
+        _filt_D_alpha[i] = get_filt_alpha(_filt_D_hz[i]);
+    }
+}
+
+//  update_all - set target and measured inputs to the PID controllers and calculate outputs
+//  target and error are filtered
+//  the derivative is then calculated and filtered
+//  the integral of each axis is then updated based on its bit in the limit mask
+//  if any input is inf or NaN no axis is updated and zero is returned
+Vector3f AC_PID_Bank::update_all(const Vector3f &target, const Vector3f &measurement, uint8_t limit)
+{
+    // don't process inf or NaN
+    if (!isfinite(target.x) || !isfinite(target.y) || !isfinite(target.z) ||
+        !isfinite(measurement.x) || !isfinite(measurement.y) || !isfinite(measurement.z)) {
+        return Vector3f();
+    }
+
+    const float target_in[NUM_AXES] {target.x, target.y, target.z};
+    const float measurement_in[NUM_AXES] {measurement.x, measurement.y, measurement.z};
+    const bool dt_positive = is_positive(_dt);
+
+    // reset input filters to values received
+    if (_reset_filter) {
+        _reset_filter = false;
+        for (uint8_t i = 0; i < NUM_AXES; i++) {
+            _target[i] = target_in[i];
+            _error[i] = target_in[i] - measurement_in[i];
+            _derivative[i] = 0.0f;
+        }
+    } else {
+        const float dt_inv = dt_positive ? 1.0f / _dt : 0.0f;
+        for (uint8_t i = 0; i < NUM_AXES; i++) {
+            const float error_last = _error[i];
+            _target[i] += _filt_T_alpha[i] * (target_in[i] - _target[i]);
+            _error[i] += _filt_E_alpha[i] * ((_target[i] - measurement_in[i]) - _error[i]);
+
+            // calculate and filter derivative, left unchanged without a time step
+            const float derivative = (_error[i] - error_last) * dt_inv;
+            _derivative[i] += dt_positive ? _filt_D_alpha[i] * (derivative - _derivative[i]) : 0.0f;
+        }
+    }
+
+    // update I terms
+    // the integrator of a limited axis is only allowed to shrink
+    for (uint8_t i = 0; i < NUM_AXES; i++) {
+        if (is_zero(_ki[i]) || !dt_positive) {
+            _integrator[i] = 0.0f;
+        } else if (((limit & (1U << i)) == 0) || (_integrator[i] * _error[i] < 0.0f)) {
+            _integrator[i] = constrain_float(_integrator[i] + _error[i] * _ki[i] * _dt, -_kimax[i], _kimax[i]);
+        }
+    }
+
+    float out[NUM_AXES];
+    for (uint8_t i = 0; i < NUM_AXES; i++) {
+        _actual[i] = measurement_in[i];
+        out[i] = _error[i] * _kp[i] + _integrator[i] + _derivative[i] * _kd[i];
+    }
+
+    return Vector3f(out[0], out[1], out[2]);
+}
+
+Vector3f AC_PID_Bank::get_pid() const
+{
+    return get_p() + get_i() + get_d();
+}
+
+Vector3f AC_PID_Bank::get_p() const
+{
+    return Vector3f(_error[0] * _kp[0], _error[1] * _kp[1], _error[2] * _kp[2]);
+}
+
+Vector3f AC_PID_Bank::get_i() const
+{
+    return Vector3f(_integrator[0], _integrator[1], _integrator[2]);
+}
+
+Vector3f AC_PID_Bank::get_d() const
+{
+    return Vector3f(_derivative[0] * _kd[0], _derivative[1] * _kd[1], _derivative[2] * _kd[2]);
+}
+
+Vector3f AC_PID_Bank::get_ff() const
+{
+    return Vector3f(_target[0] * _kff[0], _target[1] * _kff[1], _target[2] * _kff[2]);
+}
+
+void AC_PID_Bank::reset_I()
+{
+    memset(_integrator, 0, sizeof(_integrator));
+}
+
+void AC_PID_Bank::set_integrator(uint8_t axis, float i)
+{
+    if (axis >= NUM_AXES) {
+        return;
+    }
+    _integrator[axis] = constrain_float(i, -_kimax[axis], _kimax[axis]);
+}
+
+// get pid info of one axis for logging
+const AP_Logger::PID_Info &AC_PID_Bank::get_pid_info(uint8_t axis)
+{
+    AP_Logger::PID_Info &info = _pid_info[axis];
+    info.target = _target[axis];
+    info.actual = _actual[axis];
+    info.error = _error[axis];
+    info.P = _error[axis] * _kp[axis];
+    info.I = _integrator[axis];
+    info.D = _derivative[axis] * _kd[axis];
+    info.FF = _target[axis] * _kff[axis];
+    return info;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+/// @file	AC_PID_Bank.h
+/// @brief	Three axis PID algorithm with the state of all axes updated together.
+
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>
+#include <AP_Logger/AP_Logger.h>
+#include "AC_PID.h"
+
+/// @class	AC_PID_Bank
+/// @brief	Three axis equivalent of AC_PID
+/*
+ * Each term of the controller (target, error, derivative and integrator)
+ * and each gain is held as an array across the three axes so that
+ * update_all() makes a single pass over all axes rather than three calls
+ * into separate AC_PID objects.  The filter alphas are only recalculated
+ * when the time step or gains change instead of on every update, and the
+ * logging information is only filled in when it is requested.
+ *
+ * The bank does not own any parameters.  Gains are copied from AC_PID
+ * objects (which continue to hold the parameters) or set directly.
+ */
+class AC_PID_Bank {
+public:
+
+    static const uint8_t NUM_AXES = 3;
+
+    // bits of the limit mask passed to update_all, one per axis
+    enum LimitMask : uint8_t {
+        LIMIT_X = (1U << 0),
+        LIMIT_Y = (1U << 1),
+        LIMIT_Z = (1U << 2),
+    };
+
+    // Constructor, all gains are zero until set
+    AC_PID_Bank(float dt);
+
+    // set_dt - set time step in seconds
+    void set_dt(float dt);
+
+    // set the gains of one axis
+    void set_gains(uint8_t axis, float p, float i, float d, float ff, float imax, float filt_T_hz, float filt_E_hz, float filt_D_hz);
+
+    // copy the gains of one axis from a PID controller
+    void set_gains(uint8_t axis, AC_PID &pid);
+
+    //  update_all - set target and measured inputs to the PID controllers and calculate outputs
+    //  target and error are filtered
+    //  the derivative is then calculated and filtered
+    //  the integral of each axis is then updated based on its bit in the limit mask
+    //  if any input is inf or NaN no axis is updated and zero is returned
+    Vector3f update_all(const Vector3f &target, const Vector3f &measurement, uint8_t limit = 0);
+
+    // get results from pid controllers
+    Vector3f get_pid() const;
+    Vector3f get_p() const;
+    Vector3f get_i() const;
+    Vector3f get_d() const;
+    Vector3f get_ff() const;
+
+    // reset_I - reset the integrators
+    void reset_I();
+
+    // reset_filter - input filters will be reset to the next values provided to update_all()
+    void reset_filter() { _reset_filter = true; }
+
+    // integrator setting functions
+    void set_integrator(uint8_t axis, float i);
+
+    // get pid info of one axis for logging
+    const AP_Logger::PID_Info &get_pid_info(uint8_t axis);
+
+private:
+
+    // calculate a filter alpha, a zero frequency disables the filter
+    float get_filt_alpha(float filt_hz) const;
+
+    // recalculate the filter alphas from the filter frequencies and time step
+    void calc_filt_alpha();
+
+    // gains
+    float _kp[NUM_AXES];
+    float _ki[NUM_AXES];
+    float _kd[NUM_AXES];
+    float _kff[NUM_AXES];
+    float _kimax[NUM_AXES];
+    float _filt_T_hz[NUM_AXES];     // target filter frequency in Hz
+    float _filt_E_hz[NUM_AXES];     // error filter frequency in Hz
+    float _filt_D_hz[NUM_AXES];     // derivative filter frequency in Hz
+
+    // filter alphas calculated from the filter frequencies and time step
+    float _filt_T_alpha[NUM_AXES];
+    float _filt_E_alpha[NUM_AXES];
+    float _filt_D_alpha[NUM_AXES];
+
+    // internal variables
+    float _dt;                      // timestep in seconds
+    bool _reset_filter;             // true when input filters should be reset during next call to update_all
+    float _integrator[NUM_AXES];    // integrator values
+    float _target[NUM_AXES];        // target values to enable filtering
+    float _error[NUM_AXES];         // error values to enable filtering
+    float _derivative[NUM_AXES];    // derivative values to enable filtering
+    float _actual[NUM_AXES];        // last measured values (for logging purposes)
+
+    AP_Logger::PID_Info _pid_info[NUM_AXES];
+};
@@ -0,0 +1,89 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <AP_gbenchmark.h>
+
+#include <AC_PID/AC_PID.h>
+#include <AC_PID/AC_PID_Bank.h>
+
+const AP_HAL::HAL &hal = AP_HAL::get_HAL();
+
+/*
+  roll, pitch and yaw rate controllers with the copter default gains run
+  at 400Hz on a slowly changing target, as the attitude controller does
+ */
+static const float DT = 0.0025f;
+static const uint16_t NUM_TARGETS = 1024;
+
+// targets are calculated up front so only the controllers are measured
+static const Vector3f *test_targets()
+{
+    static Vector3f targets[NUM_TARGETS];
+    for (uint16_t i=0; i<NUM_TARGETS; i++) {
+        const float t = i * DT;
+        targets[i] = Vector3f(sinf(t), cosf(t), sinf(t * 0.5f));
+    }
+    return targets;
+}
+
+// a vehicle whose rates respond to the controller outputs with a lag
+static void update_rate(Vector3f &rate, const Vector3f &out)
+{
+    rate += (out * 20.0f - rate) * 0.05f;
+}
+
+/* three AC_PID controllers updated one after the other */
+static void BM_PIDScalar(benchmark::State& state)
+{
+    AC_PID roll(0.135f, 0.135f, 0.0036f, 0.0f, 0.5f, 0.0f, 0.0f, 20.0f, DT);
+    AC_PID pitch(0.135f, 0.135f, 0.0036f, 0.0f, 0.5f, 0.0f, 0.0f, 20.0f, DT);
+    AC_PID yaw(0.18f, 0.018f, 0.0f, 0.0f, 0.5f, 0.0f, 2.5f, 20.0f, DT);
+
+    const Vector3f *targets = test_targets();
+    uint16_t step = 0;
+    Vector3f rate;
+    while (state.KeepRunning()) {
+        const Vector3f &target = targets[step++ % NUM_TARGETS];
+        Vector3f out;
+        out.x = roll.update_all(target.x, rate.x, false);
+        out.y = pitch.update_all(target.y, rate.y, false);
+        out.z = yaw.update_all(target.z, rate.z, false);
+        update_rate(rate, out);
+        gbenchmark_escape(&out);
+    }
+}
+
+/* the same controllers updated together by the PID bank */
+static void BM_PIDBank(benchmark::State& state)
+{
+    AC_PID_Bank bank(DT);
+    bank.set_gains(0, 0.135f, 0.135f, 0.0036f, 0.0f, 0.5f, 0.0f, 0.0f, 20.0f);
+    bank.set_gains(1, 0.135f, 0.135f, 0.0036f, 0.0f, 0.5f, 0.0f, 0.0f, 20.0f);
+    bank.set_gains(2, 0.18f, 0.018f, 0.0f, 0.0f, 0.5f, 0.0f, 2.5f, 20.0f);
+
+    const Vector3f *targets = test_targets();
+    uint16_t step = 0;
+    Vector3f rate;
+    while (state.KeepRunning()) {
+        const Vector3f &target = targets[step++ % NUM_TARGETS];
+        Vector3f out = bank.update_all(target, rate, 0);
+        update_rate(rate, out);
+        gbenchmark_escape(&out);
+    }
+}
+
+BENCHMARK(BM_PIDScalar);
+BENCHMARK(BM_PIDBank);
+
+BENCHMARK_MAIN()
@@ -0,0 +1,83 @@
+/*
+ *       Example of the three axis PID bank.
+ *       Runs the bank alongside three AC_PID controllers with the same gains
+ *       on a simple simulated vehicle and checks that the outputs match.
+ */
+
+#include <AP_HAL/AP_HAL.h>
+#include <AC_PID/AC_PID.h>
+#include <AC_PID/AC_PID_Bank.h>
+
+void setup();
+void loop();
+
+const AP_HAL::HAL& hal = AP_HAL::get_HAL();
+
+// default PID values, as used by the copter rate controllers
+#define TEST_P 0.135f
+#define TEST_I 0.135f
+#define TEST_D 0.0036f
+#define TEST_IMAX 0.5f
+#define TEST_FILT_D 20.0f
+#define TEST_DT 0.0025f
+#define TEST_STEPS 4000
+
+// setup function
+void setup()
+{
+    hal.console->printf("ArduPilot AC_PID_Bank library test\n");
+
+    hal.scheduler->delay(1000);
+}
+
+// main loop
+void loop()
+{
+    // setup (unfortunately must be done here as we cannot create a global AC_PID object)
+    AC_PID pid[AC_PID_Bank::NUM_AXES] {
+        AC_PID(TEST_P, TEST_I, TEST_D, 0.0f, TEST_IMAX, 0.0f, 0.0f, TEST_FILT_D, TEST_DT),
+        AC_PID(TEST_P, TEST_I, TEST_D, 0.0f, TEST_IMAX, 0.0f, 0.0f, TEST_FILT_D, TEST_DT),
+        AC_PID(TEST_P * 2.0f, TEST_I * 0.1f, 0.0f, 0.0f, TEST_IMAX, 0.0f, 2.5f, TEST_FILT_D, TEST_DT),
+    };
+    AC_PID_Bank bank(TEST_DT);
+    for (uint8_t i = 0; i < AC_PID_Bank::NUM_AXES; i++) {
+        bank.set_gains(i, pid[i]);
+    }
+
+    // a vehicle whose rates respond to the controller outputs with a lag
+    Vector3f rate_scalar;
+    Vector3f rate_bank;
+    float max_diff = 0.0f;
+
+    const uint32_t start_us = AP_HAL::micros();
+    for (uint16_t step = 0; step < TEST_STEPS; step++) {
+        const float t = step * TEST_DT;
+        const Vector3f target(sinf(t * 3.0f), cosf(t * 2.0f), (step / 400) % 2 ? 1.0f : -1.0f);
+
+        // yaw is limited for the first half of the run
+        const bool yaw_limit = step < TEST_STEPS / 2;
+
+        Vector3f out_scalar;
+        for (uint8_t i = 0; i < AC_PID_Bank::NUM_AXES; i++) {
+            out_scalar[i] = pid[i].update_all(target[i], rate_scalar[i], i == 2 && yaw_limit);
+        }
+        const Vector3f out_bank = bank.update_all(target, rate_bank, yaw_limit ? AC_PID_Bank::LIMIT_Z : 0);
+
+        for (uint8_t i = 0; i < AC_PID_Bank::NUM_AXES; i++) {
+            max_diff = MAX(max_diff, fabsf(out_scalar[i] - out_bank[i]));
+            rate_scalar[i] += (out_scalar[i] * 20.0f - rate_scalar[i]) * 0.05f;
+            rate_bank[i] += (out_bank[i] * 20.0f - rate_bank[i]) * 0.05f;
+        }
+    }
+    const uint32_t elapsed_us = AP_HAL::micros() - start_us;
+
+    hal.console->printf("steps:%u max diff:%f (%s) time:%uus\n",
+                        (unsigned)TEST_STEPS, (double)max_diff,
+                        max_diff < 1.0e-5f ? "OK" : "FAIL", (unsigned)elapsed_us);
+    const Vector3f i_term = bank.get_i();
+    hal.console->printf("I roll:%f pitch:%f yaw:%f\n", (double)i_term.x, (double)i_term.y, (double)i_term.z);
+
+    hal.scheduler->delay(1000);
+}
+
+AP_HAL_MAIN();
@@ -67,6 +67,15 @@ const AP_Param::GroupInfo AC_WPNav::var_info[] = {
     // @User: Advanced
     AP_GROUPINFO("RFND_USE",   10, AC_WPNav, _rangefinder_use, 1),
 
+    // @Param: JERK
+    // @DisplayName: Waypoint Jerk
+    // @Description: Defines the rate of change of acceleration in m/s/s/s used during missions.  Higher values give quicker changes in speed along straight segments, lower values a smoother ride
+    // @Units: m/s/s/s
+    // @Range: 0.5 20
+    // @Increment: 0.5
+    // @User: Advanced
+    AP_GROUPINFO("JERK",       11, AC_WPNav, _wp_jerk, WPNAV_WP_JERK),
+
     AP_GROUPEND
 };
 
@@ -219,6 +228,55 @@ bool AC_WPNav::set_wp_destination_NED(const Vector3f& destination_NED)
     return set_wp_destination(Vector3f(destination_NED.x * 100.0f, destination_NED.y * 100.0f, -destination_NED.z * 100.0f), false);
 }
 
+/// set_fast_waypoint - set to true to ignore the waypoint radius and consider the waypoint 'reached' the moment the intermediate point reaches it
+///     the target will pass through the destination without stopping
+void AC_WPNav::set_fast_waypoint(bool fast)
+{
+    if (_flags.fast_waypoint == fast) {
+        return;
+    }
+    _flags.fast_waypoint = fast;
+
+    // recalculate the target's profile so it ends at the new speed
+    if (_flags.segment_type == SEGMENT_STRAIGHT) {
+        replan_scurve();
+    }
+}
+
+/// set_wp_destination_next - set the destination which will follow the current destination
+///     returns false if conversion from location to vector from ekf origin cannot be calculated
+bool AC_WPNav::set_wp_destination_next(const Location& destination)
+{
+    bool terr_alt;
+    Vector3f dest_neu;
+
+    // convert destination location to vector
+    if (!get_vector_NEU(destination, dest_neu, terr_alt)) {
+        return false;
+    }
+
+    return set_wp_destination_next(dest_neu, terr_alt);
+}
+
+/// set_wp_destination_next - set the destination which will follow the current destination using position vector (distance from ekf origin in cm)
+///     terrain_alt should be true if destination.z is a desired altitude above terrain
+bool AC_WPNav::set_wp_destination_next(const Vector3f& destination, bool terrain_alt)
+{
+    // the next destination must use the same altitude frame as the current destination
+    if (terrain_alt != _terrain_alt) {
+        return false;
+    }
+
+    _destination_next = destination;
+    _flags.destination_next_set = true;
+
+    // recalculate the target's profile so it ends at the corner speed
+    if (_flags.fast_waypoint && (_flags.segment_type == SEGMENT_STRAIGHT)) {
+        replan_scurve();
+    }
+    return true;
+}
+
 /// set_origin_and_destination - set origin and destination waypoints using position vectors (distance from home in cm)
 ///     terrain_alt should be true if origin.z and destination.z are desired altitudes above terrain (false if these are alt-above-ekf-origin)
 ///     returns false on failure (likely caused by missing terrain data)
@@ -263,12 +321,17 @@ bool AC_WPNav::set_wp_origin_and_destination(const Vector3f& origin, const Vecto
     _flags.segment_type = SEGMENT_STRAIGHT;
     _flags.new_wp_destination = true;   // flag new waypoint so we can freeze the pos controller's feed forward and smooth the transition
     _flags.wp_yaw_set = false;
+    _flags.destination_next_set = false;
 
     // initialise the limited speed to current speed along the track
     const Vector3f &curr_vel = _inav.get_velocity();
     // get speed along track (note: we convert vertical speed into horizontal speed equivalent)
     float speed_along_track = curr_vel.x * _pos_delta_unit.x + curr_vel.y * _pos_delta_unit.y + curr_vel.z * _pos_delta_unit.z;
-    _limited_speed_xy_cms = constrain_float(speed_along_track, 0, _pos_control.get_max_speed_xy());
+    _limited_speed_xy_cms = constrain_float(speed_along_track, 0, _track_speed);
+
+    // calculate the target's profile along the whole track
+    _scurve_time_scale = 1.0f;
+    calc_scurve(_limited_speed_xy_cms, 0.0f);
 
     return true;
 }
@@ -313,13 +376,12 @@ void AC_WPNav::get_wp_stopping_point(Vector3f& stopping_point) const
 }
 
 /// advance_wp_target_along_track - move target location along track from origin to destination
+///     the target follows the jerk limited profile calculated when the destination was set
 bool AC_WPNav::advance_wp_target_along_track(float dt)
 {
     float track_covered;        // distance (in cm) along the track that the vehicle has traveled.  Measured by drawing a perpendicular line from the track to the vehicle.
     Vector3f track_error;       // distance error (in cm) from the track_covered position (i.e. closest point on the line to the vehicle) and the vehicle
-    float track_desired_max;    // the farthest distance (in cm) along the track that the leash will allow
     float track_leash_slack;    // additional distance (in cm) along the track from our track_covered position that our leash will allow
-    bool reached_leash_limit = false;   // true when track has reached leash limit and we need to slow down the target point
 
     // get current location
     const Vector3f &curr_pos = _inav.get_position();
@@ -358,80 +420,49 @@ bool AC_WPNav::advance_wp_target_along_track(float dt)
     float track_leash_length_abs = fabsf(_track_leash_length);
     float track_error_max_abs = MAX(_track_leash_length*track_error_z/leash_z, _track_leash_length*_track_error_xy/_pos_control.get_leash_xy());
     track_leash_slack = (track_leash_length_abs > track_error_max_abs) ? safe_sqrt(sq(_track_leash_length) - sq(track_error_max_abs)) : 0;
-    track_desired_max = track_covered + track_leash_slack;
 
-    // check if target is already beyond the leash
-    if (_track_desired > track_desired_max) {
-        reached_leash_limit = true;
+    // hold the target back along its profile as it nears the end of the leash so the vehicle can catch up
+    //   the target moves at full rate while it is within half the leash slack of the vehicle and stops at the end of the leash
+    const float track_lead = _track_desired - track_covered;
+    float time_scale = 1.0f;
+    if (is_positive(track_lead)) {
+        time_scale = is_positive(track_leash_slack) ? constrain_float(2.0f * (1.0f - track_lead / track_leash_slack), 0.0f, 1.0f) : 0.0f;
     }
-
-    // get current velocity
-    const Vector3f &curr_vel = _inav.get_velocity();
-    // get speed along track
-    float speed_along_track = curr_vel.x * _pos_delta_unit.x + curr_vel.y * _pos_delta_unit.y + curr_vel.z * _pos_delta_unit.z;
-
-    // calculate point at which velocity switches from linear to sqrt
-    float linear_velocity = _pos_control.get_max_speed_xy();
-    float kP = _pos_control.get_pos_xy_p().kP();
-    if (is_positive(kP)) {   // avoid divide by zero
-        linear_velocity = _track_accel/kP;
+    if (time_scale < _scurve_time_scale) {
+        _scurve_time_scale = time_scale;
+    } else {
+        _scurve_time_scale = MIN(time_scale, _scurve_time_scale + WPNAV_TIME_SCALE_RATE * dt);
     }
 
-    // let the limited_speed_xy_cms be some range above or below current velocity along track
-    if (speed_along_track < -linear_velocity) {
-        // we are traveling fast in the opposite direction of travel to the waypoint so do not move the intermediate point
-        _limited_speed_xy_cms = 0;
-    }else{
-        // increase intermediate target point's velocity if not yet at the leash limit
-        if(dt > 0 && !reached_leash_limit) {
-            _limited_speed_xy_cms += 2.0f * _track_accel * dt;
-        }
-        // do not allow speed to be below zero or over top speed
-        _limited_speed_xy_cms = constrain_float(_limited_speed_xy_cms, 0.0f, _track_speed);
-
-        // check if we should begin slowing down
-        if (!_flags.fast_waypoint) {
-            float dist_to_dest = _track_length - _track_desired;
-            if (!_flags.slowing_down && dist_to_dest <= _slow_down_dist) {
-                _flags.slowing_down = true;
-            }
-            // if target is slowing down, limit the speed
-            if (_flags.slowing_down) {
-                _limited_speed_xy_cms = MIN(_limited_speed_xy_cms, get_slow_down_speed(dist_to_dest, _track_accel));
-            }
-        }
-
-        // if our current velocity is within the linear velocity range limit the intermediate point's velocity to be no more than the linear_velocity above or below our current velocity
-        if (fabsf(speed_along_track) < linear_velocity) {
-            _limited_speed_xy_cms = constrain_float(_limited_speed_xy_cms,speed_along_track-linear_velocity,speed_along_track+linear_velocity);
-        }
-    }
-    // advance the current target
-    if (!reached_leash_limit) {
-    	_track_desired += _limited_speed_xy_cms * dt;
-
-    	// reduce speed if we reach end of leash
-        if (_track_desired > track_desired_max) {
-        	_track_desired = track_desired_max;
-        	_limited_speed_xy_cms -= 2.0f * _track_accel * dt;
-        	if (_limited_speed_xy_cms < 0.0f) {
-        	    _limited_speed_xy_cms = 0.0f;
-        	}
-    	}
-    }
+    // get target's position, velocity and acceleration along the track from its profile
+    float scurve_pos, scurve_vel, scurve_accel;
+    _scurve.get_state(_scurve_time, scurve_pos, scurve_vel, scurve_accel);
+    _track_desired = _scurve_start + scurve_pos;
 
     // do not let desired point go past the end of the track unless it's a fast waypoint
-    if (!_flags.fast_waypoint) {
-        _track_desired = constrain_float(_track_desired, 0, _track_length);
-    } else {
-        _track_desired = constrain_float(_track_desired, 0, _track_length + WPNAV_WP_FAST_OVERSHOOT_MAX);
+    const float track_desired_limit = _flags.fast_waypoint ? _track_length + WPNAV_WP_FAST_OVERSHOOT_MAX : _track_length;
+    if (_track_desired >= track_desired_limit) {
+        _track_desired = track_desired_limit;
+        scurve_vel = 0.0f;
+        scurve_accel = 0.0f;
     }
+    _limited_speed_xy_cms = scurve_vel * _scurve_time_scale;
+
+    // advance along the profile
+    _scurve_time += dt * _scurve_time_scale;
 
-    // recalculate the desired position
+    // feed the target's velocity and acceleration forward to the position controller
+    const float target_accel = scurve_accel * sq(_scurve_time_scale);
+    _pos_control.set_desired_velocity_xy(_pos_delta_unit.x * _limited_speed_xy_cms, _pos_delta_unit.y * _limited_speed_xy_cms);
+    _pos_control.set_desired_accel_xy(_pos_delta_unit.x * target_accel, _pos_delta_unit.y * target_accel);
+
+    // recalculate the desired position.  The profile already includes the velocity fed forward so
+    // the position controller must not also move the target by it
     Vector3f final_target = _origin + _pos_delta_unit * _track_desired;
     // convert final_target.z to altitude above the ekf origin
     final_target.z += terr_offset;
     _pos_control.set_pos_target(final_target);
+    _pos_control.freeze_desired_vel_to_pos();
 
     // check if we've reached the waypoint
     if( !_flags.reached_destination ) {
@@ -521,6 +552,11 @@ void AC_WPNav::check_wp_leash_length()
     // exit immediately if recalc is not required
     if (_flags.recalc_wp_leash) {
         calculate_wp_leash_length();
+
+        // speed, acceleration or jerk limits may have changed so recalculate the target's profile
+        if (_flags.segment_type == SEGMENT_STRAIGHT) {
+            replan_scurve();
+        }
     }
 }
 
@@ -560,6 +596,14 @@ void AC_WPNav::calculate_wp_leash_length()
         _track_leash_length = MIN(leash_z/pos_delta_unit_z, _pos_control.get_leash_xy()/pos_delta_unit_xy);
     }
 
+    // calculate the maximum jerk in the direction of travel
+    const float wp_jerk = get_wp_jerk();
+    if (is_zero(pos_delta_unit_z) && is_zero(pos_delta_unit_xy)) {
+        _track_jerk = 0.0f;
+    } else {
+        _track_jerk = wp_jerk / MAX(pos_delta_unit_xy, pos_delta_unit_z);
+    }
+
     // calculate slow down distance (the distance from the destination when the target point should begin to slow down)
     calc_slow_down_distance(_track_speed, _track_accel);
 
@@ -567,6 +611,50 @@ void AC_WPNav::calculate_wp_leash_length()
     _flags.recalc_wp_leash = false;
 }
 
+/// calc_scurve - calculates the target's jerk limited profile from its current position to the end of the track
+///     speed_start and accel_start are the target's current speed and acceleration along the track
+void AC_WPNav::calc_scurve(float speed_start, float accel_start)
+{
+    // fast waypoints pass through the destination at up to the speed allowed by the corner towards the next destination
+    float speed_end = 0.0f;
+    if (_flags.fast_waypoint) {
+        speed_end = _flags.destination_next_set ? get_corner_speed() : _track_speed;
+    }
+
+    _scurve_start = MIN(_track_desired, _track_length);
+    _scurve.calculate(_track_length - _scurve_start, speed_start, accel_start, speed_end, _track_speed, _track_accel, _track_jerk);
+    _scurve_time = 0.0f;
+}
+
+/// replan_scurve - recalculates the target's profile from its current speed and acceleration
+///     used when the limits or end speed change part way along the track
+void AC_WPNav::replan_scurve()
+{
+    float scurve_pos, scurve_vel, scurve_accel;
+    _scurve.get_state(_scurve_time, scurve_pos, scurve_vel, scurve_accel);
+    calc_scurve(_limited_speed_xy_cms, scurve_accel * sq(_scurve_time_scale));
+}
+
+/// get_corner_speed - returns the maximum speed along the track at which the target can turn towards the next destination
+///     the turn is flown with at most the maximum jerk limited acceleration over the time taken to reach it
+float AC_WPNav::get_corner_speed() const
+{
+    const Vector3f next_delta = _destination_next - _destination;
+    const float next_length = next_delta.length();
+    if (!is_positive(next_length) || !is_positive(_track_jerk)) {
+        return _track_speed;
+    }
+
+    // change in velocity through the corner is 2 * speed * sin(turn_angle / 2)
+    const float cos_turn = constrain_float((next_delta / next_length) * _pos_delta_unit, -1.0f, 1.0f);
+    const float sin_half_turn = safe_sqrt((1.0f - cos_turn) * 0.5f);
+    if (!is_positive(sin_half_turn)) {
+        return _track_speed;
+    }
+    const float speed_change_max = sq(_track_accel) / _track_jerk;
+    return MIN(_track_speed, speed_change_max / (2.0f * sin_half_turn));
+}
+
 // returns target yaw in centi-degrees (used for wp and spline navigation)
 float AC_WPNav::get_yaw() const
 {
@@ -758,6 +846,10 @@ bool AC_WPNav::set_spline_origin_and_destination(const Vector3f& origin, const V
     _pos_control.set_pos_target(origin + Vector3f(0,0,terr_offset));
     _flags.reached_destination = false;
     _flags.segment_type = SEGMENT_SPLINE;
+
+    // spline segments move the target directly so clear any feed forward left by a straight segment
+    _pos_control.set_desired_velocity_xy(0.0f, 0.0f);
+    _pos_control.set_desired_accel_xy(0.0f, 0.0f);
     _flags.new_wp_destination = true;   // flag new waypoint so we can freeze the pos controller's feed forward and smooth the transition
     _flags.wp_yaw_set = false;
 
@@ -25,6 +25,10 @@
 
 #define WPNAV_WP_ACCEL_Z_DEFAULT        100.0f      // default vertical acceleration between waypoints in cm/s/s
 
+#define WPNAV_WP_JERK                     1.0f      // default jerk between waypoints in m/s/s/s
+#define WPNAV_WP_JERK_MIN                 0.5f      // minimum jerk in m/s/s/s - used for sanity checking _wp_jerk parameter
+#define WPNAV_TIME_SCALE_RATE             2.0f      // maximum rate (per second) at which the target's progress along its profile can speed back up after being held back by the leash
+
 #define WPNAV_LEASH_LENGTH_MIN          100.0f      // minimum leash lengths in cm
 
 #define WPNAV_WP_FAST_OVERSHOOT_MAX     200.0f      // 2m overshoot is allowed during fast waypoints to allow for smooth transitions to next waypoint
@@ -88,6 +92,9 @@ public:
     /// get_wp_acceleration - returns acceleration in cm/s/s during missions
     float get_wp_acceleration() const { return _wp_accel_cmss.get(); }
 
+    /// get_wp_jerk - returns jerk in cm/s/s/s during missions
+    float get_wp_jerk() const { return MAX(_wp_jerk, WPNAV_WP_JERK_MIN) * 100.0f; }
+
     /// get_wp_destination waypoint using position vector (distance from ekf origin in cm)
     const Vector3f &get_wp_destination() const { return _destination; }
 
@@ -147,7 +154,14 @@ public:
     }
 
     /// set_fast_waypoint - set to true to ignore the waypoint radius and consider the waypoint 'reached' the moment the intermediate point reaches it
-    void set_fast_waypoint(bool fast) { _flags.fast_waypoint = fast; }
+    ///     the target will pass through the destination without stopping
+    void set_fast_waypoint(bool fast);
+
+    /// set_wp_destination_next - set the destination which will follow the current destination
+    ///     used to limit the speed through a fast waypoint to what the corner towards the next destination allows
+    ///     should be called after set_wp_destination.  returns false if conversion from location to vector from ekf origin cannot be calculated
+    bool set_wp_destination_next(const Location& destination);
+    bool set_wp_destination_next(const Vector3f& destination, bool terrain_alt = false);
 
     /// update_wpnav - run the wp controller - should be called at 100hz or higher
     virtual bool update_wpnav();
@@ -240,8 +254,19 @@ protected:
         uint8_t new_wp_destination      : 1;    // true if we have just received a new destination.  allows us to freeze the position controller's xy feed forward
         SegmentType segment_type        : 1;    // active segment is either straight or spline
         uint8_t wp_yaw_set              : 1;    // true if yaw target has been set
+        uint8_t destination_next_set    : 1;    // true if the destination following the current destination is known
     } _flags;
 
+    /// calc_scurve - calculates the target's jerk limited profile from its current position to the end of the track
+    ///     speed_start and accel_start are the target's speed and acceleration along the track
+    void calc_scurve(float speed_start, float accel_start);
+
+    /// replan_scurve - recalculates the target's profile from its current speed and acceleration
+    void replan_scurve();
+
+    /// get_corner_speed - returns the maximum speed along the track at which the target can turn towards the next destination
+    float get_corner_speed() const;
+
     /// calc_slow_down_distance - calculates distance before waypoint that target point should begin to slow-down assuming it is traveling at full speed
     void calc_slow_down_distance(float speed_cms, float accel_cmss);
 
@@ -285,11 +310,13 @@ protected:
     AP_Float    _wp_radius_cm;          // distance from a waypoint in cm that, when crossed, indicates the wp has been reached
     AP_Float    _wp_accel_cmss;          // horizontal acceleration in cm/s/s during missions
     AP_Float    _wp_accel_z_cmss;        // vertical acceleration in cm/s/s during missions
+    AP_Float    _wp_jerk;               // jerk in m/s/s/s during missions
 
     // waypoint controller internal variables
     uint32_t    _wp_last_update;        // time of last update_wpnav call
     Vector3f    _origin;                // starting point of trip to next waypoint in cm from ekf origin
     Vector3f    _destination;           // target destination in cm from ekf origin
+    Vector3f    _destination_next;      // destination following _destination in cm from ekf origin (only valid if _flags.destination_next_set)
     Vector3f    _pos_delta_unit;        // each axis's percentage of the total track from origin to destination
     float       _track_error_xy;        // horizontal error of the actual position vs the desired position
     float       _track_length;          // distance in cm between origin and destination
@@ -297,10 +324,17 @@ protected:
     float       _track_desired;         // our desired distance along the track in cm
     float       _limited_speed_xy_cms;  // horizontal speed in cm/s used to advance the intermediate target towards the destination.  used to limit extreme acceleration after passing a waypoint
     float       _track_accel;           // acceleration along track
+    float       _track_jerk;            // jerk along track
     float       _track_speed;           // speed in cm/s along track
     float       _track_leash_length;    // leash length along track
     float       _slow_down_dist;        // vehicle should begin to slow down once it is within this distance from the destination
 
+    // straight segment jerk limited profile variables
+    SCurve      _scurve;                // target's speed profile from _scurve_start to the end of the track, calculated once when the track or limits change
+    float       _scurve_start;          // distance in cm along the track at which _scurve starts
+    float       _scurve_time;           // time in seconds along _scurve of the target
+    float       _scurve_time_scale;     // rate at which the target moves along _scurve (0 ~ 1).  reduced to hold the target back when the vehicle is falling behind
+
     // spline variables
     float       _spline_time;           // current spline time between origin and destination
     float       _spline_time_scale;     // current spline time between origin and destination
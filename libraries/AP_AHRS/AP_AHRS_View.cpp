@@ -89,6 +89,13 @@ Vector3f AP_AHRS_View::get_gyro_latest(void) const {
     return gyro_latest;
 }
 
+// correct a primary ins gyro sample with a previously fetched drift estimate in the same way as get_gyro_latest()
+Vector3f AP_AHRS_View::correct_gyro_sample(const Vector3f &gyro_sample, const Vector3f &gyro_drift) const {
+    Vector3f gyro_corrected = gyro_sample + gyro_drift;
+    gyro_corrected.rotate(rotation);
+    return gyro_corrected;
+}
+
 // rotate a 2D vector from earth frame to body frame
 Vector2f AP_AHRS_View::rotate_earth_to_body2D(const Vector2f &ef) const
 {
@@ -42,6 +42,15 @@ public:
     // return a smoothed and corrected gyro vector using the latest ins data (which may not have been consumed by the EKF yet)
     Vector3f get_gyro_latest(void) const;
 
+    // return the estimated gyro drift which get_gyro_latest() removes from the ins data
+    const Vector3f &get_gyro_drift(void) const {
+        return ahrs.get_gyro_drift();
+    }
+
+    // correct a primary ins gyro sample with a previously fetched drift estimate in the same way as get_gyro_latest()
+    // only uses the view's fixed rotation so may be called outside the main thread
+    Vector3f correct_gyro_sample(const Vector3f &gyro_sample, const Vector3f &gyro_drift) const;
+
     // return a DCM rotation matrix representing our current attitude in this view
     const Matrix3f &get_rotation_body_to_ned(void) const {
         return rot_body_to_ned;
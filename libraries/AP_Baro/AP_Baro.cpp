@@ -556,6 +556,11 @@ void AP_Baro::init(void)
     if (sitl == nullptr) {
         AP_HAL::panic("No SITL pointer");
     }
+    if (sitl->baro_spi) {
+        // exercise the real driver against the simulated SPI bus
+        ADD_BACKEND(AP_Baro_MS56XX::probe(*this,
+                                          std::move(hal.spi->get_device("ms5611"))));
+    }
     if (sitl->baro_count > 1) {
         ::fprintf(stderr, "More than one baro not supported.  Sorry.");
     }
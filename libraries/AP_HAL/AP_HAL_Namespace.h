@@ -27,6 +27,7 @@ namespace AP_HAL {
     class RCOutput;
     class Scheduler;
     class Semaphore;
+    class BinarySemaphore;
     class OpticalFlow;
 
     class CANProtocol;
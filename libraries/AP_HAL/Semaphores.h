@@ -21,6 +21,20 @@ public:
     virtual ~Semaphore(void) {}
 };
 
+/*
+  a binary semaphore lets one thread sleep until another thread has
+  something for it. signal() may be called from any thread, and wakes
+  the waiting thread or, if none is waiting, makes the next wait()
+  return immediately. Signals made while already signalled are merged
+ */
+class AP_HAL::BinarySemaphore {
+public:
+    // wait up to timeout_us for a signal, returns false on timeout
+    virtual bool wait(uint32_t timeout_us) WARN_IF_UNUSED = 0;
+    virtual void signal() = 0;
+    virtual ~BinarySemaphore(void) {}
+};
+
 /*
   a method to make semaphores less error prone. The WITH_SEMAPHORE()
   macro will block forever for a semaphore, and will automatically
@@ -26,6 +26,7 @@
 #include <AP_HAL_SITL/Semaphores.h>
 #define HAL_Semaphore HALSITL::Semaphore
 #define HAL_Semaphore_Recursive HALSITL::Semaphore_Recursive
+#define HAL_BinarySemaphore HALSITL::BinarySemaphore
 
 #ifndef HAL_BOARD_STORAGE_DIRECTORY
 #define HAL_BOARD_STORAGE_DIRECTORY "."
@@ -48,6 +48,26 @@ SocketAPM::~SocketAPM()
     }
 }
 
+/*
+  close the socket and open a new one of the same type
+ */
+bool SocketAPM::reset(void)
+{
+    if (fd != -1) {
+        ::close(fd);
+    }
+    fd = socket(AF_INET, datagram?SOCK_DGRAM:SOCK_STREAM, 0);
+    if (fd == -1) {
+        return false;
+    }
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    if (!datagram) {
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    return true;
+}
+
 void SocketAPM::make_sockaddr(const char *address, uint16_t port, struct sockaddr_in &sockaddr)
 {
     memset(&sockaddr, 0, sizeof(sockaddr));
@@ -62,6 +62,13 @@ public:
     // listen has been used. A new socket is returned
     SocketAPM *accept(uint32_t timeout_ms);
 
+    // return the file descriptor, for use with poll() or epoll
+    int get_fd(void) const { return fd; }
+
+    // close the socket and open a new one of the same type, dropping
+    // any binding or connection
+    bool reset(void);
+
 private:
     bool datagram;
     struct sockaddr_in in_addr {};
@@ -14,6 +14,7 @@ namespace ChibiOS {
     class Scheduler;
     class Semaphore;
     class Semaphore_Recursive;
+    class BinarySemaphore;
     class SPIBus;
     class SPIDesc;
     class SPIDevice;
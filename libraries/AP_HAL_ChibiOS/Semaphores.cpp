@@ -151,3 +151,23 @@ bool Semaphore_Recursive::take_nonblocking(void)
 
 #endif // CH_CFG_USE_MUTEXES
 
+#if CH_CFG_USE_SEMAPHORES == TRUE
+
+// constructor, initially not signalled
+BinarySemaphore::BinarySemaphore()
+{
+    static_assert(sizeof(_sem) >= sizeof(binary_semaphore_t), "invalid binary semaphore size");
+    chBSemObjectInit((binary_semaphore_t *)_sem, true);
+}
+
+bool BinarySemaphore::wait(uint32_t timeout_us)
+{
+    return chBSemWaitTimeout((binary_semaphore_t *)_sem, US2ST(timeout_us)) == MSG_OK;
+}
+
+void BinarySemaphore::signal()
+{
+    chBSemSignal((binary_semaphore_t *)_sem);
+}
+
+#endif // CH_CFG_USE_SEMAPHORES
@@ -49,3 +49,14 @@ public:
 private:
     uint32_t count;
 };
+
+// a binary semaphore, used to wake a thread from another thread
+class ChibiOS::BinarySemaphore : public AP_HAL::BinarySemaphore {
+public:
+    BinarySemaphore();
+    bool wait(uint32_t timeout_us) override;
+    void signal() override;
+private:
+    // declared as uint32_t for the same reason as Semaphore::_lock
+    uint32_t _sem[4];
+};
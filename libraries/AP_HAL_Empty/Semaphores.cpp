@@ -25,3 +25,14 @@ bool Semaphore::take_nonblocking() {
         return false;
     }
 }
+
+bool BinarySemaphore::wait(uint32_t timeout_us) {
+    /* there is no other thread to wait for */
+    const bool ret = _pending;
+    _pending = false;
+    return ret;
+}
+
+void BinarySemaphore::signal() {
+    _pending = true;
+}
@@ -11,3 +11,12 @@ public:
 private:
     bool _taken;
 };
+
+class Empty::BinarySemaphore : public AP_HAL::BinarySemaphore {
+public:
+    BinarySemaphore() : _pending(false) {}
+    bool wait(uint32_t timeout_us) override;
+    void signal() override;
+private:
+    bool _pending;
+};
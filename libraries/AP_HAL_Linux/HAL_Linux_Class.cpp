@@ -257,6 +257,10 @@ void _usage(void)
     printf("\tcustom terrain path:\n");
     printf("\t                   --terrain-directory /var/APM/terrain\n");
     printf("\t                   -t /var/APM/terrain\n");
+    printf("\tpin threads to CPUs, by group (main, timer, uart, rcin, io, sensors):\n");
+    printf("\t                   --cpu-affinity \"main=3 timer=3 io=0-1\"\n");
+    printf("\tprint per-thread runtime statistics every 10 seconds:\n");
+    printf("\t                   --thread-stats\n");
 #if AP_MODULE_SUPPORTED
     printf("\tmodule support:\n");
     printf("\t                   --module-directory %s\n", AP_MODULE_DEFAULT_DIRECTORY);
@@ -286,6 +290,8 @@ void HAL_Linux::run(int argc, char* const argv[], Callbacks* callbacks) const
         {"terrain-directory",   true,  0, 't'},
         {"storage-directory",   true,  0, 's'},
         {"module-directory",    true,  0, 'M'},
+        {"cpu-affinity",        true,  0, 'c'},
+        {"thread-stats",        false,  0, 'T'},
         {"help",                false,  0, 'h'},
         {0, false, 0, 0}
     };
@@ -336,6 +342,14 @@ void HAL_Linux::run(int argc, char* const argv[], Callbacks* callbacks) const
             module_path = gopt.optarg;
             break;
 #endif
+        case 'c':
+            if (!Scheduler::from(scheduler)->set_cpu_affinity(gopt.optarg)) {
+                exit(1);
+            }
+            break;
+        case 'T':
+            Scheduler::from(scheduler)->enable_thread_stats();
+            break;
         case 'h':
             _usage();
             exit(0);
@@ -70,6 +70,19 @@ public:
                              uint32_t timeout_usec);
     bool adjust_timer(TimerPollable *p, uint32_t timeout_usec);
 
+    /*
+     * Watch a file descriptor in the same loop as the timers. Can be
+     * called from any thread.
+     */
+    bool register_pollable(Pollable *p, uint32_t events)
+    {
+        return _poller.register_pollable(p, events);
+    }
+    void unregister_pollable(const Pollable *p)
+    {
+        _poller.unregister_pollable(p);
+    }
+
     void mainloop();
 
     bool stop() override;
@@ -421,6 +421,7 @@ AP_HAL::Device::PeriodicHandle SPIDevice::register_periodic_callback(
         snprintf(name, sizeof(name), "ap-spi-%u", _bus.bus);
 
         _bus.thread.set_stack_size(AP_LINUX_SENSORS_STACK_SIZE);
+        Scheduler::from(hal.scheduler)->configure_thread(_bus.thread, Scheduler::THREAD_GROUP_SENSORS);
         _bus.thread.start(name, AP_LINUX_SENSORS_SCHED_POLICY,
                           AP_LINUX_SENSORS_SCHED_PRIO);
     }
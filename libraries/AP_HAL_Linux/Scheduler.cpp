@@ -1,10 +1,16 @@
 #include "Scheduler.h"
 
 #include <algorithm>
+#include <alloca.h>
 #include <errno.h>
+#include <malloc.h>
 #include <poll.h>
+#include <sched.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/mman.h>
 #include <sys/time.h>
 #include <unistd.h>
@@ -33,6 +39,9 @@ extern const AP_HAL::HAL& hal;
 
 #define APM_LINUX_TIMER_RATE            1000
 #define APM_LINUX_UART_RATE             100
+// UARTs with nothing to write are only polled for reconnections
+#define APM_LINUX_UART_IDLE_RATE        10
+#define APM_LINUX_UART_IDLE_DELAY_USEC  1000000ULL
 #if CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_NAVIO ||    \
     CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_ERLEBRAIN2 || \
     CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_BH || \
@@ -45,6 +54,20 @@ extern const AP_HAL::HAL& hal;
 #define APM_LINUX_IO_RATE               50
 #endif
 
+// stack of the main thread faulted in at startup
+#define APM_LINUX_MAIN_STACK_PREFAULT   (256 * 1024)
+
+#define APM_LINUX_THREAD_STATS_PERIOD_USEC 10000000ULL
+
+/*
+  CPU affinity for the thread groups, in the format taken by
+  --cpu-affinity. Boards with spare cores may set this to isolate the
+  main and timer threads
+ */
+#ifndef HAL_LINUX_CPU_AFFINITY
+#define HAL_LINUX_CPU_AFFINITY ""
+#endif
+
 #define SCHED_THREAD(name_, UPPER_NAME_)                        \
     {                                                           \
         .name = "ap-" #name_,                                   \
@@ -52,10 +75,154 @@ extern const AP_HAL::HAL& hal;
         .policy = SCHED_FIFO,                                   \
         .prio = APM_LINUX_##UPPER_NAME_##_PRIORITY,             \
         .rate = APM_LINUX_##UPPER_NAME_##_RATE,                 \
+        .group = THREAD_GROUP_##UPPER_NAME_,                    \
     }
 
+static const char *thread_group_names[Scheduler::THREAD_GROUP_COUNT] = {
+    "main",
+    "timer",
+    "uart",
+    "rcin",
+    "io",
+    "sensors",
+};
+
 Scheduler::Scheduler()
-{ }
+{
+    if (sched_getaffinity(0, sizeof(_default_cpus), &_default_cpus) != 0) {
+        CPU_ZERO(&_default_cpus);
+        for (uint16_t cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            CPU_SET(cpu, &_default_cpus);
+        }
+    }
+}
+
+/*
+  parse a CPU list such as "0-1,3"
+ */
+static bool parse_cpu_list(const char *list, cpu_set_t &cpus)
+{
+    CPU_ZERO(&cpus);
+    while (*list) {
+        char *end;
+        const unsigned long first = strtoul(list, &end, 10);
+        unsigned long last = first;
+        if (end == list) {
+            return false;
+        }
+        if (*end == '-') {
+            list = end + 1;
+            last = strtoul(list, &end, 10);
+            if (end == list || last < first) {
+                return false;
+            }
+        }
+        if (last >= CPU_SETSIZE) {
+            return false;
+        }
+        for (unsigned long cpu = first; cpu <= last; cpu++) {
+            CPU_SET(cpu, &cpus);
+        }
+        if (*end == ',') {
+            end++;
+        } else if (*end != 0) {
+            return false;
+        }
+        list = end;
+    }
+    return CPU_COUNT(&cpus) > 0;
+}
+
+/*
+  format a CPU set as a CPU list, the reverse of parse_cpu_list()
+ */
+static void format_cpu_list(const cpu_set_t &cpus, char *buf, size_t len)
+{
+    size_t n = 0;
+    buf[0] = 0;
+    for (int cpu = 0; cpu < CPU_SETSIZE && n < len; cpu++) {
+        if (!CPU_ISSET(cpu, &cpus)) {
+            continue;
+        }
+        int last = cpu;
+        while (last + 1 < CPU_SETSIZE && CPU_ISSET(last + 1, &cpus)) {
+            last++;
+        }
+        if (last == cpu) {
+            n += snprintf(&buf[n], len - n, "%s%d", n ? "," : "", cpu);
+        } else {
+            n += snprintf(&buf[n], len - n, "%s%d-%d", n ? "," : "", cpu, last);
+        }
+        cpu = last;
+    }
+}
+
+bool Scheduler::set_cpu_affinity(const char *spec)
+{
+    char *s = strdup(spec);
+    if (s == nullptr) {
+        return false;
+    }
+
+    bool ret = true;
+    char *saveptr = nullptr;
+    for (char *entry = strtok_r(s, " ", &saveptr);
+         entry != nullptr;
+         entry = strtok_r(nullptr, " ", &saveptr)) {
+        char *cpu_list = strchr(entry, '=');
+        if (cpu_list == nullptr) {
+            fprintf(stderr, "Scheduler: expected GROUP=CPULIST in '%s'\n", entry);
+            ret = false;
+            break;
+        }
+        *cpu_list++ = 0;
+
+        uint8_t group;
+        for (group = 0; group < THREAD_GROUP_COUNT; group++) {
+            if (strcmp(entry, thread_group_names[group]) == 0) {
+                break;
+            }
+        }
+        if (group == THREAD_GROUP_COUNT) {
+            fprintf(stderr, "Scheduler: unknown thread group '%s'\n", entry);
+            ret = false;
+            break;
+        }
+
+        cpu_set_t cpus;
+        if (!parse_cpu_list(cpu_list, cpus)) {
+            fprintf(stderr, "Scheduler: bad CPU list '%s' for %s\n", cpu_list, entry);
+            ret = false;
+            break;
+        }
+        CPU_AND(&cpus, &cpus, &_default_cpus);
+        if (CPU_COUNT(&cpus) == 0) {
+            fprintf(stderr, "Scheduler: no usable CPUs in '%s' for %s\n", cpu_list, entry);
+            ret = false;
+            break;
+        }
+
+        _group_cpus[group] = cpus;
+        _group_cpus_set[group] = true;
+        _cpu_affinity_configured = true;
+    }
+
+    free(s);
+    return ret;
+}
+
+/*
+  pin a thread to the CPUs of its group. Threads inherit the affinity of
+  the thread creating them, so when any group is pinned, the threads of
+  the other groups are explicitly allowed on all CPUs
+ */
+void Scheduler::configure_thread(Thread &thread, thread_group group)
+{
+    if (!_cpu_affinity_configured) {
+        return;
+    }
+    thread.set_cpu_affinity(_group_cpus_set[group] ? _group_cpus[group] : _default_cpus);
+}
 
 
 void Scheduler::init_realtime()
@@ -72,7 +239,14 @@ void Scheduler::init_realtime()
     }
 #endif
 
-    mlockall(MCL_CURRENT|MCL_FUTURE);
+    if (mlockall(MCL_CURRENT|MCL_FUTURE) == -1) {
+        fprintf(stderr, "WARNING: failed to lock memory: %s\n", strerror(errno));
+    } else {
+        // keep freed memory in the heap, so it doesn't fault when reused
+        mallopt(M_TRIM_THRESHOLD, -1);
+        mallopt(M_MMAP_MAX, 0);
+        _prefault_stack();
+    }
 
     struct sched_param param = { .sched_priority = APM_LINUX_MAIN_PRIORITY };
     if (sched_setscheduler(0, SCHED_FIFO, &param) == -1) {
@@ -81,6 +255,19 @@ void Scheduler::init_realtime()
     }
 }
 
+/*
+  fault in the main thread's stack, so a deeper call later doesn't stall
+  on a page fault. Thread stacks are faulted in by Thread::_poison_stack()
+ */
+void Scheduler::_prefault_stack()
+{
+    volatile uint8_t *stack = (volatile uint8_t *)alloca(APM_LINUX_MAIN_STACK_PREFAULT);
+    const long page_size = sysconf(_SC_PAGESIZE);
+    for (uint32_t i = 0; i < APM_LINUX_MAIN_STACK_PREFAULT; i += page_size) {
+        stack[i] = 0;
+    }
+}
+
 void Scheduler::init()
 {
     int ret;
@@ -90,19 +277,30 @@ void Scheduler::init()
         int policy;
         int prio;
         uint32_t rate;
+        thread_group group;
     } sched_table[] = {
         SCHED_THREAD(timer, TIMER),
-        SCHED_THREAD(uart, UART),
         SCHED_THREAD(rcin, RCIN),
         SCHED_THREAD(io, IO),
     };
 
     _main_ctx = pthread_self();
 
+    if (!_cpu_affinity_configured && !set_cpu_affinity(HAL_LINUX_CPU_AFFINITY)) {
+        AP_HAL::panic("Scheduler: bad HAL_LINUX_CPU_AFFINITY");
+    }
+    if (_group_cpus_set[THREAD_GROUP_MAIN]) {
+        ret = pthread_setaffinity_np(_main_ctx, sizeof(cpu_set_t), &_group_cpus[THREAD_GROUP_MAIN]);
+        if (ret) {
+            AP_HAL::panic("Scheduler: failed to set main thread CPU affinity: %s",
+                          strerror(ret));
+        }
+    }
+
     init_realtime();
 
-    /* set barrier to N + 1 threads: worker threads + main */
-    unsigned n_threads = ARRAY_SIZE(sched_table) + 1;
+    /* set barrier to N + 2 threads: worker threads + uart + main */
+    unsigned n_threads = ARRAY_SIZE(sched_table) + 2;
     ret = pthread_barrier_init(&_initialized_barrier, nullptr, n_threads);
     if (ret) {
         AP_HAL::panic("Scheduler: Failed to initialise barrier object: %s",
@@ -114,9 +312,29 @@ void Scheduler::init()
 
         t->thread->set_rate(t->rate);
         t->thread->set_stack_size(1024 * 1024);
+        configure_thread(*t->thread, t->group);
         t->thread->start(t->name, t->policy, t->prio);
     }
 
+    /*
+      the uart thread is woken by its devices. The timer polls the
+      devices that can't wake it, and retries writes
+     */
+    _uart_timer = _uart_thread.add_timer(FUNCTOR_BIND_MEMBER(&Scheduler::_uart_task, void),
+                                         nullptr, AP_USEC_PER_SEC / APM_LINUX_UART_RATE);
+    if (_uart_timer == nullptr) {
+        AP_HAL::panic("Scheduler: failed to create uart timer");
+    }
+    _uart_busy = true;
+    if (!_uart_wakeup.init()) {
+        fprintf(stderr, "WARNING: failed to create uart wakeup, UARTs will be polled\n");
+    }
+    _uart_thread.set_stack_size(1024 * 1024);
+    configure_thread(_uart_thread, THREAD_GROUP_UART);
+    _uart_thread.start("ap-uart", SCHED_FIFO, APM_LINUX_UART_PRIORITY);
+
+    _last_thread_stats_usec = AP_HAL::micros64();
+
 #if defined(DEBUG_STACK) && DEBUG_STACK
     register_timer_process(FUNCTOR_BIND_MEMBER(&Scheduler::_debug_stack, void));
 #endif
@@ -252,19 +470,24 @@ void Scheduler::_run_io(void)
 }
 
 /*
-  run timers for all UARTs
+  run timers for all UARTs, returning true if any of them has to keep
+  being polled
  */
-void Scheduler::_run_uarts()
+bool Scheduler::_run_uarts()
 {
+    AP_HAL::UARTDriver *uarts[] = {
+        hal.uartA, hal.uartB, hal.uartC, hal.uartD,
+        hal.uartE, hal.uartF, hal.uartG, hal.uartH,
+    };
+    bool busy = false;
+
     // process any pending serial bytes
-    hal.uartA->_timer_tick();
-    hal.uartB->_timer_tick();
-    hal.uartC->_timer_tick();
-    hal.uartD->_timer_tick();
-    hal.uartE->_timer_tick();
-    hal.uartF->_timer_tick();
-    hal.uartG->_timer_tick();
-    hal.uartH->_timer_tick();
+    for (AP_HAL::UARTDriver *uart : uarts) {
+        uart->_timer_tick();
+        busy |= UARTDriver::from(uart)->_needs_polling();
+    }
+
+    return busy;
 }
 
 void Scheduler::_rcin_task()
@@ -274,7 +497,87 @@ void Scheduler::_rcin_task()
 
 void Scheduler::_uart_task()
 {
-    _run_uarts();
+    const uint64_t now = AP_HAL::micros64();
+    if (_run_uarts() || _uart_wakeup.get_fd() < 0) {
+        _uart_last_busy_usec = now;
+    }
+
+    /*
+      keep polling at the full rate for a while after the last write, so
+      a stream of writes doesn't wake the thread once per message
+     */
+    const bool busy = now - _uart_last_busy_usec < APM_LINUX_UART_IDLE_DELAY_USEC;
+    if (busy == _uart_busy) {
+        return;
+    }
+    _uart_busy = busy;
+    if (!busy && _run_uarts()) {
+        // a write queued just before going idle didn't wake us up
+        _uart_busy = true;
+        _uart_last_busy_usec = now;
+        return;
+    }
+    _uart_thread.adjust_timer(_uart_timer, AP_USEC_PER_SEC /
+                              (busy ? APM_LINUX_UART_RATE : APM_LINUX_UART_IDLE_RATE));
+}
+
+bool Scheduler::register_uart_pollable(Pollable *p)
+{
+    /*
+      edge triggered, so UARTDriver reads until the device is empty.
+      Data left behind when a read buffer is full doesn't keep waking
+      the thread: the timer stays at the full rate until it is read
+     */
+    return _uart_thread.register_pollable(p, EPOLLIN | EPOLLET);
+}
+
+void Scheduler::unregister_uart_pollable(const Pollable *p)
+{
+    _uart_thread.unregister_pollable(p);
+}
+
+void Scheduler::wakeup_uarts()
+{
+    if (!_uart_busy) {
+        _uart_wakeup.wakeup();
+    }
+}
+
+bool Scheduler::UARTWakeup::init()
+{
+    _fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_fd < 0) {
+        return false;
+    }
+    if (!_sched._uart_thread.register_pollable(this, EPOLLIN)) {
+        close(_fd);
+        _fd = -1;
+        return false;
+    }
+    return true;
+}
+
+void Scheduler::UARTWakeup::wakeup()
+{
+    const uint64_t val = 1;
+    ssize_t r;
+
+    if (_fd < 0) {
+        return;
+    }
+
+    do {
+        r = write(_fd, &val, sizeof(val));
+    } while (r == -1 && errno == EINTR);
+}
+
+void Scheduler::UARTWakeup::on_can_read()
+{
+    uint64_t val;
+
+    if (read(_fd, &val, sizeof(val)) > 0) {
+        _sched._uart_task();
+    }
 }
 
 void Scheduler::_io_task()
@@ -284,6 +587,10 @@ void Scheduler::_io_task()
 
     // run registered IO processes
     _run_io();
+
+    if (_thread_stats) {
+        _report_thread_stats();
+    }
 }
 
 bool Scheduler::in_main_thread() const
@@ -330,6 +637,13 @@ bool Scheduler::SchedulerThread::_run()
     return PeriodicThread::_run();
 }
 
+bool Scheduler::UARTThread::_run()
+{
+    _sched._wait_all_threads();
+
+    return PollerThread::_run();
+}
+
 void Scheduler::teardown()
 {
     _timer_thread.stop();
@@ -354,25 +668,28 @@ bool Scheduler::thread_create(AP_HAL::MemberProc proc, const char *name, uint32_
     }
 
     uint8_t thread_priority = APM_LINUX_IO_PRIORITY;
+    thread_group group = THREAD_GROUP_IO;
     static const struct {
         priority_base base;
         uint8_t p;
+        thread_group group;
     } priority_map[] = {
-        { PRIORITY_BOOST, APM_LINUX_MAIN_PRIORITY},
-        { PRIORITY_MAIN, APM_LINUX_MAIN_PRIORITY},
-        { PRIORITY_SPI, AP_LINUX_SENSORS_SCHED_PRIO},
-        { PRIORITY_I2C, AP_LINUX_SENSORS_SCHED_PRIO},
-        { PRIORITY_CAN, APM_LINUX_TIMER_PRIORITY},
-        { PRIORITY_TIMER, APM_LINUX_TIMER_PRIORITY},
-        { PRIORITY_RCIN, APM_LINUX_RCIN_PRIORITY},
-        { PRIORITY_IO, APM_LINUX_IO_PRIORITY},
-        { PRIORITY_UART, APM_LINUX_UART_PRIORITY},
-        { PRIORITY_STORAGE, APM_LINUX_IO_PRIORITY},
-        { PRIORITY_SCRIPTING, APM_LINUX_SCRIPTING_PRIORITY},
+        { PRIORITY_BOOST, APM_LINUX_MAIN_PRIORITY, THREAD_GROUP_MAIN},
+        { PRIORITY_MAIN, APM_LINUX_MAIN_PRIORITY, THREAD_GROUP_MAIN},
+        { PRIORITY_SPI, AP_LINUX_SENSORS_SCHED_PRIO, THREAD_GROUP_SENSORS},
+        { PRIORITY_I2C, AP_LINUX_SENSORS_SCHED_PRIO, THREAD_GROUP_SENSORS},
+        { PRIORITY_CAN, APM_LINUX_TIMER_PRIORITY, THREAD_GROUP_SENSORS},
+        { PRIORITY_TIMER, APM_LINUX_TIMER_PRIORITY, THREAD_GROUP_TIMER},
+        { PRIORITY_RCIN, APM_LINUX_RCIN_PRIORITY, THREAD_GROUP_RCIN},
+        { PRIORITY_IO, APM_LINUX_IO_PRIORITY, THREAD_GROUP_IO},
+        { PRIORITY_UART, APM_LINUX_UART_PRIORITY, THREAD_GROUP_UART},
+        { PRIORITY_STORAGE, APM_LINUX_IO_PRIORITY, THREAD_GROUP_IO},
+        { PRIORITY_SCRIPTING, APM_LINUX_SCRIPTING_PRIORITY, THREAD_GROUP_IO},
     };
     for (uint8_t i=0; i<ARRAY_SIZE(priority_map); i++) {
         if (priority_map[i].base == base) {
             thread_priority = constrain_int16(priority_map[i].p + priority, 1, APM_LINUX_MAX_PRIORITY);
+            group = priority_map[i].group;
             break;
         }
     }
@@ -386,6 +703,8 @@ bool Scheduler::thread_create(AP_HAL::MemberProc proc, const char *name, uint32_
      */
     thread->set_auto_free(true);
 
+    configure_thread(*thread, group);
+
     if (!thread->start(name, SCHED_FIFO, thread_priority)) {
         delete thread;
         return false;
@@ -393,3 +712,95 @@ bool Scheduler::thread_create(AP_HAL::MemberProc proc, const char *name, uint32_
 
     return true;
 }
+
+void Scheduler::register_thread(Thread *thread)
+{
+    pthread_mutex_lock(&_threads_mutex);
+    for (uint8_t i = 0; i < ARRAY_SIZE(_threads); i++) {
+        if (_threads[i].thread == nullptr) {
+            _threads[i].thread = thread;
+            _threads[i].last_cpu_usec = 0;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&_threads_mutex);
+}
+
+void Scheduler::unregister_thread(Thread *thread)
+{
+    pthread_mutex_lock(&_threads_mutex);
+    for (uint8_t i = 0; i < ARRAY_SIZE(_threads); i++) {
+        if (_threads[i].thread == thread) {
+            _threads[i].thread = nullptr;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&_threads_mutex);
+}
+
+static void print_thread_stats(const char *name, pthread_t ctx,
+                               uint64_t cpu_usec, uint64_t period_usec)
+{
+    struct sched_param param {};
+    int policy;
+    if (pthread_getschedparam(ctx, &policy, &param) != 0) {
+        param.sched_priority = 0;
+    }
+
+    char cpus_str[32] = "?";
+    cpu_set_t cpus;
+    if (pthread_getaffinity_np(ctx, sizeof(cpus), &cpus) == 0) {
+        format_cpu_list(cpus, cpus_str, sizeof(cpus_str));
+    }
+
+    fprintf(stderr, "%-16s prio %2d cpus %-8s %5.1f%%",
+            name, param.sched_priority, cpus_str,
+            cpu_usec * 100.0 / period_usec);
+}
+
+/*
+  print the CPU use of every thread, and the timing of the periodic
+  threads, every APM_LINUX_THREAD_STATS_PERIOD_USEC
+ */
+void Scheduler::_report_thread_stats()
+{
+    const uint64_t now = AP_HAL::micros64();
+    const uint64_t period_usec = now - _last_thread_stats_usec;
+    if (period_usec < APM_LINUX_THREAD_STATS_PERIOD_USEC) {
+        return;
+    }
+    _last_thread_stats_usec = now;
+
+    fprintf(stderr, "Thread statistics over %.1fs:\n", period_usec * 1.0e-6);
+
+    clockid_t clock;
+    struct timespec ts;
+    if (pthread_getcpuclockid(_main_ctx, &clock) == 0 &&
+        clock_gettime(clock, &ts) == 0) {
+        const uint64_t cpu_usec = ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+        print_thread_stats("ap-main", _main_ctx, cpu_usec - _main_last_cpu_usec, period_usec);
+        fprintf(stderr, "\n");
+        _main_last_cpu_usec = cpu_usec;
+    }
+
+    pthread_mutex_lock(&_threads_mutex);
+    for (uint8_t i = 0; i < ARRAY_SIZE(_threads); i++) {
+        Thread *thread = _threads[i].thread;
+        if (thread == nullptr || !thread->is_started()) {
+            continue;
+        }
+        const uint64_t cpu_usec = thread->get_cpu_time_usec();
+        print_thread_stats(thread->get_name(), thread->get_ctx(),
+                           cpu_usec - _threads[i].last_cpu_usec, period_usec);
+        _threads[i].last_cpu_usec = cpu_usec;
+
+        Thread::loop_stats stats;
+        if (thread->get_loop_stats(stats)) {
+            fprintf(stderr, " loops %u overruns %u late max %uus run max %uus",
+                    (unsigned)stats.loops, (unsigned)stats.overruns,
+                    (unsigned)stats.max_late_usec, (unsigned)stats.max_run_usec);
+        }
+        fprintf(stderr, "\n");
+    }
+    pthread_mutex_unlock(&_threads_mutex);
+}
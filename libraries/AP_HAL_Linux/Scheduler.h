@@ -1,14 +1,18 @@
 #pragma once
 
+#include <atomic>
 #include <pthread.h>
 
 #include "AP_HAL_Linux.h"
+#include "Poller.h"
+#include "PollerThread.h"
 #include "Semaphores.h"
 #include "Thread.h"
 
 #define LINUX_SCHEDULER_MAX_TIMER_PROCS 10
 #define LINUX_SCHEDULER_MAX_TIMESLICED_PROCS 10
 #define LINUX_SCHEDULER_MAX_IO_PROCS 10
+#define LINUX_SCHEDULER_MAX_THREADS 32
 
 #define AP_LINUX_SENSORS_STACK_SIZE  256 * 1024
 #define AP_LINUX_SENSORS_SCHED_POLICY  SCHED_FIFO
@@ -51,7 +55,49 @@ public:
       create a new thread
      */
     bool thread_create(AP_HAL::MemberProc, const char *name, uint32_t stack_size, priority_base base, int8_t priority) override;
-    
+
+    /*
+      threads are pinned to CPUs by group, so the main and timer threads
+      can be kept apart from IO and logging
+     */
+    enum thread_group {
+        THREAD_GROUP_MAIN,
+        THREAD_GROUP_TIMER,
+        THREAD_GROUP_UART,
+        THREAD_GROUP_RCIN,
+        THREAD_GROUP_IO,
+        THREAD_GROUP_SENSORS,
+        THREAD_GROUP_COUNT
+    };
+
+    /*
+      set CPU affinity from a list of GROUP=CPULIST entries separated by
+      spaces, e.g. "main=3 timer=3 io=0-1", where CPULIST is as in
+      taskset -c. Groups not listed may run on any CPU. Must be called
+      before init()
+     */
+    bool set_cpu_affinity(const char *spec);
+
+    /* set the CPU affinity of a thread in a group, before it is started */
+    void configure_thread(Thread &thread, thread_group group);
+
+    /* print per-thread runtime statistics every 10 seconds */
+    void enable_thread_stats() { _thread_stats = true; }
+
+    /* keep track of threads for statistics */
+    void register_thread(Thread *thread);
+    void unregister_thread(Thread *thread);
+
+    /*
+      UART, UDP and TCP devices are serviced by the uart thread as soon
+      as their file descriptor is readable
+     */
+    bool register_uart_pollable(Pollable *p);
+    void unregister_uart_pollable(const Pollable *p);
+
+    /* service the UARTs now that a write is queued, if they are idle */
+    void wakeup_uarts();
+
 private:
     class SchedulerThread : public PeriodicThread {
     public:
@@ -66,7 +112,38 @@ private:
         Scheduler &_sched;
     };
 
+    /*
+      the uart thread waits for its devices and a timer in one epoll
+      loop, rather than running at a fixed rate
+     */
+    class UARTThread : public PollerThread {
+    public:
+        UARTThread(Scheduler &sched) : _sched(sched) { }
+
+    protected:
+        bool _run() override;
+
+        Scheduler &_sched;
+    };
+
+    /* eventfd used to run the UARTs when a write is queued */
+    class UARTWakeup : public Pollable {
+    public:
+        UARTWakeup(Scheduler &sched) : _sched(sched) { }
+
+        bool init();
+        void wakeup();
+
+        void on_can_read() override;
+
+    private:
+        Scheduler &_sched;
+    };
+
     void     init_realtime();
+    void     _prefault_stack();
+
+    void     _report_thread_stats();
 
     void _wait_all_threads();
 
@@ -87,7 +164,12 @@ private:
     SchedulerThread _timer_thread{FUNCTOR_BIND_MEMBER(&Scheduler::_timer_task, void), *this};
     SchedulerThread _io_thread{FUNCTOR_BIND_MEMBER(&Scheduler::_io_task, void), *this};
     SchedulerThread _rcin_thread{FUNCTOR_BIND_MEMBER(&Scheduler::_rcin_task, void), *this};
-    SchedulerThread _uart_thread{FUNCTOR_BIND_MEMBER(&Scheduler::_uart_task, void), *this};
+    UARTThread _uart_thread{*this};
+    UARTWakeup _uart_wakeup{*this};
+    TimerPollable *_uart_timer;
+    // true while the UARTs are polled at APM_LINUX_UART_RATE
+    std::atomic<bool> _uart_busy;
+    uint64_t _uart_last_busy_usec;
 
     void _timer_task();
     void _io_task();
@@ -95,13 +177,28 @@ private:
     void _uart_task();
 
     void _run_io();
-    void _run_uarts();
+    bool _run_uarts();
 
     uint64_t _stopped_clock_usec;
     uint64_t _last_stack_debug_msec;
     pthread_t _main_ctx;
 
     Semaphore _io_semaphore;
+
+    // CPUs the process could run on at startup, used for groups not pinned
+    cpu_set_t _default_cpus;
+    cpu_set_t _group_cpus[THREAD_GROUP_COUNT];
+    bool _group_cpus_set[THREAD_GROUP_COUNT];
+    bool _cpu_affinity_configured;
+
+    struct thread_info {
+        Thread *thread;
+        uint64_t last_cpu_usec;
+    } _threads[LINUX_SCHEDULER_MAX_THREADS];
+    pthread_mutex_t _threads_mutex = PTHREAD_MUTEX_INITIALIZER;
+    bool _thread_stats;
+    uint64_t _last_thread_stats_usec;
+    uint64_t _main_last_cpu_usec;
 };
 
 }
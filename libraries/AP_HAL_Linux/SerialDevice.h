@@ -23,4 +23,11 @@ public:
 
     /* Depends on lower level to implement, most devices are fine with defaults */
     virtual void set_parity(int v) { }
+
+    /*
+     * File descriptor that becomes readable when there is data to read, so
+     * the device can be serviced as soon as data arrives. Devices returning
+     * -1 are polled.
+     */
+    virtual int get_fd() const { return -1; }
 };
@@ -20,6 +20,8 @@
 #include <limits.h>
 #include <sys/types.h>
 #include <stdio.h>
+#include <string.h>
+#include <time.h>
 #include <unistd.h>
 #include <utility>
 
@@ -38,9 +40,12 @@ namespace Linux {
 void *Thread::_run_trampoline(void *arg)
 {
     Thread *thread = static_cast<Thread *>(arg);
+    // poisoning the stack also faults in all of its pages up front
     thread->_poison_stack();
     thread->_run();
 
+    Scheduler::from(hal.scheduler)->unregister_thread(thread);
+
     if (thread->_auto_free) {
         delete thread;
     }
@@ -189,6 +194,19 @@ bool Thread::start(const char *name, int policy, int prio)
         }
     }
 
+    if (_cpus_set &&
+        (r = pthread_attr_setaffinity_np(&attr, sizeof(_cpus), &_cpus)) != 0) {
+        AP_HAL::panic("Failed to set CPU affinity for thread '%s': %s",
+                      name, strerror(r));
+    }
+
+    if (name) {
+        strncpy(_name, name, sizeof(_name) - 1);
+    }
+
+    // registered before it starts, as it may finish before we return
+    Scheduler::from(hal.scheduler)->register_thread(this);
+
     r = pthread_create(&_ctx, &attr, &Thread::_run_trampoline, this);
     if (r != 0) {
         AP_HAL::panic("Failed to create thread '%s': %s",
@@ -205,6 +223,31 @@ bool Thread::start(const char *name, int policy, int prio)
     return true;
 }
 
+bool Thread::set_cpu_affinity(const cpu_set_t &cpus)
+{
+    if (_started) {
+        return false;
+    }
+
+    _cpus = cpus;
+    _cpus_set = true;
+
+    return true;
+}
+
+uint64_t Thread::get_cpu_time_usec()
+{
+    clockid_t clock;
+    struct timespec ts;
+
+    if (!_started || pthread_getcpuclockid(_ctx, &clock) != 0 ||
+        clock_gettime(clock, &ts) != 0) {
+        return 0;
+    }
+
+    return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
 bool Thread::is_current_thread()
 {
     return pthread_equal(pthread_self(), _ctx);
@@ -258,16 +301,30 @@ bool PeriodicThread::_run()
     uint64_t next_run_usec = AP_HAL::micros64() + _period_usec;
 
     while (!_should_exit) {
+        if (_stats_reset) {
+            memset(&_stats, 0, sizeof(_stats));
+            _stats_reset = false;
+        }
+
         uint64_t dt = next_run_usec - AP_HAL::micros64();
         if (dt > _period_usec) {
             // we've lost sync - restart
             next_run_usec = AP_HAL::micros64();
+            _stats.overruns++;
         } else {
             Scheduler::from(hal.scheduler)->microsleep(dt);
         }
+
+        const uint64_t start_usec = AP_HAL::micros64();
+        if (start_usec > next_run_usec) {
+            _stats.max_late_usec = MAX(_stats.max_late_usec, start_usec - next_run_usec);
+        }
         next_run_usec += _period_usec;
 
         _task();
+
+        _stats.max_run_usec = MAX(_stats.max_run_usec, AP_HAL::micros64() - start_usec);
+        _stats.loops++;
     }
 
     _started = false;
@@ -276,6 +333,18 @@ bool PeriodicThread::_run()
     return true;
 }
 
+/*
+  get the loop timing since the last call. The statistics are reset by
+  the thread itself, so a loop in progress is not lost
+ */
+bool PeriodicThread::get_loop_stats(loop_stats &stats)
+{
+    stats = _stats;
+    _stats_reset = true;
+
+    return true;
+}
+
 bool PeriodicThread::stop()
 {
     if (!is_started()) {
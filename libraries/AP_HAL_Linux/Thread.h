@@ -18,6 +18,7 @@
 
 #include <pthread.h>
 #include <inttypes.h>
+#include <sched.h>
 #include <stdlib.h>
 
 #include <AP_HAL/utility/functor.h>
@@ -37,6 +38,10 @@ public:
 
     bool start(const char *name, int policy, int prio);
 
+    const char *get_name() const { return _name; }
+
+    pthread_t get_ctx() const { return _ctx; }
+
     bool is_current_thread();
 
     bool is_started() const { return _started; }
@@ -45,6 +50,24 @@ public:
 
     bool set_stack_size(size_t stack_size);
 
+    /* Set the CPUs the thread may run on. Must be called before start() */
+    bool set_cpu_affinity(const cpu_set_t &cpus);
+
+    /* CPU time used by the thread since it started */
+    uint64_t get_cpu_time_usec();
+
+    /*
+     * Timing of a thread running a task periodically, since the last call
+     * to get_loop_stats()
+     */
+    struct loop_stats {
+        uint32_t loops;
+        uint32_t overruns;          // loops which started after the next was due
+        uint32_t max_late_usec;     // longest delay in starting a loop
+        uint32_t max_run_usec;      // longest time taken by the task
+    };
+    virtual bool get_loop_stats(loop_stats &stats) { return false; }
+
     void set_auto_free(bool auto_free) { _auto_free = auto_free; }
 
     virtual bool stop() { return false; }
@@ -68,6 +91,10 @@ protected:
     bool _should_exit = false;
     bool _auto_free = false;
     pthread_t _ctx = 0;
+    char _name[16] {};
+
+    cpu_set_t _cpus;
+    bool _cpus_set = false;
 
     struct stack_debug {
         uint32_t *start;
@@ -87,10 +114,15 @@ public:
 
     bool stop() override;
 
+    bool get_loop_stats(loop_stats &stats) override;
+
 protected:
     bool _run() override;
 
     uint64_t _period_usec = 0;
+
+    loop_stats _stats {};
+    volatile bool _stats_reset = false;
 };
 
 }
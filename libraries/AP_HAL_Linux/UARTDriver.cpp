@@ -20,6 +20,7 @@
 #include <AP_HAL/AP_HAL.h>
 
 #include "ConsoleDevice.h"
+#include "Scheduler.h"
 #include "TCPServerDevice.h"
 #include "UARTDevice.h"
 #include "UDPDevice.h"
@@ -218,6 +219,7 @@ void UARTDriver::end()
         hal.scheduler->delay(1);
     }
 
+    _unregister_pollable();
     _device->close();
     _deallocate_buffers();
 }
@@ -308,8 +310,12 @@ size_t UARTDriver::write(uint8_t c)
         }
         hal.scheduler->delay(1);
     }
+    const bool was_empty = _writebuf.available() == 0;
     size_t ret = _writebuf.write(&c, 1);
     _write_mutex.give();
+    if (was_empty && ret > 0) {
+        Scheduler::from(hal.scheduler)->wakeup_uarts();
+    }
     return ret;
 }
 
@@ -337,8 +343,12 @@ size_t UARTDriver::write(const uint8_t *buffer, size_t size)
         return ret;
     }
 
+    const bool was_empty = _writebuf.available() == 0;
     size_t ret = _writebuf.write(buffer, size);
     _write_mutex.give();
+    if (was_empty && ret > 0) {
+        Scheduler::from(hal.scheduler)->wakeup_uarts();
+    }
     return ret;
 }
 
@@ -417,9 +427,10 @@ bool UARTDriver::_write_pending_bytes(void)
 }
 
 /*
-  push any pending bytes to/from the serial port. This is called at
-  1kHz in the timer thread. Doing it this way reduces the system call
-  overhead in the main task enormously.
+  push any pending bytes to/from the serial port. This is called in the
+  uart thread when the device has data, when a write is queued and
+  periodically. Doing it this way reduces the system call overhead in
+  the main task enormously.
  */
 void UARTDriver::_timer_tick(void)
 {
@@ -432,31 +443,101 @@ void UARTDriver::_timer_tick(void)
         num_send--;
     }
 
-    // try to fill the read buffer
+    /*
+      try to fill the read buffer. A device registered with the uart
+      thread only wakes it when new data arrives, so it is read until it
+      is empty: a short read doesn't mean that, as UDP returns a single
+      datagram per read
+     */
+    const bool drain = _pollable_registered;
+    bool empty = false;
     int ret;
     ByteBuffer::IoVec vec[2];
 
-    const auto n_vec = _readbuf.reserve(vec, _readbuf.space());
-    for (int i = 0; i < n_vec; i++) {
-        ret = _read_fd(vec[i].data, vec[i].len);
-        if (ret < 0) {
+    do {
+        const auto n_vec = _readbuf.reserve(vec, _readbuf.space());
+        if (n_vec == 0) {
             break;
         }
-        _readbuf.commit((unsigned)ret);
-
-        // update receive timestamp
-        _receive_timestamp[_receive_timestamp_idx^1] = AP_HAL::micros64();
-        _receive_timestamp_idx ^= 1;
-        
-        /* stop reading as we read less than we asked for */
-        if ((unsigned)ret < vec[i].len) {
-            break;
+        for (int i = 0; i < n_vec; i++) {
+            ret = _read_fd(vec[i].data, vec[i].len);
+            if (ret <= 0) {
+                empty = true;
+                break;
+            }
+            _readbuf.commit((unsigned)ret);
+
+            // update receive timestamp
+            _receive_timestamp[_receive_timestamp_idx^1] = AP_HAL::micros64();
+            _receive_timestamp_idx ^= 1;
+
+            /* stop reading as we read less than we asked for */
+            if ((unsigned)ret < vec[i].len) {
+                empty = !drain;
+                break;
+            }
         }
-    }
+    } while (drain && !empty);
+
+    // with a full buffer the device may still hold data which won't wake us
+    _read_pending = drain && !empty;
+
+    _update_pollable();
 
     _in_timer = false;
 }
 
+bool UARTDriver::_needs_polling(void)
+{
+    if (!_initialised) {
+        return false;
+    }
+    return !_pollable_registered || _writebuf.available() > 0 || _read_pending;
+}
+
+/*
+  called by the uart thread when the device has data. If it couldn't all
+  be read, the thread has to start polling
+ */
+void UARTDriver::_device_ready()
+{
+    _timer_tick();
+    if (_needs_polling()) {
+        Scheduler::from(hal.scheduler)->wakeup_uarts();
+    }
+}
+
+/*
+  follow the device's file descriptor, which changes when it is opened
+  or a TCP client connects or goes away. This is only called from the
+  uart thread, or once it is no longer calling _timer_tick()
+ */
+void UARTDriver::_update_pollable()
+{
+    const int fd = _connected ? _device->get_fd() : -1;
+    if (fd == _pollable.get_fd()) {
+        return;
+    }
+
+    _unregister_pollable();
+    if (fd < 0) {
+        return;
+    }
+
+    // this fails for files such as /dev/null on stdin, which are polled
+    _pollable.set_fd(fd);
+    _pollable_registered = Scheduler::from(hal.scheduler)->register_uart_pollable(&_pollable);
+}
+
+void UARTDriver::_unregister_pollable()
+{
+    if (_pollable_registered) {
+        Scheduler::from(hal.scheduler)->unregister_uart_pollable(&_pollable);
+        _pollable_registered = false;
+    }
+    _pollable.set_fd(-1);
+}
+
 void UARTDriver::configure_parity(uint8_t v) {
     _device->set_parity(v);
 }
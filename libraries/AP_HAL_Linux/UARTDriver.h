@@ -4,6 +4,7 @@
 #include <AP_HAL/utility/RingBuffer.h>
 
 #include "AP_HAL_Linux.h"
+#include "Poller.h"
 #include "SerialDevice.h"
 #include "Semaphores.h"
 
@@ -40,6 +41,13 @@ public:
     bool _write_pending_bytes(void);
     virtual void _timer_tick(void) override;
 
+    /*
+      true if the uart thread has to keep calling _timer_tick()
+      periodically, because the device can't wake it up, there are
+      bytes waiting to be written or unread data left in the device
+     */
+    bool _needs_polling(void);
+
     virtual enum flow_control get_flow_control(void) override
     {
         return _device->get_flow_control();
@@ -84,6 +92,33 @@ private:
 
     AP_HAL::OwnPtr<SerialDevice> _parseDevicePath(const char *arg);
 
+    /*
+      wakes the uart thread when the device has data to read. The file
+      descriptor belongs to the device, so it isn't closed here
+     */
+    class DevicePollable : public Pollable {
+    public:
+        DevicePollable(UARTDriver &uart) : _uart(uart) { }
+        ~DevicePollable() { _fd = -1; }
+
+        void set_fd(int fd) { _fd = fd; }
+
+        void on_can_read() override { _uart._device_ready(); }
+        void on_hang_up() override { _uart._device_ready(); }
+
+    private:
+        UARTDriver &_uart;
+    };
+
+    DevicePollable _pollable{*this};
+    bool _pollable_registered;
+    // the read buffer filled before the device was drained
+    bool _read_pending;
+
+    void _device_ready();
+    void _update_pollable();
+    void _unregister_pollable();
+
     // timestamp for receiving data on the UART, avoiding a lock
     uint64_t _receive_timestamp[2];
     uint8_t _receive_timestamp_idx;
@@ -16,7 +16,9 @@
  */
 #include <AP_gtest.h>
 
+#include <fcntl.h>
 #include <pthread.h>
+#include <sys/epoll.h>
 #include <unistd.h>
 
 #include <AP_HAL/AP_HAL.h>
@@ -91,6 +93,47 @@ TEST(LinuxThread, poller_thread)
     EXPECT_TRUE(thr.join());
 }
 
+class TestPipePollable : public Pollable {
+public:
+    TestPipePollable(int fd) : Pollable(fd) { }
+
+    volatile int n_read = 0;
+
+    void on_can_read() override {
+        uint8_t c;
+        while (read(_fd, &c, 1) == 1) {
+            n_read++;
+        }
+    }
+};
+
+TEST(LinuxThread, poller_thread_pollable)
+{
+    int fds[2];
+    ASSERT_EQ(pipe2(fds, O_NONBLOCK | O_CLOEXEC), 0);
+
+    TestPipePollable p{fds[0]};
+    PollerThread thr;
+    EXPECT_TRUE(thr.register_pollable(&p, EPOLLIN));
+    EXPECT_TRUE(thr.start(nullptr, 0, 0));
+
+    while (!thr.is_started()) {
+        usleep(1000);
+    }
+
+    EXPECT_EQ(write(fds[1], "ab", 2), 2);
+    for (int i = 0; i < 100 && p.n_read < 2; i++) {
+        usleep(1000);
+    }
+    EXPECT_EQ(p.n_read, 2);
+
+    thr.unregister_pollable(&p);
+    EXPECT_TRUE(thr.stop());
+    EXPECT_TRUE(thr.join());
+
+    close(fds[1]);
+}
+
 class TestPeriodicThread1 : public PeriodicThread {
 public:
     TestPeriodicThread1() : PeriodicThread{FUNCTOR_BIND_MEMBER(&TestPeriodicThread1::_task, void)} { }
@@ -13,8 +13,12 @@ class RCInput;
 class Util;
 class Semaphore;
 class Semaphore_Recursive;
+class BinarySemaphore;
 class GPIO;
 class DigitalSource;
 class HALSITLCAN;
 class HALSITLCANDriver;
+class DeviceBus;
+class SPIDevice;
+class SPIDeviceManager;
 }  // namespace HALSITL
@@ -0,0 +1,179 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <AP_HAL/AP_HAL.h>
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+
+#include "DeviceBus.h"
+#include <SITL/SITL.h>
+
+#include <stdio.h>
+
+extern const AP_HAL::HAL& hal;
+
+using namespace HALSITL;
+
+// time taken to start a transfer, such as chip select setup or an I2C address
+#define TRANSFER_OVERHEAD_USEC 2
+
+DeviceBus::DeviceBus(AP_HAL::Device::BusType _bus_type, uint8_t _bus_num) :
+    bus_type(_bus_type),
+    bus_num(_bus_num)
+{
+}
+
+/*
+  per-bus callback thread
+ */
+void DeviceBus::bus_thread(void)
+{
+    while (true) {
+        uint64_t now = AP_HAL::micros64();
+
+        // run the callbacks which are due, unless the bus is still busy
+        for (callback_info *callback = callbacks; callback && now >= busy_until_usec; callback = callback->next) {
+            if (now < callback->next_usec) {
+                continue;
+            }
+            stats.max_callback_delay_usec = MAX(stats.max_callback_delay_usec, now - callback->next_usec);
+            while (now >= callback->next_usec) {
+                callback->next_usec += callback->period_usec;
+            }
+            // call it with semaphore held
+            if (semaphore.take(HAL_SEMAPHORE_BLOCK_FOREVER)) {
+                callback->cb();
+                semaphore.give();
+            }
+        }
+
+        report(now);
+
+        // work out when next loop is needed
+        now = AP_HAL::micros64();
+        uint64_t next_needed = 0;
+        for (callback_info *callback = callbacks; callback; callback = callback->next) {
+            if (next_needed == 0 || callback->next_usec < next_needed) {
+                next_needed = callback->next_usec;
+            }
+        }
+        next_needed = MAX(next_needed, busy_until_usec);
+
+        // delay for at most 50ms, to handle newly added callbacks
+        uint32_t delay = 50000;
+        if (next_needed > now && next_needed - now < delay) {
+            delay = next_needed - now;
+        } else if (next_needed <= now) {
+            // wait for the clock to advance
+            delay = 1;
+        }
+        hal.scheduler->delay_microseconds(delay);
+    }
+}
+
+AP_HAL::Device::PeriodicHandle DeviceBus::register_periodic_callback(uint32_t period_usec, AP_HAL::Device::PeriodicCb cb)
+{
+    if (!thread_started) {
+        thread_started = true;
+
+        char name[8];
+        snprintf(name, sizeof(name), "%s:%u",
+                 bus_type == AP_HAL::Device::BUS_TYPE_I2C ? "I2C" : "SPI", bus_num);
+        if (!hal.scheduler->thread_create(FUNCTOR_BIND_MEMBER(&DeviceBus::bus_thread, void),
+                                          name, 1024, AP_HAL::Scheduler::PRIORITY_SPI, 0)) {
+            AP_HAL::panic("Failed to create bus thread %s", name);
+        }
+    }
+    callback_info *callback = new callback_info;
+    if (callback == nullptr) {
+        return nullptr;
+    }
+    callback->cb = cb;
+    callback->period_usec = period_usec;
+    callback->next_usec = AP_HAL::micros64() + period_usec;
+
+    // add to linked list of callbacks on thread
+    callback->next = callbacks;
+    callbacks = callback;
+
+    return callback;
+}
+
+/*
+ * Adjust the timer for the next call: it needs to be called from the bus
+ * thread, otherwise it will race with it
+ */
+bool DeviceBus::adjust_timer(AP_HAL::Device::PeriodicHandle h, uint32_t period_usec)
+{
+    callback_info *callback = static_cast<callback_info *>(h);
+    if (callback == nullptr || !semaphore.take_nonblocking()) {
+        return false;
+    }
+    callback->period_usec = period_usec;
+    callback->next_usec = AP_HAL::micros64() + period_usec;
+    semaphore.give();
+
+    return true;
+}
+
+/*
+  account for a transfer of len bytes at clock_hz, returning the
+  simulation time at which it starts on the bus
+ */
+uint64_t DeviceBus::start_transfer(uint32_t len, uint32_t clock_hz)
+{
+    // I2C sends an acknowledge bit with every byte, and an address byte
+    const uint64_t bits = (bus_type == AP_HAL::Device::BUS_TYPE_I2C) ? (len + 1) * 9 : len * 8;
+    uint32_t duration_usec = TRANSFER_OVERHEAD_USEC + bits * 1000000ULL / MAX(clock_hz, 1U);
+
+    // extra time added to every transfer, to simulate a loaded bus
+    const SITL::SITL *sitl = AP::sitl();
+    if (sitl != nullptr && sitl->bus_delay > 0) {
+        duration_usec += sitl->bus_delay;
+    }
+
+    const uint64_t start_usec = MAX(AP_HAL::micros64(), busy_until_usec);
+    busy_until_usec = start_usec + duration_usec;
+
+    stats.transfers++;
+    stats.bytes += len;
+    stats.busy_usec += duration_usec;
+
+    return start_usec;
+}
+
+/*
+  print bus statistics every minute of simulated time
+ */
+void DeviceBus::report(uint64_t now)
+{
+    if (stats.start_usec == 0) {
+        stats.start_usec = now;
+        return;
+    }
+    const uint64_t elapsed_usec = now - stats.start_usec;
+    if (elapsed_usec < 60000000ULL) {
+        return;
+    }
+    ::printf("%s%u: %u transfers, %.1f kB/s, %.1f%% busy, max callback delay %uus\n",
+             bus_type == AP_HAL::Device::BUS_TYPE_I2C ? "I2C" : "SPI", bus_num,
+             (unsigned)stats.transfers,
+             stats.bytes * 1.0e3 / elapsed_usec,
+             stats.busy_usec * 100.0 / elapsed_usec,
+             (unsigned)stats.max_callback_delay_usec);
+    memset(&stats, 0, sizeof(stats));
+    stats.start_usec = now;
+}
+
+#endif  // CONFIG_HAL_BOARD
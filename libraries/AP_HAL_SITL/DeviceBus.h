@@ -0,0 +1,75 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <AP_HAL/AP_HAL.h>
+#include "AP_HAL_SITL_Namespace.h"
+#include "Semaphores.h"
+
+/*
+  a simulated bus shared by several devices, with a thread running the
+  periodic callbacks of all of its devices, as on real boards.
+
+  Transfers take simulated bus time, worked out from their length and
+  the bus clock. The time is not spent by the caller, as SITL threads
+  can only wait for whole simulation steps. Instead the bus stays busy
+  until the transfer would have finished, later transfers start when
+  the bus is free, and callbacks are not run while the bus is busy. A
+  bus with more traffic than it can carry makes its callbacks late, and
+  devices see their reads later, as they would on hardware.
+*/
+class HALSITL::DeviceBus {
+public:
+    DeviceBus(AP_HAL::Device::BusType bus_type, uint8_t bus_num);
+
+    Semaphore_Recursive semaphore;
+
+    AP_HAL::Device::PeriodicHandle register_periodic_callback(uint32_t period_usec, AP_HAL::Device::PeriodicCb cb);
+    bool adjust_timer(AP_HAL::Device::PeriodicHandle h, uint32_t period_usec);
+
+    /*
+      account for a transfer of len bytes at clock_hz, returning the
+      simulation time at which it starts on the bus
+     */
+    uint64_t start_transfer(uint32_t len, uint32_t clock_hz);
+
+private:
+    void bus_thread(void);
+
+    // print bus statistics every minute of simulated time
+    void report(uint64_t now);
+
+    struct callback_info {
+        struct callback_info *next;
+        AP_HAL::Device::PeriodicCb cb;
+        uint32_t period_usec;
+        uint64_t next_usec;
+    } *callbacks;
+
+    AP_HAL::Device::BusType bus_type;
+    uint8_t bus_num;
+    bool thread_started;
+
+    // simulation time at which the last transfer finishes
+    uint64_t busy_until_usec;
+
+    struct {
+        uint64_t start_usec;
+        uint32_t transfers;
+        uint64_t bytes;
+        uint64_t busy_usec;
+        uint32_t max_callback_delay_usec;
+    } stats;
+};
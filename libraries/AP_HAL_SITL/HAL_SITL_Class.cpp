@@ -19,6 +19,7 @@
 #include "GPIO.h"
 #include "SITL_State.h"
 #include "Util.h"
+#include "SPIDevice.h"
 
 #include <AP_BoardConfig/AP_BoardConfig.h>
 #include <AP_HAL_Empty/AP_HAL_Empty.h>
@@ -35,10 +36,10 @@ static RCInput  sitlRCInput(&sitlState);
 static RCOutput sitlRCOutput(&sitlState);
 static AnalogIn sitlAnalogIn(&sitlState);
 static GPIO sitlGPIO(&sitlState);
+static SPIDeviceManager sitlSPI;
 
 // use the Empty HAL for hardware we don't emulate
 static Empty::I2CDeviceManager i2c_mgr_instance;
-static Empty::SPIDeviceManager emptySPI;
 static Empty::OpticalFlow emptyOpticalFlow;
 static Empty::Flash emptyFlash;
 
@@ -64,7 +65,7 @@ HAL_SITL::HAL_SITL() :
         &sitlUart6Driver,   /* uartG */
         &sitlUart7Driver,   /* uartH */
         &i2c_mgr_instance,
-        &emptySPI,          /* spi */
+        &sitlSPI,           /* spi */
         &sitlAnalogIn,      /* analogin */
         &sitlStorage, /* storage */
         &sitlUart0Driver,   /* console */
@@ -13,6 +13,7 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <errno.h>
+#include <time.h>
 #include <sys/select.h>
 
 #include <AP_Param/AP_Param.h>
@@ -185,10 +186,10 @@ void SITL_State::_fdm_input_step(void)
         _update_airspeed(_sitl->state.airspeed);
         _update_rangefinder(_sitl->state.range);
 
-        if (_sitl->adsb_plane_count >= 0 &&
+        if ((_sitl->adsb_plane_count >= 0 || traffic != nullptr) &&
             adsb == nullptr) {
-            adsb = new SITL::ADSB(_sitl->state, _home_str);
-        } else if (_sitl->adsb_plane_count == -1 &&
+            adsb = new SITL::ADSB(_sitl->state, _home_str, traffic);
+        } else if (_sitl->adsb_plane_count == -1 && traffic == nullptr &&
                    adsb != nullptr) {
             delete adsb;
             adsb = nullptr;
@@ -198,6 +199,15 @@ void SITL_State::_fdm_input_step(void)
     // trigger all APM timers.
     _scheduler->timer_event();
     _scheduler->sitl_end_atomic();
+
+    if (_lockstep) {
+        _lockstep_report();
+    }
+
+    if (_sitl->checkpoint != 0) {
+        _sitl->checkpoint.set_and_save(0);
+        _checkpoint();
+    }
 }
 
 
@@ -206,12 +216,64 @@ void SITL_State::wait_clock(uint64_t wait_time_usec)
     while (AP_HAL::micros64() < wait_time_usec) {
         if (hal.scheduler->in_main_thread()) {
             _fdm_input_step();
-        } else {
+        } else if (!_scheduler->lockstep_wait(wait_time_usec)) {
             usleep(1000);
         }
     }
 }
 
+// interval in simulated time between reports of the achieved speedup
+#define LOCKSTEP_REPORT_INTERVAL_US 60000000ULL
+
+uint64_t SITL_State::_lockstep_start_wall_us;
+
+static uint64_t wall_clock_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return uint64_t(ts.tv_sec)*1000000ULL + ts.tv_nsec/1000U;
+}
+
+/*
+  periodically report how much faster than real time a lockstep run is
+ */
+void SITL_State::_lockstep_report(void)
+{
+    const uint64_t sim_us = AP_HAL::micros64();
+    if (_lockstep_start_wall_us == 0) {
+        _lockstep_start_wall_us = wall_clock_us();
+        _lockstep_last_report_us = sim_us;
+        // report the whole run however it ends
+        atexit(_lockstep_print_speedup);
+        signal(SIGTERM, _lockstep_signal);
+        signal(SIGINT, _lockstep_signal);
+        signal(SIGHUP, _lockstep_signal);
+        return;
+    }
+    if (sim_us - _lockstep_last_report_us < LOCKSTEP_REPORT_INTERVAL_US) {
+        return;
+    }
+    _lockstep_last_report_us = sim_us;
+    _lockstep_print_speedup();
+}
+
+void SITL_State::_lockstep_print_speedup(void)
+{
+    const double wall_s = (wall_clock_us() - _lockstep_start_wall_us) * 1.0e-6;
+    const double sim_s = AP_HAL::micros64() * 1.0e-6;
+    ::fprintf(stdout, "Lockstep: %.1fs simulated in %.1fs, speedup %.1f\n",
+              sim_s, wall_s, wall_s > 0 ? sim_s / wall_s : 0.0);
+    fflush(stdout);
+}
+
+// print the final report when killed, then die of the signal as before
+void SITL_State::_lockstep_signal(int signum)
+{
+    _lockstep_print_speedup();
+    signal(signum, SIG_DFL);
+    raise(signum);
+}
+
 #define streq(a, b) (!strcmp(a, b))
 int SITL_State::sim_fd(const char *name, const char *arg)
 {
@@ -338,6 +400,10 @@ void SITL_State::_fdm_input_local(void)
         sitl_model->fill_fdm(_sitl->state);
         _sitl->update_rate_hz = sitl_model->get_rate_hz();
 
+        if (traffic != nullptr) {
+            traffic->update(_sitl->state);
+        }
+
         if (_sitl->rc_fail == SITL::SITL::SITL_RCFail_None) {
             for (uint8_t i=0; i< _sitl->state.rcin_chan_count; i++) {
                 pwm_input[i] = 1000 + _sitl->state.rcin[i]*1000;
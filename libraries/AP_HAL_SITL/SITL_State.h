@@ -23,6 +23,7 @@
 #include <SITL/SITL_Input.h>
 #include <SITL/SIM_Gimbal.h>
 #include <SITL/SIM_ADSB.h>
+#include <SITL/SIM_SharedTraffic.h>
 #include <SITL/SIM_Vicon.h>
 #include <AP_HAL/utility/Socket.h>
 
@@ -44,6 +45,7 @@ public:
 
     int gps_pipe(void);
     int gps2_pipe(void);
+    void gps_close_pipes(void);
     ssize_t gps_read(int fd, void *buf, size_t count);
     uint16_t pwm_output[SITL_NUM_CHANNELS];
     uint16_t pwm_input[SITL_RC_INPUT_CHANNELS];
@@ -150,6 +152,15 @@ private:
     void _fdm_input_step(void);
 
     void wait_clock(uint64_t wait_time_usec);
+    void _lockstep_report(void);
+    static void _lockstep_print_speedup(void);
+    static void _lockstep_signal(int signum);
+
+    // checkpoints are paused forked copies of the simulation
+    void _checkpoint(void);
+    void _checkpoint_serve(int listen_fd, pid_t parent_pid);
+    void _branch(uint8_t instance, const char *dir);
+    uint8_t _checkpoint_count;
 
     // internal state
     enum vehicle_type _vehicle;
@@ -176,6 +187,11 @@ private:
 
     bool _synthetic_clock_mode;
 
+    // lockstep mode runs unthrottled with threads stepped by the scheduler
+    bool _lockstep;
+    static uint64_t _lockstep_start_wall_us;
+    uint64_t _lockstep_last_report_us;
+
     bool _use_rtscts;
     bool _use_fg_view;
     
@@ -219,6 +235,10 @@ private:
     // simulated ADSb
     SITL::ADSB *adsb;
 
+    // traffic view shared with other SITL instances
+    SITL::SharedTraffic *traffic;
+    const char *_traffic_name;
+
     // simulated vicon system:
     SITL::Vicon *vicon;
 
@@ -6,6 +6,7 @@
 #include "AP_HAL_SITL_Namespace.h"
 #include "HAL_SITL_Class.h"
 #include "UARTDriver.h"
+#include "Scheduler.h"
 #include <AP_HAL/utility/getopt_cpp.h>
 #include <AP_Logger/AP_Logger_SITL.h>
 
@@ -32,6 +33,7 @@
 #include <SITL/SIM_AirSim.h>
 #include <SITL/SIM_Scrimmage.h>
 #include <SITL/SIM_Webots.h>
+#include <SITL/SIM_SharedMemory.h>
 
 #include <signal.h>
 #include <stdio.h>
@@ -69,6 +71,9 @@ void SITL_State::_usage(void)
            "\t--instance|-I N          set instance of SITL (adds 10*instance to all port numbers)\n"
            // "\t--param|-P NAME=VALUE    set some param\n"  CURRENTLY BROKEN!
            "\t--synthetic-clock|-S     set synthetic clock mode\n"
+           "\t--lockstep               run unthrottled with threads stepped in lockstep with the simulation\n"
+           "\t--traffic NAME           share vehicle positions with other instances using shared memory NAME\n"
+           "\t--wind-field FILE        add a gridded, time varying wind field loaded from FILE\n"
            "\t--home|-O HOME           set start location (lat,lng,alt,yaw)\n"
            "\t--model|-M MODEL         set simulation model\n"
            "\t--config string          set additional simulation config string\n"
@@ -137,6 +142,7 @@ static const struct {
     { "airsim",             AirSim::create},
     { "scrimmage",          Scrimmage::create },
     { "webots",             Webots::create },
+    { "shm",                SharedMemory::create },
 
 };
 
@@ -165,9 +171,11 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
     float speedup = 1.0f;
     _instance = 0;
     _synthetic_clock_mode = false;
+    _lockstep = false;
     // default to CMAC
     const char *home_str = nullptr;
     const char *model_str = nullptr;
+    const char *wind_field_path = nullptr;
     _use_fg_view = true;
     char *autotest_dir = nullptr;
     _fg_address = "127.0.0.1";
@@ -208,6 +216,9 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         CMDLINE_SIM_PORT_IN,
         CMDLINE_SIM_PORT_OUT,
         CMDLINE_IRLOCK_PORT,
+        CMDLINE_LOCKSTEP,
+        CMDLINE_TRAFFIC,
+        CMDLINE_WIND_FIELD,
     };
 
     const struct GetOptLong::option options[] = {
@@ -243,6 +254,9 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         {"sim-port-in",     true,   0, CMDLINE_SIM_PORT_IN},
         {"sim-port-out",    true,   0, CMDLINE_SIM_PORT_OUT},
         {"irlock-port",     true,   0, CMDLINE_IRLOCK_PORT},
+        {"lockstep",        false,  0, CMDLINE_LOCKSTEP},
+        {"traffic",         true,   0, CMDLINE_TRAFFIC},
+        {"wind-field",      true,   0, CMDLINE_WIND_FIELD},
         {0, false, 0, 0}
     };
 
@@ -361,6 +375,15 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         case CMDLINE_IRLOCK_PORT:
             _irlock_port = atoi(gopt.optarg);
             break;
+        case CMDLINE_LOCKSTEP:
+            _lockstep = true;
+            break;
+        case CMDLINE_TRAFFIC:
+            _traffic_name = gopt.optarg;
+            break;
+        case CMDLINE_WIND_FIELD:
+            wind_field_path = gopt.optarg;
+            break;
         default:
             _usage();
             exit(1);
@@ -390,6 +413,10 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
             sitl_model->set_instance(_instance);
             sitl_model->set_autotest_dir(autotest_dir);
             sitl_model->set_config(config);
+            if (_lockstep) {
+                sitl_model->set_unthrottled();
+                _scheduler->set_lockstep(true);
+            }
             _synthetic_clock_mode = true;
             break;
         }
@@ -399,6 +426,23 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
         exit(1);
     }
 
+    if (wind_field_path != nullptr) {
+        SITL::WindField *wind_field = new SITL::WindField();
+        if (wind_field == nullptr || !wind_field->load(wind_field_path)) {
+            printf("Failed to load wind field (%s)\n", wind_field_path);
+            exit(1);
+        }
+        sitl_model->set_wind_field(wind_field);
+    }
+
+    if (_traffic_name != nullptr) {
+        traffic = new SharedTraffic();
+        if (traffic == nullptr || !traffic->init(_traffic_name, _instance)) {
+            printf("Failed to setup shared traffic (%s)\n", _traffic_name);
+            exit(1);
+        }
+    }
+
     fprintf(stdout, "Starting sketch '%s'\n", SKETCH);
 
     if (strcmp(SKETCH, "ArduCopter") == 0) {
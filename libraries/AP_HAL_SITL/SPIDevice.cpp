@@ -0,0 +1,151 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <AP_HAL/AP_HAL.h>
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+
+#include "SPIDevice.h"
+#include <SITL/SIM_MPU6000.h>
+#include <SITL/SIM_MS5611.h>
+
+#include <string.h>
+
+using namespace HALSITL;
+
+static SITL::MPU6000 mpu6000;
+static SITL::MS5611 ms5611;
+
+// the IMU and baro share a bus, as on most flight controllers, so
+// their transfers contend for it
+SPIDesc SPIDeviceManager::device_table[] = {
+    { "mpu6000", 1, 0, 1000000, 8000000, &mpu6000 },
+    { "ms5611",  1, 1, 20000000, 20000000, &ms5611 },
+};
+
+SPIDevice::SPIDevice(SPIBus &_bus, SPIDesc &_device_desc) :
+    bus(_bus),
+    device_desc(_device_desc)
+{
+    set_device_bus(_bus.bus);
+    set_device_address(_device_desc.device);
+    set_speed(AP_HAL::Device::SPEED_LOW);
+}
+
+bool SPIDevice::set_speed(AP_HAL::Device::Speed speed)
+{
+    switch (speed) {
+    case AP_HAL::Device::SPEED_HIGH:
+        frequency = device_desc.highspeed;
+        break;
+    case AP_HAL::Device::SPEED_LOW:
+        frequency = device_desc.lowspeed;
+        break;
+    }
+    return true;
+}
+
+/*
+  the transfer takes bus time, and the simulated device sees it at the
+  time it starts on the bus
+ */
+bool SPIDevice::transfer(const uint8_t *send, uint32_t send_len,
+                         uint8_t *recv, uint32_t recv_len)
+{
+    const uint64_t start_usec = bus.start_transfer(send_len + recv_len, frequency);
+    return device_desc.sim->transfer(start_usec, send, send_len, recv, recv_len);
+}
+
+/*
+  the simulated devices are register based, so the bytes received
+  during the register address are not meaningful
+ */
+bool SPIDevice::transfer_fullduplex(const uint8_t *send, uint8_t *recv, uint32_t len)
+{
+    if (len == 0) {
+        return true;
+    }
+    const uint64_t start_usec = bus.start_transfer(len, frequency);
+    recv[0] = 0;
+    return device_desc.sim->transfer(start_usec, send, len, &recv[1], len-1);
+}
+
+AP_HAL::Semaphore *SPIDevice::get_semaphore()
+{
+    return &bus.semaphore;
+}
+
+AP_HAL::Device::PeriodicHandle SPIDevice::register_periodic_callback(uint32_t period_usec, AP_HAL::Device::PeriodicCb cb)
+{
+    return bus.register_periodic_callback(period_usec, cb);
+}
+
+bool SPIDevice::adjust_periodic_callback(AP_HAL::Device::PeriodicHandle h, uint32_t period_usec)
+{
+    return bus.adjust_timer(h, period_usec);
+}
+
+/*
+  return a SPIDevice given a string device name
+ */
+AP_HAL::OwnPtr<AP_HAL::SPIDevice>
+SPIDeviceManager::get_device(const char *name)
+{
+    /* Find the bus description in the table */
+    uint8_t i;
+    for (i = 0; i<ARRAY_SIZE(device_table); i++) {
+        if (strcmp(device_table[i].name, name) == 0) {
+            break;
+        }
+    }
+    if (i == ARRAY_SIZE(device_table)) {
+        return AP_HAL::OwnPtr<AP_HAL::SPIDevice>(nullptr);
+    }
+
+    SPIDesc &desc = device_table[i];
+
+    // find the bus
+    SPIBus *busp;
+    for (busp = buses; busp; busp = busp->next) {
+        if (busp->bus == desc.bus) {
+            break;
+        }
+    }
+    if (busp == nullptr) {
+        // create a new one
+        busp = new SPIBus(desc.bus);
+        if (busp == nullptr) {
+            return AP_HAL::OwnPtr<AP_HAL::SPIDevice>(nullptr);
+        }
+        busp->next = buses;
+        buses = busp;
+    }
+
+    return AP_HAL::OwnPtr<AP_HAL::SPIDevice>(new SPIDevice(*busp, desc));
+}
+
+uint8_t SPIDeviceManager::get_count()
+{
+    return ARRAY_SIZE(device_table);
+}
+
+const char *SPIDeviceManager::get_device_name(uint8_t idx)
+{
+    if (idx >= ARRAY_SIZE(device_table)) {
+        return nullptr;
+    }
+    return device_table[idx].name;
+}
+
+#endif  // CONFIG_HAL_BOARD
@@ -0,0 +1,96 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_HAL/SPIDevice.h>
+#include "AP_HAL_SITL_Namespace.h"
+#include "DeviceBus.h"
+
+namespace SITL {
+class SPIDevice;
+}
+
+namespace HALSITL {
+
+/*
+  a simulated SPI bus, with the bus number used in device bus IDs
+ */
+class SPIBus : public DeviceBus {
+public:
+    SPIBus(uint8_t _bus) :
+        DeviceBus(AP_HAL::Device::BUS_TYPE_SPI, _bus),
+        bus(_bus) {}
+
+    SPIBus *next;
+    uint8_t bus;
+};
+
+struct SPIDesc {
+    const char *name;
+    uint8_t bus;
+    uint8_t device;
+    uint32_t lowspeed;
+    uint32_t highspeed;
+    SITL::SPIDevice *sim;       // the simulated device on the far end
+};
+
+}  // namespace HALSITL
+
+class HALSITL::SPIDevice : public AP_HAL::SPIDevice {
+public:
+    SPIDevice(HALSITL::SPIBus &_bus, HALSITL::SPIDesc &_device_desc);
+
+    /* See AP_HAL::Device::set_speed() */
+    bool set_speed(AP_HAL::Device::Speed speed) override;
+
+    /* See AP_HAL::Device::transfer() */
+    bool transfer(const uint8_t *send, uint32_t send_len,
+                  uint8_t *recv, uint32_t recv_len) override;
+
+    /* See AP_HAL::SPIDevice::transfer_fullduplex() */
+    bool transfer_fullduplex(const uint8_t *send, uint8_t *recv,
+                             uint32_t len) override;
+
+    /* See AP_HAL::Device::get_semaphore() */
+    AP_HAL::Semaphore *get_semaphore() override;
+
+    /* See AP_HAL::Device::register_periodic_callback() */
+    AP_HAL::Device::PeriodicHandle register_periodic_callback(
+        uint32_t period_usec, AP_HAL::Device::PeriodicCb) override;
+
+    /* See AP_HAL::Device::adjust_periodic_callback() */
+    bool adjust_periodic_callback(AP_HAL::Device::PeriodicHandle h, uint32_t period_usec) override;
+
+private:
+    HALSITL::SPIBus &bus;
+    HALSITL::SPIDesc &device_desc;
+    uint32_t frequency;
+};
+
+class HALSITL::SPIDeviceManager : public AP_HAL::SPIDeviceManager {
+public:
+    AP_HAL::OwnPtr<AP_HAL::SPIDevice> get_device(const char *name) override;
+
+    /* See AP_HAL::SPIDeviceManager::get_count() */
+    uint8_t get_count() override;
+
+    /* See AP_HAL::SPIDeviceManager::get_device_name() */
+    const char *get_device_name(uint8_t idx) override;
+
+private:
+    static HALSITL::SPIDesc device_table[];
+    HALSITL::SPIBus *buses;
+};
@@ -4,6 +4,7 @@
 #include "Scheduler.h"
 #include "UARTDriver.h"
 #include <sys/time.h>
+#include <unistd.h>
 #include <fenv.h>
 #include <AP_BoardConfig/AP_BoardConfig.h>
 #if defined (__clang__)
@@ -31,6 +32,12 @@ bool Scheduler::_should_reboot = false;
 Scheduler::thread_attr *Scheduler::threads;
 HAL_Semaphore Scheduler::_thread_sem;
 
+bool Scheduler::_lockstep;
+pthread_mutex_t Scheduler::_lockstep_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t Scheduler::_lockstep_thread_cond = PTHREAD_COND_INITIALIZER;
+pthread_cond_t Scheduler::_lockstep_main_cond = PTHREAD_COND_INITIALIZER;
+thread_local Scheduler::thread_attr *Scheduler::_current_thread;
+
 Scheduler::Scheduler(SITL_State *sitlState) :
     _sitlState(sitlState),
     _stopped_clock_usec(0)
@@ -217,6 +224,9 @@ void Scheduler::_run_io_procs()
 void Scheduler::stop_clock(uint64_t time_usec)
 {
     _stopped_clock_usec = time_usec;
+    if (_lockstep) {
+        lockstep_step(time_usec);
+    }
     if (time_usec - _last_io_run > 10000) {
         _last_io_run = time_usec;
         _run_io_procs();
@@ -229,9 +239,11 @@ void Scheduler::stop_clock(uint64_t time_usec)
 void *Scheduler::thread_create_trampoline(void *ctx)
 {
     struct thread_attr *a = (struct thread_attr *)ctx;
+    _current_thread = a;
     a->f[0]();
     
     WITH_SEMAPHORE(_thread_sem);
+    pthread_mutex_lock(&_lockstep_mutex);
     if (threads == a) {
         threads = a->next;
     } else {
@@ -242,6 +254,9 @@ void *Scheduler::thread_create_trampoline(void *ctx)
             }
         }
     }
+    // the main thread may be waiting for this thread in lockstep mode
+    pthread_cond_signal(&_lockstep_main_cond);
+    pthread_mutex_unlock(&_lockstep_mutex);
     free(a->stack);
     free(a->f);
     delete a;
@@ -287,6 +302,9 @@ bool Scheduler::thread_create(AP_HAL::MemberProc proc, const char *name, uint32_
     a->stack_size = stack_size;
     a->f[0] = proc;
     a->name = name;
+    a->wake_usec = 0;
+    a->blocked_on = nullptr;
+    a->parked = false;
     
     pthread_attr_init(&a->attr);
 #if !defined(__CYGWIN__) && !defined(__CYGWIN64__)
@@ -294,11 +312,18 @@ bool Scheduler::thread_create(AP_HAL::MemberProc proc, const char *name, uint32_
         AP_HAL::panic("Failed to set stack of size %u for thread %s", alloc_stack, name);
     }
 #endif
+    // add to the list before the thread starts so a lockstep step
+    // started meanwhile waits for it to reach its first delay
+    pthread_mutex_lock(&_lockstep_mutex);
+    a->next = threads;
+    threads = a;
+    pthread_mutex_unlock(&_lockstep_mutex);
     if (pthread_create(&thread, &a->attr, thread_create_trampoline, a) != 0) {
+        pthread_mutex_lock(&_lockstep_mutex);
+        threads = a->next;
+        pthread_mutex_unlock(&_lockstep_mutex);
         goto failed;
     }
-    a->next = threads;
-    threads = a;
     return true;
 
 failed:
@@ -327,3 +352,141 @@ void Scheduler::check_thread_stacks(void)
         }
     }
 }
+
+/*
+  wait in lockstep mode for the main thread to advance the clock to
+  wait_time_usec. Returns false if the calling thread can't be stepped
+  and should poll the clock instead
+ */
+bool Scheduler::lockstep_wait(uint64_t wait_time_usec)
+{
+    if (!lockstep_sync_begin()) {
+        return false;
+    }
+    lockstep_sync_park(nullptr, wait_time_usec);
+    lockstep_sync_end();
+    return true;
+}
+
+bool Scheduler::lockstep_sync_begin(void)
+{
+    if (!_lockstep || _current_thread == nullptr) {
+        return false;
+    }
+    pthread_mutex_lock(&_lockstep_mutex);
+    return true;
+}
+
+void Scheduler::lockstep_sync_park(const void *sem, uint64_t wake_usec)
+{
+    struct thread_attr *a = _current_thread;
+    a->wake_usec = wake_usec;
+    a->blocked_on = sem;
+    a->parked = true;
+    pthread_cond_signal(&_lockstep_main_cond);
+    while (a->parked) {
+        pthread_cond_wait(&_lockstep_thread_cond, &_lockstep_mutex);
+    }
+    a->blocked_on = nullptr;
+}
+
+void Scheduler::lockstep_sync_end(void)
+{
+    pthread_mutex_unlock(&_lockstep_mutex);
+}
+
+/*
+  wake the threads parked on a semaphore which has been given. They
+  count as running again before the caller returns, so the main thread
+  waits for them at its next step
+ */
+void Scheduler::lockstep_sync_release(const void *sem)
+{
+    if (!_lockstep) {
+        return;
+    }
+    pthread_mutex_lock(&_lockstep_mutex);
+    bool woken = false;
+    for (struct thread_attr *p=threads; p; p=p->next) {
+        if (p->parked && p->blocked_on == sem) {
+            p->parked = false;
+            woken = true;
+        }
+    }
+    if (woken) {
+        pthread_cond_broadcast(&_lockstep_thread_cond);
+    }
+    pthread_mutex_unlock(&_lockstep_mutex);
+}
+
+/*
+  called by the main thread each time the clock is advanced in
+  lockstep mode. Threads whose delay has expired are woken, and the
+  clock is not advanced again until every thread is waiting on it or
+  on a semaphore, so threads run at the same simulated times on every
+  run. A thread blocked on anything else stops the simulation
+ */
+void Scheduler::lockstep_step(uint64_t time_usec)
+{
+    pthread_mutex_lock(&_lockstep_mutex);
+    bool woken = false;
+    for (struct thread_attr *p=threads; p; p=p->next) {
+        if (p->parked && p->wake_usec <= time_usec) {
+            p->parked = false;
+            woken = true;
+        }
+    }
+    if (woken) {
+        pthread_cond_broadcast(&_lockstep_thread_cond);
+    }
+
+    while (true) {
+        bool running = false;
+        for (struct thread_attr *p=threads; p; p=p->next) {
+            if (!p->parked) {
+                running = true;
+                break;
+            }
+        }
+        if (!running) {
+            break;
+        }
+        pthread_cond_wait(&_lockstep_main_cond, &_lockstep_mutex);
+    }
+    pthread_mutex_unlock(&_lockstep_mutex);
+}
+
+/*
+  fork the process. The lockstep mutex is held so the child can't
+  inherit it held by a thread which fork() doesn't copy
+ */
+pid_t Scheduler::fork_process(void)
+{
+    pthread_mutex_lock(&_lockstep_mutex);
+    const pid_t pid = fork();
+    pthread_mutex_unlock(&_lockstep_mutex);
+    return pid;
+}
+
+/*
+  only the calling thread is copied by fork(), so start each thread
+  again from its entry point in a forked child
+ */
+void Scheduler::restart_threads(void)
+{
+    pthread_mutex_lock(&_lockstep_mutex);
+    struct thread_attr *old = threads;
+    threads = nullptr;
+    pthread_mutex_unlock(&_lockstep_mutex);
+
+    while (old != nullptr) {
+        struct thread_attr *next = old->next;
+        if (!thread_create(old->f[0], old->name, old->stack_size - 2300, PRIORITY_IO, 0)) {
+            ::printf("Failed to restart thread %s\n", old->name);
+        }
+        free(old->stack);
+        free(old->f);
+        delete old;
+        old = next;
+    }
+}
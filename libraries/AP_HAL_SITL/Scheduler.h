@@ -56,7 +56,34 @@ public:
      */
     bool thread_create(AP_HAL::MemberProc, const char *name,
                        uint32_t stack_size, priority_base base, int8_t priority) override;
-    
+
+    /*
+      in lockstep mode threads are woken by the main thread when the
+      clock reaches the end of their delay, and the main thread waits
+      for them to finish before advancing the clock again
+     */
+    void set_lockstep(bool enable) { _lockstep = enable; }
+    bool lockstep_wait(uint64_t wait_time_usec);
+
+    /*
+      a thread blocked on a semaphore in lockstep mode is parked like
+      one waiting on the clock, so the main thread doesn't wait for
+      it. lockstep_sync_begin() returns false if the calling thread
+      isn't stepped, otherwise it holds the lockstep mutex until
+      lockstep_sync_end() so the release of the semaphore between
+      trying it and parking can't be missed. lockstep_sync_park()
+      returns when the semaphore is released or the clock reaches
+      wake_usec
+     */
+    static bool lockstep_sync_begin(void);
+    static void lockstep_sync_park(const void *sem, uint64_t wake_usec);
+    static void lockstep_sync_end(void);
+    static void lockstep_sync_release(const void *sem);
+
+    // fork the process, and in the child start again the threads fork() doesn't copy
+    pid_t fork_process(void);
+    void restart_threads(void);
+
 private:
     SITL_State *_sitlState;
     uint8_t _nested_atomic_ctr;
@@ -76,6 +103,7 @@ private:
 
     static void *thread_create_trampoline(void *ctx);
     static void check_thread_stacks(void);
+    void lockstep_step(uint64_t time_usec);
     
     bool _initialized;
     uint64_t _stopped_clock_usec;
@@ -91,8 +119,17 @@ private:
         void *stack;
         const uint8_t *stack_min;
         const char *name;
+        uint64_t wake_usec;     // clock time the thread is waiting for in lockstep mode
+        const void *blocked_on; // semaphore the thread is waiting for in lockstep mode
+        bool parked;            // true while the thread is waiting on the clock or a semaphore in lockstep mode
     };
     static struct thread_attr *threads;
     static const uint8_t stackfill = 0xEB;
+
+    static bool _lockstep;
+    static pthread_mutex_t _lockstep_mutex;
+    static pthread_cond_t _lockstep_thread_cond;
+    static pthread_cond_t _lockstep_main_cond;
+    static thread_local struct thread_attr *_current_thread;
 };
 #endif  // CONFIG_HAL_BOARD
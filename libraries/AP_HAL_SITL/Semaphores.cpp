@@ -3,6 +3,7 @@
 #if CONFIG_HAL_BOARD == HAL_BOARD_SITL
 
 #include "Semaphores.h"
+#include "Scheduler.h"
 
 extern const AP_HAL::HAL& hal;
 
@@ -29,11 +30,22 @@ bool Semaphore::give()
     if (pthread_mutex_unlock(&_lock) != 0) {
         AP_HAL::panic("Bad semaphore usage");
     }
+    Scheduler::lockstep_sync_release(this);
     return true;
 }
 
 bool Semaphore::take(uint32_t timeout_ms)
 {
+    if (Scheduler::lockstep_sync_begin()) {
+        // timeouts are in simulated time, like delays
+        const uint64_t wake_usec = timeout_ms == HAL_SEMAPHORE_BLOCK_FOREVER ? UINT64_MAX : AP_HAL::micros64() + timeout_ms * 1000ULL;
+        bool ret;
+        while (!(ret = take_nonblocking()) && AP_HAL::micros64() < wake_usec) {
+            Scheduler::lockstep_sync_park(this, wake_usec);
+        }
+        Scheduler::lockstep_sync_end();
+        return ret;
+    }
     if (timeout_ms == HAL_SEMAPHORE_BLOCK_FOREVER) {
         return pthread_mutex_lock(&_lock) == 0;
     }
@@ -55,4 +67,61 @@ bool Semaphore::take_nonblocking()
     return pthread_mutex_trylock(&_lock) == 0;
 }
 
+// construct a binary semaphore, initially not signalled
+BinarySemaphore::BinarySemaphore() :
+    _pending(false)
+{
+    pthread_mutex_init(&_lock, nullptr);
+    pthread_cond_init(&_cond, nullptr);
+}
+
+bool BinarySemaphore::wait(uint32_t timeout_us)
+{
+    if (Scheduler::lockstep_sync_begin()) {
+        const uint64_t wake_usec = AP_HAL::micros64() + timeout_us;
+        bool ret;
+        while (!(ret = take_pending()) && AP_HAL::micros64() < wake_usec) {
+            Scheduler::lockstep_sync_park(this, wake_usec);
+        }
+        Scheduler::lockstep_sync_end();
+        return ret;
+    }
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    const uint64_t nsec = ts.tv_nsec + timeout_us * 1000ULL;
+    ts.tv_sec += nsec / 1000000000ULL;
+    ts.tv_nsec = nsec % 1000000000ULL;
+
+    pthread_mutex_lock(&_lock);
+    while (!_pending) {
+        if (pthread_cond_timedwait(&_cond, &_lock, &ts) != 0) {
+            break;
+        }
+    }
+    const bool ret = _pending;
+    _pending = false;
+    pthread_mutex_unlock(&_lock);
+    return ret;
+}
+
+// clear and return the signalled state
+bool BinarySemaphore::take_pending()
+{
+    pthread_mutex_lock(&_lock);
+    const bool ret = _pending;
+    _pending = false;
+    pthread_mutex_unlock(&_lock);
+    return ret;
+}
+
+void BinarySemaphore::signal()
+{
+    pthread_mutex_lock(&_lock);
+    _pending = true;
+    pthread_cond_signal(&_cond);
+    pthread_mutex_unlock(&_lock);
+    Scheduler::lockstep_sync_release(this);
+}
+
 #endif  // CONFIG_HAL_BOARD
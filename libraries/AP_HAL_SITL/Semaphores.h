@@ -24,3 +24,17 @@ public:
 };
 
 
+class HALSITL::BinarySemaphore : public AP_HAL::BinarySemaphore {
+public:
+    BinarySemaphore();
+    bool wait(uint32_t timeout_us) override;
+    void signal() override;
+private:
+    bool take_pending();
+
+    pthread_mutex_t _lock;
+    pthread_cond_t _cond;
+    bool _pending;
+};
+
+
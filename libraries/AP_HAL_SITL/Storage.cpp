@@ -289,4 +289,21 @@ bool Storage::healthy(void)
     return _initialised && AP_HAL::millis() - _last_empty_ms < 2000;
 }
 
-
+/*
+  write the current contents to a new storage file in the current
+  directory and use it from now on. Used by a forked copy of SITL so
+  it doesn't share the file of the process it was forked from
+ */
+void Storage::reopen(void)
+{
+#if STORAGE_USE_POSIX
+    if (!using_filesystem) {
+        return;
+    }
+    close(log_fd);
+    log_fd = open(HAL_STORAGE_FILE, O_RDWR|O_CREAT|O_TRUNC, 0644);
+    if (log_fd == -1 || write(log_fd, _buffer, HAL_STORAGE_SIZE) != HAL_STORAGE_SIZE) {
+        ::printf("reopen failed for " HAL_STORAGE_FILE "\n");
+    }
+#endif
+}
@@ -31,6 +31,9 @@ public:
     void _timer_tick(void) override;
     bool healthy(void) override;
 
+    // write the storage to a new file in the current directory
+    void reopen(void);
+
 private:
     volatile bool _initialised;
     void _storage_create(void);
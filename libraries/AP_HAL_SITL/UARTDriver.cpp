@@ -143,6 +143,34 @@ void UARTDriver::end()
 {
 }
 
+/*
+  close and begin the port again, used by a forked copy of SITL so it
+  doesn't share connections with the process it was forked from
+ */
+void UARTDriver::_reopen(void)
+{
+    if (_console || (_fd == -1 && _listen_fd == -1 && _mc_fd == -1)) {
+        // never started
+        return;
+    }
+    if (_fd != -1) {
+        close(_fd);
+        _fd = -1;
+    }
+    if (_listen_fd != -1) {
+        close(_listen_fd);
+        _listen_fd = -1;
+    }
+    if (_mc_fd != -1) {
+        close(_mc_fd);
+        _mc_fd = -1;
+    }
+    _connected = false;
+    _readbuffer.clear();
+    _writebuffer.clear();
+    begin(_uart_baudrate);
+}
+
 uint32_t UARTDriver::available(void)
 {
     _check_connection();
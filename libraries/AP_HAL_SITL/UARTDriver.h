@@ -103,6 +103,7 @@ private:
     // IPv4 address of target for uartC
     const char *_tcp_client_addr;
 
+    void _reopen(void);
     void _tcp_start_connection(uint16_t port, bool wait_for_connection);
     void _uart_start_connection(void);
     void _check_reconnect();
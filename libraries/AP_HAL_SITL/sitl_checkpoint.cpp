@@ -0,0 +1,211 @@
+/*
+  SITL checkpoints
+
+  Setting SIM_CHECKPOINT forks a paused copy of the whole simulation
+  (parameters, storage, EKF, mission, physics model, simulated sensors
+  and clock) which waits on a unix socket in the current directory.
+  Each "branch INSTANCE DIR" request on that socket forks a new copy of
+  the checkpoint which continues flying as SITL instance INSTANCE, with
+  its storage and logs in DIR, so many scenarios can be run from a
+  common mid-flight state without flying the common part again.
+
+  Only the main thread is copied by fork(), so other threads are
+  started again from their entry points in each branch. In --lockstep
+  mode every thread is waiting on the clock when the checkpoint is
+  taken, which makes this safe.
+ */
+
+#include <AP_HAL/AP_HAL.h>
+#if CONFIG_HAL_BOARD == HAL_BOARD_SITL
+
+#include "AP_HAL_SITL.h"
+#include "AP_HAL_SITL_Namespace.h"
+#include "HAL_SITL_Class.h"
+#include "Scheduler.h"
+#include "Storage.h"
+#include "UARTDriver.h"
+
+#include <AP_Logger/AP_Logger.h>
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+using namespace HALSITL;
+extern const AP_HAL::HAL& hal;
+
+/*
+  fork a paused copy of the simulation
+ */
+void SITL_State::_checkpoint(void)
+{
+    // other threads are only guaranteed to be idle in lockstep mode
+    if (!_lockstep) {
+        ::printf("Checkpoint refused: SIM_CHECKPOINT needs --lockstep\n");
+        return;
+    }
+
+    struct sockaddr_un addr {};
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "checkpoint-%u.sock", (unsigned)++_checkpoint_count);
+    unlink(addr.sun_path);
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1 ||
+        bind(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1 ||
+        listen(fd, 5) == -1) {
+        ::printf("Checkpoint failed: %s\n", strerror(errno));
+        if (fd != -1) {
+            close(fd);
+        }
+        return;
+    }
+
+    // don't leave buffered output to be written again by the copy
+    fflush(nullptr);
+
+    const pid_t parent_pid = getpid();
+    const pid_t pid = _scheduler->fork_process();
+    if (pid == -1) {
+        ::printf("Checkpoint fork failed: %s\n", strerror(errno));
+        close(fd);
+        unlink(addr.sun_path);
+        return;
+    }
+    if (pid != 0) {
+        // this process continues flying
+        close(fd);
+        ::printf("Checkpoint %u at %.3fs on %s\n",
+                 (unsigned)_checkpoint_count, AP_HAL::micros64() * 1.0e-6, addr.sun_path);
+        return;
+    }
+
+    // only returns in a new branch
+    _checkpoint_serve(fd, parent_pid);
+}
+
+/*
+  run by the paused copy, handling requests until asked to exit or
+  until a branch is forked, in which case this returns in the branch.
+  The copy shares stdio buffers and exit handlers with the process it
+  was forked from, so it leaves with _exit()
+ */
+void SITL_State::_checkpoint_serve(int listen_fd, pid_t parent_pid)
+{
+    // branches are not waited for
+    signal(SIGCHLD, SIG_IGN);
+
+    while (true) {
+        struct pollfd pfd { listen_fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 1000) <= 0) {
+            // make sure we die if the process we were forked from
+            // dies, in which case we are given a new parent
+            if (getppid() != parent_pid) {
+                _exit(1);
+            }
+            continue;
+        }
+        const int fd = accept(listen_fd, nullptr, nullptr);
+        if (fd == -1) {
+            continue;
+        }
+
+        char buf[256];
+        const ssize_t n = read(fd, buf, sizeof(buf)-1);
+        buf[n > 0 ? n : 0] = 0;
+
+        unsigned instance;
+        char dir[200];
+        char reply[64];
+        if (strncmp(buf, "exit", 4) == 0) {
+            dprintf(fd, "OK\n");
+            _exit(0);
+        } else if (sscanf(buf, "branch %u %199s", &instance, dir) == 2 && instance < 256) {
+            fflush(nullptr);
+            const pid_t pid = _scheduler->fork_process();
+            if (pid == 0) {
+                close(fd);
+                close(listen_fd);
+                signal(SIGCHLD, SIG_DFL);
+                _branch(instance, dir);
+                return;
+            }
+            if (pid == -1) {
+                snprintf(reply, sizeof(reply), "ERROR %s\n", strerror(errno));
+            } else {
+                snprintf(reply, sizeof(reply), "OK %d\n", (int)pid);
+            }
+        } else {
+            snprintf(reply, sizeof(reply), "ERROR expected 'branch INSTANCE DIR' or 'exit'\n");
+        }
+        if (write(fd, reply, strlen(reply)) < 0) {
+            // the client has gone
+        }
+        close(fd);
+    }
+}
+
+/*
+  set up a new branch of a checkpoint as SITL instance 'instance'
+  with its storage and logs in 'dir'. Everything the branch would
+  otherwise share with the process it was forked from is reopened
+ */
+void SITL_State::_branch(uint8_t instance, const char *dir)
+{
+    if (chdir(dir) != 0) {
+        ::printf("Branch failed to use %s: %s\n", dir, strerror(errno));
+        _exit(1);
+    }
+
+    // ports of the new instance
+    const int16_t port_offset = 10 * (int16_t(instance) - int16_t(_instance));
+    _base_port += port_offset;
+    _rcin_port += port_offset;
+    _fg_view_port += port_offset;
+    _instance = instance;
+    sitl_model->set_instance(instance);
+
+    // the sockets are still bound or connected to the old instance's ports
+    if (!_sitl_rc_in.reset() ||
+        !_sitl_rc_in.reuseaddress() ||
+        !_sitl_rc_in.bind("0.0.0.0", _rcin_port) ||
+        !_sitl_rc_in.set_blocking(false)) {
+        ::printf("Branch failed to bind RC in port %u: %s\n", (unsigned)_rcin_port, strerror(errno));
+        _exit(1);
+    }
+    if (_use_fg_view) {
+        fg_socket.reset();
+        fg_socket.connect(_fg_address, _fg_view_port);
+    }
+
+    ((Storage *)hal.storage)->reopen();
+    AP::logger().StopLogging();
+
+    // serial ports, including the GPS pipes
+    gps_close_pipes();
+    AP_HAL::UARTDriver *uarts[] = { hal.uartA, hal.uartB, hal.uartC, hal.uartD,
+                                    hal.uartE, hal.uartF, hal.uartG, hal.uartH };
+    for (AP_HAL::UARTDriver *uart : uarts) {
+        ((UARTDriver *)uart)->_reopen();
+    }
+
+    // peripherals connected to the serial ports are created again
+    delete adsb;
+    adsb = nullptr;
+    if (traffic != nullptr && !traffic->init(_traffic_name, _instance)) {
+        delete traffic;
+        traffic = nullptr;
+    }
+
+    _scheduler->restart_threads();
+
+    ::printf("Branched as instance %u in %s at %.3fs\n",
+             (unsigned)_instance, dir, AP_HAL::micros64() * 1.0e-6);
+}
+
+#endif // CONFIG_HAL_BOARD == HAL_BOARD_SITL
@@ -100,6 +100,23 @@ int SITL_State::gps2_pipe(void)
     return gps2_state.client_fd;
 }
 
+/*
+  close the GPS pipes so the next gps_pipe() and gps2_pipe() calls
+  create new ones
+ */
+void SITL_State::gps_close_pipes(void)
+{
+    struct gps_state *states[] = { &gps_state, &gps2_state };
+    for (struct gps_state *s : states) {
+        if (s->client_fd != 0) {
+            close(s->client_fd);
+            close(s->gps_fd);
+            s->client_fd = 0;
+            s->gps_fd = 0;
+        }
+    }
+}
+
 /*
   write some bytes from the simulated GPS
  */
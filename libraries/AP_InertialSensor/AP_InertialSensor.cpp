@@ -33,6 +33,8 @@
 #define timing_printf(fmt, args...)
 #endif
 
+#define INS_RATE_LOOP_BUFFER_SIZE 8  // gyro samples queued for a rate loop running outside the main loop
+
 #ifndef HAL_DEFAULT_INS_FAST_SAMPLE
 #define HAL_DEFAULT_INS_FAST_SAMPLE 0
 #endif
@@ -717,6 +719,10 @@ AP_InertialSensor::detect_backends(void)
     // IMUs defined by IMU lines in hwdef.dat
     HAL_INS_PROBE_LIST;
 #elif CONFIG_HAL_BOARD == HAL_BOARD_SITL
+    if (AP::sitl()->imu_spi) {
+        // exercise the real driver against the simulated SPI bus
+        ADD_BACKEND(AP_InertialSensor_Invensense::probe(*this, hal.spi->get_device("mpu6000"), ROTATION_NONE));
+    }
     ADD_BACKEND(AP_InertialSensor_SITL::detect(*this));
 #elif HAL_INS_DEFAULT == HAL_INS_HIL
     ADD_BACKEND(AP_InertialSensor_HIL::detect(*this));
@@ -1304,6 +1310,9 @@ void AP_InertialSensor::update(void)
                 break;
             }
         }
+
+        // the rate loop follows the primary gyro from its next sample
+        _rate_loop_gyro = _primary_gyro;
     }
 
     _last_update_usec = AP_HAL::micros();
@@ -1311,6 +1320,60 @@ void AP_InertialSensor::update(void)
     _have_sample = false;
 }
 
+/*
+  start queueing every filtered gyro sample so a rate loop running
+  outside the main loop sees each sample as soon as the backend
+  produces it, without taking the backend semaphore
+ */
+bool AP_InertialSensor::enable_rate_loop_buffer(void)
+{
+    for (uint8_t i=0; i<_gyro_count; i++) {
+        if (_rate_loop_buffer[i] != nullptr) {
+            continue;
+        }
+        ObjectBuffer<rate_loop_sample> *buffer = new ObjectBuffer<rate_loop_sample>(INS_RATE_LOOP_BUFFER_SIZE);
+        if (buffer == nullptr || buffer->space() == 0) {
+            delete buffer;
+            return false;
+        }
+        _rate_loop_buffer[i] = buffer;
+    }
+    _rate_loop_gyro = _primary_gyro;
+    return true;
+}
+
+/*
+  wait for the next filtered primary gyro sample queued for the rate
+  loop. Older samples are dropped as the rate loop only needs the
+  latest, but their time steps are added up so the rate loop knows how
+  much time has passed. The samples of the other gyros are discarded
+  so that they are fresh if the primary gyro changes
+ */
+uint16_t AP_InertialSensor::get_next_gyro_sample(Vector3f &gyro, float &dt, uint32_t timeout_us)
+{
+    dt = 0;
+    const uint8_t instance = _rate_loop_gyro;
+    if (_rate_loop_buffer[instance] == nullptr) {
+        return 0;
+    }
+    if (_rate_loop_buffer[instance]->empty() && !_rate_loop_sem.wait(timeout_us)) {
+        return 0;
+    }
+    uint16_t count = 0;
+    rate_loop_sample sample;
+    while (_rate_loop_buffer[instance]->pop(sample)) {
+        gyro = sample.gyro;
+        dt += sample.dt;
+        count++;
+    }
+    for (uint8_t i=0; i<_gyro_count; i++) {
+        if (i != instance && _rate_loop_buffer[i] != nullptr) {
+            _rate_loop_buffer[i]->advance(_rate_loop_buffer[i]->available());
+        }
+    }
+    return count;
+}
+
 /*
   wait for a sample to be available. This is the function that
   determines the timing of the main loop in ardupilot.
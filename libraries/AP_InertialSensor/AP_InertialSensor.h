@@ -21,6 +21,7 @@
 
 #include <AP_AccelCal/AP_AccelCal.h>
 #include <AP_HAL/AP_HAL.h>
+#include <AP_HAL/utility/RingBuffer.h>
 #include <AP_Math/AP_Math.h>
 #include <Filter/LowPassFilter2p.h>
 #include <Filter/LowPassFilter.h>
@@ -208,6 +209,14 @@ public:
     // get the gyro filter rate in Hz
     uint16_t get_gyro_filter_hz(void) const { return _gyro_filter_cutoff; }
 
+    // start queueing every filtered gyro sample for a rate loop running outside the main loop
+    bool enable_rate_loop_buffer(void);
+
+    // wait up to timeout_us for the next filtered primary gyro sample queued for the rate loop.  Older samples
+    // are dropped, dt is set to the time covered by all the samples taken and the number of samples is returned,
+    // or zero if no new sample arrived.  should only be called from a single thread
+    uint16_t get_next_gyro_sample(Vector3f &gyro, float &dt, uint32_t timeout_us);
+
     // get the accel filter rate in Hz
     uint16_t get_accel_filter_hz(void) const { return _accel_filter_cutoff; }
 
@@ -407,6 +416,16 @@ private:
     bool _new_accel_data[INS_MAX_INSTANCES];
     bool _new_gyro_data[INS_MAX_INSTANCES];
 
+    // filtered gyro samples handed from the backends to the rate loop without locking.  Each
+    // gyro has its own buffer so that a change of primary gyro never mixes samples of two gyros
+    struct rate_loop_sample {
+        Vector3f gyro;
+        float dt;                           // time since the previous sample in seconds
+    };
+    ObjectBuffer<rate_loop_sample> *_rate_loop_buffer[INS_MAX_INSTANCES];
+    HAL_BinarySemaphore _rate_loop_sem;     // signalled when a sample is pushed to a rate loop buffer
+    volatile uint8_t _rate_loop_gyro;       // primary gyro as of the last update(), read by the rate loop
+
     // optional notch filter on gyro
     NotchFilterParams _notch_filter;
     NotchFilterVector3f _gyro_notch_filter[INS_MAX_INSTANCES];
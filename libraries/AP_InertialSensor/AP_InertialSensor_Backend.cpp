@@ -235,6 +235,12 @@ void AP_InertialSensor_Backend::_notify_new_gyro_raw_sample(uint8_t instance,
             _imu._gyro_notch_filter[instance].reset();
         }
         _imu._new_gyro_data[instance] = true;
+
+        // hand the sample to the rate loop if it runs outside the main loop
+        if (_imu._rate_loop_buffer[instance] != nullptr) {
+            _imu._rate_loop_buffer[instance]->push(AP_InertialSensor::rate_loop_sample{_imu._gyro_filtered[instance], dt});
+            _imu._rate_loop_sem.signal();
+        }
     }
 
     if (!_imu.batchsampler.doing_post_filter_logging()) {
@@ -17,6 +17,8 @@
 #include "vector2.h"
 #include "vector3.h"
 #include "spline5.h"
+#include "scurve.h"
+#include "chirp.h"
 #include "location.h"
 
 // define AP_Param types AP_Vector3f and Ap_Matrix3f
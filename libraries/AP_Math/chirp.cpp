@@ -0,0 +1,76 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AP_Math.h"
+#include "chirp.h"
+
+// initialise the sweep
+//     time_record is the length of the sweep in seconds including the fades and the constant frequency time
+//     frequencies are in Hz, the stop frequency may be lower than the start frequency
+void Chirp::init(float time_record, float frequency_start_hz, float frequency_stop_hz, float time_fade_in, float time_fade_out, float time_const_freq)
+{
+    _time_record = MAX(time_record, 0.0f);
+    _frequency_start_hz = fabsf(frequency_start_hz);
+    _frequency_stop_hz = fabsf(frequency_stop_hz);
+    _time_const_freq = constrain_float(time_const_freq, 0.0f, _time_record);
+    _time_fade_in = constrain_float(time_fade_in, 0.0f, _time_record);
+    _time_fade_out = constrain_float(time_fade_out, 0.0f, _time_record - _time_fade_in);
+    _frequency_hz = _frequency_start_hz;
+    _window = 0.0f;
+}
+
+// calculate the sweep output at time (in seconds) since the start of the sweep, zero outside of the sweep
+float Chirp::update(float time, float magnitude)
+{
+    if (time < 0.0f || time >= _time_record) {
+        _frequency_hz = (time < 0.0f) ? _frequency_start_hz : _frequency_stop_hz;
+        _window = 0.0f;
+        return 0.0f;
+    }
+
+    // raised cosine fade in and fade out
+    if (time < _time_fade_in) {
+        _window = 0.5f - 0.5f * cosf(M_PI * time / _time_fade_in);
+    } else if (time > _time_record - _time_fade_out) {
+        _window = 0.5f - 0.5f * cosf(M_PI * (_time_record - time) / _time_fade_out);
+    } else {
+        _window = 1.0f;
+    }
+
+    // phase of the start frequency held for the constant frequency time
+    const float w_start = M_2PI * _frequency_start_hz;
+    float phase;
+    if (time <= _time_const_freq) {
+        _frequency_hz = _frequency_start_hz;
+        phase = w_start * time;
+    } else {
+        const float t = time - _time_const_freq;
+        const float time_sweep = _time_record - _time_const_freq;
+        phase = w_start * _time_const_freq;
+        if (!is_positive(_frequency_start_hz) || !is_positive(_frequency_stop_hz) || is_equal(_frequency_start_hz, _frequency_stop_hz)) {
+            // a logarithmic sweep needs non-zero, different frequencies so fall back to a linear sweep
+            _frequency_hz = _frequency_start_hz + (_frequency_stop_hz - _frequency_start_hz) * t / time_sweep;
+            phase += M_PI * (_frequency_start_hz + _frequency_hz) * t;
+        } else {
+            // the frequency rises exponentially and the phase is its integral
+            const float ratio = _frequency_stop_hz / _frequency_start_hz;
+            const float growth = powf(ratio, t / time_sweep);
+            _frequency_hz = _frequency_start_hz * growth;
+            phase += w_start * time_sweep * (growth - 1.0f) / logf(ratio);
+        }
+    }
+
+    return magnitude * _window * sinf(phase);
+}
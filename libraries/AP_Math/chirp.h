@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * Logarithmic frequency sweep (chirp) used to excite a system for
+ * identification of its frequency response.
+ *
+ * The sweep holds the start frequency for a settling time so the system
+ * reaches a steady oscillation, then increases the frequency
+ * exponentially to the stop frequency at the end of the record so that
+ * each decade of frequency gets the same time.  The magnitude is faded in
+ * at the start and out at the end with raised cosine windows.
+ */
+class Chirp {
+public:
+
+    Chirp() { init(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f); }
+
+    // initialise the sweep
+    //     time_record is the length of the sweep in seconds including the fades and the constant frequency time
+    //     frequencies are in Hz, the stop frequency may be lower than the start frequency
+    void init(float time_record, float frequency_start_hz, float frequency_stop_hz, float time_fade_in, float time_fade_out, float time_const_freq);
+
+    // calculate the sweep output at time (in seconds) since the start of the sweep, zero outside of the sweep
+    float update(float time, float magnitude);
+
+    // get frequency in Hz of the most recent output
+    float get_frequency_hz() const { return _frequency_hz; }
+
+    // get window (between 0 and 1) applied to the magnitude of the most recent output
+    float get_window() const { return _window; }
+
+    // get length of the sweep in seconds
+    float get_time_record() const { return _time_record; }
+
+    // true once time is past the end of the sweep
+    bool completed(float time) const { return time >= _time_record; }
+
+private:
+
+    float _time_record;         // length of the sweep in seconds
+    float _frequency_start_hz;  // frequency at the start of the sweep
+    float _frequency_stop_hz;   // frequency at the end of the sweep
+    float _time_fade_in;        // time the magnitude is faded in over
+    float _time_fade_out;       // time before the end of the sweep the magnitude is faded out over
+    float _time_const_freq;     // time the start frequency is held for
+
+    float _frequency_hz;        // frequency of the most recent output
+    float _window;              // window applied to the most recent output
+};
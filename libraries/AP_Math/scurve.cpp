@@ -0,0 +1,227 @@
+/*
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AP_Math.h"
+#include "scurve.h"
+
+#define SCURVE_SEARCH_ITERATIONS    20  // number of bisection iterations used to find the cruise and end speeds
+
+// clear the profile so that it covers no distance
+void SCurve::init()
+{
+    _num_segments = 0;
+    _time_total = 0.0f;
+    _length = 0.0f;
+    _speed_start = 0.0f;
+    _accel_start = 0.0f;
+    _speed_end = 0.0f;
+}
+
+// calculate the time spent at constant jerk and at constant acceleration to change speed by speed_delta
+void SCurve::calc_speed_change_times(float speed_delta, float accel_max, float jerk_max, float &time_jerk, float &time_accel)
+{
+    speed_delta = fabsf(speed_delta);
+    if (speed_delta * jerk_max >= sq(accel_max)) {
+        // acceleration reaches accel_max and holds it
+        time_jerk = accel_max / jerk_max;
+        time_accel = speed_delta / accel_max - time_jerk;
+    } else {
+        // acceleration ramps up and straight back down again
+        time_jerk = safe_sqrt(speed_delta / jerk_max);
+        time_accel = 0.0f;
+    }
+}
+
+// get distance covered while changing speed from speed_from to speed_to with jerk limited acceleration
+float SCurve::calc_speed_change_dist(float speed_from, float speed_to, float accel_max, float jerk_max)
+{
+    float time_jerk, time_accel;
+    calc_speed_change_times(speed_to - speed_from, accel_max, jerk_max, time_jerk, time_accel);
+
+    // the acceleration is symmetric in time so the average speed is half way between the two speeds
+    return (speed_from + speed_to) * 0.5f * (2.0f * time_jerk + time_accel);
+}
+
+// calculate the profile to move length from speed_start to speed_end
+//     speeds must be positive, the cruise speed will be no more than speed_max (unless speed_start is higher)
+//     the acceleration starts at accel_start and is brought to zero before following the profile
+//     if the track is too short to reach speed_end it is adjusted to the closest speed that can be reached
+//     if speed_max is zero the profile only covers the distance needed to stop
+void SCurve::calculate(float length, float speed_start, float accel_start, float speed_end, float speed_max, float accel_max, float jerk_max)
+{
+    init();
+
+    length = MAX(length, 0.0f);
+    _speed_start = MAX(speed_start, 0.0f);
+    speed_max = MAX(speed_max, 0.0f);
+    speed_end = constrain_float(speed_end, 0.0f, speed_max);
+
+    // without acceleration the target can only continue at its current speed
+    if (!is_positive(accel_max) || !is_positive(jerk_max)) {
+        _speed_end = _speed_start;
+        if (is_positive(_speed_start)) {
+            _length = length;
+            add_segment(_length / _speed_start, 0.0f);
+        }
+        return;
+    }
+
+    // bring the starting acceleration to zero at the maximum jerk, limited so the speed does not fall below zero
+    if (!is_zero(accel_start)) {
+        _accel_start = constrain_float(accel_start, -accel_max, accel_max);
+        if (is_negative(_accel_start) && (_speed_start < sq(_accel_start) * 0.5f / jerk_max)) {
+            _accel_start = -safe_sqrt(2.0f * jerk_max * _speed_start);
+        }
+        add_segment(fabsf(_accel_start) / jerk_max, is_positive(_accel_start) ? -jerk_max : jerk_max);
+    }
+
+    // the rest of the profile starts where the acceleration reaches zero
+    float pos_plan, speed_plan, accel_plan;
+    get_end_state(pos_plan, speed_plan, accel_plan);
+    const float length_plan = MAX(length - pos_plan, 0.0f);
+    _length = pos_plan + length_plan;
+
+    // move speed_end towards the starting speed until the change in speed fits within the track
+    if (calc_speed_change_dist(speed_plan, speed_end, accel_max, jerk_max) > length_plan) {
+        float reachable = speed_plan;
+        float unreachable = speed_end;
+        for (uint8_t i = 0; i < SCURVE_SEARCH_ITERATIONS; i++) {
+            const float speed_test = (reachable + unreachable) * 0.5f;
+            if (calc_speed_change_dist(speed_plan, speed_test, accel_max, jerk_max) > length_plan) {
+                unreachable = speed_test;
+            } else {
+                reachable = speed_test;
+            }
+        }
+        speed_end = reachable;
+    }
+    _speed_end = speed_end;
+
+    // find the highest cruise speed for which changing to and from the cruise speed fits within the track
+    float speed_cruise;
+    if (speed_plan > speed_max) {
+        // slow to speed_max if possible, otherwise slow straight to the end speed
+        speed_cruise = MAX(speed_max, speed_end);
+        if (calc_speed_change_dist(speed_plan, speed_cruise, accel_max, jerk_max) + calc_speed_change_dist(speed_cruise, speed_end, accel_max, jerk_max) > length_plan) {
+            speed_cruise = speed_end;
+        }
+    } else {
+        float reachable = MAX(speed_plan, speed_end);
+        float unreachable = speed_max;
+        if (calc_speed_change_dist(speed_plan, unreachable, accel_max, jerk_max) + calc_speed_change_dist(unreachable, speed_end, accel_max, jerk_max) <= length_plan) {
+            reachable = unreachable;
+        } else {
+            for (uint8_t i = 0; i < SCURVE_SEARCH_ITERATIONS; i++) {
+                const float speed_test = (reachable + unreachable) * 0.5f;
+                if (calc_speed_change_dist(speed_plan, speed_test, accel_max, jerk_max) + calc_speed_change_dist(speed_test, speed_end, accel_max, jerk_max) > length_plan) {
+                    unreachable = speed_test;
+                } else {
+                    reachable = speed_test;
+                }
+            }
+        }
+        speed_cruise = reachable;
+    }
+
+    // build the segments
+    add_speed_change(speed_plan, speed_cruise, accel_max, jerk_max);
+    if (is_positive(speed_cruise)) {
+        const float cruise_length = length_plan - calc_speed_change_dist(speed_plan, speed_cruise, accel_max, jerk_max) - calc_speed_change_dist(speed_cruise, speed_end, accel_max, jerk_max);
+        if (is_positive(cruise_length)) {
+            add_segment(cruise_length / speed_cruise, 0.0f);
+        }
+    }
+    add_speed_change(speed_cruise, speed_end, accel_max, jerk_max);
+
+    // without a cruise speed (speed_max is zero) the target stops wherever the segments end rather than jumping to the end of the track
+    if (!is_positive(speed_cruise)) {
+        get_end_state(pos_plan, speed_plan, accel_plan);
+        _length = pos_plan;
+    }
+}
+
+// add the segments which change speed from speed_from to speed_to
+void SCurve::add_speed_change(float speed_from, float speed_to, float accel_max, float jerk_max)
+{
+    float time_jerk, time_accel;
+    calc_speed_change_times(speed_to - speed_from, accel_max, jerk_max, time_jerk, time_accel);
+    const float jerk = (speed_to >= speed_from) ? jerk_max : -jerk_max;
+    add_segment(time_jerk, jerk);
+    add_segment(time_accel, 0.0f);
+    add_segment(time_jerk, -jerk);
+}
+
+// add a constant jerk segment after the last segment
+void SCurve::add_segment(float duration, float jerk)
+{
+    if (!is_positive(duration) || (_num_segments >= SEGMENTS_MAX)) {
+        return;
+    }
+
+    // state at the start of the new segment is the state at the end of the previous one
+    segment &seg = _segments[_num_segments];
+    get_end_state(seg.pos, seg.vel, seg.accel);
+    seg.time_start = _time_total;
+    seg.jerk = jerk;
+
+    _time_total += duration;
+    _num_segments++;
+}
+
+// get position, velocity and acceleration t seconds after the start of a segment
+void SCurve::get_segment_state(const segment &seg, float t, float &pos, float &vel, float &accel)
+{
+    pos = seg.pos + seg.vel * t + seg.accel * sq(t) * 0.5f + seg.jerk * t * t * t * (1.0f / 6.0f);
+    vel = seg.vel + seg.accel * t + seg.jerk * sq(t) * 0.5f;
+    accel = seg.accel + seg.jerk * t;
+}
+
+// get position, velocity and acceleration at the end of the last segment
+void SCurve::get_end_state(float &pos, float &vel, float &accel) const
+{
+    if (_num_segments == 0) {
+        pos = 0.0f;
+        vel = _speed_start;
+        accel = _accel_start;
+        return;
+    }
+    const segment &seg = _segments[_num_segments - 1];
+    get_segment_state(seg, _time_total - seg.time_start, pos, vel, accel);
+}
+
+// get position, velocity and acceleration along the track at time (in seconds) since the start of the profile
+//     after the profile has finished the position continues to move at the end speed
+void SCurve::get_state(float time, float &pos, float &vel, float &accel) const
+{
+    if (time >= _time_total) {
+        pos = _length + _speed_end * (time - _time_total);
+        vel = _speed_end;
+        accel = 0.0f;
+        return;
+    }
+    if ((time <= 0.0f) || (_num_segments == 0)) {
+        pos = 0.0f;
+        vel = _speed_start;
+        accel = _accel_start;
+        return;
+    }
+
+    // find the segment holding time.  there are at most eight so this is constant time
+    uint8_t i = _num_segments - 1;
+    while ((i > 0) && (time < _segments[i].time_start)) {
+        i--;
+    }
+    get_segment_state(_segments[i], time - _segments[i].time_start, pos, vel, accel);
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * Jerk limited (S-curve) speed profile along a straight track.
+ *
+ * The profile is made up of at most eight constant jerk segments: a
+ * ramp of the starting acceleration to zero, a jerk limited change to a
+ * cruise speed, the cruise and a jerk limited change from the cruise
+ * speed to the end speed.  The
+ * segments are calculated once by calculate() after which the position,
+ * velocity and acceleration at any time can be retrieved in constant
+ * time using get_state().
+ */
+class SCurve {
+public:
+
+    SCurve() { init(); }
+
+    // clear the profile so that it covers no distance
+    void init();
+
+    // calculate the profile to move length from speed_start to speed_end
+    //     speeds must be positive, the cruise speed will be no more than speed_max (unless speed_start is higher)
+    //     the acceleration starts at accel_start so that replanning a moving target keeps its acceleration continuous
+    //     if the track is too short to reach speed_end it is adjusted to the closest speed that can be reached
+    //     if speed_max is zero the profile only covers the distance needed to stop
+    void calculate(float length, float speed_start, float accel_start, float speed_end, float speed_max, float accel_max, float jerk_max);
+
+    // get position, velocity and acceleration along the track at time (in seconds) since the start of the profile
+    //     after the profile has finished the position continues to move at the end speed
+    void get_state(float time, float &pos, float &vel, float &accel) const;
+
+    // get length covered by the profile
+    float get_length() const { return _length; }
+
+    // get duration of the profile in seconds
+    float get_time_total() const { return _time_total; }
+
+    // get speed at the end of the profile.  may differ from the requested end speed if the track was too short
+    float get_speed_end() const { return _speed_end; }
+
+    // get distance covered while changing speed from speed_from to speed_to with jerk limited acceleration
+    static float calc_speed_change_dist(float speed_from, float speed_to, float accel_max, float jerk_max);
+
+private:
+
+    // calculate the time spent at constant jerk and at constant acceleration to change speed by speed_delta
+    static void calc_speed_change_times(float speed_delta, float accel_max, float jerk_max, float &time_jerk, float &time_accel);
+
+    // add the segments which change speed from speed_from to speed_to
+    void add_speed_change(float speed_from, float speed_to, float accel_max, float jerk_max);
+
+    // add a constant jerk segment after the last segment
+    void add_segment(float duration, float jerk);
+
+    static const uint8_t SEGMENTS_MAX = 8;
+
+    // constant jerk segment along with the state at its start
+    struct segment {
+        float time_start;   // time since the start of the profile
+        float jerk;
+        float pos;
+        float vel;
+        float accel;
+    } _segments[SEGMENTS_MAX];
+    uint8_t _num_segments;
+
+    // get position, velocity and acceleration t seconds after the start of a segment
+    static void get_segment_state(const segment &seg, float t, float &pos, float &vel, float &accel);
+
+    // get position, velocity and acceleration at the end of the last segment
+    void get_end_state(float &pos, float &vel, float &accel) const;
+
+    float _time_total;      // time at the end of the last segment
+    float _length;          // distance covered by the profile
+    float _speed_start;     // speed at the start of the profile
+    float _accel_start;     // acceleration at the start of the profile
+    float _speed_end;       // speed at the end of the profile
+};
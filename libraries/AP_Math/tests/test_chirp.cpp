@@ -0,0 +1,79 @@
+#include <AP_gtest.h>
+
+#include <AP_Math/AP_Math.h>
+
+TEST(ChirpTest, Frequency)
+{
+    Chirp chirp;
+    chirp.init(20.0f, 0.5f, 40.0f, 1.0f, 1.0f, 2.0f);
+
+    // start frequency is held for the constant frequency time
+    chirp.update(1.0f, 1.0f);
+    EXPECT_FLOAT_EQ(0.5f, chirp.get_frequency_hz());
+    chirp.update(2.0f, 1.0f);
+    EXPECT_FLOAT_EQ(0.5f, chirp.get_frequency_hz());
+
+    // logarithmic sweep is at the geometric mean of the frequencies half way through
+    chirp.update(11.0f, 1.0f);
+    EXPECT_NEAR(sqrtf(0.5f * 40.0f), chirp.get_frequency_hz(), 0.01f);
+
+    // frequency only increases and ends at the stop frequency
+    float frequency_prev = 0.0f;
+    for (float t = 0.0f; t < 20.0f; t += 0.01f) {
+        chirp.update(t, 1.0f);
+        EXPECT_GE(chirp.get_frequency_hz(), frequency_prev);
+        frequency_prev = chirp.get_frequency_hz();
+    }
+    EXPECT_NEAR(40.0f, frequency_prev, 0.1f);
+}
+
+TEST(ChirpTest, Magnitude)
+{
+    Chirp chirp;
+    chirp.init(10.0f, 1.0f, 10.0f, 2.0f, 2.0f, 1.0f);
+
+    // output is faded in and out and never exceeds the magnitude
+    EXPECT_FLOAT_EQ(0.0f, chirp.update(0.0f, 5.0f));
+    float peak = 0.0f;
+    for (float t = 0.0f; t < 10.0f; t += 0.001f) {
+        const float out = chirp.update(t, 5.0f);
+        EXPECT_LE(fabsf(out), 5.0f * chirp.get_window() + 1.0e-4f);
+        if (t > 2.0f && t < 8.0f) {
+            EXPECT_FLOAT_EQ(1.0f, chirp.get_window());
+            peak = MAX(peak, fabsf(out));
+        }
+    }
+    EXPECT_NEAR(5.0f, peak, 0.01f);
+    EXPECT_LT(chirp.get_window(), 0.01f);
+
+    // nothing is output outside of the sweep
+    EXPECT_FLOAT_EQ(0.0f, chirp.update(-1.0f, 5.0f));
+    EXPECT_FLOAT_EQ(0.0f, chirp.update(10.0f, 5.0f));
+    EXPECT_TRUE(chirp.completed(10.0f));
+    EXPECT_FALSE(chirp.completed(9.9f));
+}
+
+TEST(ChirpTest, ContinuousPhase)
+{
+    // the output only changes by as much as the frequency allows between steps
+    Chirp chirp;
+    chirp.init(30.0f, 0.1f, 20.0f, 0.0f, 0.0f, 5.0f);
+    const float dt = 0.0025f;
+    float out_prev = chirp.update(0.0f, 1.0f);
+    for (float t = dt; t < 30.0f; t += dt) {
+        const float out = chirp.update(t, 1.0f);
+        EXPECT_LE(fabsf(out - out_prev), M_2PI * chirp.get_frequency_hz() * dt * 1.01f + 1.0e-4f);
+        out_prev = out;
+    }
+}
+
+TEST(ChirpTest, LinearFallback)
+{
+    // a sweep from zero can't be logarithmic
+    Chirp chirp;
+    chirp.init(10.0f, 0.0f, 10.0f, 0.0f, 0.0f, 0.0f);
+    chirp.update(5.0f, 1.0f);
+    EXPECT_NEAR(5.0f, chirp.get_frequency_hz(), 0.001f);
+}
+
+AP_GTEST_MAIN()
@@ -0,0 +1,157 @@
+#include <AP_gtest.h>
+
+#include <AP_Math/AP_Math.h>
+
+// step through a profile checking that it never exceeds its limits and
+// that position and velocity are continuous
+static void check_profile(const SCurve &scurve, float speed_max, float accel_max, float jerk_max)
+{
+    const float dt = 0.0025f;
+    float pos_prev, vel_prev, accel_prev;
+    scurve.get_state(0.0f, pos_prev, vel_prev, accel_prev);
+    for (float t = dt; t <= scurve.get_time_total() + dt; t += dt) {
+        float pos, vel, accel;
+        scurve.get_state(t, pos, vel, accel);
+        EXPECT_LE(vel, MAX(speed_max, vel_prev) + 0.01f);
+        EXPECT_GE(vel, -0.01f);
+        EXPECT_LE(fabsf(accel), accel_max * 1.001f);
+        EXPECT_LE(fabsf(accel - accel_prev), jerk_max * dt * 1.01f);
+        EXPECT_NEAR(pos - pos_prev, (vel + vel_prev) * 0.5f * dt, 0.01f);
+        EXPECT_GE(pos, pos_prev - 0.001f);
+        pos_prev = pos;
+        vel_prev = vel;
+        accel_prev = accel;
+    }
+}
+
+TEST(SCurveTest, StopToStop)
+{
+    SCurve scurve;
+    scurve.calculate(10000.0f, 0.0f, 0.0f, 0.0f, 500.0f, 100.0f, 100.0f);
+    check_profile(scurve, 500.0f, 100.0f, 100.0f);
+
+    float pos, vel, accel;
+    scurve.get_state(scurve.get_time_total(), pos, vel, accel);
+    EXPECT_FLOAT_EQ(10000.0f, pos);
+    EXPECT_FLOAT_EQ(0.0f, vel);
+
+    // long track reaches the maximum speed half way along
+    scurve.get_state(scurve.get_time_total() * 0.5f, pos, vel, accel);
+    EXPECT_NEAR(5000.0f, pos, 1.0f);
+    EXPECT_NEAR(500.0f, vel, 0.1f);
+    EXPECT_NEAR(0.0f, accel, 0.1f);
+}
+
+TEST(SCurveTest, ShortTrack)
+{
+    // track too short to reach the maximum speed
+    SCurve scurve;
+    scurve.calculate(200.0f, 0.0f, 0.0f, 0.0f, 500.0f, 100.0f, 100.0f);
+    check_profile(scurve, 500.0f, 100.0f, 100.0f);
+
+    float pos, vel, accel;
+    scurve.get_state(scurve.get_time_total(), pos, vel, accel);
+    EXPECT_FLOAT_EQ(200.0f, pos);
+    EXPECT_FLOAT_EQ(0.0f, vel);
+    scurve.get_state(scurve.get_time_total() + 1.0f, pos, vel, accel);
+    EXPECT_FLOAT_EQ(200.0f, pos);
+}
+
+TEST(SCurveTest, FastWaypoint)
+{
+    // starting and finishing while moving
+    SCurve scurve;
+    scurve.calculate(3000.0f, 200.0f, 0.0f, 300.0f, 500.0f, 100.0f, 200.0f);
+    check_profile(scurve, 500.0f, 100.0f, 200.0f);
+    EXPECT_FLOAT_EQ(300.0f, scurve.get_speed_end());
+
+    // continues at the end speed after the profile has finished
+    float pos, vel, accel;
+    scurve.get_state(scurve.get_time_total() + 2.0f, pos, vel, accel);
+    EXPECT_NEAR(3600.0f, pos, 0.01f);
+    EXPECT_FLOAT_EQ(300.0f, vel);
+}
+
+TEST(SCurveTest, EndSpeedUnreachable)
+{
+    // track too short to stop so the end speed is raised
+    SCurve scurve;
+    scurve.calculate(100.0f, 500.0f, 0.0f, 0.0f, 500.0f, 100.0f, 100.0f);
+    check_profile(scurve, 500.0f, 100.0f, 100.0f);
+    EXPECT_GT(scurve.get_speed_end(), 0.0f);
+    EXPECT_LE(SCurve::calc_speed_change_dist(500.0f, scurve.get_speed_end(), 100.0f, 100.0f), 100.0f);
+}
+
+TEST(SCurveTest, SlowDown)
+{
+    // start above the maximum speed
+    SCurve scurve;
+    scurve.calculate(10000.0f, 800.0f, 0.0f, 0.0f, 500.0f, 100.0f, 100.0f);
+    check_profile(scurve, 800.0f, 100.0f, 100.0f);
+
+    float pos, vel, accel;
+    scurve.get_state(scurve.get_time_total() * 0.5f, pos, vel, accel);
+    EXPECT_NEAR(500.0f, vel, 0.1f);
+}
+
+TEST(SCurveTest, ZeroLength)
+{
+    SCurve scurve;
+    scurve.calculate(0.0f, 0.0f, 0.0f, 0.0f, 500.0f, 100.0f, 100.0f);
+    EXPECT_FLOAT_EQ(0.0f, scurve.get_time_total());
+
+    float pos, vel, accel;
+    scurve.get_state(1.0f, pos, vel, accel);
+    EXPECT_FLOAT_EQ(0.0f, pos);
+    EXPECT_FLOAT_EQ(0.0f, vel);
+}
+
+TEST(SCurveTest, AccelStart)
+{
+    // replanning while accelerating or braking keeps the acceleration continuous
+    SCurve scurve;
+    scurve.calculate(5000.0f, 200.0f, 80.0f, 0.0f, 500.0f, 100.0f, 100.0f);
+    check_profile(scurve, 500.0f, 100.0f, 100.0f);
+
+    float pos, vel, accel;
+    scurve.get_state(0.0f, pos, vel, accel);
+    EXPECT_FLOAT_EQ(80.0f, accel);
+    scurve.get_state(scurve.get_time_total(), pos, vel, accel);
+    EXPECT_FLOAT_EQ(5000.0f, pos);
+    EXPECT_FLOAT_EQ(0.0f, vel);
+
+    scurve.calculate(5000.0f, 400.0f, -100.0f, 0.0f, 500.0f, 100.0f, 100.0f);
+    check_profile(scurve, 500.0f, 100.0f, 100.0f);
+    scurve.get_state(0.0f, pos, vel, accel);
+    EXPECT_FLOAT_EQ(-100.0f, accel);
+    scurve.get_state(scurve.get_time_total(), pos, vel, accel);
+    EXPECT_FLOAT_EQ(5000.0f, pos);
+
+    // braking hard at low speed stops rather than reversing
+    scurve.calculate(5000.0f, 10.0f, -100.0f, 0.0f, 500.0f, 100.0f, 100.0f);
+    check_profile(scurve, 500.0f, 100.0f, 100.0f);
+}
+
+TEST(SCurveTest, ZeroSpeedMax)
+{
+    // without a maximum speed the target does not move
+    SCurve scurve;
+    scurve.calculate(1000.0f, 0.0f, 0.0f, 0.0f, 0.0f, 100.0f, 100.0f);
+    float pos, vel, accel;
+    scurve.get_state(1.0f, pos, vel, accel);
+    EXPECT_FLOAT_EQ(0.0f, pos);
+    EXPECT_FLOAT_EQ(0.0f, vel);
+
+    // or only moves as far as it takes to stop
+    scurve.calculate(1000.0f, 100.0f, 0.0f, 0.0f, 0.0f, 100.0f, 100.0f);
+    check_profile(scurve, 100.0f, 100.0f, 100.0f);
+    scurve.get_state(scurve.get_time_total() + 1.0f, pos, vel, accel);
+    EXPECT_NEAR(SCurve::calc_speed_change_dist(100.0f, 0.0f, 100.0f, 100.0f), pos, 0.01f);
+    EXPECT_FLOAT_EQ(0.0f, vel);
+
+    scurve.calculate(1000.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+    scurve.get_state(1.0f, pos, vel, accel);
+    EXPECT_FLOAT_EQ(0.0f, pos);
+}
+
+AP_GTEST_MAIN()
@@ -140,27 +140,37 @@ void AP_Motors6DOF::setup_motors(motor_frame_class frame_class, motor_frame_type
         add_motor_raw_6dof(AP_MOTORS_MOT_6,     -0.25f,         0,              0,              0,                  0,                  1.0f,           6);
         break;
 
-    case SUB_FRAME_VECTORED_6DOF_90DEG:
-        add_motor_raw_6dof(AP_MOTORS_MOT_1,     1.0f,           1.0f,           0,              1.0f,               0,                  0,              1);
-        add_motor_raw_6dof(AP_MOTORS_MOT_2,     0,              0,              1.0f,           0,                  1.0f,               0,              2);
-        add_motor_raw_6dof(AP_MOTORS_MOT_3,     1.0f,           -1.0f,          0,              1.0f,               0,                  0,              3);
-        add_motor_raw_6dof(AP_MOTORS_MOT_4,     0,              0,              0,              0,                  0,                  1.0f,           4);
-        add_motor_raw_6dof(AP_MOTORS_MOT_5,     0,              0,              0,              0,                  0,                  1.0f,           5);
-        add_motor_raw_6dof(AP_MOTORS_MOT_6,     -1.0f,          1.0f,           0,              1.0f,               0,                  0,              6);
-        add_motor_raw_6dof(AP_MOTORS_MOT_7,     0,              0,              -1.0f,          0,                  1.0f,               0,              7);
-        add_motor_raw_6dof(AP_MOTORS_MOT_8,     -1.0f,          -1.0f,          0,              1.0f,               0,                  0,              8);
+    case SUB_FRAME_VECTORED_6DOF_90DEG: {
+        // each motor's contribution to           Roll        Pitch       Yaw         Throttle    Forward     Lateral
+        static const float effectiveness[][AP_MotorsMixer::NUM_AXES] = {
+            /* AP_MOTORS_MOT_1 */               { 1.0f,       1.0f,       0,          1.0f,       0,          0       },
+            /* AP_MOTORS_MOT_2 */               { 0,          0,          1.0f,       0,          1.0f,       0       },
+            /* AP_MOTORS_MOT_3 */               { 1.0f,       -1.0f,      0,          1.0f,       0,          0       },
+            /* AP_MOTORS_MOT_4 */               { 0,          0,          0,          0,          0,          1.0f    },
+            /* AP_MOTORS_MOT_5 */               { 0,          0,          0,          0,          0,          1.0f    },
+            /* AP_MOTORS_MOT_6 */               { -1.0f,      1.0f,       0,          1.0f,       0,          0       },
+            /* AP_MOTORS_MOT_7 */               { 0,          0,          -1.0f,      0,          1.0f,       0       },
+            /* AP_MOTORS_MOT_8 */               { -1.0f,      -1.0f,      0,          1.0f,       0,          0       },
+        };
+        add_motors_effectiveness(effectiveness, ARRAY_SIZE(effectiveness));
         break;
+    }
 
-    case SUB_FRAME_VECTORED_6DOF:
-        add_motor_raw_6dof(AP_MOTORS_MOT_1,     0,              0,              1.0f,           0,                  -1.0f,              1.0f,           1);
-        add_motor_raw_6dof(AP_MOTORS_MOT_2,     0,              0,              -1.0f,          0,                  -1.0f,              -1.0f,          2);
-        add_motor_raw_6dof(AP_MOTORS_MOT_3,     0,              0,              -1.0f,          0,                  1.0f,               1.0f,           3);
-        add_motor_raw_6dof(AP_MOTORS_MOT_4,     0,              0,              1.0f,           0,                  1.0f,               -1.0f,          4);
-        add_motor_raw_6dof(AP_MOTORS_MOT_5,     1.0f,           -1.0f,          0,              -1.0f,              0,                  0,              5);
-        add_motor_raw_6dof(AP_MOTORS_MOT_6,     -1.0f,          -1.0f,          0,              -1.0f,              0,                  0,              6);
-        add_motor_raw_6dof(AP_MOTORS_MOT_7,     1.0f,           1.0f,           0,              -1.0f,              0,                  0,              7);
-        add_motor_raw_6dof(AP_MOTORS_MOT_8,     -1.0f,          1.0f,           0,              -1.0f,              0,                  0,              8);
+    case SUB_FRAME_VECTORED_6DOF: {
+        // each motor's contribution to           Roll        Pitch       Yaw         Throttle    Forward     Lateral
+        static const float effectiveness[][AP_MotorsMixer::NUM_AXES] = {
+            /* AP_MOTORS_MOT_1 */               { 0,          0,          1.0f,       0,          -1.0f,      1.0f    },
+            /* AP_MOTORS_MOT_2 */               { 0,          0,          -1.0f,      0,          -1.0f,      -1.0f   },
+            /* AP_MOTORS_MOT_3 */               { 0,          0,          -1.0f,      0,          1.0f,       1.0f    },
+            /* AP_MOTORS_MOT_4 */               { 0,          0,          1.0f,       0,          1.0f,       -1.0f   },
+            /* AP_MOTORS_MOT_5 */               { 1.0f,       -1.0f,      0,          -1.0f,      0,          0       },
+            /* AP_MOTORS_MOT_6 */               { -1.0f,      -1.0f,      0,          -1.0f,      0,          0       },
+            /* AP_MOTORS_MOT_7 */               { 1.0f,       1.0f,       0,          -1.0f,      0,          0       },
+            /* AP_MOTORS_MOT_8 */               { -1.0f,      1.0f,       0,          -1.0f,      0,          0       },
+        };
+        add_motors_effectiveness(effectiveness, ARRAY_SIZE(effectiveness));
         break;
+    }
 
     case SUB_FRAME_VECTORED:
         add_motor_raw_6dof(AP_MOTORS_MOT_1,     0,              0,              1.0f,           0,                  -1.0f,              1.0f,           1);
@@ -197,6 +207,40 @@ void AP_Motors6DOF::add_motor_raw_6dof(int8_t motor_num, float roll_fac, float p
     _throttle_factor[motor_num] = throttle_fac;
     _forward_factor[motor_num] = forward_fac;
     _lateral_factor[motor_num] = lat_fac;
+    _mixer.set_factor(motor_num, AP_MotorsMixer::THROTTLE, throttle_fac);
+    _mixer.set_factor(motor_num, AP_MotorsMixer::FORWARD, forward_fac);
+    _mixer.set_factor(motor_num, AP_MotorsMixer::LATERAL, lat_fac);
+}
+
+// add motors numbered from AP_MOTORS_MOT_1 given each motor's contribution to each axis
+//   the factors used for mixing are the effectiveness' pseudo-inverse, calculated once here and scaled so the
+//   largest factor for each axis is 1.0 like the frames given by factors.  Frames which cannot control their
+//   axes independently use their effectiveness as the factors
+void AP_Motors6DOF::add_motors_effectiveness(const float effectiveness[][AP_MotorsMixer::NUM_AXES], uint8_t num_motors)
+{
+    float motor_effectiveness[AP_MotorsMixer::MAX_MOTORS][AP_MotorsMixer::NUM_AXES] {};
+    num_motors = MIN(num_motors, MIN(AP_MOTORS_MAX_NUM_MOTORS, AP_MotorsMixer::MAX_MOTORS));
+    for (uint8_t i = 0; i < num_motors; i++) {
+        const float *eff = effectiveness[i];
+        add_motor_raw_6dof(AP_MOTORS_MOT_1 + i, eff[AP_MotorsMixer::ROLL], eff[AP_MotorsMixer::PITCH], eff[AP_MotorsMixer::YAW],
+                           eff[AP_MotorsMixer::THROTTLE], eff[AP_MotorsMixer::FORWARD], eff[AP_MotorsMixer::LATERAL], i + 1);
+        memcpy(motor_effectiveness[AP_MOTORS_MOT_1 + i], eff, sizeof(motor_effectiveness[0]));
+    }
+    if (!_mixer.set_effectiveness(motor_effectiveness)) {
+        return;
+    }
+    _mixer.normalise_factors(1.0f);
+
+    // the per motor factors are used by the vectored frames and get_roll_factor
+    for (uint8_t i = 0; i < num_motors; i++) {
+        const uint8_t motor_num = AP_MOTORS_MOT_1 + i;
+        _roll_factor[motor_num] = _mixer.get_factor(motor_num, AP_MotorsMixer::ROLL);
+        _pitch_factor[motor_num] = _mixer.get_factor(motor_num, AP_MotorsMixer::PITCH);
+        _yaw_factor[motor_num] = _mixer.get_factor(motor_num, AP_MotorsMixer::YAW);
+        _throttle_factor[motor_num] = _mixer.get_factor(motor_num, AP_MotorsMixer::THROTTLE);
+        _forward_factor[motor_num] = _mixer.get_factor(motor_num, AP_MotorsMixer::FORWARD);
+        _lateral_factor[motor_num] = _mixer.get_factor(motor_num, AP_MotorsMixer::LATERAL);
+    }
 }
 
 // output_min - sends minimum values out to the motors
@@ -284,23 +328,13 @@ void AP_Motors6DOF::output_armed_stabilizing()
     } else if ((sub_frame_t)_last_frame_class == SUB_FRAME_VECTORED_6DOF) {
         output_armed_stabilizing_vectored_6dof();
     } else {
-        uint8_t i;                          // general purpose counter
-        float   roll_thrust;                // roll thrust input value, +/- 1.0
-        float   pitch_thrust;               // pitch thrust input value, +/- 1.0
-        float   yaw_thrust;                 // yaw thrust input value, +/- 1.0
-        float   throttle_thrust;            // throttle thrust input value, +/- 1.0
-        float   forward_thrust;             // forward thrust input value, +/- 1.0
-        float   lateral_thrust;             // lateral thrust input value, +/- 1.0
-
-        roll_thrust = (_roll_in + _roll_in_ff);
-        pitch_thrust = (_pitch_in + _pitch_in_ff);
-        yaw_thrust = (_yaw_in + _yaw_in_ff);
-        throttle_thrust = get_throttle_bidirectional();
-        forward_thrust = _forward_in;
-        lateral_thrust = _lateral_in;
-
-        float rpy_out[AP_MOTORS_MAX_NUM_MOTORS]; // buffer so we don't have to multiply coefficients multiple times.
-        float linear_out[AP_MOTORS_MAX_NUM_MOTORS]; // 3 linear DOF mix for each motor
+        float demand[AP_MotorsMixer::NUM_AXES];
+        demand[AP_MotorsMixer::ROLL] = (_roll_in + _roll_in_ff);
+        demand[AP_MotorsMixer::PITCH] = (_pitch_in + _pitch_in_ff);
+        demand[AP_MotorsMixer::YAW] = (_yaw_in + _yaw_in_ff);
+        demand[AP_MotorsMixer::THROTTLE] = get_throttle_bidirectional();
+        demand[AP_MotorsMixer::FORWARD] = _forward_in;
+        demand[AP_MotorsMixer::LATERAL] = _lateral_in;
 
         // initialize limits flags
         limit.roll = false;
@@ -310,40 +344,24 @@ void AP_Motors6DOF::output_armed_stabilizing()
         limit.throttle_upper = false;
 
         // sanity check throttle is above zero and below current limited throttle
-        if (throttle_thrust <= -_throttle_thrust_max) {
-            throttle_thrust = -_throttle_thrust_max;
+        if (demand[AP_MotorsMixer::THROTTLE] <= -_throttle_thrust_max) {
+            demand[AP_MotorsMixer::THROTTLE] = -_throttle_thrust_max;
             limit.throttle_lower = true;
         }
-        if (throttle_thrust >= _throttle_thrust_max) {
-            throttle_thrust = _throttle_thrust_max;
+        if (demand[AP_MotorsMixer::THROTTLE] >= _throttle_thrust_max) {
+            demand[AP_MotorsMixer::THROTTLE] = _throttle_thrust_max;
             limit.throttle_upper = true;
         }
 
-        // calculate roll, pitch and yaw for each motor
-        for (i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
-            if (motor_enabled[i]) {
-                rpy_out[i] = roll_thrust * _roll_factor[i] +
-                             pitch_thrust * _pitch_factor[i] +
-                             yaw_thrust * _yaw_factor[i];
-
-            }
-        }
-
-        // calculate linear command for each motor
+        // mix all six axes for the enabled motors in one pass per axis
         // linear factors should be 0.0 or 1.0 for now
-        for (i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
-            if (motor_enabled[i]) {
-                linear_out[i] = throttle_thrust * _throttle_factor[i] +
-                                forward_thrust * _forward_factor[i] +
-                                lateral_thrust * _lateral_factor[i];
-            }
-        }
+        float thrust_out[AP_MotorsMixer::MAX_MOTORS];
+        _mixer.mix(demand, thrust_out);
 
         // Calculate final output for each motor
-        for (i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
-            if (motor_enabled[i]) {
-                _thrust_rpyt_out[i] = constrain_float(_motor_reverse[i]*(rpy_out[i] + linear_out[i]),-1.0f,1.0f);
-            }
+        for (uint8_t i = 0; i < _mixer.get_num_motors(); i++) {
+            const uint8_t motor_num = _mixer.get_motor_num(i);
+            _thrust_rpyt_out[motor_num] = constrain_float(_motor_reverse[motor_num]*thrust_out[i],-1.0f,1.0f);
         }
     }
 
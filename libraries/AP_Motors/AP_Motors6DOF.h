@@ -51,6 +51,9 @@ protected:
     //Override MotorsMatrix method
     void add_motor_raw_6dof(int8_t motor_num, float roll_fac, float pitch_fac, float yaw_fac, float climb_fac, float forward_fac, float lat_fac, uint8_t testing_order);
 
+    // add motors numbered from AP_MOTORS_MOT_1 given each motor's contribution to each axis, the factors are calculated from its pseudo-inverse
+    void add_motors_effectiveness(const float effectiveness[][AP_MotorsMixer::NUM_AXES], uint8_t num_motors);
+
     void output_armed_stabilizing() override;
     void output_armed_stabilizing_vectored();
     void output_armed_stabilizing_vectored_6dof();
@@ -133,7 +133,6 @@ uint16_t AP_MotorsMatrix::get_motor_mask()
 // includes new scaling stability patch
 void AP_MotorsMatrix::output_armed_stabilizing()
 {
-    uint8_t i;                          // general purpose counter
     float   roll_thrust;                // roll thrust input value, +/- 1.0
     float   pitch_thrust;               // pitch thrust input value, +/- 1.0
     float   yaw_thrust;                 // yaw thrust input value, +/- 1.0
@@ -188,30 +187,23 @@ void AP_MotorsMatrix::output_armed_stabilizing()
     // Octo-Quad (x8) + : MOT_YAW_HEADROOM = 300, ATC_RAT_RLL_IMAX = 0.5,   ATC_RAT_PIT_IMAX = 0.5,   ATC_RAT_YAW_IMAX = 0.25
     // Quads cannot make use of motor loss handling because it doesn't have enough degrees of freedom.
 
+    // the mixer only holds the enabled motors, packed so each pass below only visits motors in use
+    const uint8_t num_motors = _mixer.get_num_motors();
+    float thrust_out[AP_MotorsMixer::MAX_MOTORS];   // roll, pitch and yaw outputs of the packed motors
+    const int8_t lost_index = _thrust_boost ? _mixer.get_index(_motor_lost_index) : -1;
+
     // calculate amount of yaw we can fit into the throttle range
     // this is always equal to or less than the requested yaw from the pilot or rate controller
     float rp_low = 1.0f;    // lowest thrust value
     float rp_high = -1.0f;  // highest thrust value
-    for (i = 0; i < AP_MOTORS_MAX_NUM_MOTORS; i++) {
-        if (motor_enabled[i]) {
-            // calculate the thrust outputs for roll and pitch
-            _thrust_rpyt_out[i] = roll_thrust * _roll_factor[i] + pitch_thrust * _pitch_factor[i];
-            // record lowest roll + pitch command
-            if (_thrust_rpyt_out[i] < rp_low) {
-                rp_low = _thrust_rpyt_out[i];
-            }
-            // record highest roll + pitch command
-            if (_thrust_rpyt_out[i] > rp_high && (!_thrust_boost || i != _motor_lost_index)) {
-                rp_high = _thrust_rpyt_out[i];
-            }
-        }
-    }
+    const float rp_demand[AP_MotorsMixer::NUM_AXES] {roll_thrust, pitch_thrust};
+    _mixer.mix(rp_demand, thrust_out, rp_low, rp_high, lost_index);
 
     // include the lost motor scaled by _thrust_boost_ratio
-    if (_thrust_boost && motor_enabled[_motor_lost_index]) {
+    if (lost_index >= 0) {
         // record highest roll + pitch command
-        if (_thrust_rpyt_out[_motor_lost_index] > rp_high) {
-            rp_high = _thrust_boost_ratio * rp_high + (1.0f - _thrust_boost_ratio) * _thrust_rpyt_out[_motor_lost_index];
+        if (thrust_out[lost_index] > rp_high) {
+            rp_high = _thrust_boost_ratio * rp_high + (1.0f - _thrust_boost_ratio) * thrust_out[lost_index];
         }
     }
 
@@ -239,25 +231,13 @@ void AP_MotorsMatrix::output_armed_stabilizing()
     // add yaw control to thrust outputs
     float rpy_low = 1.0f;   // lowest thrust value
     float rpy_high = -1.0f; // highest thrust value
-    for (i = 0; i < AP_MOTORS_MAX_NUM_MOTORS; i++) {
-        if (motor_enabled[i]) {
-            _thrust_rpyt_out[i] = _thrust_rpyt_out[i] + yaw_thrust * _yaw_factor[i];
+    _mixer.add(AP_MotorsMixer::YAW, yaw_thrust, thrust_out, rpy_low, rpy_high, lost_index);
 
-            // record lowest roll + pitch + yaw command
-            if (_thrust_rpyt_out[i] < rpy_low) {
-                rpy_low = _thrust_rpyt_out[i];
-            }
-            // record highest roll + pitch + yaw command
-            if (_thrust_rpyt_out[i] > rpy_high && (!_thrust_boost || i != _motor_lost_index)) {
-                rpy_high = _thrust_rpyt_out[i];
-            }
-        }
-    }
     // include the lost motor scaled by _thrust_boost_ratio
-    if (_thrust_boost) {
+    if (lost_index >= 0) {
         // record highest roll + pitch + yaw command
-        if (_thrust_rpyt_out[_motor_lost_index] > rpy_high && motor_enabled[_motor_lost_index]) {
-            rpy_high = _thrust_boost_ratio * rpy_high + (1.0f - _thrust_boost_ratio) * _thrust_rpyt_out[_motor_lost_index];
+        if (thrust_out[lost_index] > rpy_high) {
+            rpy_high = _thrust_boost_ratio * rpy_high + (1.0f - _thrust_boost_ratio) * thrust_out[lost_index];
         }
     }
 
@@ -296,10 +276,8 @@ void AP_MotorsMatrix::output_armed_stabilizing()
     }
 
     // add scaled roll, pitch, constrained yaw and throttle for each motor
-    for (i = 0; i < AP_MOTORS_MAX_NUM_MOTORS; i++) {
-        if (motor_enabled[i]) {
-            _thrust_rpyt_out[i] = throttle_thrust_best_rpy + thr_adj + (rpy_scale * _thrust_rpyt_out[i]);
-        }
+    for (uint8_t i = 0; i < num_motors; i++) {
+        _thrust_rpyt_out[_mixer.get_motor_num(i)] = throttle_thrust_best_rpy + thr_adj + (rpy_scale * thrust_out[i]);
     }
 
     // check for failed motor
@@ -419,6 +397,10 @@ void AP_MotorsMatrix::add_motor_raw(int8_t motor_num, float roll_fac, float pitc
         _roll_factor[motor_num] = roll_fac;
         _pitch_factor[motor_num] = pitch_fac;
         _yaw_factor[motor_num] = yaw_fac;
+        _mixer.add_motor(motor_num);
+        _mixer.set_factor(motor_num, AP_MotorsMixer::ROLL, roll_fac);
+        _mixer.set_factor(motor_num, AP_MotorsMixer::PITCH, pitch_fac);
+        _mixer.set_factor(motor_num, AP_MotorsMixer::YAW, yaw_fac);
 
         // set order that motor appears in test
         _test_order[motor_num] = testing_order;
@@ -455,6 +437,7 @@ void AP_MotorsMatrix::remove_motor(int8_t motor_num)
         _roll_factor[motor_num] = 0;
         _pitch_factor[motor_num] = 0;
         _yaw_factor[motor_num] = 0;
+        _mixer.remove_motor(motor_num);
     }
 }
 
@@ -831,6 +814,9 @@ void AP_MotorsMatrix::normalise_rpy_factors()
             if (!is_zero(yaw_fac)) {
                 _yaw_factor[i] = 0.5f * _yaw_factor[i] / yaw_fac;
             }
+            _mixer.set_factor(i, AP_MotorsMixer::ROLL, _roll_factor[i]);
+            _mixer.set_factor(i, AP_MotorsMixer::PITCH, _pitch_factor[i]);
+            _mixer.set_factor(i, AP_MotorsMixer::YAW, _yaw_factor[i]);
         }
     }
 }
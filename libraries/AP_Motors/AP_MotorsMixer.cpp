@@ -0,0 +1,224 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AP_MotorsMixer.h"
+
+// remove all motors
+void AP_MotorsMixer::clear()
+{
+    _num_motors = 0;
+    memset(_factor, 0, sizeof(_factor));
+}
+
+// add a motor with all of its factors zero.  does nothing if the motor has already been added
+void AP_MotorsMixer::add_motor(uint8_t motor_num)
+{
+    if (motor_num >= MAX_MOTORS || get_index(motor_num) >= 0) {
+        return;
+    }
+
+    // find the packed index which keeps the motors in ascending order and shuffle the later motors up
+    uint8_t index = _num_motors;
+    while (index > 0 && _motor_num[index-1] > motor_num) {
+        _motor_num[index] = _motor_num[index-1];
+        for (uint8_t axis = 0; axis < NUM_AXES; axis++) {
+            _factor[axis][index] = _factor[axis][index-1];
+        }
+        index--;
+    }
+
+    _motor_num[index] = motor_num;
+    for (uint8_t axis = 0; axis < NUM_AXES; axis++) {
+        _factor[axis][index] = 0.0f;
+    }
+    _num_motors++;
+}
+
+// remove a motor
+void AP_MotorsMixer::remove_motor(uint8_t motor_num)
+{
+    const int8_t index = get_index(motor_num);
+    if (index < 0) {
+        return;
+    }
+
+    // shuffle the later motors down
+    for (uint8_t i = index; i < _num_motors - 1; i++) {
+        _motor_num[i] = _motor_num[i+1];
+        for (uint8_t axis = 0; axis < NUM_AXES; axis++) {
+            _factor[axis][i] = _factor[axis][i+1];
+        }
+    }
+    _num_motors--;
+    for (uint8_t axis = 0; axis < NUM_AXES; axis++) {
+        _factor[axis][_num_motors] = 0.0f;
+    }
+}
+
+// set a motor's factor for an axis.  the motor must have been added
+void AP_MotorsMixer::set_factor(uint8_t motor_num, Axis axis, float factor)
+{
+    const int8_t index = get_index(motor_num);
+    if (index < 0 || axis >= NUM_AXES) {
+        return;
+    }
+    _factor[axis][index] = factor;
+}
+
+// get a motor's factor for an axis, zero if the motor has not been added
+float AP_MotorsMixer::get_factor(uint8_t motor_num, Axis axis) const
+{
+    const int8_t index = get_index(motor_num);
+    if (index < 0 || axis >= NUM_AXES) {
+        return 0.0f;
+    }
+    return _factor[axis][index];
+}
+
+// get packed motor index of a motor number, -1 if the motor has not been added
+int8_t AP_MotorsMixer::get_index(uint8_t motor_num) const
+{
+    for (uint8_t i = 0; i < _num_motors; i++) {
+        if (_motor_num[i] == motor_num) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// calculate all factors from the actuator effectiveness matrix
+//   the factors are the Moore-Penrose pseudo-inverse, transpose(B) * inverse(B * transpose(B)), of the effectiveness B
+//   restricted to the axes the motors contribute to.  This gives the smallest motor outputs which achieve the demand
+bool AP_MotorsMixer::set_effectiveness(const float effectiveness[MAX_MOTORS][NUM_AXES])
+{
+    // find the axes which at least one motor contributes to
+    uint8_t axes[NUM_AXES];
+    uint8_t num_axes = 0;
+    for (uint8_t axis = 0; axis < NUM_AXES; axis++) {
+        for (uint8_t i = 0; i < _num_motors; i++) {
+            if (!is_zero(effectiveness[_motor_num[i]][axis])) {
+                axes[num_axes++] = axis;
+                break;
+            }
+        }
+    }
+    if (num_axes == 0 || num_axes > _num_motors) {
+        return false;
+    }
+
+    // B * transpose(B)
+    float bbt[NUM_AXES * NUM_AXES];
+    for (uint8_t row = 0; row < num_axes; row++) {
+        for (uint8_t col = 0; col < num_axes; col++) {
+            float sum = 0.0f;
+            for (uint8_t i = 0; i < _num_motors; i++) {
+                sum += effectiveness[_motor_num[i]][axes[row]] * effectiveness[_motor_num[i]][axes[col]];
+            }
+            bbt[row * num_axes + col] = sum;
+        }
+    }
+
+    float bbt_inv[NUM_AXES * NUM_AXES];
+    if (!inverse(bbt, bbt_inv, num_axes)) {
+        return false;
+    }
+
+    // transpose(B) * inverse(B * transpose(B))
+    memset(_factor, 0, sizeof(_factor));
+    for (uint8_t i = 0; i < _num_motors; i++) {
+        for (uint8_t col = 0; col < num_axes; col++) {
+            float sum = 0.0f;
+            for (uint8_t row = 0; row < num_axes; row++) {
+                sum += effectiveness[_motor_num[i]][axes[row]] * bbt_inv[row * num_axes + col];
+            }
+            _factor[axes[col]][i] = sum;
+        }
+    }
+    return true;
+}
+
+// scale each axis' factors so the largest magnitude is max_factor.  axes with no factors are unchanged
+void AP_MotorsMixer::normalise_factors(float max_factor)
+{
+    for (uint8_t axis = 0; axis < NUM_AXES; axis++) {
+        float largest = 0.0f;
+        for (uint8_t i = 0; i < _num_motors; i++) {
+            largest = MAX(largest, fabsf(_factor[axis][i]));
+        }
+        if (!is_positive(largest)) {
+            continue;
+        }
+        const float scale = max_factor / largest;
+        for (uint8_t i = 0; i < _num_motors; i++) {
+            _factor[axis][i] *= scale;
+        }
+    }
+}
+
+// mix the demands into the packed motor outputs, replacing their contents
+void AP_MotorsMixer::mix(const float demand[NUM_AXES], float out[]) const
+{
+    for (uint8_t i = 0; i < _num_motors; i++) {
+        out[i] = 0.0f;
+    }
+
+    // each axis is a single pass over contiguous factors, axes without a demand are skipped
+    for (uint8_t axis = 0; axis < NUM_AXES; axis++) {
+        if (is_zero(demand[axis])) {
+            continue;
+        }
+        const float *factor = _factor[axis];
+        const float d = demand[axis];
+        for (uint8_t i = 0; i < _num_motors; i++) {
+            out[i] += d * factor[i];
+        }
+    }
+}
+
+// mix the demands into the packed motor outputs, replacing their contents
+//   low and high are updated with the lowest and highest outputs, the output at index high_exclude is not included in high
+void AP_MotorsMixer::mix(const float demand[NUM_AXES], float out[], float &low, float &high, int8_t high_exclude) const
+{
+    mix(demand, out);
+    update_range(out, low, high, high_exclude);
+}
+
+// add a single axis demand to the packed motor outputs
+//   low and high are updated with the lowest and highest outputs, the output at index high_exclude is not included in high
+void AP_MotorsMixer::add(Axis axis, float demand, float out[], float &low, float &high, int8_t high_exclude) const
+{
+    if (axis >= NUM_AXES) {
+        return;
+    }
+    const float *factor = _factor[axis];
+    for (uint8_t i = 0; i < _num_motors; i++) {
+        out[i] += demand * factor[i];
+    }
+
+    update_range(out, low, high, high_exclude);
+}
+
+// update low and high from the packed motor outputs
+void AP_MotorsMixer::update_range(const float out[], float &low, float &high, int8_t high_exclude) const
+{
+    for (uint8_t i = 0; i < _num_motors; i++) {
+        if (out[i] < low) {
+            low = out[i];
+        }
+        if (out[i] > high && i != high_exclude) {
+            high = out[i];
+        }
+    }
+}
@@ -0,0 +1,90 @@
+/// @file	AP_MotorsMixer.h
+/// @brief	Table driven mixer from axis demands to motor thrusts
+#pragma once
+
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>        // ArduPilot Mega Vector/Matrix math Library
+
+/*
+ * The mixer holds each enabled motor's contribution from each axis demand
+ * (roll, pitch, yaw, throttle, forward and lateral) packed into one
+ * contiguous array per axis, so mixing only visits the motors which are
+ * actually in use and each axis is a single multiply-add pass the compiler
+ * can vectorise.  Motors are packed in ascending motor number order.
+ *
+ * The factors are either set directly (as the motors libraries have always
+ * done for their frames) or calculated once at setup from an actuator
+ * effectiveness matrix (each motor's contribution to each axis) using its
+ * pseudo-inverse.  This allows frames with tilted motors to be described by
+ * their geometry alone.
+ */
+class AP_MotorsMixer {
+public:
+
+    static const uint8_t MAX_MOTORS = 12;
+
+    enum Axis : uint8_t {
+        ROLL = 0,
+        PITCH,
+        YAW,
+        THROTTLE,
+        FORWARD,
+        LATERAL,
+        NUM_AXES
+    };
+
+    AP_MotorsMixer() { clear(); }
+
+    // remove all motors
+    void clear();
+
+    // add a motor with all of its factors zero.  does nothing if the motor has already been added
+    void add_motor(uint8_t motor_num);
+
+    // remove a motor
+    void remove_motor(uint8_t motor_num);
+
+    // set a motor's factor for an axis.  the motor must have been added
+    void set_factor(uint8_t motor_num, Axis axis, float factor);
+
+    // get a motor's factor for an axis, zero if the motor has not been added
+    float get_factor(uint8_t motor_num, Axis axis) const;
+
+    // calculate all factors from the actuator effectiveness matrix
+    //   effectiveness holds each motor's contribution to each axis indexed by motor number, only added motors are used
+    //   axes which no motor contributes to are left with zero factors
+    //   returns false and leaves the factors unchanged if the axes cannot be controlled independently
+    bool set_effectiveness(const float effectiveness[MAX_MOTORS][NUM_AXES]);
+
+    // scale each axis' factors so the largest magnitude is max_factor.  axes with no factors are unchanged
+    void normalise_factors(float max_factor);
+
+    // number of motors in the mixer
+    uint8_t get_num_motors() const { return _num_motors; }
+
+    // get motor number of a packed motor index
+    uint8_t get_motor_num(uint8_t index) const { return _motor_num[index]; }
+
+    // get packed motor index of a motor number, -1 if the motor has not been added
+    int8_t get_index(uint8_t motor_num) const;
+
+    // mix the demands into the packed motor outputs, replacing their contents
+    void mix(const float demand[NUM_AXES], float out[]) const;
+
+    // mix the demands into the packed motor outputs, replacing their contents
+    //   low and high are updated with the lowest and highest outputs, the output at index high_exclude is not included in high
+    void mix(const float demand[NUM_AXES], float out[], float &low, float &high, int8_t high_exclude = -1) const;
+
+    // add a single axis demand to the packed motor outputs
+    //   low and high are updated with the lowest and highest outputs, the output at index high_exclude is not included in high
+    void add(Axis axis, float demand, float out[], float &low, float &high, int8_t high_exclude = -1) const;
+
+private:
+
+    // update low and high from the packed motor outputs
+    void update_range(const float out[], float &low, float &high, int8_t high_exclude) const;
+
+    uint8_t _num_motors;                        // number of motors packed into the arrays below
+    uint8_t _motor_num[MAX_MOTORS];             // motor number of each packed motor
+    float   _factor[NUM_AXES][MAX_MOTORS];      // each packed motor's contribution from each axis demand
+};
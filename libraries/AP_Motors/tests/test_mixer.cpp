@@ -0,0 +1,142 @@
+#include <AP_gtest.h>
+
+#include <AP_Motors/AP_MotorsMixer.h>
+
+const AP_HAL::HAL &hal = AP_HAL::get_HAL();
+
+// motors are packed in ascending motor number order however they are added
+TEST(MotorsMixerTest, Packing)
+{
+    AP_MotorsMixer mixer;
+    mixer.add_motor(5);
+    mixer.add_motor(1);
+    mixer.add_motor(3);
+    mixer.add_motor(3);
+    EXPECT_EQ(3, mixer.get_num_motors());
+    EXPECT_EQ(1, mixer.get_motor_num(0));
+    EXPECT_EQ(3, mixer.get_motor_num(1));
+    EXPECT_EQ(5, mixer.get_motor_num(2));
+
+    mixer.set_factor(5, AP_MotorsMixer::ROLL, 0.5f);
+    mixer.remove_motor(3);
+    EXPECT_EQ(2, mixer.get_num_motors());
+    EXPECT_EQ(-1, mixer.get_index(3));
+    EXPECT_EQ(1, mixer.get_index(5));
+    EXPECT_FLOAT_EQ(0.5f, mixer.get_factor(5, AP_MotorsMixer::ROLL));
+    EXPECT_FLOAT_EQ(0.0f, mixer.get_factor(3, AP_MotorsMixer::ROLL));
+}
+
+// mixing and adding a single axis track the range of the outputs
+TEST(MotorsMixerTest, Mix)
+{
+    AP_MotorsMixer mixer;
+    const float roll[] = {-0.5f, 0.5f, 0.5f, -0.5f};
+    const float yaw[] = {0.5f, 0.5f, -0.5f, -0.5f};
+    for (uint8_t i = 0; i < 4; i++) {
+        mixer.add_motor(i);
+        mixer.set_factor(i, AP_MotorsMixer::ROLL, roll[i]);
+        mixer.set_factor(i, AP_MotorsMixer::YAW, yaw[i]);
+    }
+
+    const float demand[AP_MotorsMixer::NUM_AXES] {0.2f};
+    float out[AP_MotorsMixer::MAX_MOTORS];
+    float low = 1.0f;
+    float high = -1.0f;
+    mixer.mix(demand, out, low, high);
+    EXPECT_FLOAT_EQ(-0.1f, out[0]);
+    EXPECT_FLOAT_EQ(0.1f, out[1]);
+    EXPECT_FLOAT_EQ(-0.1f, low);
+    EXPECT_FLOAT_EQ(0.1f, high);
+
+    // highest output is excluded from the high value
+    low = 1.0f;
+    high = -1.0f;
+    mixer.add(AP_MotorsMixer::YAW, 0.2f, out, low, high, 1);
+    EXPECT_FLOAT_EQ(0.2f, out[1]);
+    EXPECT_FLOAT_EQ(-0.2f, out[3]);
+    EXPECT_FLOAT_EQ(-0.2f, low);
+    EXPECT_FLOAT_EQ(0.0f, high);
+}
+
+// factors calculated from the effectiveness of a quad X recreate the demand
+TEST(MotorsMixerTest, Effectiveness)
+{
+    AP_MotorsMixer mixer;
+    float effectiveness[AP_MotorsMixer::MAX_MOTORS][AP_MotorsMixer::NUM_AXES] {};
+    const float angle_deg[] = {45.0f, -135.0f, -45.0f, 135.0f};
+    const float yaw[] = {1.0f, 1.0f, -1.0f, -1.0f};
+    for (uint8_t i = 0; i < 4; i++) {
+        mixer.add_motor(i);
+        effectiveness[i][AP_MotorsMixer::ROLL] = -sinf(radians(angle_deg[i]));
+        effectiveness[i][AP_MotorsMixer::PITCH] = cosf(radians(angle_deg[i]));
+        effectiveness[i][AP_MotorsMixer::YAW] = yaw[i];
+        effectiveness[i][AP_MotorsMixer::THROTTLE] = 1.0f;
+    }
+    EXPECT_TRUE(mixer.set_effectiveness(effectiveness));
+
+    // unused axes have no factors
+    EXPECT_FLOAT_EQ(0.0f, mixer.get_factor(0, AP_MotorsMixer::FORWARD));
+
+    const float demand[AP_MotorsMixer::NUM_AXES] {0.1f, -0.2f, 0.05f, 0.6f};
+    float out[AP_MotorsMixer::MAX_MOTORS];
+    float low = 1.0f;
+    float high = -1.0f;
+    mixer.mix(demand, out, low, high);
+    for (uint8_t axis = 0; axis < AP_MotorsMixer::FORWARD; axis++) {
+        float achieved = 0.0f;
+        for (uint8_t i = 0; i < 4; i++) {
+            achieved += effectiveness[i][axis] * out[i];
+        }
+        EXPECT_NEAR(demand[axis], achieved, 1.0e-5f);
+    }
+}
+
+// normalised factors of a frame with independent, evenly driven axes are its effectiveness
+TEST(MotorsMixerTest, NormalisedEffectiveness)
+{
+    // vectored 6DOF ROV: four vectored horizontal thrusters and four vertical thrusters
+    static const float effectiveness[][AP_MotorsMixer::NUM_AXES] = {
+        { 0,     0,     1.0f,  0,     -1.0f, 1.0f  },
+        { 0,     0,     -1.0f, 0,     -1.0f, -1.0f },
+        { 0,     0,     -1.0f, 0,     1.0f,  1.0f  },
+        { 0,     0,     1.0f,  0,     1.0f,  -1.0f },
+        { 1.0f,  -1.0f, 0,     -1.0f, 0,     0     },
+        { -1.0f, -1.0f, 0,     -1.0f, 0,     0     },
+        { 1.0f,  1.0f,  0,     -1.0f, 0,     0     },
+        { -1.0f, 1.0f,  0,     -1.0f, 0,     0     },
+    };
+    AP_MotorsMixer mixer;
+    float motor_effectiveness[AP_MotorsMixer::MAX_MOTORS][AP_MotorsMixer::NUM_AXES] {};
+    for (uint8_t i = 0; i < ARRAY_SIZE(effectiveness); i++) {
+        mixer.add_motor(i);
+        memcpy(motor_effectiveness[i], effectiveness[i], sizeof(motor_effectiveness[i]));
+    }
+    EXPECT_TRUE(mixer.set_effectiveness(motor_effectiveness));
+
+    // the pseudo-inverse shares each axis between the four motors driving it
+    EXPECT_FLOAT_EQ(0.25f, mixer.get_factor(0, AP_MotorsMixer::YAW));
+
+    mixer.normalise_factors(1.0f);
+    for (uint8_t i = 0; i < ARRAY_SIZE(effectiveness); i++) {
+        for (uint8_t axis = 0; axis < AP_MotorsMixer::NUM_AXES; axis++) {
+            EXPECT_NEAR(effectiveness[i][axis], mixer.get_factor(i, (AP_MotorsMixer::Axis)axis), 1.0e-5f);
+        }
+    }
+}
+
+// more axes than motors cannot be controlled
+TEST(MotorsMixerTest, Underactuated)
+{
+    AP_MotorsMixer mixer;
+    float effectiveness[AP_MotorsMixer::MAX_MOTORS][AP_MotorsMixer::NUM_AXES] {};
+    mixer.add_motor(0);
+    mixer.add_motor(1);
+    effectiveness[0][AP_MotorsMixer::ROLL] = 1.0f;
+    effectiveness[1][AP_MotorsMixer::PITCH] = 1.0f;
+    effectiveness[1][AP_MotorsMixer::YAW] = 1.0f;
+    mixer.set_factor(0, AP_MotorsMixer::ROLL, 0.5f);
+    EXPECT_FALSE(mixer.set_effectiveness(effectiveness));
+    EXPECT_FLOAT_EQ(0.5f, mixer.get_factor(0, AP_MotorsMixer::ROLL));
+}
+
+AP_GTEST_MAIN()
@@ -44,35 +44,43 @@ void AP_Proximity_AirSimSITL::update(void)
 
     set_status(AP_Proximity::Proximity_Good);
 
-    memset(_distance_valid, 0, sizeof(_distance_valid));
-    memset(_angle, 0, sizeof(_angle));
-    memset(_distance, 0, sizeof(_distance));
-
-    // only use 8 sectors to match RPLidar
-    const uint8_t nsectors = MIN(8, PROXIMITY_SECTORS_MAX);
-    const uint16_t degrees_per_sector = 360 / nsectors;
+    // points are re-binned into the boundary's faces on every update
+    _boundary.reset();
 
     for (uint16_t i=0; i<points.length; i++) {
         Vector3f &point = points.data[i];
         if (point.is_zero()) {
             continue;
         }
-        float angle_deg = wrap_360(degrees(atan2f(-point.y, point.x)));
-        uint16_t angle_rounded = uint16_t(angle_deg+0.5);
-        uint8_t sector = wrap_360(angle_rounded + 22.5f) / degrees_per_sector;
-        if (!_distance_valid[sector] || PROXIMITY_MAX_RANGE < _distance[sector]) {
-            _distance_valid[sector] = true;
-            const Vector2f v = Vector2f(point.x, point.y);
-            _distance[sector] = v.length();
-            _angle[sector] = angle_deg;
-            update_boundary_for_sector(sector, true);
+        // points are x forward, y left and z up
+        const float angle_deg = wrap_360(degrees(atan2f(-point.y, point.x)));
+        const float pitch_deg = degrees(atan2f(point.z, norm(point.x, point.y)));
+        const float distance = point.length();
+        if (distance > PROXIMITY_MAX_RANGE) {
+            continue;
+        }
+        const AP_Proximity_Boundary_3D::Face face = _boundary.get_face(pitch_deg, angle_deg);
+        float face_distance;
+        if (!_boundary.get_distance(face, face_distance) || distance < face_distance) {
+            _boundary.set_face_attributes(face, pitch_deg, angle_deg, distance);
+        }
+    }
+
+    // update Object Avoidance database with the closest horizontal object in each sector
+    for (uint8_t i=0; i<PROXIMITY_NUM_SECTORS; i++) {
+        float angle_deg, distance;
+        if (_boundary.get_horizontal_distance(i, angle_deg, distance)) {
+            database_push(angle_deg, distance);
         }
     }
 
 #if 0
     printf("npoints=%u\n", points.length);
-    for (uint16_t i=0; i<nsectors; i++) {
-        printf("sector[%u] ang=%.1f dist=%.1f\n", i, _angle[i], _distance[i]);
+    for (uint16_t i=0; i<PROXIMITY_NUM_SECTORS; i++) {
+        float angle_deg, distance;
+        if (_boundary.get_horizontal_distance(i, angle_deg, distance)) {
+            printf("sector[%u] ang=%.1f dist=%.1f\n", i, angle_deg, distance);
+        }
     }
 #endif
 }
@@ -88,11 +96,4 @@ float AP_Proximity_AirSimSITL::distance_min() const
     return 0.0f;
 }
 
-// get distance upwards in meters. returns true on success
-bool AP_Proximity_AirSimSITL::get_upward_distance(float &distance) const
-{
-    // we don't have an upward facing laser
-    return false;
-}
-
 #endif // CONFIG_HAL_BOARD
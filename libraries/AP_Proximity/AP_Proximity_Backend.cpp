@@ -29,21 +29,13 @@ AP_Proximity_Backend::AP_Proximity_Backend(AP_Proximity &_frontend, AP_Proximity
         frontend(_frontend),
         state(_state)
 {
-    // initialise sector edge vector used for building the boundary fence
-    init_boundary();
 }
 
 // get distance in meters in a particular direction in degrees (0 is forward, angles increase in the clockwise direction)
 bool AP_Proximity_Backend::get_horizontal_distance(float angle_deg, float &distance) const
 {
-    uint8_t sector;
-    if (convert_angle_to_sector(angle_deg, sector)) {
-        if (_distance_valid[sector]) {
-            distance = _distance[sector];
-            return true;
-        }
-    }
-    return false;
+    float sector_angle_deg;
+    return _boundary.get_horizontal_distance(_boundary.get_face(angle_deg).sector, sector_angle_deg, distance);
 }
 
 // get distance and angle to closest object (used for pre-arm check)
@@ -51,55 +43,40 @@ bool AP_Proximity_Backend::get_horizontal_distance(float angle_deg, float &dista
 bool AP_Proximity_Backend::get_closest_object(float& angle_deg, float &distance) const
 {
     bool sector_found = false;
-    uint8_t sector = 0;
 
     // check all sectors for shorter distance
-    for (uint8_t i=0; i<_num_sectors; i++) {
-        if (_distance_valid[i]) {
-            if (!sector_found || (_distance[i] < _distance[sector])) {
-                sector = i;
+    for (uint8_t i=0; i<PROXIMITY_NUM_SECTORS; i++) {
+        float sector_angle_deg, sector_distance;
+        if (_boundary.get_horizontal_distance(i, sector_angle_deg, sector_distance)) {
+            if (!sector_found || (sector_distance < distance)) {
+                angle_deg = sector_angle_deg;
+                distance = sector_distance;
                 sector_found = true;
             }
         }
     }
 
-    if (sector_found) {
-        angle_deg = _angle[sector];
-        distance = _distance[sector];
-    }
     return sector_found;
 }
 
 // get number of objects, used for non-GPS avoidance
 uint8_t AP_Proximity_Backend::get_object_count() const
 {
-    return _num_sectors;
+    return PROXIMITY_NUM_SECTORS;
 }
 
 // get an object's angle and distance, used for non-GPS avoidance
 // returns false if no angle or distance could be returned for some reason
 bool AP_Proximity_Backend::get_object_angle_and_distance(uint8_t object_number, float& angle_deg, float &distance) const
 {
-    if (object_number < _num_sectors && _distance_valid[object_number]) {
-        angle_deg = _angle[object_number];
-        distance = _distance[object_number];
-        return true;
-    }
-    return false;
+    return _boundary.get_horizontal_distance(object_number, angle_deg, distance);
 }
 
 // get distances in PROXIMITY_MAX_DIRECTION directions. used for sending distances to ground station
 bool AP_Proximity_Backend::get_horizontal_distances(AP_Proximity::Proximity_Distance_Array &prx_dist_array) const
 {
     // exit immediately if we have no good ranges
-    bool valid_distances = false;
-    for (uint8_t i=0; i<_num_sectors; i++) {
-        if (_distance_valid[i]) {
-            valid_distances = true;
-            break;
-        }
-    }
-    if (!valid_distances) {
+    if (!_boundary.has_horizontal_distances()) {
         return false;
     }
 
@@ -113,12 +90,13 @@ bool AP_Proximity_Backend::get_horizontal_distances(AP_Proximity::Proximity_Dist
     }
 
     // cycle through all sectors filling in distances
-    for (uint8_t i=0; i<_num_sectors; i++) {
-        if (_distance_valid[i]) {
+    for (uint8_t i=0; i<PROXIMITY_NUM_SECTORS; i++) {
+        float angle_deg, distance;
+        if (_boundary.get_horizontal_distance(i, angle_deg, distance)) {
             // convert angle to orientation
-            int16_t orientation = static_cast<int16_t>(_angle[i] * (PROXIMITY_MAX_DIRECTION / 360.0f));
-            if ((orientation >= 0) && (orientation < PROXIMITY_MAX_DIRECTION) && (_distance[i] < prx_dist_array.distance[orientation])) {
-                prx_dist_array.distance[orientation] = _distance[i];
+            int16_t orientation = static_cast<int16_t>(angle_deg * (PROXIMITY_MAX_DIRECTION / 360.0f));
+            if ((orientation >= 0) && (orientation < PROXIMITY_MAX_DIRECTION) && (distance < prx_dist_array.distance[orientation])) {
+                prx_dist_array.distance[orientation] = distance;
                 dist_set[orientation] = true;
             }
         }
@@ -147,39 +125,19 @@ const Vector2f* AP_Proximity_Backend::get_boundary_points(uint16_t& num_points)
         return nullptr;
     }
 
-    // check at least one sector has valid data, if not, exit
-    bool some_valid = false;
-    for (uint8_t i=0; i<_num_sectors; i++) {
-        if (_distance_valid[i]) {
-            some_valid = true;
-            break;
-        }
-    }
-    if (!some_valid) {
-        num_points = 0;
-        return nullptr;
-    }
-
-    // return boundary points
-    num_points = _num_sectors;
-    return _boundary_point;
+    // boundary is maintained as faces are updated so this is just a lookup
+    return _boundary.get_boundary_points(num_points);
 }
 
-// initialise the boundary and sector_edge_vector array used for object avoidance
+// clear the boundary used for object avoidance
 //   should be called if the sector_middle_deg or _setor_width_deg arrays are changed
 void AP_Proximity_Backend::init_boundary()
 {
-    for (uint8_t sector=0; sector < _num_sectors; sector++) {
-        float angle_rad = radians((float)_sector_middle_deg[sector]+(float)_sector_width_deg[sector]/2.0f);
-        _sector_edge_vector[sector].x = cosf(angle_rad) * 100.0f;
-        _sector_edge_vector[sector].y = sinf(angle_rad) * 100.0f;
-        _boundary_point[sector] = _sector_edge_vector[sector] * PROXIMITY_BOUNDARY_DIST_DEFAULT;
-    }
+    _boundary.reset();
 }
 
-// update boundary points used for object avoidance based on a single sector's distance changing
-//   the boundary points lie on the line between sectors meaning two boundary points may be updated based on a single sector's distance changing
-//   the boundary point is set to the shortest distance found in the two adjacent sectors, this is a conservative boundary around the vehicle
+// update the boundary used for object avoidance from a single sector's distance
+//   the sector's closest object is set on the horizontal face of the 3D boundary holding it
 void AP_Proximity_Backend::update_boundary_for_sector(const uint8_t sector, const bool push_to_OA_DB)
 {
     // sanity check
@@ -191,47 +149,37 @@ void AP_Proximity_Backend::update_boundary_for_sector(const uint8_t sector, cons
         database_push(_angle[sector], _distance[sector]);
     }
 
-    // find adjacent sector (clockwise)
-    uint8_t next_sector = sector + 1;
-    if (next_sector >= _num_sectors) {
-        next_sector = 0;
-    }
-
-    // boundary point lies on the line between the two sectors at the shorter distance found in the two sectors
-    float shortest_distance = PROXIMITY_BOUNDARY_DIST_DEFAULT;
-    if (_distance_valid[sector] && _distance_valid[next_sector]) {
-        shortest_distance = MIN(_distance[sector], _distance[next_sector]);
-    } else if (_distance_valid[sector]) {
-        shortest_distance = _distance[sector];
-    } else if (_distance_valid[next_sector]) {
-        shortest_distance = _distance[next_sector];
-    }
-    if (shortest_distance < PROXIMITY_BOUNDARY_DIST_MIN) {
-        shortest_distance = PROXIMITY_BOUNDARY_DIST_MIN;
+    // faces to recalculate are those holding this sector's earlier object and the face holding its new object.
+    // Sectors may be wider than the boundary's faces so this may be several faces
+    bool recalc_face[PROXIMITY_NUM_SECTORS] {};
+    for (uint8_t i=0; i<PROXIMITY_NUM_SECTORS; i++) {
+        float face_distance;
+        recalc_face[i] = (_face_source_sector[i] == sector) && _boundary.get_distance(AP_Proximity_Boundary_3D::Face(PROXIMITY_MIDDLE_LAYER, i), face_distance);
     }
-    _boundary_point[sector] = _sector_edge_vector[sector] * shortest_distance;
-
-    // if the next sector (clockwise) has an invalid distance, set boundary to create a cup like boundary
-    if (!_distance_valid[next_sector]) {
-        _boundary_point[next_sector] = _sector_edge_vector[next_sector] * shortest_distance;
-    }
-
-    // repeat for edge between sector and previous sector
-    uint8_t prev_sector = (sector == 0) ? _num_sectors-1 : sector-1;
-    shortest_distance = PROXIMITY_BOUNDARY_DIST_DEFAULT;
-    if (_distance_valid[prev_sector] && _distance_valid[sector]) {
-        shortest_distance = MIN(_distance[prev_sector], _distance[sector]);
-    } else if (_distance_valid[prev_sector]) {
-        shortest_distance = _distance[prev_sector];
-    } else if (_distance_valid[sector]) {
-        shortest_distance = _distance[sector];
+    if (_distance_valid[sector]) {
+        recalc_face[_boundary.get_face(_angle[sector]).sector] = true;
     }
-    _boundary_point[prev_sector] = _sector_edge_vector[prev_sector] * shortest_distance;
 
-    // if the sector counter-clockwise from the previous sector has an invalid distance, set boundary to create a cup like boundary
-    uint8_t prev_sector_ccw = (prev_sector == 0) ? _num_sectors-1 : prev_sector-1;
-    if (!_distance_valid[prev_sector_ccw]) {
-        _boundary_point[prev_sector_ccw] = _sector_edge_vector[prev_sector_ccw] * shortest_distance;
+    // set each face to the closest object of all sectors falling within it, so an
+    // object hidden by a closer one from another sector reappears when that one clears
+    for (uint8_t i=0; i<PROXIMITY_NUM_SECTORS; i++) {
+        if (!recalc_face[i]) {
+            continue;
+        }
+        const AP_Proximity_Boundary_3D::Face face(PROXIMITY_MIDDLE_LAYER, i);
+        uint8_t closest_sector = _num_sectors;
+        for (uint8_t s=0; s<_num_sectors; s++) {
+            if (_distance_valid[s] && (_boundary.get_face(_angle[s]) == face) &&
+                ((closest_sector >= _num_sectors) || (_distance[s] < _distance[closest_sector]))) {
+                closest_sector = s;
+            }
+        }
+        if (closest_sector < _num_sectors) {
+            _boundary.set_face_attributes(face, 0.0f, _angle[closest_sector], _distance[closest_sector]);
+        } else {
+            _boundary.reset_face(face);
+        }
+        _face_source_sector[i] = closest_sector;
     }
 }
 
@@ -283,6 +231,19 @@ bool AP_Proximity_Backend::convert_angle_to_sector(float angle_degrees, uint8_t
     return false;
 }
 
+// returns true if a reading at angle_deg (0 is forward, clockwise) falls within a user defined ignore area
+bool AP_Proximity_Backend::ignore_reading(float angle_deg) const
+{
+    for (uint8_t i=0; i < PROXIMITY_MAX_IGNORE; i++) {
+        if (frontend._ignore_width_deg[i] != 0) {
+            if (fabsf(wrap_180(angle_deg - frontend._ignore_angle_deg[i])) <= frontend._ignore_width_deg[i] * 0.5f) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
 // get ignore area info
 uint8_t AP_Proximity_Backend::get_ignore_area_count() const
 {
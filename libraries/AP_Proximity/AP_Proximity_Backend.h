@@ -17,11 +17,10 @@
 #include <AP_Common/AP_Common.h>
 #include <AP_HAL/AP_HAL.h>
 #include "AP_Proximity.h"
+#include "AP_Proximity_Boundary_3D.h"
 #include <AP_Common/Location.h>
 
-#define PROXIMITY_SECTORS_MAX   12  // maximum number of sectors
-#define PROXIMITY_BOUNDARY_DIST_MIN 0.6f    // minimum distance for a boundary point.  This ensures the object avoidance code doesn't think we are outside the boundary.
-#define PROXIMITY_BOUNDARY_DIST_DEFAULT 100 // if we have no data for a sector, boundary is placed 100m out
+#define PROXIMITY_SECTORS_MAX   12  // maximum number of sectors for sensors which report per-sector distances
 
 class AP_Proximity_Backend
 {
@@ -41,7 +40,7 @@ public:
     virtual float distance_min() const = 0;
 
     // get distance upwards in meters. returns true on success
-    virtual bool get_upward_distance(float &distance) const { return false; }
+    virtual bool get_upward_distance(float &distance) const { return _boundary.get_upward_distance(distance); }
 
     // handle mavlink DISTANCE_SENSOR messages
     virtual void handle_msg(const mavlink_message_t &msg) {}
@@ -73,16 +72,16 @@ protected:
     // find which sector a given angle falls into
     bool convert_angle_to_sector(float angle_degrees, uint8_t &sector) const;
 
-    // initialise the boundary and sector_edge_vector array used for object avoidance
+    // clear the boundary used for object avoidance
     //   should be called if the sector_middle_deg or _setor_width_deg arrays are changed
     void init_boundary();
 
-    // update boundary points used for object avoidance based on a single sector's distance changing
-    //   the boundary points lie on the line between sectors meaning two boundary points may be updated based on a single sector's distance changing
-    //   the boundary point is set to the shortest distance found in the two adjacent sectors, this is a conservative boundary around the vehicle
+    // update the boundary used for object avoidance from a single sector's distance
+    //   the sector's closest object is set on the horizontal face of the 3D boundary holding it
     void update_boundary_for_sector(const uint8_t sector, const bool push_to_OA_DB);
 
     // get ignore area info
+    bool ignore_reading(float angle_deg) const;
     uint8_t get_ignore_area_count() const;
     bool get_ignore_area(uint8_t index, uint16_t &angle_deg, uint8_t &width_deg) const;
     bool get_next_ignore_start_or_end(uint8_t start_or_end, int16_t start_angle, int16_t &ignore_start) const;
@@ -95,7 +94,12 @@ protected:
     AP_Proximity &frontend;
     AP_Proximity::Proximity_State &state;   // reference to this instances state
 
-    // sectors
+    // 3D boundary around the vehicle used by all queries.  Sensors
+    // producing many readings (or readings outside the horizontal
+    // plane) should update its faces directly
+    AP_Proximity_Boundary_3D _boundary;
+
+    // sectors for sensors which report per-sector distances
     uint8_t _num_sectors = PROXIMITY_MAX_DIRECTION;
     uint16_t _sector_middle_deg[PROXIMITY_SECTORS_MAX] = {0, 45, 90, 135, 180, 225, 270, 315, 0, 0, 0, 0};  // middle angle of each sector
     uint8_t _sector_width_deg[PROXIMITY_SECTORS_MAX] = {45, 45, 45, 45, 45, 45, 45, 45, 0, 0, 0, 0};        // width (in degrees) of each sector
@@ -104,8 +108,5 @@ protected:
     float _angle[PROXIMITY_SECTORS_MAX];            // angle to closest object within each sector
     float _distance[PROXIMITY_SECTORS_MAX];         // distance to closest object within each sector
     bool _distance_valid[PROXIMITY_SECTORS_MAX];    // true if a valid distance received for each sector
-
-    // fence boundary
-    Vector2f _sector_edge_vector[PROXIMITY_SECTORS_MAX];    // vector for right-edge of each sector, used to speed up calculation of boundary
-    Vector2f _boundary_point[PROXIMITY_SECTORS_MAX];        // bounding polygon around the vehicle calculated conservatively for object avoidance
+    uint8_t _face_source_sector[PROXIMITY_NUM_SECTORS];    // sector whose object each horizontal face of _boundary holds, only meaningful while the face is valid
 };
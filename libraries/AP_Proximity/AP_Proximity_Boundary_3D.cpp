@@ -0,0 +1,258 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AP_Proximity_Boundary_3D.h"
+
+// the top and bottom layers provide the upward and downward distances, all others the horizontal boundary.
+// with a single layer it is used for the horizontal boundary only
+#define PROXIMITY_HORIZONTAL_LAYER_FIRST    ((PROXIMITY_NUM_LAYERS > 1) ? 1 : 0)
+#define PROXIMITY_HORIZONTAL_LAYER_LAST     ((PROXIMITY_NUM_LAYERS > 1) ? (PROXIMITY_NUM_LAYERS - 2) : 0)
+#define PROXIMITY_TOP_LAYER                 (PROXIMITY_NUM_LAYERS - 1)
+#define PROXIMITY_BOTTOM_LAYER              0
+
+AP_Proximity_Boundary_3D::AP_Proximity_Boundary_3D()
+{
+    // initialise sector edge vector used for building the boundary fence
+    for (uint8_t sector=0; sector < PROXIMITY_NUM_SECTORS; sector++) {
+        const float angle_rad = radians(sector * PROXIMITY_SECTOR_WIDTH_DEG + PROXIMITY_SECTOR_WIDTH_DEG * 0.5f);
+        _sector_edge_vector[sector].x = cosf(angle_rad) * 100.0f;
+        _sector_edge_vector[sector].y = sinf(angle_rad) * 100.0f;
+    }
+    reset();
+}
+
+// get the sector holding a body-frame yaw in degrees
+uint8_t AP_Proximity_Boundary_3D::get_sector(float yaw) const
+{
+    // sector 0 is centred on forward
+    const uint16_t sector = wrap_360(yaw + PROXIMITY_SECTOR_WIDTH_DEG * 0.5f) * (1.0f / PROXIMITY_SECTOR_WIDTH_DEG);
+    return MIN(sector, PROXIMITY_NUM_SECTORS - 1);
+}
+
+// get the face holding a body-frame pitch and yaw (both in degrees)
+AP_Proximity_Boundary_3D::Face AP_Proximity_Boundary_3D::get_face(float pitch, float yaw) const
+{
+    // layer 0 starts straight down
+    const uint16_t layer = (constrain_float(pitch, -90.0f, 90.0f) + 90.0f) * (1.0f / PROXIMITY_LAYER_HEIGHT_DEG);
+    return Face(MIN(layer, PROXIMITY_NUM_LAYERS - 1), get_sector(yaw));
+}
+
+// set a face's closest object and update the boundary
+void AP_Proximity_Boundary_3D::set_face_attributes(const Face &face, float pitch, float yaw, float distance)
+{
+    if (!face.valid()) {
+        return;
+    }
+
+    _distance[face.layer][face.sector] = distance;
+    _angle[face.layer][face.sector] = yaw;
+    _pitch[face.layer][face.sector] = pitch;
+    _distance_valid[face.layer][face.sector] = true;
+
+    if ((face.layer >= PROXIMITY_HORIZONTAL_LAYER_FIRST) && (face.layer <= PROXIMITY_HORIZONTAL_LAYER_LAST)) {
+        update_horizontal(face.sector);
+    } else {
+        update_vertical(face.layer);
+    }
+}
+
+// mark a face as having no valid object and update the boundary
+void AP_Proximity_Boundary_3D::reset_face(const Face &face)
+{
+    if (!face.valid() || !_distance_valid[face.layer][face.sector]) {
+        return;
+    }
+
+    _distance_valid[face.layer][face.sector] = false;
+
+    if ((face.layer >= PROXIMITY_HORIZONTAL_LAYER_FIRST) && (face.layer <= PROXIMITY_HORIZONTAL_LAYER_LAST)) {
+        update_horizontal(face.sector);
+    } else {
+        update_vertical(face.layer);
+    }
+}
+
+// mark all faces as having no valid object
+void AP_Proximity_Boundary_3D::reset()
+{
+    memset(_distance_valid, 0, sizeof(_distance_valid));
+    memset(_horizontal_valid, 0, sizeof(_horizontal_valid));
+    _horizontal_valid_count = 0;
+    _upward_valid = false;
+    _downward_valid = false;
+    for (uint8_t sector=0; sector < PROXIMITY_NUM_SECTORS; sector++) {
+        _boundary_point[sector] = _sector_edge_vector[sector] * PROXIMITY_BOUNDARY_DIST_DEFAULT;
+    }
+}
+
+// get a face's distance to its closest object. returns false if the face has no valid object
+bool AP_Proximity_Boundary_3D::get_distance(const Face &face, float &distance) const
+{
+    if (!face.valid() || !_distance_valid[face.layer][face.sector]) {
+        return false;
+    }
+    distance = _distance[face.layer][face.sector];
+    return true;
+}
+
+// get a face's yaw to its closest object. returns false if the face has no valid object
+bool AP_Proximity_Boundary_3D::get_angle(const Face &face, float &yaw) const
+{
+    if (!face.valid() || !_distance_valid[face.layer][face.sector]) {
+        return false;
+    }
+    yaw = _angle[face.layer][face.sector];
+    return true;
+}
+
+// get the closest horizontal distance and its yaw within a sector. returns false if the sector has no valid objects
+bool AP_Proximity_Boundary_3D::get_horizontal_distance(uint8_t sector, float &yaw, float &distance) const
+{
+    if (sector >= PROXIMITY_NUM_SECTORS || !_horizontal_valid[sector]) {
+        return false;
+    }
+    yaw = _horizontal_angle[sector];
+    distance = _horizontal_distance[sector];
+    return true;
+}
+
+// get the body-frame polygon (in cm) around the vehicle used by simple avoidance
+//   returns nullptr and sets num_points to zero if no boundary can be returned
+const Vector2f* AP_Proximity_Boundary_3D::get_boundary_points(uint16_t &num_points) const
+{
+    if (!has_horizontal_distances()) {
+        num_points = 0;
+        return nullptr;
+    }
+    num_points = PROXIMITY_NUM_SECTORS;
+    return _boundary_point;
+}
+
+// get the vertical distance (in meters) to the closest object above the vehicle.  returns true on success
+bool AP_Proximity_Boundary_3D::get_upward_distance(float &distance) const
+{
+    if (!_upward_valid) {
+        return false;
+    }
+    distance = _upward_distance;
+    return true;
+}
+
+// get the vertical distance (in meters) to the closest object below the vehicle.  returns true on success
+bool AP_Proximity_Boundary_3D::get_downward_distance(float &distance) const
+{
+    if (!_downward_valid) {
+        return false;
+    }
+    distance = _downward_distance;
+    return true;
+}
+
+// recalculate a sector's closest horizontal distance from its horizontal layers
+void AP_Proximity_Boundary_3D::update_horizontal(uint8_t sector)
+{
+    const bool was_valid = _horizontal_valid[sector];
+    bool valid = false;
+    for (uint8_t layer = PROXIMITY_HORIZONTAL_LAYER_FIRST; layer <= PROXIMITY_HORIZONTAL_LAYER_LAST; layer++) {
+        if (!_distance_valid[layer][sector]) {
+            continue;
+        }
+        const float horizontal_distance = _distance[layer][sector] * cosf(radians(_pitch[layer][sector]));
+        if (!valid || (horizontal_distance < _horizontal_distance[sector])) {
+            _horizontal_distance[sector] = horizontal_distance;
+            _horizontal_angle[sector] = _angle[layer][sector];
+            valid = true;
+        }
+    }
+    _horizontal_valid[sector] = valid;
+    if (valid != was_valid) {
+        if (valid) {
+            _horizontal_valid_count++;
+        } else {
+            _horizontal_valid_count--;
+        }
+    }
+
+    update_boundary(sector);
+}
+
+// recalculate the upward or downward distance from the top or bottom layer
+void AP_Proximity_Boundary_3D::update_vertical(uint8_t layer)
+{
+    bool valid = false;
+    float shortest_distance = 0.0f;
+    for (uint8_t sector=0; sector < PROXIMITY_NUM_SECTORS; sector++) {
+        if (!_distance_valid[layer][sector]) {
+            continue;
+        }
+        const float vertical_distance = _distance[layer][sector] * fabsf(sinf(radians(_pitch[layer][sector])));
+        if (!valid || (vertical_distance < shortest_distance)) {
+            shortest_distance = vertical_distance;
+            valid = true;
+        }
+    }
+
+    if (layer == PROXIMITY_TOP_LAYER) {
+        _upward_distance = shortest_distance;
+        _upward_valid = valid;
+    } else if (layer == PROXIMITY_BOTTOM_LAYER) {
+        _downward_distance = shortest_distance;
+        _downward_valid = valid;
+    }
+}
+
+// shortest horizontal distance of a sector and its clockwise neighbour
+float AP_Proximity_Boundary_3D::get_edge_distance(uint8_t sector) const
+{
+    const uint8_t next_sector = (sector + 1 >= PROXIMITY_NUM_SECTORS) ? 0 : sector + 1;
+
+    // boundary point lies on the line between the two sectors at the shorter distance found in the two sectors
+    float shortest_distance = PROXIMITY_BOUNDARY_DIST_DEFAULT;
+    if (_horizontal_valid[sector] && _horizontal_valid[next_sector]) {
+        shortest_distance = MIN(_horizontal_distance[sector], _horizontal_distance[next_sector]);
+    } else if (_horizontal_valid[sector]) {
+        shortest_distance = _horizontal_distance[sector];
+    } else if (_horizontal_valid[next_sector]) {
+        shortest_distance = _horizontal_distance[next_sector];
+    }
+    return MAX(shortest_distance, PROXIMITY_BOUNDARY_DIST_MIN);
+}
+
+// update boundary points around a sector after its horizontal distance changes
+//   the boundary points lie on the line between sectors meaning two boundary points may be updated based on a single sector's distance changing
+//   the boundary point is set to the shortest distance found in the two adjacent sectors, this is a conservative boundary around the vehicle
+void AP_Proximity_Boundary_3D::update_boundary(uint8_t sector)
+{
+    // edge between sector and next sector (clockwise)
+    const uint8_t next_sector = (sector + 1 >= PROXIMITY_NUM_SECTORS) ? 0 : sector + 1;
+    float shortest_distance = get_edge_distance(sector);
+    _boundary_point[sector] = _sector_edge_vector[sector] * shortest_distance;
+
+    // if the next sector (clockwise) has an invalid distance, set boundary to create a cup like boundary
+    if (!_horizontal_valid[next_sector]) {
+        _boundary_point[next_sector] = _sector_edge_vector[next_sector] * shortest_distance;
+    }
+
+    // repeat for edge between sector and previous sector
+    const uint8_t prev_sector = (sector == 0) ? PROXIMITY_NUM_SECTORS - 1 : sector - 1;
+    shortest_distance = get_edge_distance(prev_sector);
+    _boundary_point[prev_sector] = _sector_edge_vector[prev_sector] * shortest_distance;
+
+    // if the sector counter-clockwise from the previous sector has an invalid distance, set boundary to create a cup like boundary
+    const uint8_t prev_sector_ccw = (prev_sector == 0) ? PROXIMITY_NUM_SECTORS - 1 : prev_sector - 1;
+    if (!_horizontal_valid[prev_sector_ccw]) {
+        _boundary_point[prev_sector_ccw] = _sector_edge_vector[prev_sector_ccw] * shortest_distance;
+    }
+}
@@ -0,0 +1,137 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>
+
+#ifndef PROXIMITY_NUM_SECTORS
+#define PROXIMITY_NUM_SECTORS   8   // number of sectors (in the horizontal plane) around the vehicle
+#endif
+#ifndef PROXIMITY_NUM_LAYERS
+#define PROXIMITY_NUM_LAYERS    5   // number of elevation layers from straight down to straight up.  Must be odd so the middle layer is horizontal
+#endif
+
+#define PROXIMITY_SECTOR_WIDTH_DEG  (360.0f / PROXIMITY_NUM_SECTORS)    // width of each sector in degrees
+#define PROXIMITY_LAYER_HEIGHT_DEG  (180.0f / PROXIMITY_NUM_LAYERS)     // height of each layer in degrees
+#define PROXIMITY_MIDDLE_LAYER      (PROXIMITY_NUM_LAYERS / 2)          // index of the horizontal layer
+#define PROXIMITY_BOUNDARY_DIST_MIN 0.6f    // minimum distance for a boundary point.  This ensures the object avoidance code doesn't think we are outside the boundary.
+#define PROXIMITY_BOUNDARY_DIST_DEFAULT 100 // if we have no data for a sector, boundary is placed 100m out
+
+static_assert(PROXIMITY_NUM_LAYERS % 2 == 1, "PROXIMITY_NUM_LAYERS must be odd");
+static_assert(PROXIMITY_NUM_SECTORS >= 3 && PROXIMITY_NUM_SECTORS <= 72, "PROXIMITY_NUM_SECTORS must be between 3 and 72");
+
+/*
+ * 3D boundary around the vehicle made up of faces, each covering one sector
+ * (azimuth) in one layer (elevation).  Each face holds the closest object seen
+ * within it in body-frame (yaw and pitch in degrees, distance in meters).
+ *
+ * The horizontal polygon used by simple avoidance and the upward and downward
+ * distances are updated incrementally as each face changes so consumers only
+ * read pre-calculated values.  The polygon is made of the closest horizontal
+ * distance in each sector across all but the top and bottom layers, which
+ * instead provide the upward and downward distances.
+ */
+class AP_Proximity_Boundary_3D
+{
+public:
+    AP_Proximity_Boundary_3D();
+
+    // a face is identified by its layer (0 = straight down) and sector (0 = forward, clockwise)
+    class Face {
+    public:
+        Face() : layer(PROXIMITY_NUM_LAYERS), sector(PROXIMITY_NUM_SECTORS) {}
+        Face(uint8_t _layer, uint8_t _sector) : layer(_layer), sector(_sector) {}
+
+        bool valid() const { return (layer < PROXIMITY_NUM_LAYERS) && (sector < PROXIMITY_NUM_SECTORS); }
+        bool operator ==(const Face &other) const { return (layer == other.layer) && (sector == other.sector); }
+        bool operator !=(const Face &other) const { return !(*this == other); }
+
+        uint8_t layer;
+        uint8_t sector;
+    };
+
+    // get the face holding a body-frame pitch and yaw (both in degrees)
+    Face get_face(float pitch, float yaw) const;
+
+    // get the horizontal face holding a body-frame yaw in degrees
+    Face get_face(float yaw) const { return Face(PROXIMITY_MIDDLE_LAYER, get_sector(yaw)); }
+
+    // set a face's closest object and update the boundary
+    void set_face_attributes(const Face &face, float pitch, float yaw, float distance);
+
+    // mark a face as having no valid object and update the boundary
+    void reset_face(const Face &face);
+
+    // mark all faces as having no valid object
+    void reset();
+
+    // get a face's distance (and yaw) to its closest object. returns false if the face has no valid object
+    bool get_distance(const Face &face, float &distance) const;
+    bool get_angle(const Face &face, float &yaw) const;
+
+    // get the closest horizontal distance and its yaw within a sector. returns false if the sector has no valid objects
+    bool get_horizontal_distance(uint8_t sector, float &yaw, float &distance) const;
+
+    // returns true if any sector has a valid horizontal distance
+    bool has_horizontal_distances() const { return _horizontal_valid_count > 0; }
+
+    // get the body-frame polygon (in cm) around the vehicle used by simple avoidance
+    //   returns nullptr and sets num_points to zero if no boundary can be returned
+    const Vector2f* get_boundary_points(uint16_t &num_points) const;
+
+    // get the vertical distance (in meters) to the closest object above or below the vehicle.  returns true on success
+    bool get_upward_distance(float &distance) const;
+    bool get_downward_distance(float &distance) const;
+
+private:
+
+    // get the sector holding a body-frame yaw in degrees
+    uint8_t get_sector(float yaw) const;
+
+    // recalculate a sector's closest horizontal distance from its horizontal layers
+    void update_horizontal(uint8_t sector);
+
+    // update boundary points around a sector after its horizontal distance changes
+    void update_boundary(uint8_t sector);
+
+    // recalculate the upward or downward distance from the top or bottom layer
+    void update_vertical(uint8_t layer);
+
+    // shortest horizontal distance of a sector and its clockwise neighbour
+    float get_edge_distance(uint8_t sector) const;
+
+    // per face closest object
+    float _distance[PROXIMITY_NUM_LAYERS][PROXIMITY_NUM_SECTORS];   // distance (in meters) to closest object
+    float _angle[PROXIMITY_NUM_LAYERS][PROXIMITY_NUM_SECTORS];      // yaw (in degrees) to closest object
+    float _pitch[PROXIMITY_NUM_LAYERS][PROXIMITY_NUM_SECTORS];      // pitch (in degrees) to closest object
+    bool _distance_valid[PROXIMITY_NUM_LAYERS][PROXIMITY_NUM_SECTORS];
+
+    // per sector closest horizontal object
+    float _horizontal_distance[PROXIMITY_NUM_SECTORS];
+    float _horizontal_angle[PROXIMITY_NUM_SECTORS];
+    bool _horizontal_valid[PROXIMITY_NUM_SECTORS];
+    uint8_t _horizontal_valid_count;
+
+    // vertical distances (in meters) from the top and bottom layers
+    float _upward_distance;
+    bool _upward_valid;
+    float _downward_distance;
+    bool _downward_valid;
+
+    // fence boundary
+    Vector2f _sector_edge_vector[PROXIMITY_NUM_SECTORS];    // vector for right-edge of each sector, used to speed up calculation of boundary
+    Vector2f _boundary_point[PROXIMITY_NUM_SECTORS];        // bounding polygon around the vehicle calculated conservatively for object avoidance
+};
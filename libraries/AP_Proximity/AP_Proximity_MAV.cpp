@@ -50,8 +50,7 @@ void AP_Proximity_MAV::update(void)
 bool AP_Proximity_MAV::get_upward_distance(float &distance) const
 {
     if ((_last_upward_update_ms != 0) && (AP_HAL::millis() - _last_upward_update_ms <= PROXIMITY_MAV_TIMEOUT_MS)) {
-        distance = _distance_upward;
-        return true;
+        return AP_Proximity_Backend::get_upward_distance(distance);
     }
     return false;
 }
@@ -75,10 +74,19 @@ void AP_Proximity_MAV::handle_msg(const mavlink_message_t &msg)
             update_boundary_for_sector(sector, true);
         }
 
-        // store upward distance
-        if (packet.orientation == MAV_SENSOR_ROTATION_PITCH_90) {
-            _distance_upward = packet.current_distance * 0.01f;
-            _last_upward_update_ms = AP_HAL::millis();
+        // store upward and downward distances on the top and bottom faces of the boundary
+        if ((packet.orientation == MAV_SENSOR_ROTATION_PITCH_90) || (packet.orientation == MAV_SENSOR_ROTATION_PITCH_270)) {
+            const float pitch = (packet.orientation == MAV_SENSOR_ROTATION_PITCH_90) ? 90.0f : -90.0f;
+            const AP_Proximity_Boundary_3D::Face face = _boundary.get_face(pitch, 0.0f);
+            const float distance = packet.current_distance * 0.01f;
+            if ((packet.current_distance >= packet.min_distance) && (packet.current_distance <= packet.max_distance)) {
+                _boundary.set_face_attributes(face, pitch, 0.0f, distance);
+            } else {
+                _boundary.reset_face(face);
+            }
+            if (packet.orientation == MAV_SENSOR_ROTATION_PITCH_90) {
+                _last_upward_update_ms = AP_HAL::millis();
+            }
         }
         return;
     }
@@ -100,7 +108,6 @@ void AP_Proximity_MAV::handle_msg(const mavlink_message_t &msg)
             return;
         }
 
-        const float MAX_DISTANCE = 9999.0f;
         const uint8_t total_distances = MIN(((360.0f / fabs(increment)) + 0.5f), MAVLINK_MSG_OBSTACLE_DISTANCE_FIELD_DISTANCES_LEN); // usually 72
 
         // set distance min and max
@@ -119,15 +126,11 @@ void AP_Proximity_MAV::handle_msg(const mavlink_message_t &msg)
         float current_vehicle_bearing;
         const bool database_ready = database_prepare_for_push(current_loc, current_vehicle_bearing);
 
-        // initialise updated array and proximity sector angles (to closest object) and distances
-        bool sector_updated[_num_sectors];
-        float sector_width_half[_num_sectors];
-        for (uint8_t i = 0; i < _num_sectors; i++) {
-            sector_updated[i] = false;
-            sector_width_half[i] = _sector_width_deg[i] * 0.5f;
-            _angle[i] = _sector_middle_deg[i];
-            _distance[i] = MAX_DISTANCE;
-        }
+        // find the closest object within each horizontal face of the boundary.  The face
+        // is calculated directly from the angle so this is linear in the number of distances
+        float face_distance[PROXIMITY_NUM_SECTORS];
+        float face_angle[PROXIMITY_NUM_SECTORS];
+        bool face_updated[PROXIMITY_NUM_SECTORS] {};
 
         // iterate over message's sectors
         for (uint8_t j = 0; j < total_distances; j++) {
@@ -144,15 +147,12 @@ void AP_Proximity_MAV::handle_msg(const mavlink_message_t &msg)
             const float packet_distance_m = distance_cm * 0.01f;
             const float mid_angle = wrap_360((float)j * increment + yaw_correction);
 
-            // iterate over proximity sectors
-            for (uint8_t i = 0; i < _num_sectors; i++) {
-                float angle_diff = fabsf(wrap_180(_sector_middle_deg[i] - mid_angle));
-                // update distance array sector with shortest distance from message
-                if ((angle_diff <= sector_width_half[i]) && (packet_distance_m < _distance[i])) {
-                    _distance[i] = packet_distance_m;
-                    _angle[i] = mid_angle;
-                    sector_updated[i] = true;
-                }
+            // update face with shortest distance from message
+            const uint8_t sector = _boundary.get_face(mid_angle).sector;
+            if (!face_updated[sector] || (packet_distance_m < face_distance[sector])) {
+                face_distance[sector] = packet_distance_m;
+                face_angle[sector] = mid_angle;
+                face_updated[sector] = true;
             }
 
             // update Object Avoidance database with Earth-frame point
@@ -161,11 +161,13 @@ void AP_Proximity_MAV::handle_msg(const mavlink_message_t &msg)
             }
         }
 
-        // update proximity sectors validity and boundary point
-        for (uint8_t i = 0; i < _num_sectors; i++) {
-            _distance_valid[i] = (_distance[i] >= _distance_min) && (_distance[i] <= _distance_max);
-            if (sector_updated[i]) {
-                update_boundary_for_sector(i, false);
+        // update boundary once per face.  Faces without a valid distance in this message are cleared
+        for (uint8_t i = 0; i < PROXIMITY_NUM_SECTORS; i++) {
+            const AP_Proximity_Boundary_3D::Face face(PROXIMITY_MIDDLE_LAYER, i);
+            if (face_updated[i]) {
+                _boundary.set_face_attributes(face, 0.0f, face_angle[i], face_distance[i]);
+            } else {
+                _boundary.reset_face(face);
             }
         }
     }
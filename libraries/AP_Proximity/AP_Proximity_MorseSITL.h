@@ -20,9 +20,6 @@ public:
     float distance_max() const override;
     float distance_min() const override;
 
-    // get distance upwards in meters. returns true on success
-    bool get_upward_distance(float &distance) const override;
-
 private:
     SITL::SITL *sitl;
     float distance_maximum;
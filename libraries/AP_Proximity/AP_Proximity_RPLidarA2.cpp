@@ -129,11 +129,6 @@ float AP_Proximity_RPLidarA2::distance_min() const
 
 bool AP_Proximity_RPLidarA2::initialise()
 {
-    // initialise sectors
-    if (!_sector_initialised) {
-        init_sectors();
-        return false;
-    }
     if (!_initialised) {
         reset_rplidar();            // set to a known state
         Debug(1, "LIDAR initialised");
@@ -158,65 +153,6 @@ void AP_Proximity_RPLidarA2::reset_rplidar()
 
 }
 
-// initialise sector angles using user defined ignore areas, left same as SF40C
-void AP_Proximity_RPLidarA2::init_sectors()
-{
-    // use defaults if no ignore areas defined
-    const uint8_t ignore_area_count = get_ignore_area_count();
-    if (ignore_area_count == 0) {
-        _sector_initialised = true;
-        return;
-    }
-
-    uint8_t sector = 0;
-    for (uint8_t i=0; i<ignore_area_count; i++) {
-
-        // get ignore area info
-        uint16_t ign_area_angle;
-        uint8_t ign_area_width;
-        if (get_ignore_area(i, ign_area_angle, ign_area_width)) {
-
-            // calculate how many degrees of space we have between this end of this ignore area and the start of the end
-            int16_t start_angle, end_angle;
-            get_next_ignore_start_or_end(1, ign_area_angle, start_angle);
-            get_next_ignore_start_or_end(0, start_angle, end_angle);
-            int16_t degrees_to_fill = wrap_360(end_angle - start_angle);
-
-            // divide up the area into sectors
-            while ((degrees_to_fill > 0) && (sector < PROXIMITY_SECTORS_MAX)) {
-                uint16_t sector_size;
-                if (degrees_to_fill >= 90) {
-                    // set sector to maximum of 45 degrees
-                    sector_size = 45;
-                } else if (degrees_to_fill > 45) {
-                    // use half the remaining area to optimise size of this sector and the next
-                    sector_size = degrees_to_fill / 2.0f;
-                } else  {
-                    // 45 degrees or less are left so put it all into the next sector
-                    sector_size = degrees_to_fill;
-                }
-                // record the sector middle and width
-                _sector_middle_deg[sector] = wrap_360(start_angle + sector_size / 2.0f);
-                _sector_width_deg[sector] = sector_size;
-
-                // move onto next sector
-                start_angle += sector_size;
-                sector++;
-                degrees_to_fill -= sector_size;
-            }
-        }
-    }
-
-    // set num sectors
-    _num_sectors = sector;
-
-    // re-initialise boundary because sector locations have changed
-    init_boundary();
-
-    // record success
-    _sector_initialised = true;
-}
-
 // set Lidar into SCAN mode
 void AP_Proximity_RPLidarA2::set_scan_mode()
 {
@@ -402,28 +338,25 @@ void AP_Proximity_RPLidarA2::parse_response_data()
                 Debug(2, "                                       D%02.2f A%03.1f Q%02d", distance_m, angle_deg, quality);
 #endif
                 _last_distance_received_ms = AP_HAL::millis();
-                uint8_t sector;
-                if (convert_angle_to_sector(angle_deg, sector)) {
-                    if (distance_m > distance_min()) {
-                        if (_last_sector == sector) {
-                            if (_distance_m_last > distance_m) {
-                                _distance_m_last = distance_m;
-                                _angle_deg_last  = angle_deg;
-                            }
+                if (!ignore_reading(angle_deg)) {
+                    const AP_Proximity_Boundary_3D::Face face = _boundary.get_face(angle_deg);
+                    if (face != _last_face) {
+                        // a new face started, the previous one can be updated now
+                        if (_last_distance_valid) {
+                            _boundary.set_face_attributes(_last_face, 0.0f, _angle_deg_last, _distance_m_last);
+                            database_push(_angle_deg_last, _distance_m_last);
                         } else {
-                            // a new sector started, the previous one can be updated now
-                            _angle[_last_sector] = _angle_deg_last;
-                            _distance[_last_sector] = _distance_m_last;
-                            _distance_valid[_last_sector] = true;
-                            // update boundary used for avoidance
-                            update_boundary_for_sector(_last_sector, true);
-                            // initialize the new sector
-                            _last_sector     = sector;
-                            _distance_m_last = distance_m;
-                            _angle_deg_last  = angle_deg;
+                            _boundary.reset_face(_last_face);
                         }
-                    } else {
-                        _distance_valid[sector] = false;
+                        // initialize the new face
+                        _last_face = face;
+                        _last_distance_valid = false;
+                    }
+                    // record the shortest valid distance within the face
+                    if ((distance_m > distance_min()) && (!_last_distance_valid || (distance_m < _distance_m_last))) {
+                        _distance_m_last = distance_m;
+                        _angle_deg_last  = angle_deg;
+                        _last_distance_valid = true;
                     }
                 }
             } else {
@@ -69,7 +69,6 @@ private:
 
     // initialise sensor (returns true if sensor is successfully initialised)
     bool initialise();
-    void init_sectors();
     void set_scan_mode();
 
     // send request for something from sensor
@@ -87,7 +86,6 @@ private:
     bool _information_data;
     bool _resetted;
     bool _initialised;
-    bool _sector_initialised;
 
     uint8_t _payload_length;
     uint8_t _cnt;
@@ -97,14 +95,15 @@ private:
     // request related variables
     enum ResponseType _response_type;         ///< response from the lidar
     enum rp_state _rp_state;
-    uint8_t   _last_sector;                   ///< last sector requested
     uint32_t  _last_request_ms;               ///< system time of last request
     uint32_t  _last_distance_received_ms;     ///< system time of last distance measurement received from sensor
     uint32_t  _last_reset_ms;
 
-    // sector related variables
-    float _angle_deg_last;
-    float _distance_m_last;
+    // boundary face related variables
+    AP_Proximity_Boundary_3D::Face _last_face;    ///< face holding the most recent reading
+    float _angle_deg_last;                        ///< angle of the closest reading within _last_face
+    float _distance_m_last;                       ///< distance of the closest reading within _last_face
+    bool _last_distance_valid;                    ///< true if a valid reading has been received within _last_face
 
     struct PACKED _sensor_scan {
         uint8_t startbit      : 1;            ///< on the first revolution 1 else 0
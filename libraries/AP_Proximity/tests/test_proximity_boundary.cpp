@@ -0,0 +1,127 @@
+#include <AP_gtest.h>
+
+#include <AP_Proximity/AP_Proximity_Boundary_3D.h>
+#include <AP_Math/AP_Math.h>
+
+const AP_HAL::HAL &hal = AP_HAL::get_HAL();
+
+TEST(AP_Proximity_Boundary_3D, Faces)
+{
+    AP_Proximity_Boundary_3D boundary;
+
+    // sector 0 is centred on forward
+    EXPECT_EQ(0, boundary.get_face(0.0f).sector);
+    EXPECT_EQ(0, boundary.get_face(-10.0f).sector);
+    EXPECT_EQ(0, boundary.get_face(350.0f).sector);
+    EXPECT_EQ(1, boundary.get_face(PROXIMITY_SECTOR_WIDTH_DEG).sector);
+    EXPECT_EQ(PROXIMITY_NUM_SECTORS - 1, boundary.get_face(-PROXIMITY_SECTOR_WIDTH_DEG).sector);
+    EXPECT_EQ(PROXIMITY_MIDDLE_LAYER, boundary.get_face(0.0f).layer);
+
+    // layer 0 is straight down
+    EXPECT_EQ(0, boundary.get_face(-90.0f, 0.0f).layer);
+    EXPECT_EQ(PROXIMITY_NUM_LAYERS - 1, boundary.get_face(90.0f, 0.0f).layer);
+    EXPECT_EQ(PROXIMITY_MIDDLE_LAYER, boundary.get_face(0.0f, 0.0f).layer);
+
+    EXPECT_TRUE(boundary.get_face(0.0f).valid());
+    EXPECT_FALSE(AP_Proximity_Boundary_3D::Face().valid());
+}
+
+TEST(AP_Proximity_Boundary_3D, HorizontalDistance)
+{
+    AP_Proximity_Boundary_3D boundary;
+    float yaw, distance;
+
+    EXPECT_FALSE(boundary.has_horizontal_distances());
+    const AP_Proximity_Boundary_3D::Face face = boundary.get_face(90.0f);
+    boundary.set_face_attributes(face, 0.0f, 90.0f, 5.0f);
+    EXPECT_TRUE(boundary.has_horizontal_distances());
+    EXPECT_TRUE(boundary.get_horizontal_distance(face.sector, yaw, distance));
+    EXPECT_FLOAT_EQ(90.0f, yaw);
+    EXPECT_FLOAT_EQ(5.0f, distance);
+
+    // a closer object in a lower layer of the same sector is closest horizontally
+    const AP_Proximity_Boundary_3D::Face low_face = boundary.get_face(-30.0f, 95.0f);
+    EXPECT_EQ(face.sector, low_face.sector);
+    EXPECT_NE(face.layer, low_face.layer);
+    boundary.set_face_attributes(low_face, -30.0f, 95.0f, 4.0f);
+    EXPECT_TRUE(boundary.get_horizontal_distance(face.sector, yaw, distance));
+    EXPECT_FLOAT_EQ(95.0f, yaw);
+    EXPECT_FLOAT_EQ(4.0f * cosf(radians(30.0f)), distance);
+
+    // clearing it restores the object in the middle layer
+    boundary.reset_face(low_face);
+    EXPECT_TRUE(boundary.get_horizontal_distance(face.sector, yaw, distance));
+    EXPECT_FLOAT_EQ(5.0f, distance);
+
+    boundary.reset_face(face);
+    EXPECT_FALSE(boundary.get_horizontal_distance(face.sector, yaw, distance));
+    EXPECT_FALSE(boundary.has_horizontal_distances());
+    EXPECT_FALSE(boundary.get_distance(face, distance));
+}
+
+TEST(AP_Proximity_Boundary_3D, BoundaryPoints)
+{
+    AP_Proximity_Boundary_3D boundary;
+    uint16_t num_points;
+
+    EXPECT_EQ(nullptr, boundary.get_boundary_points(num_points));
+    EXPECT_EQ(0, num_points);
+
+    // points either side of the sector, and the cup around them, are pulled in to the object
+    boundary.set_face_attributes(boundary.get_face(0.0f), 0.0f, 0.0f, 10.0f);
+    const Vector2f *points = boundary.get_boundary_points(num_points);
+    ASSERT_NE(nullptr, points);
+    EXPECT_EQ(PROXIMITY_NUM_SECTORS, num_points);
+    EXPECT_FLOAT_EQ(1000.0f, points[0].length());
+    EXPECT_FLOAT_EQ(1000.0f, points[1].length());
+    EXPECT_FLOAT_EQ(1000.0f, points[PROXIMITY_NUM_SECTORS - 1].length());
+    EXPECT_FLOAT_EQ(1000.0f, points[PROXIMITY_NUM_SECTORS - 2].length());
+    EXPECT_FLOAT_EQ(PROXIMITY_BOUNDARY_DIST_DEFAULT * 100.0f, points[PROXIMITY_NUM_SECTORS / 2].length());
+
+    // points are never closer than the minimum distance
+    boundary.set_face_attributes(boundary.get_face(0.0f), 0.0f, 0.0f, 0.1f);
+    EXPECT_FLOAT_EQ(PROXIMITY_BOUNDARY_DIST_MIN * 100.0f, points[0].length());
+
+    // the edge between two sectors takes the closer object
+    boundary.set_face_attributes(boundary.get_face(PROXIMITY_SECTOR_WIDTH_DEG), 0.0f, PROXIMITY_SECTOR_WIDTH_DEG, 20.0f);
+    boundary.set_face_attributes(boundary.get_face(0.0f), 0.0f, 0.0f, 30.0f);
+    EXPECT_FLOAT_EQ(2000.0f, points[0].length());
+    EXPECT_FLOAT_EQ(2000.0f, points[1].length());
+    EXPECT_FLOAT_EQ(3000.0f, points[PROXIMITY_NUM_SECTORS - 1].length());
+
+    boundary.reset();
+    EXPECT_EQ(nullptr, boundary.get_boundary_points(num_points));
+}
+
+TEST(AP_Proximity_Boundary_3D, VerticalDistance)
+{
+    AP_Proximity_Boundary_3D boundary;
+    float distance;
+
+    EXPECT_FALSE(boundary.get_upward_distance(distance));
+    EXPECT_FALSE(boundary.get_downward_distance(distance));
+
+    const AP_Proximity_Boundary_3D::Face up_face = boundary.get_face(80.0f, 0.0f);
+    boundary.set_face_attributes(up_face, 80.0f, 0.0f, 10.0f);
+    boundary.set_face_attributes(boundary.get_face(85.0f, 180.0f), 85.0f, 180.0f, 20.0f);
+    EXPECT_TRUE(boundary.get_upward_distance(distance));
+    EXPECT_FLOAT_EQ(10.0f * sinf(radians(80.0f)), distance);
+    EXPECT_FALSE(boundary.get_downward_distance(distance));
+
+    // vertical objects are not part of the horizontal boundary
+    EXPECT_FALSE(boundary.has_horizontal_distances());
+
+    boundary.set_face_attributes(boundary.get_face(-90.0f, 0.0f), -90.0f, 0.0f, 3.0f);
+    EXPECT_TRUE(boundary.get_downward_distance(distance));
+    EXPECT_FLOAT_EQ(3.0f, distance);
+
+    boundary.reset_face(up_face);
+    EXPECT_TRUE(boundary.get_upward_distance(distance));
+    EXPECT_FLOAT_EQ(20.0f * sinf(radians(85.0f)), distance);
+
+    boundary.reset();
+    EXPECT_FALSE(boundary.get_upward_distance(distance));
+    EXPECT_FALSE(boundary.get_downward_distance(distance));
+}
+
+AP_GTEST_MAIN()
@@ -30,8 +30,8 @@ const AP_Param::GroupInfo AP_SmartRTL::var_info[] = {
 
     // @Param: POINTS
     // @DisplayName: SmartRTL maximum number of points on path
-    // @Description: SmartRTL maximum number of points on path. Set to 0 to disable SmartRTL.  100 points consumes about 3k of memory.
-    // @Range: 0 500
+    // @Description: SmartRTL maximum number of points on path. Set to 0 to disable SmartRTL.  100 points consumes about 1.5k of memory.  The maximum of 1000 points keeps SmartRTL within the 15k used by the 500 points of the previous path format.  Points are only stored at least SRTL_ACCURACY apart and the path is simplified and pruned as it grows, so each point usually covers much more than SRTL_ACCURACY of flight.
+    // @Range: 0 1000
     // @User: Advanced
     // @RebootRequired: True
     AP_GROUPINFO("POINTS", 1, AP_SmartRTL, _points_max, SMARTRTL_POINTS_DEFAULT),
@@ -60,10 +60,15 @@ const AP_Param::GroupInfo AP_SmartRTL::var_info[] = {
 *    2. Simplification uses the Ramer-Douglas-Peucker algorithm. See Wikipedia
 *    for a more complete description.
 *
-*    The simplification and pruning algorithms run in the background and do not
-*    alter the path in memory.  Two definitions, SMARTRTL_SIMPLIFY_TIME_US and
-*    SMARTRTL_PRUNING_LOOP_TIME_US are used to limit how long each algorithm will
-*    be run before they save their state and return.
+*    The simplification and pruning algorithms run in their own low priority
+*    thread and do not alter the path in memory.  SMARTRTL_CLEANUP_TIME_US sets
+*    how long each algorithm runs before saving its state and yielding.
+*
+*    To fit long paths in memory the points are quantised and stored as int16
+*    offsets from the previous point (see write_path_point).  The path is split
+*    into chunks of SMARTRTL_CHUNK_POINTS points and the bounding box of each
+*    chunk is used as a spatial index so the loop search only compares segments
+*    which are near each other.
 *
 *    Both algorithms are "anytime algorithms" meaning they can be interrupted
 *    before they complete which is helpful when memory is filling up and we just
@@ -80,14 +85,13 @@ AP_SmartRTL::AP_SmartRTL(bool example_mode) :
     _example_mode(example_mode)
 {
     AP_Param::setup_object_defaults(this, var_info);
-    _simplify.bitmask.setall();
 }
 
 // initialise safe rtl including setting up background processes
 void AP_SmartRTL::init()
 {
     // protect against repeated call to init
-    if (_path != nullptr) {
+    if (_path_chunks != nullptr) {
         return;
     }
 
@@ -100,30 +104,43 @@ void AP_SmartRTL::init()
     }
 
     // allocate arrays
-    _path = (Vector3f*)calloc(_points_max, sizeof(Vector3f));
+    _path_chunks = (path_chunk_t*)calloc((_points_max + SMARTRTL_CHUNK_POINTS - 1) / SMARTRTL_CHUNK_POINTS, sizeof(path_chunk_t));
+    _path_offsets = (path_offset_t*)calloc(_points_max, sizeof(path_offset_t));
 
     _prune.loops_max = _points_max * SMARTRTL_PRUNING_LOOP_BUFFER_LEN_MULT;
     _prune.loops = (prune_loop_t*)calloc(_prune.loops_max, sizeof(prune_loop_t));
 
     _simplify.stack_max = _points_max * SMARTRTL_SIMPLIFY_STACK_LEN_MULT;
-    _simplify.stack = (simplify_start_finish_t*)calloc(_simplify.stack_max, sizeof(simplify_start_finish_t));
+    _simplify.stack = (uint16_t*)calloc(_simplify.stack_max, sizeof(uint16_t));
+
+    _simplify.bitmask_words = (_points_max + 31) / 32;
+    _simplify.bitmask = (uint32_t*)calloc(_simplify.bitmask_words, sizeof(uint32_t));
 
     // check if memory allocation failed
-    if (_path == nullptr || _prune.loops == nullptr || _simplify.stack == nullptr) {
+    if (_path_chunks == nullptr || _path_offsets == nullptr || _prune.loops == nullptr || _simplify.stack == nullptr || _simplify.bitmask == nullptr) {
         log_action(SRTL_DEACTIVATED_INIT_FAILED);
         gcs().send_text(MAV_SEVERITY_WARNING, "SmartRTL deactivated: init failed");
-        free(_path);
+        free(_path_chunks);
+        free(_path_offsets);
         free(_prune.loops);
         free(_simplify.stack);
+        free(_simplify.bitmask);
+        _path_chunks = nullptr;
         return;
     }
 
     _path_points_max = _points_max;
+    _path_resolution = MAX(_accuracy * SMARTRTL_POINT_RESOLUTION_RATIO, SMARTRTL_POINT_RESOLUTION_MIN);
+    simplify_bitmask_setall();
 
     // when running the example sketch, we want the cleanup tasks to run when we tell them to, not in the background (so that they can be timed.)
-    if (!_example_mode){
-        // register background cleanup to run in IO thread
-        hal.scheduler->register_io_process(FUNCTOR_BIND_MEMBER(&AP_SmartRTL::run_background_cleanup, void));
+    if (!_example_mode) {
+        // run background cleanup in its own low priority thread, falling back to the IO thread
+        if (!hal.scheduler->thread_create(FUNCTOR_BIND_MEMBER(&AP_SmartRTL::cleanup_thread, void),
+                                          "SmartRTL",
+                                          SMARTRTL_CLEANUP_THREAD_STACK, AP_HAL::Scheduler::PRIORITY_IO, -1)) {
+            hal.scheduler->register_io_process(FUNCTOR_BIND_MEMBER(&AP_SmartRTL::run_background_cleanup, void));
+        }
     }
 }
 
@@ -154,7 +171,7 @@ bool AP_SmartRTL::pop_point(Vector3f& point)
     }
 
     // return last point and remove from path
-    point = _path[--_path_points_count];
+    point = decode_point(get_path_point(--_path_points_count));
 
     // record count of last point popped
     _path_points_completed_limit = _path_points_count;
@@ -173,7 +190,7 @@ void AP_SmartRTL::set_home(bool position_ok)
 
 void AP_SmartRTL::set_home(bool position_ok, const Vector3f& current_pos)
 {
-    if (_path == nullptr) {
+    if (_path_chunks == nullptr) {
         return;
     }
 
@@ -291,30 +308,205 @@ bool AP_SmartRTL::add_point(const Vector3f& point)
     }
 
     // check if we have traveled far enough
+    const Vector3l new_point = encode_point(point);
+    Vector3l last_point;
+    uint16_t num_bridge_points = 0;
     if (_path_points_count > 0) {
-        const Vector3f& last_pos = _path[_path_points_count-1];
-        if (last_pos.distance_squared(point) < sq(_accuracy.get())) {
+        last_point = get_path_point(_path_points_count-1);
+        if (decode_point(last_point).distance_squared(point) < sq(_accuracy.get())) {
             _path_sem.give();
             return true;
         }
+        // a very large jump must be bridged so that the new point can be stored as an offset
+        num_bridge_points = points_to_bridge(last_point, new_point);
     }
 
     // check we have space in the path
-    if (_path_points_count >= _path_points_max) {
+    if (_path_points_count + num_bridge_points >= _path_points_max) {
         _path_sem.give();
         log_action(SRTL_ADD_FAILED_PATH_FULL, point);
         return false;
     }
 
     // add point to path
-    _path[_path_points_count++] = point;
+    Vector3l prev_point = last_point;
+    for (uint16_t i = 0; i < num_bridge_points; i++) {
+        const Vector3l bridge = bridge_point(last_point, new_point, i, num_bridge_points);
+        write_path_point(_path_points_count++, bridge, prev_point);
+        prev_point = bridge;
+    }
+    write_path_point(_path_points_count++, new_point, prev_point);
     log_action(SRTL_POINT_ADD, point);
 
     _path_sem.give();
     return true;
 }
 
-// run background cleanup - should be run regularly from the IO thread
+// convert point in meters to units of _path_resolution
+Vector3l AP_SmartRTL::encode_point(const Vector3f& point) const
+{
+    return Vector3l(roundf(point.x / _path_resolution),
+                    roundf(point.y / _path_resolution),
+                    roundf(point.z / _path_resolution));
+}
+
+// convert point in units of _path_resolution to meters
+Vector3f AP_SmartRTL::decode_point(const Vector3l& point) const
+{
+    return Vector3f(point.x * _path_resolution,
+                    point.y * _path_resolution,
+                    point.z * _path_resolution);
+}
+
+// get a point on the path in units of _path_resolution
+Vector3l AP_SmartRTL::get_path_point(uint16_t index) const
+{
+    const uint16_t chunk_start = index - (index % SMARTRTL_CHUNK_POINTS);
+    Vector3l point = _path_chunks[chunk_start / SMARTRTL_CHUNK_POINTS].first;
+    for (uint16_t i = chunk_start + 1; i <= index; i++) {
+        next_path_point(i, point);
+    }
+    return point;
+}
+
+// advance point from the path point before index to the path point at index
+void AP_SmartRTL::next_path_point(uint16_t index, Vector3l& point) const
+{
+    if (index % SMARTRTL_CHUNK_POINTS == 0) {
+        point = _path_chunks[index / SMARTRTL_CHUNK_POINTS].first;
+    } else {
+        const path_offset_t &ofs = _path_offsets[index];
+        point.x += ofs.x;
+        point.y += ofs.y;
+        point.z += ofs.z;
+    }
+}
+
+// write point to the path at index.  prev should hold the point at index-1
+void AP_SmartRTL::write_path_point(uint16_t index, const Vector3l& point, const Vector3l& prev)
+{
+    path_chunk_t &chunk = _path_chunks[index / SMARTRTL_CHUNK_POINTS];
+    if (index % SMARTRTL_CHUNK_POINTS == 0) {
+        // first point in chunk is stored in full and resets the bounding box
+        chunk.first = point;
+        chunk.min = point;
+        chunk.max = point;
+        if (index == 0) {
+            return;
+        }
+        // include previous point so the bounding box covers the segment ending at this point
+        chunk.min = Vector3l(MIN(point.x, prev.x), MIN(point.y, prev.y), MIN(point.z, prev.z));
+        chunk.max = Vector3l(MAX(point.x, prev.x), MAX(point.y, prev.y), MAX(point.z, prev.z));
+        return;
+    }
+    _path_offsets[index] = {int16_t(point.x - prev.x), int16_t(point.y - prev.y), int16_t(point.z - prev.z)};
+    chunk.min = Vector3l(MIN(chunk.min.x, point.x), MIN(chunk.min.y, point.y), MIN(chunk.min.z, point.z));
+    chunk.max = Vector3l(MAX(chunk.max.x, point.x), MAX(chunk.max.y, point.y), MAX(chunk.max.z, point.z));
+}
+
+// returns the number of points which must be inserted on the straight line between from and to
+// so that every point can be stored as an int16 offset from the point before it
+uint16_t AP_SmartRTL::points_to_bridge(const Vector3l& from, const Vector3l& to)
+{
+    const int64_t dist = MAX(MAX(llabs(int64_t(to.x) - from.x), llabs(int64_t(to.y) - from.y)), llabs(int64_t(to.z) - from.z));
+    if (dist <= INT16_MAX) {
+        return 0;
+    }
+    return MIN((dist + INT16_MAX - 1) / INT16_MAX - 1, (int64_t)UINT16_MAX);
+}
+
+// returns the num'th of num_points points evenly spaced along the straight line between from and to
+Vector3l AP_SmartRTL::bridge_point(const Vector3l& from, const Vector3l& to, uint16_t num, uint16_t num_points)
+{
+    const int64_t mult = num + 1;
+    const int64_t div = num_points + 1;
+    return Vector3l(from.x + (int32_t)(((int64_t(to.x) - from.x) * mult) / div),
+                    from.y + (int32_t)(((int64_t(to.y) - from.y) * mult) / div),
+                    from.z + (int32_t)(((int64_t(to.z) - from.z) * mult) / div));
+}
+
+// rewrite the path from from_index onwards, removing points for which keep_point returns false
+// keep_point may also change the point and must give the same result each time it is called.
+// long straight gaps are bridged with evenly spaced points.  removed points are logged with remove_action
+// returns the number of points removed from the path or -1 if the bridging points would not fit, in which case the path is unchanged
+// must be called with _path_sem held.  _path_points_count is not updated
+template <typename KeepPointFn>
+int32_t AP_SmartRTL::rewrite_path(uint16_t from_index, SRTL_Actions remove_action, KeepPointFn keep_point)
+{
+    // whole chunks are rewritten so that their first points and bounding boxes are rebuilt
+    const uint16_t start_index = from_index - (from_index % SMARTRTL_CHUNK_POINTS);
+    const Vector3l start_prev = (start_index > 0) ? get_path_point(start_index - 1) : Vector3l();
+
+    // removing points may leave a gap too large to store as an offset.  Points are rewritten in place so bridging
+    // points must fit in the space left by removed points, otherwise unread points would be overwritten.
+    // check the whole range before writing anything so that a path which can't be rewritten is left intact
+    uint16_t write_index = start_index;
+    Vector3l prev = start_prev;
+    Vector3l point;
+    for (uint16_t index = start_index; index < _path_points_count; index++) {
+        next_path_point(index, point);
+        Vector3l new_point = point;
+        if ((index >= from_index) && !keep_point(index, new_point)) {
+            continue;
+        }
+        if (write_index > 0) {
+            write_index += points_to_bridge(prev, new_point);
+            if (write_index > index) {
+                return -1;
+            }
+        }
+        write_index++;
+        prev = new_point;
+    }
+
+    // each chunk is decoded before any of its points are overwritten
+    uint16_t read_index = start_index;
+    write_index = start_index;
+    prev = start_prev;
+    Vector3l chunk_points[SMARTRTL_CHUNK_POINTS];
+    while (read_index < _path_points_count) {
+        const uint16_t chunk_start = read_index;
+        const uint16_t num_points = MIN(_path_points_count - chunk_start, SMARTRTL_CHUNK_POINTS);
+        for (uint16_t i = 0; i < num_points; i++) {
+            next_path_point(chunk_start + i, point);
+            chunk_points[i] = point;
+        }
+        read_index += num_points;
+
+        for (uint16_t i = 0; i < num_points; i++) {
+            const uint16_t index = chunk_start + i;
+            point = chunk_points[i];
+            if ((index >= from_index) && !keep_point(index, point)) {
+                log_action(remove_action, decode_point(point));
+                continue;
+            }
+            if (write_index > 0) {
+                const uint16_t num_bridge_points = points_to_bridge(prev, point);
+                const Vector3l bridge_start = prev;
+                for (uint16_t b = 0; b < num_bridge_points; b++) {
+                    const Vector3l bridge = bridge_point(bridge_start, point, b, num_bridge_points);
+                    write_path_point(write_index++, bridge, prev);
+                    prev = bridge;
+                }
+            }
+            write_path_point(write_index++, point, prev);
+            prev = point;
+        }
+    }
+
+    return _path_points_count - write_index;
+}
+
+// cleanup thread, runs run_background_cleanup until the vehicle is rebooted
+void AP_SmartRTL::cleanup_thread()
+{
+    while (true) {
+        hal.scheduler->delay(SMARTRTL_CLEANUP_THREAD_INTERVAL_MS);
+        run_background_cleanup();
+    }
+}
+
+// run background cleanup - run regularly from the cleanup thread
 void AP_SmartRTL::run_background_cleanup()
 {
     if (!_active) {
@@ -457,11 +649,11 @@ void AP_SmartRTL::detect_simplifications()
 
     // if not complete but also nothing to do, we must be restarting
     if (_simplify.stack_count == 0) {
-        // reset to beginning state. add a single element in the array with:
+        // reset to beginning state. start with a single section from:
         //   start = first path point OR the index of the last already-simplified point
-        //   finish = final path point
-        _simplify.stack[0].start = (_simplify.path_points_completed > 0) ? _simplify.path_points_completed - 1 : 0;
-        _simplify.stack[0].finish = _simplify.path_points_count-1;
+        //   end = final path point
+        _simplify.start = (_simplify.path_points_completed > 0) ? _simplify.path_points_completed - 1 : 0;
+        _simplify.stack[0] = _simplify.path_points_count-1;
         _simplify.stack_count++;
     }
 
@@ -469,22 +661,26 @@ void AP_SmartRTL::detect_simplifications()
     while (_simplify.stack_count > 0) { // while there is something to do
 
         // if this method has run for long enough, exit
-        if (AP_HAL::micros() - start_time_us > SMARTRTL_SIMPLIFY_TIME_US) {
+        if (AP_HAL::micros() - start_time_us > SMARTRTL_CLEANUP_TIME_US) {
             return;
         }
 
-        // pop last item off the simplify stack
-        const simplify_start_finish_t tmp = _simplify.stack[--_simplify.stack_count];
-        const uint16_t start_index = tmp.start;
-        const uint16_t end_index = tmp.finish;
+        // the section to simplify starts at the end of the previous section and ends at the top of the stack
+        const uint16_t start_index = _simplify.start;
+        const uint16_t end_index = _simplify.stack[_simplify.stack_count-1];
+        const Vector3l start_point = get_path_point(start_index);
+        const Vector3f start_pos = decode_point(start_point);
+        const Vector3f end_pos = decode_point(get_path_point(end_index));
 
         // find the point between start and end points that is farthest from the start-end line segment
         float max_dist = 0.0f;
         uint16_t farthest_point_index = start_index;
+        Vector3l point = start_point;
         for (uint16_t i = start_index + 1; i < end_index; i++) {
+            next_path_point(i, point);
             // only check points that have not already been flagged for simplification
-            if (_simplify.bitmask.get(i)) {
-                const float dist = _path[i].distance_to_segment(_path[start_index], _path[end_index]);
+            if (simplify_bitmask_get(i)) {
+                const float dist = decode_point(point).distance_to_segment(start_pos, end_pos);
                 if (dist > max_dist) {
                     farthest_point_index = i;
                     max_dist = dist;
@@ -492,22 +688,24 @@ void AP_SmartRTL::detect_simplifications()
             }
         }
 
-        // if the farthest point is more than ACCURACY * 0.5 add two new elements to the _simplification_stack
-        // so that on the next iteration we will check between start-to-farthestpoint and farthestpoint-to-end
+        // if the farthest point is more than ACCURACY * 0.5 push it onto the stack so that on the next iteration
+        // we will check between start-to-farthestpoint and later farthestpoint-to-end
         if (max_dist > SMARTRTL_SIMPLIFY_EPSILON) {
             // if the to-do list is full, give up on simplifying. This should never happen.
             if (_simplify.stack_count >= _simplify.stack_max) {
                 _simplify.complete = true;
                 return;
             }
-            _simplify.stack[_simplify.stack_count++] = simplify_start_finish_t {start_index, farthest_point_index};
-            _simplify.stack[_simplify.stack_count++] = simplify_start_finish_t {farthest_point_index, end_index};
+            _simplify.stack[_simplify.stack_count++] = farthest_point_index;
         } else {
             // if the farthest point was closer than ACCURACY * 0.5 we can simplify all points between start and end
             for (uint16_t i = start_index + 1; i < end_index; i++) {
-                _simplify.bitmask.clear(i);
+                simplify_bitmask_clear(i);
                 _simplify.removal_required = true;
             }
+            // move onto the next section
+            _simplify.start = end_index;
+            _simplify.stack_count--;
         }
     }
     _simplify.path_points_completed = _simplify.path_points_count;
@@ -533,35 +731,70 @@ void AP_SmartRTL::detect_loops()
     const uint32_t start_time_us = AP_HAL::micros();
 
     // run for defined amount of time
-    while (AP_HAL::micros() - start_time_us < SMARTRTL_PRUNING_LOOP_TIME_US) {
-
-        // advance inner loop
-        _prune.j++;
-        if (_prune.j > _prune.i - 2) {
-            // set inner loop back to first point
-            _prune.j = 1;
-            // reduce outer loop
-            _prune.i--;
-            // complete when outer loop has run out of new points to check
-            if (_prune.i < 4 || _prune.i < _prune.path_points_completed) {
-                _prune.complete = true;
-                _prune.path_points_completed = _prune.path_points_count;
-                return;
-            }
+    while (AP_HAL::micros() - start_time_us < SMARTRTL_CLEANUP_TIME_US) {
+
+        // complete when outer loop has run out of new points to check
+        if (_prune.i < 4 || _prune.i < _prune.path_points_completed) {
+            _prune.complete = true;
+            _prune.path_points_completed = _prune.path_points_count;
+            return;
+        }
+
+        // compare segment ending at point i with all earlier segments and then move onto the previous segment
+        if (detect_loop_with_segment(_prune.i--) && _prune.complete) {
+            // loop buffer is full
+            return;
         }
+    }
+}
 
-        // find the closest distance between two line segments and the mid-point
-        dist_point dp = segment_segment_dist(_path[_prune.i], _path[_prune.i-1], _path[_prune.j-1], _path[_prune.j]);
-        if (dp.distance < SMARTRTL_PRUNING_DELTA) {
-            // if there is a loop here, add to loop array
-            if (!add_loop(_prune.j, _prune.i-1, dp.midpoint)) {
-                // if the buffer is full, stop trying to prune
-                _prune.complete = true;
+// search for a loop between the segment ending at path point i and all earlier segments
+// returns true if a loop was found or the loop array is full.  Chunks are skipped if their bounding box is not within
+// SMARTRTL_PRUNING_DELTA of the segment
+bool AP_SmartRTL::detect_loop_with_segment(uint16_t i)
+{
+    const Vector3l seg_start = get_path_point(i-1);
+    const Vector3l seg_end = get_path_point(i);
+    const Vector3f seg_start_pos = decode_point(seg_start);
+    const Vector3f seg_end_pos = decode_point(seg_end);
+
+    // bounding box of the segment expanded by the pruning distance (rounded up)
+    const int32_t margin = ceilf(SMARTRTL_PRUNING_DELTA / _path_resolution) + 1;
+    const Vector3l seg_min(MIN(seg_start.x, seg_end.x) - margin, MIN(seg_start.y, seg_end.y) - margin, MIN(seg_start.z, seg_end.z) - margin);
+    const Vector3l seg_max(MAX(seg_start.x, seg_end.x) + margin, MAX(seg_start.y, seg_end.y) + margin, MAX(seg_start.z, seg_end.z) + margin);
+
+    // segments from path point j-1 to j, for j from 1 to i-2, are checked in order.  A chunk's
+    // bounding box includes the point before the chunk so it covers all segments ending in the chunk
+    const uint16_t j_last = i - 2;
+    for (uint16_t chunk = 0; chunk <= j_last / SMARTRTL_CHUNK_POINTS; chunk++) {
+        const path_chunk_t &c = _path_chunks[chunk];
+        if (c.min.x > seg_max.x || c.max.x < seg_min.x ||
+            c.min.y > seg_max.y || c.max.y < seg_min.y ||
+            c.min.z > seg_max.z || c.max.z < seg_min.z) {
+            continue;
+        }
+        const uint16_t j_first = MAX(chunk * SMARTRTL_CHUNK_POINTS, 1);
+        const uint16_t j_chunk_last = MIN(chunk * SMARTRTL_CHUNK_POINTS + SMARTRTL_CHUNK_POINTS - 1, j_last);
+        Vector3l point = get_path_point(j_first - 1);
+        Vector3f pos = decode_point(point);
+        for (uint16_t j = j_first; j <= j_chunk_last; j++) {
+            const Vector3f prev_pos = pos;
+            next_path_point(j, point);
+            pos = decode_point(point);
+
+            // find the closest distance between two line segments and the mid-point
+            const dist_point dp = segment_segment_dist(seg_end_pos, seg_start_pos, prev_pos, pos);
+            if (dp.distance < SMARTRTL_PRUNING_DELTA) {
+                // if there is a loop here, add to loop array
+                if (!add_loop(j, i-1, dp.midpoint)) {
+                    // if the buffer is full, stop trying to prune
+                    _prune.complete = true;
+                }
+                return true;
             }
-            // set inner loop forward to trigger outer loop move to next segment
-            _prune.j = _prune.i;
         }
     }
+    return false;
 }
 
 // restart simplify if new points have been added to path
@@ -588,7 +821,7 @@ void AP_SmartRTL::restart_simplification(uint16_t path_points_count)
 {
     _simplify.complete = false;
     _simplify.removal_required = false;
-    _simplify.bitmask.setall();
+    simplify_bitmask_setall();
     _simplify.stack_count = 0;
     _simplify.path_points_count = path_points_count;
 }
@@ -605,7 +838,6 @@ void AP_SmartRTL::restart_pruning(uint16_t path_points_count)
 {
     _prune.complete = false;
     _prune.i = (path_points_count > 0) ? path_points_count - 1 : 0;
-    _prune.j = 0;
     _prune.path_points_count = path_points_count;
 }
 
@@ -624,24 +856,17 @@ void AP_SmartRTL::remove_points_by_simplify_bitmask()
     if (!_path_sem.take_nonblocking()) {
         return;
     }
-    uint16_t dest = 1;
-    uint16_t removed = 0;
-    for (uint16_t src = 1; src < _path_points_count; src++) {
-        if (!_simplify.bitmask.get(src)) {
-            log_action(SRTL_POINT_SIMPLIFY, _path[src]);
-            removed++;
-        } else {
-            _path[dest] = _path[src];
-            dest++;
-        }
-    }
+    const int32_t removed = rewrite_path(1, SRTL_POINT_SIMPLIFY, [this](uint16_t index, Vector3l &point) {
+        return simplify_bitmask_get(index);
+    });
 
     // reduce count of the number of points simplified
-    if (_path_points_count > removed && _simplify.path_points_count > removed) {
+    // if the path could not be rewritten it is unchanged and the points are simply not removed
+    if (removed >= 0 && _path_points_count > removed && _simplify.path_points_count > removed) {
         _path_points_count -= removed;
         _simplify.path_points_count -= removed;
         _simplify.path_points_completed = _simplify.path_points_count;
-    } else {
+    } else if (removed >= 0) {
         // this is an error that should never happen so deactivate
         deactivate(SRTL_DEACTIVATED_PROGRAM_ERROR, "program error");
     }
@@ -649,7 +874,7 @@ void AP_SmartRTL::remove_points_by_simplify_bitmask()
     _path_sem.give();
 
     // flag point removal is complete
-    _simplify.bitmask.setall();
+    simplify_bitmask_setall();
     _simplify.removal_required = false;
 }
 
@@ -674,40 +899,48 @@ bool AP_SmartRTL::remove_points_by_loops(uint16_t num_points_to_remove)
         i--;
         prune_loop_t loop = _prune.loops[i];
 
+        // remove last prune loop from array
+        _prune.loops_count--;
+
+        // remove points between start and end of the loop and shift points after the end of the loop down by the number of points in the loop
         // midpoint goes into start_index (this is the end point of the first segment)
-        _path[loop.start_index] = loop.midpoint;
+        const Vector3l midpoint = encode_point(loop.midpoint);
+        const int32_t removed = rewrite_path(loop.start_index, SRTL_POINT_PRUNE, [&loop, &midpoint](uint16_t index, Vector3l &point) {
+            if (index == loop.start_index) {
+                point = midpoint;
+            } else if (index <= loop.end_index) {
+                return false;
+            }
+            return true;
+        });
 
-        // shift points after the end of the loop down by the number of points in the loop
-        uint16_t loop_num_points_to_remove = loop.end_index - loop.start_index;
-        for (uint16_t dest = loop.start_index + 1; dest < _path_points_count - loop_num_points_to_remove; dest++) {
-            log_action(SRTL_POINT_PRUNE, _path[dest]);
-            _path[dest] = _path[dest + loop_num_points_to_remove];
+        // skip the loop if the midpoint is too far from its new neighbours for the bridging points to fit.  This
+        // can only happen with extremely long segments and leaves the path unchanged
+        if (removed < 0) {
+            continue;
         }
-
-        if (_path_points_count > loop_num_points_to_remove) {
-            _path_points_count -= loop_num_points_to_remove;
-            removed_points += loop_num_points_to_remove;
-        } else {
+        // bridging points may reduce the number of points removed
+        const uint16_t loop_num_points_removed = removed;
+        if (loop_num_points_removed > loop.end_index - loop.start_index || _path_points_count <= loop_num_points_removed) {
             // this is an error that should never happen so deactivate
             deactivate(SRTL_DEACTIVATED_PROGRAM_ERROR, "program error");
             _path_sem.give();
             // we return true so thorough_cleanup does not get stuck
             return true;
         }
+        _path_points_count -= loop_num_points_removed;
+        removed_points += loop_num_points_removed;
 
         // fix the indices of any existing prune loops
         // we do not check for overlapping loops because add_loops should have caught them
         for (uint16_t loop_cnt = 0; loop_cnt < i; loop_cnt++) {
             if (_prune.loops[loop_cnt].start_index >= loop.end_index) {
-                _prune.loops[loop_cnt].start_index -= loop_num_points_to_remove;
+                _prune.loops[loop_cnt].start_index -= loop_num_points_removed;
             }
             if (_prune.loops[loop_cnt].end_index >= loop.end_index) {
-                _prune.loops[loop_cnt].end_index -= loop_num_points_to_remove;
+                _prune.loops[loop_cnt].end_index -= loop_num_points_removed;
             }
         }
-
-        // remove last prune loop from array
-        _prune.loops_count--;
     }
 
     _path_sem.give();
@@ -731,9 +964,14 @@ bool AP_SmartRTL::add_loop(uint16_t start_index, uint16_t end_index, const Vecto
 
     // create new loop structure and calculate length squared of loop
     prune_loop_t new_loop = {start_index, end_index, midpoint, 0.0f};
-    new_loop.length_squared = midpoint.distance_squared(_path[start_index]) + midpoint.distance_squared(_path[end_index]);
+    Vector3l point = get_path_point(start_index);
+    Vector3f pos = decode_point(point);
+    new_loop.length_squared = midpoint.distance_squared(pos) + midpoint.distance_squared(decode_point(get_path_point(end_index)));
     for (uint16_t i = start_index; i < end_index; i++) {
-        new_loop.length_squared += _path[i].distance_squared(_path[i+1]);
+        const Vector3f prev_pos = pos;
+        next_path_point(i+1, point);
+        pos = decode_point(point);
+        new_loop.length_squared += prev_pos.distance_squared(pos);
     }
 
     // look for overlapping loops and find their combined length
@@ -1,13 +1,14 @@
 #pragma once
 
 #include <AP_HAL/AP_HAL.h>
-#include <AP_Common/Bitmask.h>
 #include <AP_Math/AP_Math.h>
 
 // definitions and macros
 #define SMARTRTL_ACCURACY_DEFAULT        2.0f   // default _ACCURACY parameter value.  Points will be no closer than this distance (in meters) together.
-#define SMARTRTL_POINTS_DEFAULT          300    // default _POINTS parameter value.  High numbers improve path pruning but use more memory and CPU for cleanup. Memory used will be 20bytes * this number.
-#define SMARTRTL_POINTS_MAX              500    // the absolute maximum number of points this library can support.
+#define SMARTRTL_POINTS_DEFAULT          300    // default _POINTS parameter value.  High numbers improve path pruning but use more memory and CPU for cleanup. Memory used will be 15bytes * this number.
+#define SMARTRTL_POINTS_MAX              1000   // the absolute maximum number of points this library can support.  Limits memory to about 15k, as used by the 500 points of the previous path format.
+                                                // The int16 offsets plus cleanup buffers take about 15 bytes per point, so tens of thousands of points
+                                                // would need several hundred k, beyond what SmartRTL may take on most boards
 #define SMARTRTL_TIMEOUT                 15000  // the time in milliseconds with no points saved to the path (for whatever reason), before SmartRTL is disabled for the flight
 #define SMARTRTL_CLEANUP_POINT_TRIGGER   50     // simplification will trigger when this many points are added to the path
 #define SMARTRTL_CLEANUP_START_MARGIN    10     // routine cleanup algorithms begin when the path array has only this many empty slots remaining
@@ -16,10 +17,14 @@
 #define SMARTRTL_SIMPLIFY_STACK_LEN_MULT (2.0f/3.0f)+1  // simplify buffer size as compared to maximum number of points.
                                                 // The minimum is int((s/2-1)+min(s/2, SMARTRTL_POINTS_MAX-s)), where s = pow(2, floor(log(SMARTRTL_POINTS_MAX)/log(2)))
                                                 // To avoid this annoying math, a good-enough overestimate is ceil(SMARTRTL_POINTS_MAX*2.0f/3.0f)
-#define SMARTRTL_SIMPLIFY_TIME_US        200    // maximum time (in microseconds) the simplification algorithm will run before returning
 #define SMARTRTL_PRUNING_DELTA (_accuracy * 0.99)   // How many meters apart must two points be, such that we can assume that there is no obstacle between them.  must be smaller than _ACCURACY parameter
 #define SMARTRTL_PRUNING_LOOP_BUFFER_LEN_MULT 0.25f // pruning loop buffer size as compared to maximum number of points
-#define SMARTRTL_PRUNING_LOOP_TIME_US    200    // maximum time (in microseconds) that the loop finding algorithm will run before returning
+#define SMARTRTL_CLEANUP_TIME_US         1000   // time (in microseconds) the simplification and loop finding algorithms run before yielding to the rest of the cleanup thread
+#define SMARTRTL_CLEANUP_THREAD_INTERVAL_MS  1  // cleanup thread sleeps for this many milliseconds between calls to run_background_cleanup
+#define SMARTRTL_CLEANUP_THREAD_STACK    4096   // cleanup thread stack size in bytes
+#define SMARTRTL_CHUNK_POINTS            16     // path is stored in chunks of this many points. The first point of each chunk is stored in full, the others as int16 offsets from the previous point
+#define SMARTRTL_POINT_RESOLUTION_RATIO  0.05f  // points are stored with a resolution of this fraction of the _ACCURACY parameter
+#define SMARTRTL_POINT_RESOLUTION_MIN    0.001f // minimum resolution (in meters) of stored points
 
 class AP_SmartRTL {
 
@@ -38,7 +43,7 @@ public:
     uint16_t get_num_points() const;
 
     // get a point on the path
-    const Vector3f& get_point(uint16_t index) const { return _path[index]; }
+    Vector3f get_point(uint16_t index) const { return decode_point(get_path_point(index)); }
 
     // get next point on the path to home, returns true on success
     bool pop_point(Vector3f& point);
@@ -71,7 +76,7 @@ public:
     // cancel request for thorough cleanup
     void cancel_request_for_thorough_cleanup();
 
-    // run background cleanup - should be run regularly from the IO thread
+    // run background cleanup - run regularly from the cleanup thread
     void run_background_cleanup();
 
     // parameter var table
@@ -97,6 +102,37 @@ private:
     // add point to end of path
     bool add_point(const Vector3f& point);
 
+    // cleanup thread, runs run_background_cleanup until the vehicle is rebooted
+    void cleanup_thread();
+
+    // conversion between points in meters and points in units of _path_resolution
+    Vector3l encode_point(const Vector3f& point) const;
+    Vector3f decode_point(const Vector3l& point) const;
+
+    // get a point on the path in units of _path_resolution
+    Vector3l get_path_point(uint16_t index) const;
+
+    // advance point from the path point before index to the path point at index
+    // used to walk along the path without decoding each chunk from its start
+    void next_path_point(uint16_t index, Vector3l& point) const;
+
+    // write point to the path at index.  prev should hold the point at index-1
+    // the caller is responsible for ensuring that point is within an int16 offset of prev (see points_to_bridge)
+    void write_path_point(uint16_t index, const Vector3l& point, const Vector3l& prev);
+
+    // returns the number of points which must be inserted on the straight line between from and to
+    // so that every point can be stored as an int16 offset from the point before it
+    static uint16_t points_to_bridge(const Vector3l& from, const Vector3l& to);
+
+    // returns the num'th of num_points points evenly spaced along the straight line between from and to
+    static Vector3l bridge_point(const Vector3l& from, const Vector3l& to, uint16_t num, uint16_t num_points);
+
+    // rewrite the path from from_index onwards, removing points for which keep_point returns false and logging them with remove_action
+    // keep_point may also change the point.  long straight gaps are bridged with evenly spaced points
+    // returns the number of points removed from the path or -1 if the path could not be rewritten and is unchanged
+    template <typename KeepPointFn>
+    int32_t rewrite_path(uint16_t from_index, SRTL_Actions remove_action, KeepPointFn keep_point);
+
     // routine cleanup attempts to remove 10 points (see SMARTRTL_CLEANUP_POINT_MIN definition) by simplification or loop pruning
     void routine_cleanup(uint16_t path_points_count, uint16_t path_points_complete_limit);
 
@@ -140,6 +176,11 @@ private:
     // returns false if it failed to remove points (because it could not take semaphore)
     bool remove_points_by_loops(uint16_t num_points_to_remove);
 
+    // search for a loop between the segment ending at path point i and all earlier segments
+    // returns true if a loop was found or the loop array is full.  Chunks are skipped if their bounding box is not within
+    // SMARTRTL_PRUNING_DELTA of the segment
+    bool detect_loop_with_segment(uint16_t i);
+
     // add loop to loops array
     //  returns true if loop added successfully, false on failure (because loop array is full)
     //  checks if loop overlaps with an existing loop, keeps only the longer loop
@@ -176,29 +217,46 @@ private:
     ThoroughCleanupType _thorough_clean_type;   // used by example sketch to test simplify and prune separately
 
     // path variables
-    Vector3f* _path;    // points are stored in meters from EKF origin in NED
+    // points are stored in meters from EKF origin in NED quantised to _path_resolution.  The path is split into
+    // chunks of SMARTRTL_CHUNK_POINTS points.  Each chunk holds its first point in full and the remaining points
+    // are stored as int16 offsets from the previous point, roughly halving the memory used by each point
+    typedef struct {
+        Vector3l first;     // first point in the chunk
+        Vector3l min;       // bounding box of the points in the chunk and the last point of the previous chunk
+        Vector3l max;       // used to quickly skip segments which are far away when searching for loops
+    } path_chunk_t;
+    typedef struct {
+        int16_t x;
+        int16_t y;
+        int16_t z;
+    } path_offset_t;
+    path_chunk_t* _path_chunks; // chunks holding the first point of each chunk and bounding boxes
+    path_offset_t* _path_offsets;   // offsets of each point from the previous point
+    float _path_resolution;     // resolution (in meters) of stored points, calculated from _ACCURACY on init
     uint16_t _path_points_max;  // after the array has been allocated, we will need to know how big it is. We can't use the parameter, because a user could change the parameter in-flight
     uint16_t _path_points_count;// number of points in the path array
     uint16_t _path_points_completed_limit;  // set by main thread to the path_point_count when a point is popped.  used by simplify and prune algorithms to detect path shrinking
     HAL_Semaphore _path_sem;   // semaphore for updating path
 
     // Simplify
-    // structure and buffer to hold the "to-do list" for the simplify algorithm.
-    typedef struct {
-        uint16_t start;
-        uint16_t finish;
-    } simplify_start_finish_t;
     struct {
         bool complete;          // true after simplify_detection has completed
         bool removal_required;  // true if some simplify-able points have been found on the path, set true by detect_simplifications, set false by remove_points_by_simplify_bitmask
         uint16_t path_points_count; // copy of _path_points_count taken when the simply algorithm started
         uint16_t path_points_completed = SMARTRTL_POINTS_MAX; // number of points in that path that have already been simplified and should be ignored
-        simplify_start_finish_t* stack;
-        uint16_t stack_max;     // maximum number of elements in the _simplify_stack array
-        uint16_t stack_count;   // number of elements in _simplify_stack array
-        Bitmask<SMARTRTL_POINTS_MAX> bitmask;  // simplify algorithm clears bits for each point that can be removed
+        uint16_t start;         // start of the section of the path currently being simplified
+        uint16_t* stack;        // "to-do list" holding the ends of the sections still to be simplified. Each section starts at the end of the one above it on the stack
+        uint16_t stack_max;     // maximum number of elements in the stack array
+        uint16_t stack_count;   // number of elements in stack array
+        uint32_t* bitmask;      // simplify algorithm clears bits for each point that can be removed
+        uint16_t bitmask_words; // number of 32bit words in bitmask array
     } _simplify;
 
+    // accessors for the simplify bitmask
+    bool simplify_bitmask_get(uint16_t index) const { return (_simplify.bitmask[index / 32] & (1U << (index % 32))) != 0; }
+    void simplify_bitmask_clear(uint16_t index) { _simplify.bitmask[index / 32] &= ~(1U << (index % 32)); }
+    void simplify_bitmask_setall() { memset(_simplify.bitmask, 0xff, _simplify.bitmask_words * sizeof(uint32_t)); }
+
     // Pruning
     typedef struct {
         uint16_t start_index;   // index of the first point in the loop
@@ -210,8 +268,7 @@ private:
         bool complete;
         uint16_t path_points_count;  // copy of _path_points_count taken when the prune algorithm started
         uint16_t path_points_completed; // number of points in that path that have already been checked for loops and should be ignored
-        uint16_t i;     // loop search's outer loop index
-        uint16_t j;     // loop search's inner loop index
+        uint16_t i;     // loop search's outer loop index.  Segment from path point i-1 to i will be checked next
         prune_loop_t* loops;// the result of the pruning algorithm
         uint16_t loops_max; // maximum number of elements in the _prunable_loops array
         uint16_t loops_count;   // number of elements in the _prunable_loops array
@@ -32,6 +32,10 @@ AP_AHRS_NavEKF &ahrs(vehicle.ahrs);
 AP_SmartRTL smart_rtl{true};
 AP_BoardConfig board_config;
 
+// points are stored by SmartRTL with a resolution of SMARTRTL_POINT_RESOLUTION_RATIO * accuracy (0.1m by default)
+// so they are compared with this tolerance (in meters)
+#define POINT_TOLERANCE 0.1f
+
 void setup();
 void loop();
 void reset();
@@ -103,7 +107,7 @@ void check_path(const std::vector<Vector3f>& correct_path, const char* test_name
     bool points_match = true;
     uint16_t failure_index = 0;
     for (uint16_t i = 0; i < points_to_compare; i++) {
-        if (smart_rtl.get_point(i) != correct_path[i]) {
+        if ((smart_rtl.get_point(i) - correct_path[i]).length() > POINT_TOLERANCE) {
             failure_index = i;
             points_match = false;
         }
@@ -118,7 +122,7 @@ void check_path(const std::vector<Vector3f>& correct_path, const char* test_name
     // display the first failed point and all subsequent points
     if (!points_match) {
         for (uint16_t j = failure_index; j < points_to_compare; j++) {
-            const Vector3f& smartrtl_point = smart_rtl.get_point(j);
+            const Vector3f smartrtl_point = smart_rtl.get_point(j);
             hal.console->printf("   expected point %d to be %4.2f,%4.2f,%4.2f, got %4.2f,%4.2f,%4.2f\n",
                             (int)j,
                             (double)correct_path[j].x,
@@ -41,12 +41,38 @@ const AP_Param::GroupInfo AP_Terrain::var_info[] = {
 
     // @Param: SPACING
     // @DisplayName: Terrain grid spacing
-    // @Description: Distance between terrain grid points in meters. This controls the horizontal resolution of the terrain data that is stored on te SD card and requested from the ground station. If your GCS is using the worldwide SRTM database then a resolution of 100 meters is appropriate. Some parts of the world may have higher resolution data available, such as 30 meter data available in the SRTM database in the USA. The grid spacing also controls how much data is kept in memory during flight. A larger grid spacing will allow for a larger amount of data in memory. A grid spacing of 100 meters results in the vehicle keeping 12 grid squares in memory with each grid square having a size of 2.7 kilometers by 3.2 kilometers. Any additional grid squares are stored on the SD once they are fetched from the GCS and will be demand loaded as needed.
+    // @Description: Distance between terrain grid points in meters. This controls the horizontal resolution of the terrain data that is stored on te SD card and requested from the ground station. If your GCS is using the worldwide SRTM database then a resolution of 100 meters is appropriate. Some parts of the world may have higher resolution data available, such as 30 meter data available in the SRTM database in the USA. The grid spacing also controls how much data is kept in memory during flight. A larger grid spacing will allow for a larger amount of data in memory. With a grid spacing of 100 meters each grid square kept in memory (see TERRAIN_CACHE_SZ) has a size of 2.7 kilometers by 3.2 kilometers. Any additional grid squares are stored on the SD once they are fetched from the GCS and will be demand loaded as needed.
     // @Units: m
     // @Increment: 1
     // @User: Advanced
     AP_GROUPINFO("SPACING",   1, AP_Terrain, grid_spacing, 100),
 
+    // @Param: CACHE_SZ
+    // @DisplayName: Terrain cache size
+    // @Description: The number of terrain grid blocks kept in memory. Each grid block uses about 1.8 kilobytes of memory and covers 32x28 terrain grid points. A larger cache reduces disk reads and extrapolation on long terrain following legs at high speed, at the cost of memory. A reboot is required for changes to take effect.
+    // @Range: 4 128
+    // @Increment: 1
+    // @RebootRequired: True
+    // @User: Advanced
+    AP_GROUPINFO("CACHE_SZ",  2, AP_Terrain, config_cache_size, TERRAIN_GRID_BLOCK_CACHE_SIZE),
+
+    // @Param: PREFETCH
+    // @DisplayName: Terrain prefetch enable
+    // @Description: When enabled, terrain grid blocks along the current mission leg and along the terrain lookahead bearing are loaded from the SD card before they are needed
+    // @Values: 0:Disable,1:Enable
+    // @User: Advanced
+    AP_GROUPINFO("PREFETCH",  3, AP_Terrain, prefetch_enable, 1),
+
+#if AP_TERRAIN_MMAP_ENABLED
+    // @Param: MMAP
+    // @DisplayName: Terrain memory mapped database
+    // @Description: When enabled, all terrain files in the terrain directory are memory mapped at startup and terrain heights are read directly from the mapping, so terrain lookups never wait for disk reads. This needs enough RAM to hold the terrain files in use and is only available on Linux based boards.
+    // @Values: 0:Disable,1:Enable
+    // @RebootRequired: True
+    // @User: Advanced
+    AP_GROUPINFO("MMAP",      4, AP_Terrain, mmap_enable, 0),
+#endif
+
     AP_GROUPEND
 };
 
@@ -98,9 +124,45 @@ bool AP_Terrain::height_amsl(const Location &loc, float &height, bool corrected)
 
     calculate_grid_info(loc, info);
 
-    // find the grid
-    const struct grid_block &grid = find_grid_cache(info).grid;
+    bool have_height = false;
+#if AP_TERRAIN_MMAP_ENABLED
+    // try the memory mapped database first, which never waits on disk
+    const struct grid_block *mgrid = mmap_find_block(info);
+    if (mgrid != nullptr) {
+        have_height = interpolate_height(*mgrid, info, height);
+    }
+#endif
+
+    if (!have_height) {
+        // find the grid
+        const struct grid_block &grid = find_grid_cache(info).grid;
+        if (!interpolate_height(grid, info, height)) {
+            return false;
+        }
+    }
 
+    if (loc.lat == ahrs.get_home().lat &&
+        loc.lng == ahrs.get_home().lng) {
+        // remember home altitude as a special case
+        home_height = height;
+        home_loc = loc;
+    }
+
+    // apply correction which assumes home altitude is at terrain altitude
+    if (corrected) {
+        height += (ahrs.get_home().alt * 0.01f) - home_height;
+    }
+
+    return true;
+}
+
+
+/*
+  interpolate the height at a grid_info position within a grid block.
+  Returns false if the surrounding heights are not available
+ */
+bool AP_Terrain::interpolate_height(const struct grid_block &grid, const struct grid_info &info, float &height)
+{
     /*
       note that we rely on the one square overlap to ensure these
       calculations don't go past the end of the arrays
@@ -133,23 +195,9 @@ bool AP_Terrain::height_amsl(const Location &loc, float &height, bool corrected)
     float avg  = (1.0f-info.frac_y) * avg1 + info.frac_y * avg2;
 
     height = avg;
-
-    if (loc.lat == ahrs.get_home().lat &&
-        loc.lng == ahrs.get_home().lng) {
-        // remember home altitude as a special case
-        home_height = height;
-        home_loc = loc;
-    }
-
-    // apply correction which assumes home altitude is at terrain altitude
-    if (corrected) {
-        height += (ahrs.get_home().alt * 0.01f) - home_height;
-    }
-
     return true;
 }
 
-
 /* 
    find difference between home terrain height and the terrain
    height at the current location in meters. A positive result
@@ -268,24 +316,33 @@ float AP_Terrain::lookahead(float bearing, float distance, float climb_ratio)
         return 0;
     }
 
-    float climb = 0;
-    float lookahead_estimate = 0;
-
-    // check for terrain at grid spacing intervals
-    while (distance > 0) {
-        loc.offset_bearing(bearing, grid_spacing);
-        climb += climb_ratio * grid_spacing;
-        distance -= grid_spacing;
-        float height;
-        if (height_amsl(loc, height, false)) {
-            float rise = (height - base_height) - climb;
-            if (rise > lookahead_estimate) {
-                lookahead_estimate = rise;
-            }
-        }
+    // remember the lookahead path so upcoming grids can be prefetched
+    prefetch_bearing = bearing;
+    prefetch_distance = distance;
+    prefetch_lookahead_ms = AP_HAL::millis();
+
+    if (distance <= 0) {
+        return 0;
+    }
+
+    // check for terrain along the path in a single pass, loading any
+    // grids we don't have. The rise above the climb line is the
+    // negative of the clearance below it
+    Location end = loc;
+    end.offset_bearing(bearing, distance);
+    Profile prof;
+    float rise = 0;
+    if (profile(loc, end, base_height, climb_ratio, prof, nullptr, 0, true)) {
+        rise = MAX(-prof.min_clearance, 0);
     }
 
-    return lookahead_estimate;
+    if (prof.num_valid < prof.num_samples) {
+        // some of the path is still loading, so don't let the missing
+        // terrain lower the estimate
+        return MAX(rise, lookahead_rise);
+    }
+    lookahead_rise = rise;
+    return rise;
 }
 
 
@@ -320,6 +377,9 @@ void AP_Terrain::update(void)
     // check for pending rally data
     update_rally_data();
 
+    // load grids we are about to fly into
+    update_prefetch();
+
     // update capabilities and status
     if (allocate()) {
         if (!pos_valid) {
@@ -350,10 +410,12 @@ void AP_Terrain::log_terrain_data()
     float terrain_height = 0;
     float current_height = 0;
     uint16_t pending, loaded;
+    uint32_t hits, misses, prefetched;
 
     height_amsl(loc, terrain_height, false);
     height_above_terrain(current_height, true);
     get_statistics(pending, loaded);
+    get_cache_statistics(hits, misses, prefetched);
 
     struct log_TERRAIN pkt = {
         LOG_PACKET_HEADER_INIT(LOG_TERRAIN_MSG),
@@ -365,7 +427,10 @@ void AP_Terrain::log_terrain_data()
         terrain_height : terrain_height,
         current_height : current_height,
         pending        : pending,
-        loaded         : loaded
+        loaded         : loaded,
+        cache_hits     : hits,
+        cache_misses   : misses,
+        prefetched     : prefetched
     };
     AP::logger().WriteBlock(&pkt, sizeof(pkt));
 }
@@ -382,14 +447,45 @@ bool AP_Terrain::allocate(void)
     if (cache != nullptr) {
         return true;
     }
-    cache = (struct grid_cache *)calloc(TERRAIN_GRID_BLOCK_CACHE_SIZE, sizeof(cache[0]));
-    if (cache == nullptr) {
+    const uint16_t size = constrain_int16(config_cache_size, 4, TERRAIN_GRID_BLOCK_CACHE_SIZE_MAX);
+
+    // use a power of two number of hash buckets, at least twice the
+    // number of cache entries to keep the chains short
+    uint16_t hash_size = 1;
+    while (hash_size < size*2) {
+        hash_size <<= 1;
+    }
+
+    cache = (struct grid_cache *)calloc(size, sizeof(cache[0]));
+    cache_hash = (int16_t *)calloc(hash_size, sizeof(cache_hash[0]));
+    if (cache == nullptr || cache_hash == nullptr) {
+        free(cache);
+        free(cache_hash);
+        cache = nullptr;
+        cache_hash = nullptr;
         enable.set(0);
         gcs().send_text(MAV_SEVERITY_CRITICAL, "Terrain: Allocation failed");
         return false;
     }
-    cache_size = TERRAIN_GRID_BLOCK_CACHE_SIZE;
+    for (uint16_t i=0; i<size; i++) {
+        cache[i].hash_next = -1;
+    }
+    for (uint16_t i=0; i<hash_size; i++) {
+        cache_hash[i] = -1;
+    }
+    cache_hash_size = hash_size;
+    cache_size = size;
     return true;
 }
 
+/*
+  get grid cache statistics for logging
+ */
+void AP_Terrain::get_cache_statistics(uint32_t &hits, uint32_t &misses, uint32_t &prefetched) const
+{
+    hits = cache_hits;
+    misses = cache_misses;
+    prefetched = cache_prefetched;
+}
+
 #endif // AP_TERRAIN_AVAILABLE
@@ -30,6 +30,14 @@
 #include <AP_Param/AP_Param.h>
 #include <AP_Mission/AP_Mission.h>
 
+#ifndef AP_TERRAIN_MMAP_ENABLED
+#define AP_TERRAIN_MMAP_ENABLED (CONFIG_HAL_BOARD == HAL_BOARD_LINUX || CONFIG_HAL_BOARD == HAL_BOARD_SITL)
+#endif
+
+#if AP_TERRAIN_MMAP_ENABLED
+#include <atomic>
+#endif
+
 #define TERRAIN_DEBUG 0
 
 
@@ -51,12 +59,31 @@
 #define TERRAIN_GRID_BLOCK_SIZE_X (TERRAIN_GRID_MAVLINK_SIZE*TERRAIN_GRID_BLOCK_MUL_X)
 #define TERRAIN_GRID_BLOCK_SIZE_Y (TERRAIN_GRID_MAVLINK_SIZE*TERRAIN_GRID_BLOCK_MUL_Y)
 
-// number of grid_blocks in the LRU memory cache
+// default number of grid_blocks in the LRU memory cache
 #define TERRAIN_GRID_BLOCK_CACHE_SIZE 12
 
+// maximum number of grid_blocks in the LRU memory cache
+#define TERRAIN_GRID_BLOCK_CACHE_SIZE_MAX 128
+
+// maximum number of grid_blocks to prefetch per update() call. At most
+// half the cache holds prefetched grids that have not been used yet
+#define TERRAIN_PREFETCH_MAX_BLOCKS 4
+
+// time a lookahead() bearing remains valid for prefetching
+#define TERRAIN_PREFETCH_LOOKAHEAD_TIMEOUT_MS 5000
+
 // format of grid on disk
 #define TERRAIN_GRID_FORMAT_VERSION 1
 
+// maximum number of degree files memory mapped at once
+#define TERRAIN_MMAP_MAX_TILES 64
+
+// minimum time between requests to map a missing degree file
+#define TERRAIN_MMAP_REQUEST_INTERVAL_MS 5000
+
+// number of mapped grid blocks paged in per IO thread call
+#define TERRAIN_MMAP_PREFAULT_BLOCKS 256
+
 #if TERRAIN_DEBUG
 #define ASSERT_RANGE(v,minv,maxv) assert((v)<=(maxv)&&(v)>=(minv))
 #else
@@ -170,6 +197,50 @@ public:
      */
     float lookahead(float bearing, float distance, float climb_ratio);
 
+    /*
+      terrain profile along a segment, see profile()
+     */
+    struct Profile {
+        float max_height;           // highest terrain sampled, meters AMSL
+        float max_height_dist;      // distance from start of highest terrain, meters
+        float min_clearance;        // lowest height of the reference line above the terrain, meters
+        float min_clearance_dist;   // distance from start of lowest clearance, meters
+        uint16_t num_samples;       // number of samples taken
+        uint16_t num_valid;         // number of samples with terrain data
+    };
+
+    /*
+      calculate the terrain profile from start to end in a single pass
+      over the grid, sampling at grid spacing intervals. Clearance is
+      relative to a reference line starting at start_height meters
+      AMSL and rising climb_ratio meters per meter travelled.
+
+      If heights is not nullptr the terrain height of the first
+      max_heights samples is stored in it, with NaN where no terrain
+      data is available. Unless load_missing is true only grid blocks
+      already in memory are used and no disk reads are started.
+
+      return false if no terrain data is available along the segment
+     */
+    bool profile(const Location &start, const Location &end,
+                 float start_height, float climb_ratio,
+                 Profile &prof, float *heights = nullptr, uint16_t max_heights = 0,
+                 bool load_missing = false);
+
+    /*
+      calculate the terrain profile between two locations, with the
+      clearance relative to a straight line between their altitudes
+     */
+    bool profile_segment(const Location &start, const Location &end,
+                         Profile &prof, float *heights = nullptr, uint16_t max_heights = 0);
+
+    /*
+      calculate the terrain profile of the mission leg ending at the
+      given mission command index
+     */
+    bool profile_mission_leg(uint16_t index, Profile &prof,
+                             float *heights = nullptr, uint16_t max_heights = 0);
+
     /*
       log terrain status to AP_Logger
      */
@@ -180,6 +251,11 @@ public:
      */
     void get_statistics(uint16_t &pending, uint16_t &loaded);
 
+    /*
+      get grid cache hit/miss statistics
+     */
+    void get_cache_statistics(uint32_t &hits, uint32_t &misses, uint32_t &prefetched) const;
+
 private:
     // allocate the terrain subsystem data
     bool allocate(void);
@@ -242,8 +318,15 @@ private:
 
         volatile enum GridCacheState state;
 
-        // the last time access was requested to this block, used for LRU
-        uint32_t last_access_ms;
+        // access sequence number of the last access to this block,
+        // used for LRU
+        uint32_t last_access;
+
+        // next cache index in the same hash bucket, or -1
+        int16_t hash_next;
+
+        // loaded by prefetch and not yet used
+        bool prefetched;
     };
 
     /*
@@ -278,11 +361,55 @@ private:
     // given a location, fill a grid_info structure
     void calculate_grid_info(const Location &loc, struct grid_info &info) const;
 
+    // the two halves of calculate_grid_info(). The grid indices are
+    // cheap, the grid_block SW corner is only needed when the indices
+    // move to a new grid_block
+    void calculate_grid_idx(const Location &loc, struct grid_info &info) const;
+    void calculate_grid_corner(struct grid_info &info) const;
+
+    /*
+      interpolate the height at a grid_info position within a grid
+      block. Returns false if the surrounding heights are not available
+     */
+    bool interpolate_height(const struct grid_block &grid, const struct grid_info &info, float &height);
+
+    /*
+      number of grid blocks per row of a degree file, and the byte
+      offset of a grid block within its degree file
+     */
+    uint16_t calc_east_blocks(int8_t lat_degrees, int16_t lon_degrees) const;
+    uint32_t block_file_offset(const struct grid_block &block) const;
+
     /*
       find a grid structure given a grid_info
     */
     struct grid_cache &find_grid_cache(const struct grid_info &info);
 
+    /*
+      grid cache hash index management
+    */
+    uint16_t grid_hash(int32_t lat, int32_t lon) const;
+    int16_t find_cache_idx(int32_t lat, int32_t lon, uint16_t spacing) const;
+    void cache_hash_insert(uint16_t idx);
+    void cache_hash_remove(uint16_t idx);
+
+    /*
+      choose a cache entry to replace and load it with the given grid
+    */
+    struct grid_cache &load_grid_cache(const struct grid_info &info, bool prefetch=false);
+
+    /*
+      prefetch the grid for a location into the cache, returning true
+      if a disk read was scheduled for it
+    */
+    bool prefetch_grid(const Location &loc);
+    uint8_t prefetch_line(const Location &start, float bearing, float distance, uint8_t max_blocks);
+
+    /*
+      prefetch grids along the current mission leg and lookahead bearing
+    */
+    void update_prefetch(void);
+
     /*
       calculate bit number in grid_block bitmap. This corresponds to a
       bit representing a 4x4 mavlink transmitted block
@@ -315,7 +442,7 @@ private:
       disk IO functions
      */
     int16_t find_io_idx(enum GridCacheState state);
-    uint16_t get_block_crc(struct grid_block &block);
+    uint16_t get_block_crc(const struct grid_block &block) const;
     void check_disk_read(void);
     void check_disk_write(void);
     void io_timer(void);
@@ -324,6 +451,48 @@ private:
     void write_block(void);
     void read_block(void);
 
+#if AP_TERRAIN_MMAP_ENABLED
+    /*
+      memory mapped terrain database. Degree files are mapped by the
+      IO thread and then read directly by height_amsl(), bypassing the
+      grid cache and its disk reads
+     */
+    enum MMapBlockState : uint8_t {
+        MMAP_BLOCK_UNCHECKED = 0, // CRC not yet checked
+        MMAP_BLOCK_VALID     = 1, // CRC, position and spacing ok
+        MMAP_BLOCK_INVALID   = 2, // empty or corrupt block
+        MMAP_BLOCK_WRITING   = 3, // being written by the IO thread
+    };
+
+    struct mmap_tile {
+        const union grid_io_block *blocks;
+        enum MMapBlockState *block_state;
+        // blocks in a full degree, the size of the mapping
+        uint32_t num_blocks;
+        // blocks inside the file, grown by the main thread as blocks
+        // are written past the end
+        std::atomic<uint32_t> file_blocks;
+        // blocks paged in by the IO thread, which the main thread
+        // may read without a page fault
+        std::atomic<uint32_t> ready_blocks;
+        size_t map_size;
+        uint16_t east_blocks;
+        uint16_t spacing;
+        int16_t lon_degrees;
+        int8_t lat_degrees;
+    };
+
+    bool mmap_enabled(void) const;
+    const struct grid_block *mmap_find_block(const struct grid_info &info);
+    int16_t mmap_find_tile(int8_t lat_degrees, int16_t lon_degrees);
+    void mmap_block_write_start(const struct grid_block &block);
+    void mmap_block_write_done(const struct grid_block &block);
+    void mmap_io_timer(void);
+    void mmap_import_all(void);
+    bool mmap_tile_file(int8_t lat_degrees, int16_t lon_degrees, const char *path);
+    void mmap_prefault(struct mmap_tile &tile);
+#endif
+
     /*
       check for missing mission terrain data
      */
@@ -338,15 +507,45 @@ private:
     // parameters
     AP_Int8  enable;
     AP_Int16 grid_spacing; // meters between grid points
+    AP_Int16 config_cache_size; // number of grid blocks to cache
+    AP_Int8  prefetch_enable;
+#if AP_TERRAIN_MMAP_ENABLED
+    AP_Int8  mmap_enable;
+#endif
 
     // reference to AP_Mission, so we can ask preload terrain data for 
     // all waypoints
     const AP_Mission &mission;
 
     // cache of grids in memory, LRU
-    uint8_t cache_size = 0;
+    uint16_t cache_size = 0;
     struct grid_cache *cache = nullptr;
 
+    // hash buckets indexing the cache by grid lat/lon, each holding
+    // the first cache index in the bucket or -1
+    uint16_t cache_hash_size = 0;
+    int16_t *cache_hash = nullptr;
+
+    // access sequence counter for LRU
+    uint32_t access_counter;
+
+    // cache statistics
+    uint32_t cache_hits;
+    uint32_t cache_misses;
+    uint32_t cache_prefetched;
+
+    // number of cache entries loaded by prefetch and not yet used
+    uint16_t prefetch_resident;
+
+    // last bearing and distance passed to lookahead(), for prefetching
+    float prefetch_bearing;
+    float prefetch_distance;
+    uint32_t prefetch_lookahead_ms;
+
+    // rise returned by the last lookahead() with terrain data for the
+    // whole path, used while grids along the path are loading
+    float lookahead_rise;
+
     // a grid_cache block waiting for disk IO
     enum DiskIoState {
         DiskIoIdle      = 0,
@@ -412,6 +611,23 @@ private:
 
     char *file_path = nullptr;
 
+#if AP_TERRAIN_MMAP_ENABLED
+    // mapped degree files. Entries below mmap_num_tiles are only
+    // written by the IO thread before mmap_num_tiles is incremented,
+    // except for block_state which is owned by the main thread once
+    // the tile is published
+    struct mmap_tile mmap_tiles[TERRAIN_MMAP_MAX_TILES];
+    std::atomic<uint8_t> mmap_num_tiles;
+    uint8_t mmap_last_tile;
+
+    // degree file requested by the main thread
+    volatile bool mmap_request_pending;
+    bool mmap_import_done;
+    int8_t mmap_request_lat_degrees;
+    int16_t mmap_request_lon_degrees;
+    uint32_t mmap_last_request_ms;
+#endif
+
     // status
     enum TerrainStatus system_status = TerrainStatusDisabled;
 
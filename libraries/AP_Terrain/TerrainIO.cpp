@@ -31,17 +31,28 @@
 extern const AP_HAL::HAL& hal;
 
 /*
-  check for blocks that need to be read from disk
+  check for blocks that need to be read from disk. Blocks waiting for
+  a demand read are always read before prefetched blocks, and the most
+  recently accessed block is read first
  */
 void AP_Terrain::check_disk_read(void)
 {
+    int16_t newest_i = -1;
     for (uint16_t i=0; i<cache_size; i++) {
-        if (cache[i].state == GRID_CACHE_DISKWAIT) {
-            disk_block.block = cache[i].grid;
-            disk_io_state = DiskIoWaitRead;
-            return;
+        if (cache[i].state != GRID_CACHE_DISKWAIT) {
+            continue;
         }
-    }    
+        if (newest_i == -1 ||
+            (cache[newest_i].prefetched && !cache[i].prefetched) ||
+            (cache[newest_i].prefetched == cache[i].prefetched &&
+             cache[i].last_access > cache[newest_i].last_access)) {
+            newest_i = i;
+        }
+    }
+    if (newest_i != -1) {
+        disk_block.block = cache[newest_i].grid;
+        disk_io_state = DiskIoWaitRead;
+    }
 }
 
 /*
@@ -52,6 +63,9 @@ void AP_Terrain::check_disk_write(void)
     for (uint16_t i=0; i<cache_size; i++) {
         if (cache[i].state == GRID_CACHE_DIRTY) {
             disk_block.block = cache[i].grid;
+#if AP_TERRAIN_MMAP_ENABLED
+            mmap_block_write_start(disk_block.block);
+#endif
             disk_io_state = DiskIoWaitWrite;
             return;
         }
@@ -91,14 +105,25 @@ void AP_Terrain::schedule_disk_io(void)
                 cache[cache_idx].grid = disk_block.block;
             }
             cache[cache_idx].state = GRID_CACHE_VALID;
-            cache[cache_idx].last_access_ms = AP_HAL::millis();
+            if (cache[cache_idx].prefetched) {
+                cache_prefetched++;
+            }
         }
+        // start on the next block straight away rather than waiting
+        // for the next call
         disk_io_state = DiskIoIdle;
+        check_disk_read();
+        if (disk_io_state == DiskIoIdle) {
+            check_disk_write();
+        }
         break;
     }
 
     case DiskIoDoneWrite: {
         // a write has completed
+#if AP_TERRAIN_MMAP_ENABLED
+        mmap_block_write_done(disk_block.block);
+#endif
         int16_t cache_idx = find_io_idx(GRID_CACHE_DIRTY);
         if (cache_idx != -1) {
             if (cache[cache_idx].grid.bitmap == disk_block.block.bitmap) {
@@ -206,25 +231,39 @@ void AP_Terrain::open_file(void)
 }
 
 /*
-  seek to the right offset for disk_block
+  work out how many grid blocks there are in each row of a degree
+  file at this latitude
  */
-void AP_Terrain::seek_offset(void)
+uint16_t AP_Terrain::calc_east_blocks(int8_t lat_degrees, int16_t lon_degrees) const
 {
-    struct grid_block &block = disk_block.block;
-    // work out how many longitude blocks there are at this latitude
     Location loc1, loc2;
-    loc1.lat = block.lat_degrees*10*1000*1000L;
-    loc1.lng = block.lon_degrees*10*1000*1000L;
-    loc2.lat = block.lat_degrees*10*1000*1000L;
-    loc2.lng = (block.lon_degrees+1)*10*1000*1000L;
+    loc1.lat = lat_degrees*10*1000*1000L;
+    loc1.lng = lon_degrees*10*1000*1000L;
+    loc2.lat = lat_degrees*10*1000*1000L;
+    loc2.lng = (lon_degrees+1)*10*1000*1000L;
 
     // shift another two blocks east to ensure room is available
     loc2.offset(0, 2*grid_spacing*TERRAIN_GRID_BLOCK_SIZE_Y);
     const Vector2f offset = loc1.get_distance_NE(loc2);
-    uint16_t east_blocks = offset.y / (grid_spacing*TERRAIN_GRID_BLOCK_SIZE_Y);
+    return offset.y / (grid_spacing*TERRAIN_GRID_BLOCK_SIZE_Y);
+}
+
+/*
+  get the offset of a grid block within its degree file
+ */
+uint32_t AP_Terrain::block_file_offset(const struct grid_block &block) const
+{
+    const uint16_t east_blocks = calc_east_blocks(block.lat_degrees, block.lon_degrees);
+    return (east_blocks * block.grid_idx_x + 
+            block.grid_idx_y) * sizeof(union grid_io_block);
+}
 
-    uint32_t file_offset = (east_blocks * block.grid_idx_x + 
-                            block.grid_idx_y) * sizeof(union grid_io_block);
+/*
+  seek to the right offset for disk_block
+ */
+void AP_Terrain::seek_offset(void)
+{
+    const uint32_t file_offset = block_file_offset(disk_block.block);
     if (AP::FS().lseek(fd, file_offset, SEEK_SET) != (off_t)file_offset) {
 #if TERRAIN_DEBUG
         hal.console->printf("Seek %lu failed - %s\n",
@@ -318,6 +357,10 @@ void AP_Terrain::read_block(void)
  */
 void AP_Terrain::io_timer(void)
 {
+#if AP_TERRAIN_MMAP_ENABLED
+    mmap_io_timer();
+#endif
+
     if (io_failure) {
         // don't keep trying io, so we don't thrash the filesystem
         // code while flying
@@ -0,0 +1,376 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  memory mapped terrain database for boards with plenty of RAM
+
+  Each degree file is mapped read-only, with the mapping covering a
+  full degree so blocks later written past the end of the file by the
+  normal disk IO path appear in it without remapping. The file itself
+  is never extended: blocks past its end are treated as missing until
+  written. The IO thread pages the blocks in before lookups may use
+  them, so lookups read the grid blocks directly from the mapping
+  without waiting for the disk. Pages can still be reclaimed under
+  memory pressure unless the process locks its memory, as the Linux
+  HAL does when running as root.
+ */
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>
+#include <GCS_MAVLink/GCS_MAVLink.h>
+#include <GCS_MAVLink/GCS.h>
+#include <stdio.h>
+#include "AP_Terrain.h"
+
+#if AP_TERRAIN_AVAILABLE && AP_TERRAIN_MMAP_ENABLED
+
+#include <AP_Filesystem/AP_Filesystem.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+extern const AP_HAL::HAL& hal;
+
+/*
+  return true if the memory mapped database is in use
+ */
+bool AP_Terrain::mmap_enabled(void) const
+{
+    return mmap_enable != 0 && grid_spacing > 0;
+}
+
+/*
+  find a published tile for a degree file, or -1
+ */
+int16_t AP_Terrain::mmap_find_tile(int8_t lat_degrees, int16_t lon_degrees)
+{
+    const uint8_t num_tiles = mmap_num_tiles.load(std::memory_order_acquire);
+
+    // successive lookups are nearly always in the same degree file
+    if (mmap_last_tile < num_tiles &&
+        mmap_tiles[mmap_last_tile].lat_degrees == lat_degrees &&
+        mmap_tiles[mmap_last_tile].lon_degrees == lon_degrees &&
+        mmap_tiles[mmap_last_tile].spacing == grid_spacing) {
+        return mmap_last_tile;
+    }
+    for (uint8_t i=0; i<num_tiles; i++) {
+        if (mmap_tiles[i].lat_degrees == lat_degrees &&
+            mmap_tiles[i].lon_degrees == lon_degrees &&
+            mmap_tiles[i].spacing == grid_spacing) {
+            mmap_last_tile = i;
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*
+  find a validated grid block in the memory mapped database. Returns
+  nullptr if the block is not available, in which case the caller
+  falls back to the grid cache
+ */
+const AP_Terrain::grid_block *AP_Terrain::mmap_find_block(const struct grid_info &info)
+{
+    if (!mmap_enabled()) {
+        return nullptr;
+    }
+
+    const int16_t t = mmap_find_tile(info.lat_degrees, info.lon_degrees);
+    if (t == -1) {
+        // ask the IO thread to map this degree file
+        const uint32_t now = AP_HAL::millis();
+        if (!mmap_request_pending &&
+            now - mmap_last_request_ms > TERRAIN_MMAP_REQUEST_INTERVAL_MS) {
+            mmap_request_lat_degrees = info.lat_degrees;
+            mmap_request_lon_degrees = info.lon_degrees;
+            mmap_last_request_ms = now;
+            mmap_request_pending = true;
+        }
+        return nullptr;
+    }
+
+    struct mmap_tile &tile = mmap_tiles[t];
+    const uint32_t idx = tile.east_blocks * (uint32_t)info.grid_idx_x + info.grid_idx_y;
+    if (info.grid_idx_y >= tile.east_blocks ||
+        idx >= tile.ready_blocks.load(std::memory_order_acquire)) {
+        // past the end of the file, or not paged in yet
+        return nullptr;
+    }
+
+    const struct grid_block &block = tile.blocks[idx].block;
+    switch (tile.block_state[idx]) {
+    case MMAP_BLOCK_VALID:
+        return &block;
+
+    case MMAP_BLOCK_INVALID:
+    case MMAP_BLOCK_WRITING:
+        return nullptr;
+
+    case MMAP_BLOCK_UNCHECKED:
+        break;
+    }
+
+    // first access since the block was mapped or written, check it
+    // is the block we want and that it is intact
+    if (block.bitmap != 0 &&
+        block.lat == info.grid_lat &&
+        block.lon == info.grid_lon &&
+        block.spacing == grid_spacing &&
+        block.version == TERRAIN_GRID_FORMAT_VERSION &&
+        block.crc == get_block_crc(block)) {
+        tile.block_state[idx] = MMAP_BLOCK_VALID;
+        return &block;
+    }
+    tile.block_state[idx] = MMAP_BLOCK_INVALID;
+    return nullptr;
+}
+
+/*
+  a block is about to be written by the IO thread, don't read it from
+  the mapping until the write is complete
+ */
+void AP_Terrain::mmap_block_write_start(const struct grid_block &block)
+{
+    const int16_t t = mmap_find_tile(block.lat_degrees, block.lon_degrees);
+    if (t == -1) {
+        return;
+    }
+    struct mmap_tile &tile = mmap_tiles[t];
+    const uint32_t idx = tile.east_blocks * (uint32_t)block.grid_idx_x + block.grid_idx_y;
+    if (idx < tile.num_blocks) {
+        tile.block_state[idx] = MMAP_BLOCK_WRITING;
+    }
+}
+
+/*
+  a block write has completed, re-validate it on next access. A write
+  past the end of the file extends it, so the IO thread can page in
+  the new blocks
+ */
+void AP_Terrain::mmap_block_write_done(const struct grid_block &block)
+{
+    const int16_t t = mmap_find_tile(block.lat_degrees, block.lon_degrees);
+    if (t == -1) {
+        // the block may have created a new degree file
+        if (mmap_enabled()) {
+            mmap_last_request_ms = 0;
+        }
+        return;
+    }
+    struct mmap_tile &tile = mmap_tiles[t];
+    const uint32_t idx = tile.east_blocks * (uint32_t)block.grid_idx_x + block.grid_idx_y;
+    if (idx < tile.num_blocks) {
+        tile.block_state[idx] = MMAP_BLOCK_UNCHECKED;
+        if (idx >= tile.file_blocks.load(std::memory_order_relaxed)) {
+            tile.file_blocks.store(idx+1, std::memory_order_release);
+        }
+    }
+}
+
+/********************************************************
+All the functions below this point run in the IO timer context. A
+tile is filled in completely before mmap_num_tiles is incremented to
+publish it to the main thread.
+*********************************************************/
+
+/*
+  map one degree file. The mapping covers the full size of a degree at
+  the current grid spacing so all blocks written later are inside it,
+  but only the blocks within the file are used. Pages of the mapping
+  past the end of the file are never touched, as reading them would
+  raise SIGBUS
+ */
+bool AP_Terrain::mmap_tile_file(int8_t lat_degrees, int16_t lon_degrees, const char *path)
+{
+    const uint8_t num_tiles = mmap_num_tiles.load(std::memory_order_relaxed);
+    if (num_tiles >= TERRAIN_MMAP_MAX_TILES) {
+        return false;
+    }
+    for (uint8_t i=0; i<num_tiles; i++) {
+        if (mmap_tiles[i].lat_degrees == lat_degrees &&
+            mmap_tiles[i].lon_degrees == lon_degrees &&
+            mmap_tiles[i].spacing == grid_spacing) {
+            // already mapped
+            return true;
+        }
+    }
+
+    // number of grid block rows in a degree of latitude, with the
+    // same margin as calc_east_blocks() uses for columns
+    Location loc1, loc2;
+    loc1.lat = lat_degrees*10*1000*1000L;
+    loc1.lng = lon_degrees*10*1000*1000L;
+    loc2.lat = (lat_degrees+1)*10*1000*1000L;
+    loc2.lng = lon_degrees*10*1000*1000L;
+    const Vector2f offset = loc1.get_distance_NE(loc2);
+    const uint16_t north_blocks = offset.x / (grid_spacing*TERRAIN_GRID_BLOCK_SPACING_X) + 2;
+    const uint16_t east_blocks = calc_east_blocks(lat_degrees, lon_degrees);
+
+    const uint32_t num_blocks = north_blocks * (uint32_t)east_blocks;
+    const size_t map_size = num_blocks * sizeof(union grid_io_block);
+
+    int fd2 = ::open(path, O_RDWR|O_CLOEXEC);
+    if (fd2 == -1) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd2, &st) != 0) {
+        ::close(fd2);
+        return false;
+    }
+    const uint32_t file_blocks = MIN((uint64_t)st.st_size / sizeof(union grid_io_block), num_blocks);
+    void *p = mmap(nullptr, map_size, PROT_READ, MAP_SHARED, fd2, 0);
+    // the mapping stays valid after the file is closed
+    ::close(fd2);
+    if (p == MAP_FAILED) {
+        return false;
+    }
+    // we will be reading most of this, start paging it in now
+    if (file_blocks > 0) {
+        madvise(p, file_blocks * sizeof(union grid_io_block), MADV_WILLNEED);
+    }
+
+    enum MMapBlockState *state = (enum MMapBlockState *)calloc(num_blocks, sizeof(state[0]));
+    if (state == nullptr) {
+        munmap(p, map_size);
+        return false;
+    }
+
+    struct mmap_tile &tile = mmap_tiles[num_tiles];
+    tile.blocks = (const union grid_io_block *)p;
+    tile.block_state = state;
+    tile.num_blocks = num_blocks;
+    tile.file_blocks.store(file_blocks, std::memory_order_relaxed);
+    tile.ready_blocks.store(0, std::memory_order_relaxed);
+    tile.map_size = map_size;
+    tile.east_blocks = east_blocks;
+    tile.spacing = grid_spacing;
+    tile.lat_degrees = lat_degrees;
+    tile.lon_degrees = lon_degrees;
+
+    mmap_num_tiles.store(num_tiles+1, std::memory_order_release);
+
+#if TERRAIN_DEBUG
+    hal.console->printf("Terrain: mapped %s %u blocks\n", path, (unsigned)num_blocks);
+#endif
+    return true;
+}
+
+/*
+  page in the next blocks of a tile within the file, so the main thread
+  doesn't take a page fault when it first reads them
+ */
+void AP_Terrain::mmap_prefault(struct mmap_tile &tile)
+{
+    const uint32_t ready = tile.ready_blocks.load(std::memory_order_relaxed);
+    const uint32_t file_blocks = tile.file_blocks.load(std::memory_order_acquire);
+    if (ready >= file_blocks) {
+        return;
+    }
+    const uint32_t n = MIN(file_blocks - ready, (uint32_t)TERRAIN_MMAP_PREFAULT_BLOCKS);
+
+    const volatile uint8_t *start = (const volatile uint8_t *)&tile.blocks[ready];
+    const size_t len = n * sizeof(union grid_io_block);
+    const long page_size = sysconf(_SC_PAGESIZE);
+    uint8_t sum = 0;
+    for (size_t ofs = 0; ofs < len; ofs += page_size) {
+        sum += start[ofs];
+    }
+    sum += start[len-1];
+    (void)sum;
+
+    tile.ready_blocks.store(ready + n, std::memory_order_release);
+}
+
+/*
+  map all degree files found in the terrain directory
+ */
+void AP_Terrain::mmap_import_all(void)
+{
+    const char* terrain_dir = hal.util->get_custom_terrain_directory();
+    if (terrain_dir == nullptr) {
+        terrain_dir = HAL_BOARD_TERRAIN_DIRECTORY;
+    }
+    DIR *d = AP::FS().opendir(terrain_dir);
+    if (d == nullptr) {
+        return;
+    }
+    struct dirent *de;
+    uint8_t count = 0;
+    while ((de = AP::FS().readdir(d)) != nullptr) {
+        // files are named like N35E149.DAT
+        char ns, ew;
+        unsigned lat, lon;
+        if (strlen(de->d_name) != 11 ||
+            sscanf(de->d_name, "%c%02u%c%03u.DAT", &ns, &lat, &ew, &lon) != 4 ||
+            (ns != 'N' && ns != 'S') ||
+            (ew != 'E' && ew != 'W') ||
+            lat > 90 || lon > 180) {
+            continue;
+        }
+        char *path = nullptr;
+        if (asprintf(&path, "%s/%s", terrain_dir, de->d_name) <= 0) {
+            continue;
+        }
+        const int8_t lat_degrees = ns=='S' ? -(int16_t)lat : (int16_t)lat;
+        const int16_t lon_degrees = ew=='W' ? -(int16_t)lon : (int16_t)lon;
+        if (mmap_tile_file(lat_degrees, lon_degrees, path)) {
+            count++;
+        }
+        free(path);
+    }
+    AP::FS().closedir(d);
+    if (count > 0) {
+        gcs().send_text(MAV_SEVERITY_INFO, "Terrain: mapped %u files", (unsigned)count);
+    }
+}
+
+/*
+  IO thread handling of the memory mapped database
+ */
+void AP_Terrain::mmap_io_timer(void)
+{
+    if (!mmap_enabled()) {
+        return;
+    }
+    if (!mmap_import_done) {
+        mmap_import_done = true;
+        mmap_import_all();
+    }
+    if (mmap_request_pending) {
+        const char* terrain_dir = hal.util->get_custom_terrain_directory();
+        if (terrain_dir == nullptr) {
+            terrain_dir = HAL_BOARD_TERRAIN_DIRECTORY;
+        }
+        char *path = nullptr;
+        if (asprintf(&path, "%s/%c%02u%c%03u.DAT", terrain_dir,
+                     mmap_request_lat_degrees<0?'S':'N',
+                     (unsigned)MIN(abs((int32_t)mmap_request_lat_degrees), 99),
+                     mmap_request_lon_degrees<0?'W':'E',
+                     (unsigned)MIN(abs((int32_t)mmap_request_lon_degrees), 999)) > 0) {
+            mmap_tile_file(mmap_request_lat_degrees, mmap_request_lon_degrees, path);
+            free(path);
+        }
+        mmap_request_pending = false;
+    }
+
+    const uint8_t num_tiles = mmap_num_tiles.load(std::memory_order_acquire);
+    for (uint8_t i=0; i<num_tiles; i++) {
+        mmap_prefault(mmap_tiles[i]);
+    }
+}
+
+#endif // AP_TERRAIN_AVAILABLE && AP_TERRAIN_MMAP_ENABLED
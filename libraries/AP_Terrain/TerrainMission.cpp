@@ -24,6 +24,7 @@
 #include <GCS_MAVLink/GCS.h>
 #include "AP_Terrain.h"
 #include <AP_GPS/AP_GPS.h>
+#include <AP_AHRS/AP_AHRS.h>
 
 #if AP_TERRAIN_AVAILABLE
 
@@ -164,4 +165,82 @@ void AP_Terrain::update_rally_data(void)
     }
 }
 
+/*
+  make sure the grid for a location is in the cache, scheduling a disk
+  read if it isn't. Returns true if a new grid was loaded
+ */
+bool AP_Terrain::prefetch_grid(const Location &loc)
+{
+    struct grid_info info;
+    calculate_grid_info(loc, info);
+    if (find_cache_idx(info.grid_lat, info.grid_lon, grid_spacing) != -1) {
+        return false;
+    }
+    load_grid_cache(info, true);
+    return true;
+}
+
+/*
+  prefetch grids along a line from start, loading at most max_blocks
+  new grids. Returns the number of grids loaded
+ */
+uint8_t AP_Terrain::prefetch_line(const Location &start, float bearing, float distance, uint8_t max_blocks)
+{
+    // step at half the smallest grid block dimension so no grid
+    // along the line is skipped
+    const float step = 0.5f * MIN(TERRAIN_GRID_BLOCK_SPACING_X, TERRAIN_GRID_BLOCK_SPACING_Y) * grid_spacing;
+    Location loc = start;
+    uint8_t count = 0;
+    while (distance > 0 && count < max_blocks) {
+        const float dist = MIN(step, distance);
+        loc.offset_bearing(bearing, dist);
+        distance -= dist;
+        if (prefetch_grid(loc)) {
+            count++;
+        }
+    }
+    return count;
+}
+
+/*
+  load grids we are about to fly into along the current mission leg
+  and the most recent lookahead() bearing, so they are available
+  before the vehicle reaches them
+ */
+void AP_Terrain::update_prefetch(void)
+{
+    if (prefetch_enable == 0 || grid_spacing <= 0 || !allocate()) {
+        return;
+    }
+
+    Location loc;
+    if (!AP::ahrs().get_position(loc)) {
+        return;
+    }
+
+    // never hold more than half the cache in grids prefetched but not
+    // yet used, so the grids around the current location are not
+    // evicted and prefetched grids don't evict each other
+    if (prefetch_resident >= cache_size/2) {
+        return;
+    }
+    uint8_t budget = MIN(TERRAIN_PREFETCH_MAX_BLOCKS, cache_size/2 - prefetch_resident);
+
+    // the current mission leg
+    if (mission.state() == AP_Mission::MISSION_RUNNING) {
+        const Location &dest = mission.get_current_nav_cmd().content.location;
+        if (dest.lat != 0 || dest.lng != 0) {
+            const float bearing = loc.get_bearing_to(dest) * 0.01f;
+            budget -= prefetch_line(loc, bearing, loc.get_distance(dest), budget);
+        }
+    }
+
+    // the most recent lookahead bearing
+    if (budget > 0 &&
+        prefetch_distance > 0 &&
+        AP_HAL::millis() - prefetch_lookahead_ms < TERRAIN_PREFETCH_LOOKAHEAD_TIMEOUT_MS) {
+        prefetch_line(loc, prefetch_bearing, prefetch_distance, budget);
+    }
+}
+
 #endif // AP_TERRAIN_AVAILABLE
@@ -0,0 +1,198 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  terrain profile queries along segments and mission legs
+ */
+
+#include <AP_HAL/AP_HAL.h>
+#include <AP_Common/AP_Common.h>
+#include <AP_Math/AP_Math.h>
+#include "AP_Terrain.h"
+
+#if AP_TERRAIN_AVAILABLE
+
+extern const AP_HAL::HAL& hal;
+
+/*
+  set a profile to no samples
+ */
+static void profile_init(AP_Terrain::Profile &prof)
+{
+    memset(&prof, 0, sizeof(prof));
+    prof.max_height = -FLT_MAX;
+    prof.min_clearance = FLT_MAX;
+}
+
+/*
+  calculate the terrain profile from start to end in a single pass
+  over the grid. Samples are interpolated linearly in latitude and
+  longitude, and the grid block is only looked up when the samples
+  move into a new grid block. Grid blocks which are not already
+  mapped or cached are reported as unavailable rather than loaded, so
+  a profile of a long leg doesn't flush the cache, unless load_missing
+  is set. Then they are queued for a disk read as height_amsl() does
+ */
+bool AP_Terrain::profile(const Location &start, const Location &end,
+                         float start_height, float climb_ratio,
+                         Profile &prof, float *heights, uint16_t max_heights,
+                         bool load_missing)
+{
+    profile_init(prof);
+
+    if (!allocate() || grid_spacing <= 0) {
+        return false;
+    }
+
+    const float distance = start.get_distance(end);
+    const uint32_t num_steps = MAX(1U, (uint32_t)ceilf(distance / grid_spacing));
+    if (num_steps >= UINT16_MAX) {
+        return false;
+    }
+    const int32_t dlat = end.lat - start.lat;
+    const int32_t dlng = end.lng - start.lng;
+
+    // grid block of the previous sample
+    struct grid_info block_info {};
+    bool have_block = false;
+#if AP_TERRAIN_MMAP_ENABLED
+    const struct grid_block *mgrid = nullptr;
+#endif
+    const struct grid_block *cgrid = nullptr;
+    bool cgrid_checked = false;
+
+    Location loc = start;
+    for (uint32_t i=0; i<=num_steps; i++) {
+        const float frac = i / (float)num_steps;
+        loc.lat = start.lat + (int32_t)(dlat * frac);
+        loc.lng = start.lng + (int32_t)(dlng * frac);
+        const float dist = distance * frac;
+
+        struct grid_info info;
+        calculate_grid_idx(loc, info);
+        if (!have_block ||
+            info.lat_degrees != block_info.lat_degrees ||
+            info.lon_degrees != block_info.lon_degrees ||
+            info.grid_idx_x != block_info.grid_idx_x ||
+            info.grid_idx_y != block_info.grid_idx_y) {
+            // moved into a new grid block
+            calculate_grid_corner(info);
+            block_info = info;
+            have_block = true;
+#if AP_TERRAIN_MMAP_ENABLED
+            mgrid = mmap_find_block(info);
+#endif
+            cgrid = nullptr;
+            cgrid_checked = false;
+        } else {
+            info.grid_lat = block_info.grid_lat;
+            info.grid_lon = block_info.grid_lon;
+        }
+
+        float height;
+        bool valid = false;
+#if AP_TERRAIN_MMAP_ENABLED
+        if (mgrid != nullptr) {
+            valid = interpolate_height(*mgrid, info, height);
+        }
+#endif
+        if (!valid && !cgrid_checked) {
+            if (load_missing) {
+                cgrid = &find_grid_cache(info).grid;
+            } else {
+                const int16_t idx = find_cache_idx(info.grid_lat, info.grid_lon, grid_spacing);
+                if (idx != -1) {
+                    cgrid = &cache[idx].grid;
+                }
+            }
+            cgrid_checked = true;
+        }
+        if (!valid && cgrid != nullptr) {
+            valid = interpolate_height(*cgrid, info, height);
+        }
+
+        if (heights != nullptr && i < max_heights) {
+            heights[i] = valid ? height : nanf("");
+        }
+        prof.num_samples++;
+        if (!valid) {
+            continue;
+        }
+        prof.num_valid++;
+        if (height > prof.max_height) {
+            prof.max_height = height;
+            prof.max_height_dist = dist;
+        }
+        const float clearance = (start_height + climb_ratio * dist) - height;
+        if (clearance < prof.min_clearance) {
+            prof.min_clearance = clearance;
+            prof.min_clearance_dist = dist;
+        }
+    }
+
+    return prof.num_valid > 0;
+}
+
+/*
+  calculate the terrain profile between two locations, with the
+  clearance relative to a straight line between their altitudes
+ */
+bool AP_Terrain::profile_segment(const Location &start, const Location &end,
+                                 Profile &prof, float *heights, uint16_t max_heights)
+{
+    int32_t start_alt_cm, end_alt_cm;
+    if (!start.get_alt_cm(Location::AltFrame::ABSOLUTE, start_alt_cm) ||
+        !end.get_alt_cm(Location::AltFrame::ABSOLUTE, end_alt_cm)) {
+        profile_init(prof);
+        return false;
+    }
+    const float distance = start.get_distance(end);
+    const float climb_ratio = is_positive(distance) ? (end_alt_cm - start_alt_cm) * 0.01f / distance : 0;
+    return profile(start, end, start_alt_cm * 0.01f, climb_ratio, prof, heights, max_heights);
+}
+
+/*
+  calculate the terrain profile of the mission leg ending at the given
+  mission command index. The leg starts at the previous navigation
+  command with a location, or at home
+ */
+bool AP_Terrain::profile_mission_leg(uint16_t index, Profile &prof,
+                                     float *heights, uint16_t max_heights)
+{
+    profile_init(prof);
+
+    AP_Mission::Mission_Command end_cmd;
+    if (index == 0 ||
+        !mission.read_cmd_from_storage(index, end_cmd) ||
+        !AP_Mission::is_nav_cmd(end_cmd) ||
+        !end_cmd.content.location.initialised()) {
+        return false;
+    }
+
+    // find the start of the leg. Index zero is home
+    AP_Mission::Mission_Command start_cmd;
+    uint16_t i = index;
+    do {
+        i--;
+        if (!mission.read_cmd_from_storage(i, start_cmd)) {
+            return false;
+        }
+    } while (i > 0 &&
+             (!AP_Mission::is_nav_cmd(start_cmd) || !start_cmd.content.location.initialised()));
+
+    return profile_segment(start_cmd.content.location, end_cmd.content.location,
+                           prof, heights, max_heights);
+}
+
+#endif // AP_TERRAIN_AVAILABLE
@@ -59,6 +59,16 @@ bool AP_Terrain::check_bitmap(const struct grid_block &grid, uint8_t idx_x, uint
   grid indices
 */
 void AP_Terrain::calculate_grid_info(const Location &loc, struct grid_info &info) const
+{
+    calculate_grid_idx(loc, info);
+    calculate_grid_corner(info);
+}
+
+/*
+  given a location, calculate the grid indices and fractions. This
+  leaves grid_lat and grid_lon unset
+*/
+void AP_Terrain::calculate_grid_idx(const Location &loc, struct grid_info &info) const
 {
     // grids start on integer degrees. This makes storing terrain data
     // on the SD card a bit easier
@@ -91,42 +101,137 @@ void AP_Terrain::calculate_grid_info(const Location &loc, struct grid_info &info
     info.frac_x = (offset.x - idx_x * grid_spacing) / grid_spacing;
     info.frac_y = (offset.y - idx_y * grid_spacing) / grid_spacing;
 
-    // calculate lat/lon of SW corner of 32*28 grid_block
+    ASSERT_RANGE(info.idx_x,0,TERRAIN_GRID_BLOCK_SPACING_X-1);
+    ASSERT_RANGE(info.idx_y,0,TERRAIN_GRID_BLOCK_SPACING_Y-1);
+    ASSERT_RANGE(info.frac_x,0,1);
+    ASSERT_RANGE(info.frac_y,0,1);
+}
+
+/*
+  calculate lat/lon of SW corner of the 32*28 grid_block given by the
+  degree and grid indices in info
+*/
+void AP_Terrain::calculate_grid_corner(struct grid_info &info) const
+{
+    Location ref;
+    ref.lat = info.lat_degrees*10*1000*1000L;
+    ref.lng = info.lon_degrees*10*1000*1000L;
     ref.offset(info.grid_idx_x * TERRAIN_GRID_BLOCK_SPACING_X * (float)grid_spacing,
                info.grid_idx_y * TERRAIN_GRID_BLOCK_SPACING_Y * (float)grid_spacing);
     info.grid_lat = ref.lat;
     info.grid_lon = ref.lng;
+}
 
-    ASSERT_RANGE(info.idx_x,0,TERRAIN_GRID_BLOCK_SPACING_X-1);
-    ASSERT_RANGE(info.idx_y,0,TERRAIN_GRID_BLOCK_SPACING_Y-1);
-    ASSERT_RANGE(info.frac_x,0,1);
-    ASSERT_RANGE(info.frac_y,0,1);
+/*
+  hash a grid SW corner into a cache_hash bucket
+ */
+uint16_t AP_Terrain::grid_hash(int32_t lat, int32_t lon) const
+{
+    const uint32_t h = ((uint32_t)lat * 2654435761U) ^ ((uint32_t)lon * 40503U);
+    return (h ^ (h >> 16)) & (cache_hash_size - 1);
 }
 
+/*
+  find the cache index of a grid, or -1 if not in the cache
+ */
+int16_t AP_Terrain::find_cache_idx(int32_t lat, int32_t lon, uint16_t spacing) const
+{
+    if (cache_hash == nullptr) {
+        return -1;
+    }
+    int16_t i = cache_hash[grid_hash(lat, lon)];
+    while (i != -1) {
+        const struct grid_block &grid = cache[i].grid;
+        if (grid.lat == lat &&
+            grid.lon == lon &&
+            grid.spacing == spacing) {
+            return i;
+        }
+        i = cache[i].hash_next;
+    }
+    return -1;
+}
+
+/*
+  add a cache entry to the hash index
+ */
+void AP_Terrain::cache_hash_insert(uint16_t idx)
+{
+    const uint16_t bucket = grid_hash(cache[idx].grid.lat, cache[idx].grid.lon);
+    cache[idx].hash_next = cache_hash[bucket];
+    cache_hash[bucket] = idx;
+}
+
+/*
+  remove a cache entry from the hash index
+ */
+void AP_Terrain::cache_hash_remove(uint16_t idx)
+{
+    int16_t *p = &cache_hash[grid_hash(cache[idx].grid.lat, cache[idx].grid.lon)];
+    while (*p != -1) {
+        if (*p == (int16_t)idx) {
+            *p = cache[idx].hash_next;
+            break;
+        }
+        p = &cache[*p].hash_next;
+    }
+    cache[idx].hash_next = -1;
+}
 
 /*
   find a grid structure given a grid_info
  */
 AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info)
 {
-    uint16_t oldest_i = 0;
-
     // see if we have that grid
+    const int16_t i = find_cache_idx(info.grid_lat, info.grid_lon, grid_spacing);
+    if (i != -1) {
+        cache_hits++;
+        cache[i].last_access = ++access_counter;
+        if (cache[i].prefetched) {
+            cache[i].prefetched = false;
+            prefetch_resident--;
+        }
+        return cache[i];
+    }
+
+    cache_misses++;
+    return load_grid_cache(info);
+}
+
+/*
+  replace the least recently used grid with the grid given by info,
+  initially unpopulated and waiting for a disk read. Grids with
+  changes not yet written to disk are only replaced if nothing else
+  is available. A prefetched grid doesn't count as an access, so it
+  doesn't push grids in use out of the cache ahead of their turn, and
+  it is read from disk after any waiting demand reads
+ */
+AP_Terrain::grid_cache &AP_Terrain::load_grid_cache(const struct grid_info &info, bool prefetch)
+{
+    int16_t oldest_i = -1;
+    uint16_t oldest_dirty_i = 0;
     for (uint16_t i=0; i<cache_size; i++) {
-        if (cache[i].grid.lat == info.grid_lat && 
-            cache[i].grid.lon == info.grid_lon &&
-            cache[i].grid.spacing == grid_spacing) {
-            cache[i].last_access_ms = AP_HAL::millis();
-            return cache[i];
+        if (cache[i].last_access < cache[oldest_dirty_i].last_access) {
+            oldest_dirty_i = i;
+        }
+        if (cache[i].state == GRID_CACHE_DIRTY) {
+            continue;
         }
-        if (cache[i].last_access_ms < cache[oldest_i].last_access_ms) {
+        if (oldest_i == -1 || cache[i].last_access < cache[oldest_i].last_access) {
             oldest_i = i;
         }
     }
+    if (oldest_i == -1) {
+        oldest_i = oldest_dirty_i;
+    }
+
+    cache_hash_remove(oldest_i);
 
-    // Not found. Use the oldest grid and make it this grid,
-    // initially unpopulated
     struct grid_cache &grid = cache[oldest_i];
+    if (grid.prefetched) {
+        prefetch_resident--;
+    }
     memset(&grid, 0, sizeof(grid));
 
     grid.grid.lat = info.grid_lat;
@@ -137,11 +242,19 @@ AP_Terrain::grid_cache &AP_Terrain::find_grid_cache(const struct grid_info &info
     grid.grid.lat_degrees = info.lat_degrees;
     grid.grid.lon_degrees = info.lon_degrees;
     grid.grid.version = TERRAIN_GRID_FORMAT_VERSION;
-    grid.last_access_ms = AP_HAL::millis();
+    if (prefetch) {
+        grid.last_access = access_counter;
+        grid.prefetched = true;
+        prefetch_resident++;
+    } else {
+        grid.last_access = ++access_counter;
+    }
 
     // mark as waiting for disk read
     grid.state = GRID_CACHE_DISKWAIT;
 
+    cache_hash_insert(oldest_i);
+
     return grid;
 }
 
@@ -169,15 +282,16 @@ int16_t AP_Terrain::find_io_idx(enum GridCacheState state)
 }
 
 /*
-  get CRC for a block
+  get CRC for a block, taken with crc=0
  */
-uint16_t AP_Terrain::get_block_crc(struct grid_block &block)
+uint16_t AP_Terrain::get_block_crc(const struct grid_block &block) const
 {
-    uint16_t saved_crc = block.crc;
-    block.crc = 0;
-    uint16_t ret = crc16_ccitt((const uint8_t *)&block, sizeof(block), 0);
-    block.crc = saved_crc;
-    return ret;
+    const uint8_t zero_crc[sizeof(block.crc)] {};
+    const uint8_t *b = (const uint8_t *)&block;
+    const uint32_t crc_ofs = offsetof(struct grid_block, crc);
+    uint16_t ret = crc16_ccitt(b, crc_ofs, 0);
+    ret = crc16_ccitt(zero_crc, sizeof(zero_crc), ret);
+    return crc16_ccitt(&b[crc_ofs+sizeof(block.crc)], sizeof(block)-(crc_ofs+sizeof(block.crc)), ret);
 }
 
 #endif // AP_TERRAIN_AVAILABLE
@@ -22,10 +22,12 @@ void GCS::get_sensor_status_flags(uint32_t &present,
 
 MissionItemProtocol_Waypoints *GCS::_missionitemprotocol_waypoints;
 MissionItemProtocol_Rally *GCS::_missionitemprotocol_rally;
+MissionItemProtocol_Fence *GCS::_missionitemprotocol_fence;
 
 const MAV_MISSION_TYPE GCS_MAVLINK::supported_mission_types[] = {
     MAV_MISSION_TYPE_MISSION,
     MAV_MISSION_TYPE_RALLY,
+    MAV_MISSION_TYPE_FENCE,
 };
 
 /*
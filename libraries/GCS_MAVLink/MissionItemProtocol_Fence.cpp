@@ -0,0 +1,170 @@
+/*
+  Implementation details for transfering fence inclusion and exclusion
+  zones using the MISSION_ITEM protocol to and from a GCS.
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "MissionItemProtocol_Fence.h"
+
+#include <AC_Fence/AC_Fence.h>
+#include <GCS_MAVLink/GCS.h>
+
+
+MAV_MISSION_RESULT MissionItemProtocol_Fence::append_item(const mavlink_mission_item_int_t &cmd)
+{
+    AC_PolyFenceItem item;
+    const MAV_MISSION_RESULT ret = convert_MISSION_ITEM_INT_to_AC_PolyFenceItem(cmd, item);
+    if (ret != MAV_MISSION_ACCEPTED) {
+        return ret;
+    }
+    if (!fence.polyfence().set_item(fence.polyfence().num_items(), item)) {
+        return MAV_MISSION_ERROR;
+    }
+    return MAV_MISSION_ACCEPTED;
+}
+
+MAV_MISSION_RESULT MissionItemProtocol_Fence::complete(const GCS_MAVLINK &_link)
+{
+    if (!fence.polyfence().save_items()) {
+        // leave the previous fence in place
+        fence.polyfence().reload_items();
+        _link.send_text(MAV_SEVERITY_WARNING, "Fence items invalid");
+        return MAV_MISSION_INVALID;
+    }
+    _link.send_text(MAV_SEVERITY_INFO, "Fence received");
+    return MAV_MISSION_ACCEPTED;
+}
+
+bool MissionItemProtocol_Fence::clear_all_items()
+{
+    fence.polyfence().truncate_items(0);
+    return fence.polyfence().save_items();
+}
+
+MAV_MISSION_RESULT MissionItemProtocol_Fence::convert_MISSION_ITEM_INT_to_AC_PolyFenceItem(const mavlink_mission_item_int_t &cmd, AC_PolyFenceItem &ret)
+{
+    switch (cmd.command) {
+    case MAV_CMD_NAV_FENCE_POLYGON_VERTEX_INCLUSION:
+        ret.type = AC_PolyFenceType::POLYGON_INCLUSION;
+        break;
+    case MAV_CMD_NAV_FENCE_POLYGON_VERTEX_EXCLUSION:
+        ret.type = AC_PolyFenceType::POLYGON_EXCLUSION;
+        break;
+    case MAV_CMD_NAV_FENCE_CIRCLE_INCLUSION:
+        ret.type = AC_PolyFenceType::CIRCLE_INCLUSION;
+        break;
+    case MAV_CMD_NAV_FENCE_CIRCLE_EXCLUSION:
+        ret.type = AC_PolyFenceType::CIRCLE_EXCLUSION;
+        break;
+    case MAV_CMD_NAV_FENCE_RETURN_POINT:
+        ret.type = AC_PolyFenceType::RETURN_POINT;
+        break;
+    default:
+        return MAV_MISSION_UNSUPPORTED;
+    }
+    if (cmd.frame != MAV_FRAME_GLOBAL &&
+        cmd.frame != MAV_FRAME_GLOBAL_INT &&
+        cmd.frame != MAV_FRAME_GLOBAL_RELATIVE_ALT &&
+        cmd.frame != MAV_FRAME_GLOBAL_RELATIVE_ALT_INT) {
+        return MAV_MISSION_UNSUPPORTED_FRAME;
+    }
+    if (!check_lat(cmd.x)) {
+        return MAV_MISSION_INVALID_PARAM5_X;
+    }
+    if (!check_lng(cmd.y)) {
+        return MAV_MISSION_INVALID_PARAM6_Y;
+    }
+    // param1 is the vertex count for polygons and the radius in
+    // meters for circles
+    if (ret.type != AC_PolyFenceType::RETURN_POINT &&
+        (cmd.param1 < 1 || cmd.param1 > UINT16_MAX)) {
+        return MAV_MISSION_INVALID_PARAM1;
+    }
+    ret.reserved = 0;
+    ret.param = (ret.type == AC_PolyFenceType::RETURN_POINT) ? 0 : (uint16_t)cmd.param1;
+    ret.lat = cmd.x;
+    ret.lng = cmd.y;
+    return MAV_MISSION_ACCEPTED;
+}
+
+MAV_MISSION_RESULT MissionItemProtocol_Fence::get_item(const GCS_MAVLINK &_link,
+                                                       const mavlink_message_t &msg,
+                                                       const mavlink_mission_request_int_t &packet,
+                                                       mavlink_mission_item_int_t &ret_packet)
+{
+    AC_PolyFenceItem item;
+    if (!fence.polyfence().get_item(packet.seq, item)) {
+        return MAV_MISSION_INVALID_SEQUENCE;
+    }
+
+    switch (item.type) {
+    case AC_PolyFenceType::POLYGON_INCLUSION:
+        ret_packet.command = MAV_CMD_NAV_FENCE_POLYGON_VERTEX_INCLUSION;
+        break;
+    case AC_PolyFenceType::POLYGON_EXCLUSION:
+        ret_packet.command = MAV_CMD_NAV_FENCE_POLYGON_VERTEX_EXCLUSION;
+        break;
+    case AC_PolyFenceType::CIRCLE_INCLUSION:
+        ret_packet.command = MAV_CMD_NAV_FENCE_CIRCLE_INCLUSION;
+        break;
+    case AC_PolyFenceType::CIRCLE_EXCLUSION:
+        ret_packet.command = MAV_CMD_NAV_FENCE_CIRCLE_EXCLUSION;
+        break;
+    case AC_PolyFenceType::RETURN_POINT:
+        ret_packet.command = MAV_CMD_NAV_FENCE_RETURN_POINT;
+        break;
+    default:
+        return MAV_MISSION_ERROR;
+    }
+    ret_packet.frame = MAV_FRAME_GLOBAL_INT;
+    ret_packet.param1 = item.param;
+    ret_packet.x = item.lat;
+    ret_packet.y = item.lng;
+
+    return MAV_MISSION_ACCEPTED;
+}
+
+uint16_t MissionItemProtocol_Fence::item_count() const {
+    return fence.polyfence().num_items();
+}
+
+uint16_t MissionItemProtocol_Fence::max_items() const {
+    return fence.polyfence().max_items();
+}
+
+MAV_MISSION_RESULT MissionItemProtocol_Fence::replace_item(const mavlink_mission_item_int_t &cmd)
+{
+    AC_PolyFenceItem item;
+    const MAV_MISSION_RESULT ret = convert_MISSION_ITEM_INT_to_AC_PolyFenceItem(cmd, item);
+    if (ret != MAV_MISSION_ACCEPTED) {
+        return ret;
+    }
+    if (!fence.polyfence().set_item(cmd.seq, item)) {
+        return MAV_MISSION_ERROR;
+    }
+    return MAV_MISSION_ACCEPTED;
+}
+
+void MissionItemProtocol_Fence::timeout()
+{
+    // discard the partial upload
+    fence.polyfence().reload_items();
+    link->send_text(MAV_SEVERITY_WARNING, "Fence upload timeout");
+}
+
+void MissionItemProtocol_Fence::truncate(const mavlink_mission_count_t &packet)
+{
+    fence.polyfence().truncate_items(packet.count);
+}
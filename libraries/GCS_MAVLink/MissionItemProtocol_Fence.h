@@ -0,0 +1,38 @@
+#pragma once
+
+#include "MissionItemProtocol.h"
+
+class MissionItemProtocol_Fence : public MissionItemProtocol {
+public:
+    MissionItemProtocol_Fence(class AC_Fence &_fence) :
+        fence(_fence) {}
+    void truncate(const mavlink_mission_count_t &packet) override;
+    MAV_MISSION_TYPE mission_type() const override { return MAV_MISSION_TYPE_FENCE; }
+
+    MAV_MISSION_RESULT complete(const GCS_MAVLINK &_link) override;
+    void timeout() override;
+
+protected:
+
+    ap_message next_item_ap_message_id() const override {
+        return MSG_NEXT_MISSION_REQUEST_FENCE;
+    }
+    bool clear_all_items() override WARN_IF_UNUSED;
+
+private:
+    AC_Fence &fence;
+
+    uint16_t item_count() const override;
+    uint16_t max_items() const override;
+
+    MAV_MISSION_RESULT replace_item(const mavlink_mission_item_int_t&) override WARN_IF_UNUSED;
+    MAV_MISSION_RESULT append_item(const mavlink_mission_item_int_t&) override WARN_IF_UNUSED;
+
+    MAV_MISSION_RESULT get_item(const GCS_MAVLINK &_link,
+                                const mavlink_message_t &msg,
+                                const mavlink_mission_request_int_t &packet,
+                                mavlink_mission_item_int_t &ret_packet) override WARN_IF_UNUSED;
+
+    static MAV_MISSION_RESULT convert_MISSION_ITEM_INT_to_AC_PolyFenceItem(const mavlink_mission_item_int_t &cmd, struct AC_PolyFenceItem &ret) WARN_IF_UNUSED;
+
+};
@@ -24,11 +24,16 @@
 #include "SIM_Aircraft.h"
 #include <AP_HAL_SITL/SITL_State.h>
 
+// ICAO addresses of other SITL instances are this plus their instance
+// number, clear of the randomly generated simulated vehicles
+#define SITL_TRAFFIC_ICAO_BASE 10000
+
 namespace SITL {
 
 SITL *_sitl;
 
-ADSB::ADSB(const struct sitl_fdm &_fdm, const char *_home_str)
+ADSB::ADSB(const struct sitl_fdm &_fdm, const char *_home_str, SharedTraffic *_traffic) :
+    traffic(_traffic)
 {
     float yaw_degrees;
     HALSITL::SITL_State::parse_home(_home_str, home, yaw_degrees);
@@ -76,14 +81,14 @@ void ADSB::update(void)
     if (_sitl == nullptr) {
         _sitl = AP::sitl();
         return;
-    } else if (_sitl->adsb_plane_count <= 0) {
+    } else if (_sitl->adsb_plane_count <= 0 && traffic == nullptr) {
         return;
     } else if (_sitl->adsb_plane_count >= num_vehicles_MAX) {
         _sitl->adsb_plane_count.set_and_save(0);
         num_vehicles = 0;
         return;
-    } else if (num_vehicles != _sitl->adsb_plane_count) {
-        num_vehicles = _sitl->adsb_plane_count;
+    } else if (num_vehicles != MAX(_sitl->adsb_plane_count.get(), 0)) {
+        num_vehicles = MAX(_sitl->adsb_plane_count.get(), 0);
         for (uint8_t i=0; i<num_vehicles_MAX; i++) {
             vehicles[i].initialised = false;
         }
@@ -187,6 +192,7 @@ void ADSB::send_report(void)
      */
     uint32_t now_us = AP_HAL::micros();
     if (now_us - last_report_us >= reporting_period_ms*1000UL) {
+        last_report_us = now_us;
         for (uint8_t i=0; i<num_vehicles; i++) {
             ADSB_Vehicle &vehicle = vehicles[i];
             Location loc = home;
@@ -199,7 +205,6 @@ void ADSB::send_report(void)
             }
             
             mavlink_adsb_vehicle_t adsb_vehicle {};
-            last_report_us = now_us;
 
             adsb_vehicle.ICAO_address = vehicle.ICAO_address;
             adsb_vehicle.lat = loc.lat;
@@ -221,18 +226,35 @@ void ADSB::send_report(void)
                 ADSB_FLAGS_SIMULATED;
             adsb_vehicle.squawk = 0; // NOTE: ADSB_FLAGS_VALID_SQUAWK bit is not set
 
-            mavlink_status_t *chan0_status = mavlink_get_channel_status(MAVLINK_COMM_0);
-            uint8_t saved_seq = chan0_status->current_tx_seq;
-            chan0_status->current_tx_seq = mavlink.seq;
-            len = mavlink_msg_adsb_vehicle_encode(vehicle_system_id,
-                                                  MAV_COMP_ID_ADSB,
-                                                  &msg, &adsb_vehicle);
-            chan0_status->current_tx_seq = saved_seq;
-            
-            uint8_t msgbuf[len];
-            len = mavlink_msg_to_send_buffer(msgbuf, &msg);
-            if (len > 0) {
-                mav_socket.send(msgbuf, len);
+            send_adsb_vehicle(adsb_vehicle);
+        }
+
+        // report the other SITL instances sharing the traffic view
+        if (traffic != nullptr) {
+            SharedTraffic::Vehicle others[SharedTraffic::max_vehicles];
+            const uint8_t count = traffic->get_others(others, ARRAY_SIZE(others), AP_HAL::micros64());
+            for (uint8_t i=0; i<count; i++) {
+                const SharedTraffic::Vehicle &other = others[i];
+                mavlink_adsb_vehicle_t adsb_vehicle {};
+                adsb_vehicle.ICAO_address = SITL_TRAFFIC_ICAO_BASE + other.instance;
+                adsb_vehicle.lat = other.lat;
+                adsb_vehicle.lon = other.lng;
+                adsb_vehicle.altitude_type = ADSB_ALTITUDE_TYPE_PRESSURE_QNH;
+                adsb_vehicle.altitude = other.alt_m * 1000;
+                adsb_vehicle.heading = wrap_360_cd(100*other.yaw_deg);
+                adsb_vehicle.hor_velocity = norm(other.velocity_ef.x, other.velocity_ef.y) * 100;
+                adsb_vehicle.ver_velocity = -other.velocity_ef.z * 100;
+                snprintf(adsb_vehicle.callsign, sizeof(adsb_vehicle.callsign), "SITL%u", (unsigned)other.instance);
+                adsb_vehicle.emitter_type = ADSB_EMITTER_TYPE_UAV;
+                adsb_vehicle.tslc = 1;
+                adsb_vehicle.flags =
+                    ADSB_FLAGS_VALID_COORDS |
+                    ADSB_FLAGS_VALID_ALTITUDE |
+                    ADSB_FLAGS_VALID_HEADING |
+                    ADSB_FLAGS_VALID_VELOCITY |
+                    ADSB_FLAGS_VALID_CALLSIGN |
+                    ADSB_FLAGS_SIMULATED;
+                send_adsb_vehicle(adsb_vehicle);
             }
         }
     }
@@ -263,4 +285,25 @@ void ADSB::send_report(void)
 
 }
 
+/*
+  send an ADSB_VEHICLE message to the vehicle
+ */
+void ADSB::send_adsb_vehicle(const mavlink_adsb_vehicle_t &adsb_vehicle)
+{
+    mavlink_message_t msg;
+    mavlink_status_t *chan0_status = mavlink_get_channel_status(MAVLINK_COMM_0);
+    uint8_t saved_seq = chan0_status->current_tx_seq;
+    chan0_status->current_tx_seq = mavlink.seq;
+    uint16_t len = mavlink_msg_adsb_vehicle_encode(vehicle_system_id,
+                                                   MAV_COMP_ID_ADSB,
+                                                   &msg, &adsb_vehicle);
+    chan0_status->current_tx_seq = saved_seq;
+
+    uint8_t msgbuf[len];
+    len = mavlink_msg_to_send_buffer(msgbuf, &msg);
+    if (len > 0) {
+        mav_socket.send(msgbuf, len);
+    }
+}
+
 } // namespace SITL
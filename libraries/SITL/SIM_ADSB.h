@@ -21,6 +21,7 @@
 #include <AP_HAL/utility/Socket.h>
 
 #include "SIM_Aircraft.h"
+#include "SIM_SharedTraffic.h"
 
 namespace SITL {
 
@@ -42,7 +43,7 @@ private:
         
 class ADSB {
 public:
-    ADSB(const struct sitl_fdm &_fdm, const char *home_str);
+    ADSB(const struct sitl_fdm &_fdm, const char *home_str, SharedTraffic *_traffic = nullptr);
     void update(void);
 
 private:
@@ -50,6 +51,10 @@ private:
     const uint16_t target_port = 5762;
 
     Location home;
+
+    // other SITL instances, reported as traffic alongside the simulated vehicles
+    SharedTraffic *traffic;
+
     uint8_t num_vehicles = 0;
     static const uint8_t num_vehicles_MAX = 200;
     ADSB_Vehicle vehicles[num_vehicles_MAX];
@@ -75,6 +80,7 @@ private:
     } mavlink {};
 
     void send_report(void);
+    void send_adsb_vehicle(const mavlink_adsb_vehicle_t &adsb_vehicle);
 };
 
 }  // namespace SITL
@@ -567,6 +567,19 @@ void Aircraft::update_wind(const struct sitl_input &input)
                        sinf(radians(input.wind.direction))*cosf(radians(input.wind.dir_z)), 
                        sinf(radians(input.wind.dir_z))) * input.wind.speed;
 
+    // add the gridded wind field at the vehicle position
+    if (wind_field) {
+        wind_ef += wind_field->sample(position, time_now_us * 1.0e-6f);
+    }
+
+    if (sitl && sitl->wind_turb_type == SITL::TURB_TYPE_DRYDEN) {
+        // input.wind.turbulence is the vertical intensity in m/s
+        if (input.wind.turbulence > 0 && !on_ground()) {
+            wind_ef += turbulence.update(frame_time_us * 1.0e-6f, velocity_air_ef, hagl(), input.wind.turbulence);
+        }
+        return;
+    }
+
     const float wind_turb = input.wind.turbulence * 10.0f;  // scale input.wind.turbulence to match standard deviation when using iir_coef=0.98
     const float iir_coef = 0.98f;  // filtering high frequencies from turbulence
 
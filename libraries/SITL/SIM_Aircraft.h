@@ -28,6 +28,8 @@
 #include "SIM_Gripper_EPM.h"
 #include "SIM_Parachute.h"
 #include "SIM_Precland.h"
+#include "SIM_WindField.h"
+#include "SIM_Turbulence.h"
 #include <Filter/Filter.h>
 
 namespace SITL {
@@ -47,6 +49,14 @@ public:
      */
     void set_speedup(float speedup);
 
+    /*
+      run frames as fast as possible rather than synchronising with
+      the wall clock
+     */
+    void set_unthrottled(void) {
+        use_time_sync = false;
+    }
+
     /*
       set instance number
      */
@@ -105,6 +115,9 @@ public:
 
     float gross_mass() const { return mass + external_payload_mass; }
 
+    // height above ground level in metres
+    float get_hagl(void) const { return hagl(); }
+
     virtual void set_config(const char* config) {
         config_ = config;
     }
@@ -126,6 +139,7 @@ public:
     void set_gripper_servo(Gripper_Servo *_gripper) { gripper = _gripper; }
     void set_gripper_epm(Gripper_EPM *_gripper_epm) { gripper_epm = _gripper_epm; }
     void set_precland(SIM_Precland *_precland);
+    void set_wind_field(WindField *_wind_field) { wind_field = _wind_field; }
 
 protected:
     SITL *sitl;
@@ -277,6 +291,8 @@ private:
     Gripper_EPM *gripper_epm;
     Parachute *parachute;
     SIM_Precland *precland;
+    WindField *wind_field;
+    Turbulence turbulence;
 };
 
 } // namespace SITL
@@ -206,12 +206,13 @@ static Frame supported_frames[] =
     Frame("firefly",   6, firefly_motors)
 };
 
-void Frame::init(float _mass, float hover_throttle, float _terminal_velocity, float _terminal_rotation_rate)
+void Frame::init(float _mass, float _hover_throttle, float _terminal_velocity, float _terminal_rotation_rate)
 {
     /*
        scaling from total motor power to Newtons. Allows the copter
        to hover against gravity when each motor is at hover_throttle
     */
+    hover_throttle = _hover_throttle;
     thrust_scale = (_mass * GRAVITY_MSS) / (num_motors * hover_throttle);
 
     terminal_velocity = _terminal_velocity;
@@ -239,15 +240,52 @@ void Frame::calculate_forces(const Aircraft &aircraft,
                              Vector3f &body_accel)
 {
     Vector3f thrust; // newtons
+    Vector3f vibe_accel;
+
+    // motor model settings, the same for every motor
+    const SITL *sitl = AP::sitl();
+    Motor::Model model {};
+    model.dt = 1.0f / aircraft.get_rate_hz();
+    model.speed_alpha = 1;
+    float vibe = 0;
+    float prop_dia = 0;
+    if (sitl) {
+        if (is_positive(sitl->motor.tconst)) {
+            model.speed_alpha = 1 - expf(-model.dt / sitl->motor.tconst);
+        }
+        model.expo = constrain_float(sitl->motor.expo, -1, 1);
+        model.rpm_max = sitl->motor.rpm_max;
+        model.ripple = sitl->motor.ripple;
+        vibe = sitl->motor.vibe;
+        prop_dia = sitl->motor.prop_dia;
+    }
+
+    // keep the hover throttle the same whatever the thrust curve
+    const float hover_thrust = (1 - model.expo) * hover_throttle + model.expo * sq(hover_throttle);
+    const float scale = thrust_scale * hover_throttle / hover_thrust;
 
     for (uint8_t i=0; i<num_motors; i++) {
         Vector3f mraccel, mthrust;
-        motors[i].calculate_forces(input, thrust_scale, motor_offset, mraccel, mthrust);
+        motors[i].calculate_forces(input, scale, motor_offset, model, mraccel, mthrust);
         rot_accel += mraccel;
         thrust += mthrust;
+        if (model.rpm_max > 0 && !is_zero(vibe)) {
+            vibe_accel += motors[i].imbalance_accel(vibe);
+        }
+    }
+
+    if (is_positive(prop_dia)) {
+        /*
+          ground effect, using the Cheeseman-Bennett approximation
+          T/T_inf = 1/(1-(R/4z)^2), limited to heights of at least
+          half the prop radius where it gives a third more thrust
+        */
+        const float radius = 0.5f * prop_dia;
+        const float height = MAX(aircraft.get_hagl(), 0.5f * radius);
+        thrust /= 1 - sq(radius / (4 * height));
     }
 
-    body_accel = thrust/aircraft.gross_mass();
+    body_accel = thrust/aircraft.gross_mass() + vibe_accel;
 
     if (terminal_rotation_rate > 0) {
         // rotational air resistance
@@ -266,7 +304,7 @@ void Frame::calculate_forces(const Aircraft &aircraft,
     // add some noise
     const float gyro_noise = radians(0.1);
     const float accel_noise = 0.3;
-    const float noise_scale = thrust.length() / (thrust_scale * num_motors);
+    const float noise_scale = thrust.length() / (scale * num_motors);
     rot_accel += Vector3f(aircraft.rand_normal(0, 1),
                           aircraft.rand_normal(0, 1),
                           aircraft.rand_normal(0, 1)) * gyro_noise * noise_scale;
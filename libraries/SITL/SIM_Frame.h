@@ -44,7 +44,7 @@ public:
     static Frame *find_frame(const char *name);
     
     // initialise frame
-    void init(float mass, float hover_throttle, float terminal_velocity, float terminal_rotation_rate);
+    void init(float mass, float _hover_throttle, float terminal_velocity, float terminal_rotation_rate);
 
     // calculate rotational and linear accelerations
     void calculate_forces(const Aircraft &aircraft,
@@ -53,6 +53,7 @@ public:
     
     float terminal_velocity;
     float terminal_rotation_rate;
+    float hover_throttle;
     float thrust_scale;
     uint8_t motor_offset;
 
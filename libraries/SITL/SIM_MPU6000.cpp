@@ -0,0 +1,245 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  simulated MPU6000 IMU on a simulated SPI bus
+*/
+
+#include "SIM_MPU6000.h"
+#include "SITL.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// register bits used by the simulation
+#define CONFIG_FIFO_MODE_STOP   0x40
+#define INT_STATUS_RAW_RDY      0x01
+#define INT_STATUS_FIFO_OFLOW   0x10
+#define USER_CTRL_FIFO_RESET    0x04
+#define USER_CTRL_FIFO_EN       0x40
+#define PWR_MGMT_1_SLEEP        0x40
+#define PWR_MGMT_1_DEVICE_RESET 0x80
+
+#define MPU6000_WHOAMI          0x68
+#define MPU6000_REV_D9          0x59
+
+// the simulated sensor runs at a constant temperature
+#define MPU6000_TEMP_DEGC       25.0f
+
+namespace SITL {
+
+MPU6000::MPU6000()
+{
+    reset();
+}
+
+/*
+  put the registers into their power on state
+ */
+void MPU6000::reset(void)
+{
+    memset(regs, 0, sizeof(regs));
+    regs[PWR_MGMT_1] = PWR_MGMT_1_SLEEP;
+    regs[WHOAMI] = MPU6000_WHOAMI;
+    regs[PRODUCT_ID] = MPU6000_REV_D9;
+    fifo_head = 0;
+    fifo_count = 0;
+}
+
+static void put_int16(uint8_t *buf, float v)
+{
+    const int16_t i = constrain_float(v, INT16_MIN, INT16_MAX);
+    buf[0] = uint16_t(i) >> 8;
+    buf[1] = uint16_t(i) & 0xFF;
+}
+
+/*
+  build a sample from the simulation state. The sensor is mounted with
+  its X axis along the vehicle's Y axis and its Z axis up, to match the
+  axis swap in the Invensense driver
+ */
+void MPU6000::make_sample(uint8_t sample[sample_size]) const
+{
+    const SITL *sitl = AP::sitl();
+    if (sitl == nullptr) {
+        memset(sample, 0, sample_size);
+        return;
+    }
+    const struct sitl_fdm &state = sitl->state;
+
+    const float accel_lsb = (16384 >> ((regs[ACCEL_CONFIG] >> 3) & 3)) / GRAVITY_MSS;
+    const float gyro_lsb = 131.0f / (1U << ((regs[GYRO_CONFIG] >> 3) & 3));
+
+    put_int16(&sample[0], state.yAccel * accel_lsb);
+    put_int16(&sample[2], state.xAccel * accel_lsb);
+    put_int16(&sample[4], -state.zAccel * accel_lsb);
+    put_int16(&sample[6], (MPU6000_TEMP_DEGC - 36.53f) * 340);
+    put_int16(&sample[8], state.pitchRate * gyro_lsb);
+    put_int16(&sample[10], state.rollRate * gyro_lsb);
+    put_int16(&sample[12], -state.yawRate * gyro_lsb);
+}
+
+/*
+  generate the samples due up to time_usec
+ */
+void MPU6000::update(uint64_t time_usec)
+{
+    if (regs[PWR_MGMT_1] & PWR_MGMT_1_SLEEP) {
+        next_sample_usec = time_usec;
+        return;
+    }
+    if (next_sample_usec > time_usec) {
+        return;
+    }
+
+    // the gyro runs at 8kHz with the low pass filter disabled, otherwise 1kHz
+    const uint8_t dlpf_cfg = regs[CONFIG] & 7;
+    const uint32_t base_rate_hz = (dlpf_cfg == 0 || dlpf_cfg == 7) ? 8000 : 1000;
+    const uint32_t period_usec = MAX(1000000UL * (1 + regs[SMPLRT_DIV]) / base_rate_hz, 1U);
+
+    const bool fifo_enabled = (regs[USER_CTRL] & USER_CTRL_FIFO_EN) && regs[FIFO_EN] != 0;
+
+    // there is no point generating more samples than the FIFO holds,
+    // but the ones skipped still count as lost
+    const uint64_t max_backlog_usec = period_usec * (fifo_size / sample_size + 1);
+    if (time_usec - next_sample_usec > max_backlog_usec) {
+        const uint64_t skip_usec = time_usec - max_backlog_usec - next_sample_usec;
+        if (fifo_enabled) {
+            overflow_count += skip_usec / period_usec;
+        }
+        next_sample_usec += (skip_usec / period_usec) * period_usec;
+    }
+
+    // the sensor state is the same for all samples generated now
+    uint8_t sample[sample_size];
+    make_sample(sample);
+    memcpy(&regs[ACCEL_XOUT_H], sample, sample_size);
+
+    while (next_sample_usec <= time_usec) {
+        next_sample_usec += period_usec;
+        regs[INT_STATUS] |= INT_STATUS_RAW_RDY;
+        if (!fifo_enabled) {
+            continue;
+        }
+        if (fifo_count + sample_size > fifo_size) {
+            regs[INT_STATUS] |= INT_STATUS_FIFO_OFLOW;
+            overflow_count++;
+            if (time_usec - last_overflow_report_usec > 1000000) {
+                last_overflow_report_usec = time_usec;
+                ::printf("MPU6000: FIFO overflow at %.3fs, %u samples lost\n",
+                         time_usec * 1.0e-6, (unsigned)overflow_count);
+            }
+            if (regs[CONFIG] & CONFIG_FIFO_MODE_STOP) {
+                // new samples are dropped until the FIFO is read
+                continue;
+            }
+            // otherwise the oldest sample is overwritten
+            fifo_head = (fifo_head + sample_size) % fifo_size;
+            fifo_count -= sample_size;
+        }
+        for (uint8_t i=0; i<sample_size; i++) {
+            fifo[(fifo_head + fifo_count + i) % fifo_size] = sample[i];
+        }
+        fifo_count += sample_size;
+    }
+}
+
+uint8_t MPU6000::read_register(uint8_t reg)
+{
+    uint8_t v;
+    switch (reg) {
+    case FIFO_COUNTH:
+        return fifo_count >> 8;
+    case FIFO_COUNTL:
+        return fifo_count & 0xFF;
+    case FIFO_R_W:
+        if (fifo_count == 0) {
+            return 0;
+        }
+        v = fifo[fifo_head];
+        fifo_head = (fifo_head + 1) % fifo_size;
+        fifo_count--;
+        return v;
+    case INT_STATUS:
+        // cleared on read
+        v = regs[INT_STATUS];
+        regs[INT_STATUS] = 0;
+        return v;
+    default:
+        return regs[reg];
+    }
+}
+
+void MPU6000::write_register(uint8_t reg, uint8_t val)
+{
+    switch (reg) {
+    case PWR_MGMT_1:
+        if (val & PWR_MGMT_1_DEVICE_RESET) {
+            reset();
+            return;
+        }
+        break;
+    case USER_CTRL:
+        if (val & USER_CTRL_FIFO_RESET) {
+            fifo_head = 0;
+            fifo_count = 0;
+            val &= ~USER_CTRL_FIFO_RESET;
+        }
+        break;
+    case WHOAMI:
+    case PRODUCT_ID:
+    case FIFO_COUNTH:
+    case FIFO_COUNTL:
+    case FIFO_R_W:
+        // read only
+        return;
+    default:
+        break;
+    }
+    regs[reg] = val;
+}
+
+/*
+  a register read or write. The first byte is the register, with the
+  top bit set for reads. Registers auto-increment except the FIFO
+ */
+bool MPU6000::transfer(uint64_t time_usec,
+                       const uint8_t *send, uint32_t send_len,
+                       uint8_t *recv, uint32_t recv_len)
+{
+    if (send == nullptr || send_len == 0) {
+        return false;
+    }
+    update(time_usec);
+
+    uint8_t reg = send[0] & 0x7F;
+    if (send[0] & 0x80) {
+        for (uint32_t i=0; i<recv_len; i++) {
+            recv[i] = read_register(reg);
+            if (reg != FIFO_R_W) {
+                reg = (reg + 1) % num_registers;
+            }
+        }
+        return true;
+    }
+    for (uint32_t i=1; i<send_len; i++) {
+        write_register(reg, send[i]);
+        if (reg != FIFO_R_W) {
+            reg = (reg + 1) % num_registers;
+        }
+    }
+    return true;
+}
+
+}  // namespace SITL
@@ -0,0 +1,87 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  simulated MPU6000 IMU on a simulated SPI bus
+*/
+
+#pragma once
+
+#include "SIM_SPIDevice.h"
+
+namespace SITL {
+
+/*
+  Register level simulation of the parts of an MPU6000 used by the
+  Invensense driver. Samples are generated at the configured output
+  data rate in simulation time and queued in a 1024 byte FIFO, so a
+  driver which reads the FIFO late sees the FIFO fill and, in stop
+  mode, overflow and lose samples, as on real hardware.
+*/
+class MPU6000 : public SPIDevice {
+public:
+    MPU6000();
+
+    bool transfer(uint64_t time_usec,
+                  const uint8_t *send, uint32_t send_len,
+                  uint8_t *recv, uint32_t recv_len) override;
+
+    // number of samples lost to FIFO overflow
+    uint32_t get_overflow_count(void) const { return overflow_count; }
+
+private:
+    enum Register : uint8_t {
+        PRODUCT_ID   = 0x0C,
+        SMPLRT_DIV   = 0x19,
+        CONFIG       = 0x1A,
+        GYRO_CONFIG  = 0x1B,
+        ACCEL_CONFIG = 0x1C,
+        FIFO_EN      = 0x23,
+        INT_STATUS   = 0x3A,
+        ACCEL_XOUT_H = 0x3B,
+        USER_CTRL    = 0x6A,
+        PWR_MGMT_1   = 0x6B,
+        FIFO_COUNTH  = 0x72,
+        FIFO_COUNTL  = 0x73,
+        FIFO_R_W     = 0x74,
+        WHOAMI       = 0x75,
+    };
+
+    static const uint8_t num_registers = 0x80;
+    static const uint16_t fifo_size = 1024;
+    static const uint8_t sample_size = 14;  // accel, temperature and gyro
+
+    void reset(void);
+
+    // generate the samples due up to time_usec
+    void update(uint64_t time_usec);
+
+    // build a sample from the simulation state, in register order
+    void make_sample(uint8_t sample[sample_size]) const;
+
+    uint8_t read_register(uint8_t reg);
+    void write_register(uint8_t reg, uint8_t val);
+
+    uint8_t regs[num_registers];
+
+    uint8_t fifo[fifo_size];
+    uint16_t fifo_head;     // index of the oldest byte
+    uint16_t fifo_count;
+
+    uint64_t next_sample_usec = 0;
+    uint32_t overflow_count = 0;
+    uint64_t last_overflow_report_usec = 0;
+};
+
+}  // namespace SITL
@@ -0,0 +1,165 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  simulated MS5611 barometer on a simulated SPI bus
+*/
+
+#include "SIM_MS5611.h"
+#include "SITL.h"
+
+#include <AP_Baro/AP_Baro.h>
+#include <AP_Math/crc.h>
+
+#include <stdio.h>
+#include <string.h>
+
+// maximum conversion times in microseconds for OSR 256 to 4096, from
+// the datasheet
+static const uint16_t conversion_usec[] = { 600, 1170, 2280, 4540, 9040 };
+
+// calibration coefficients C1 to C6, from the datasheet example
+static const uint16_t calibration[6] = { 40127, 36924, 23317, 23282, 33464, 28312 };
+
+namespace SITL {
+
+MS5611::MS5611()
+{
+    reset();
+}
+
+/*
+  reload the PROM and abandon any conversion, as the reset command does
+ */
+void MS5611::reset(void)
+{
+    memset(prom, 0, sizeof(prom));
+    memcpy(&prom[1], calibration, sizeof(calibration));
+    // the CRC is calculated with its own field zeroed
+    prom[7] |= crc_crc4(prom);
+    conversion_pending = false;
+    adc_value = 0;
+}
+
+/*
+  raw values which the driver's first and second order compensation
+  turns back into the simulated pressure and temperature
+ */
+void MS5611::make_raw(uint32_t &D1, uint32_t &D2) const
+{
+    const SITL *sitl = AP::sitl();
+    if (sitl == nullptr) {
+        D1 = D2 = 0;
+        return;
+    }
+
+    float sim_alt = sitl->state.altitude;
+    sim_alt += sitl->baro_drift * AP_HAL::millis() * 0.001f;
+    sim_alt += sitl->baro_noise * rand_float();
+
+    float sigma, delta, theta;
+    AP_Baro::SimpleAtmosphere(sim_alt * 0.001f, sigma, delta, theta);
+    const double pressure = SSL_AIR_PRESSURE * delta;
+    const double temperature = 303.16f * theta - C_TO_KELVIN;
+
+    const double C1 = prom[1], C2 = prom[2], C3 = prom[3];
+    const double C4 = prom[4], C5 = prom[5], C6 = prom[6];
+
+    // below 20C the driver subtracts dT^2/2^31 from TEMP, so solve the
+    // quadratic for dT there
+    const double target = temperature * 100 - 2000;
+    const double k = C6 / 8388608;
+    double dT = target / k;
+    if (target < 0) {
+        dT = (k - sqrt(k * k - 4 * target / 2147483648.0)) * 2147483648.0 / 2;
+    }
+    const double TEMP = dT * k;
+    double OFF = C2 * 65536 + C4 * dT / 128;
+    double SENS = C1 * 32768 + C3 * dT / 256;
+    if (TEMP < 0) {
+        OFF -= 2.5 * TEMP * TEMP;
+        SENS -= 1.25 * TEMP * TEMP;
+    }
+
+    D2 = constrain_float(dT + C5 * 256, 1, 0xFFFFFE);
+    D1 = constrain_float((pressure * 32768 + OFF) * 2097152 / SENS, 1, 0xFFFFFE);
+}
+
+/*
+  the result is taken from the simulation state at the start of the
+  conversion and is available once the conversion time has passed
+ */
+void MS5611::start_conversion(uint64_t time_usec, uint8_t cmd)
+{
+    const uint8_t osr = MIN((cmd & 0x0F) / 2, ARRAY_SIZE(conversion_usec) - 1);
+    uint32_t D1, D2;
+    make_raw(D1, D2);
+    adc_value = (cmd & 0xF0) == CONVERT_D1 ? D1 : D2;
+    conversion_done_usec = time_usec + conversion_usec[osr];
+    conversion_pending = true;
+}
+
+/*
+  a transfer is one command byte, followed by the bytes of the ADC
+  result or PROM word it selects
+ */
+bool MS5611::transfer(uint64_t time_usec,
+                      const uint8_t *send, uint32_t send_len,
+                      uint8_t *recv, uint32_t recv_len)
+{
+    if (send == nullptr || send_len == 0) {
+        return false;
+    }
+    const uint8_t cmd = send[0];
+
+    if (cmd == RESET) {
+        reset();
+        return true;
+    }
+    if ((cmd & 0xF0) == CONVERT_D1 || (cmd & 0xF0) == CONVERT_D2) {
+        start_conversion(time_usec, cmd);
+        return true;
+    }
+
+    uint32_t value = 0;
+    uint8_t value_len = 0;
+    if (cmd == ADC_READ) {
+        // reading with no completed conversion gives zero, and a read
+        // during a conversion spoils its result
+        if (conversion_pending && time_usec >= conversion_done_usec) {
+            value = adc_value;
+        } else {
+            early_read_count++;
+            if (time_usec - last_early_read_report_usec > 1000000) {
+                last_early_read_report_usec = time_usec;
+                ::printf("MS5611: ADC read before conversion at %.3fs, %u reads failed\n",
+                         time_usec * 1.0e-6, (unsigned)early_read_count);
+            }
+        }
+        conversion_pending = false;
+        value_len = 3;
+    } else if ((cmd & 0xF0) == PROM_READ) {
+        value = prom[(cmd >> 1) & 7];
+        value_len = 2;
+    } else {
+        return false;
+    }
+
+    for (uint32_t i=0; i<recv_len; i++) {
+        recv[i] = i < value_len ? (value >> (8 * (value_len - 1 - i))) & 0xFF : 0;
+    }
+    return true;
+}
+
+}  // namespace SITL
@@ -0,0 +1,70 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  simulated MS5611 barometer on a simulated SPI bus
+*/
+
+#pragma once
+
+#include "SIM_SPIDevice.h"
+
+namespace SITL {
+
+/*
+  Command level simulation of an MS5611. A conversion started by a
+  command takes the datasheet conversion time for its oversampling
+  ratio in simulation time, and an ADC read before it completes
+  returns zero, as on real hardware. A driver held off by a busy bus
+  therefore sees the same failed reads it would on a real board.
+*/
+class MS5611 : public SPIDevice {
+public:
+    MS5611();
+
+    bool transfer(uint64_t time_usec,
+                  const uint8_t *send, uint32_t send_len,
+                  uint8_t *recv, uint32_t recv_len) override;
+
+    // number of ADC reads which found no completed conversion
+    uint32_t get_early_read_count(void) const { return early_read_count; }
+
+private:
+    enum Command : uint8_t {
+        RESET      = 0x1E,
+        CONVERT_D1 = 0x40,  // pressure, plus 2 * OSR index
+        CONVERT_D2 = 0x50,  // temperature, plus 2 * OSR index
+        ADC_READ   = 0x00,
+        PROM_READ  = 0xA0,  // plus 2 * word
+    };
+
+    void reset(void);
+
+    // start a conversion of D1 or D2
+    void start_conversion(uint64_t time_usec, uint8_t cmd);
+
+    // raw D1 and D2 values for the current simulation state
+    void make_raw(uint32_t &D1, uint32_t &D2) const;
+
+    uint16_t prom[8];
+
+    uint64_t conversion_done_usec;
+    bool conversion_pending;
+    uint32_t adc_value;
+
+    uint32_t early_read_count;
+    uint64_t last_early_read_report_usec;
+};
+
+}  // namespace SITL
@@ -25,6 +25,7 @@ using namespace SITL;
 void Motor::calculate_forces(const struct sitl_input &input,
                              const float thrust_scale,
                              uint8_t motor_offset,
+                             const Model &model,
                              Vector3f &rot_accel,
                              Vector3f &thrust)
 {
@@ -32,14 +33,31 @@ void Motor::calculate_forces(const struct sitl_input &input,
     const float arm_scale = radians(5000);
     const float yaw_scale = radians(400);
 
-    // get motor speed from 0 to 1
-    float motor_speed = constrain_float((input.servos[motor_offset+servo]-1100)/900.0, 0, 1);
+    // get motor demand from 0 to 1
+    const float demand = constrain_float((input.servos[motor_offset+servo]-1100)/900.0, 0, 1);
+
+    // the thrust curve gives the fraction of full thrust wanted. Thrust
+    // and torque are both proportional to the rotor speed squared, and
+    // the rotor speed follows the speed needed for that thrust with a
+    // first order lag
+    const float thrust_demand = (1 - model.expo) * demand + model.expo * sq(demand);
+    rotor_speed += (safe_sqrt(thrust_demand) - rotor_speed) * model.speed_alpha;
+    float motor_thrust = sq(rotor_speed);
 
     // the yaw torque of the motor
-    Vector3f rotor_torque(0, 0, yaw_factor * motor_speed * yaw_scale);
+    Vector3f rotor_torque(0, 0, yaw_factor * motor_thrust * yaw_scale);
+
+    // advance the rotor and add the thrust ripple of a two bladed prop
+    // passing the arm, at twice the rotor frequency
+    if (model.rpm_max > 0) {
+        rotor_phase = wrap_2PI(rotor_phase + rotor_speed * model.rpm_max * (M_2PI / 60) * model.dt);
+        if (!is_zero(model.ripple)) {
+            motor_thrust *= 1 + model.ripple * sinf(2 * rotor_phase);
+        }
+    }
 
     // get thrust for untilted motor
-    thrust(0, 0, -motor_speed);
+    thrust(0, 0, -motor_thrust);
 
     // define the arm position relative to center of mass
     Vector3f arm(arm_scale * cosf(radians(angle)), arm_scale * sinf(radians(angle)), 0);
@@ -83,6 +101,14 @@ void Motor::calculate_forces(const struct sitl_input &input,
     thrust = thrust * thrust_scale;
 }
 
+// body frame acceleration from rotor imbalance, at the rotor frequency
+Vector3f Motor::imbalance_accel(float accel_max) const
+{
+    // the imbalance force rotates with the rotor in the plane of an untilted motor
+    const float accel = accel_max * sq(rotor_speed);
+    return Vector3f(cosf(rotor_phase) * accel, sinf(rotor_phase) * accel, 0);
+}
+
 /*
   update and return current value of a servo. Calculated as 1000..2000
  */
@@ -114,14 +140,14 @@ uint16_t Motor::update_servo(uint16_t demand, uint64_t time_usec, float &last_va
 void Motor::current_and_voltage(const struct sitl_input &input, float &voltage, float &current,
                                 uint8_t motor_offset)
 {
-    // get motor speed from 0 to 1
-    float motor_speed = constrain_float((input.servos[motor_offset+servo]-1100)/900.0, 0, 1);
+    // get motor thrust from 0 to 1, as calculated by calculate_forces()
+    const float motor_thrust = sq(rotor_speed);
 
-    // assume 10A per motor at full speed
-    current = 10 * motor_speed;
+    // assume 10A per motor at full thrust
+    current = 10 * motor_thrust;
 
     // assume 3S, and full throttle drops voltage by 0.7V
     if (AP::sitl()) {
-        voltage = AP::sitl()->batt_voltage - motor_speed * 0.7;
+        voltage = AP::sitl()->batt_voltage - motor_thrust * 0.7;
     }
 }
@@ -44,6 +44,22 @@ public:
     uint64_t last_change_usec;
     float last_roll_value, last_pitch_value;
 
+    // modelled rotor state
+    float rotor_speed = 0;  // rotor speed as a fraction of its speed at full demand
+    float rotor_phase = 0;  // rotor angle in radians
+
+    /*
+      motor model settings shared by all motors of a frame, calculated
+      once per time step
+     */
+    struct Model {
+        float dt;           // time step, seconds
+        float speed_alpha;  // low pass filter constant for the rotor speed, 1 for instant response
+        float expo;         // thrust curve expo, 0 for thrust proportional to demand
+        float rpm_max;      // rotor speed at full demand, 0 to not track the rotor angle
+        float ripple;       // blade passing thrust ripple as a fraction of thrust
+    };
+
     Motor(uint8_t _servo, float _angle, float _yaw_factor, uint8_t _display_order) :
         servo(_servo), // what servo output drives this motor
         angle(_angle), // angle in degrees from front
@@ -72,9 +88,13 @@ public:
     void calculate_forces(const struct sitl_input &input,
                           float thrust_scale,
                           uint8_t motor_offset,
+                          const Model &model,
                           Vector3f &rot_accel, // rad/sec
                           Vector3f &body_thrust); // Z is down
 
+    // body frame acceleration from rotor imbalance, at the rotor frequency
+    Vector3f imbalance_accel(float accel_max) const;
+
     uint16_t update_servo(uint16_t demand, uint64_t time_usec, float &last_value);
 
     // calculate current and voltage
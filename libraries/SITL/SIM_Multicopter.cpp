@@ -68,6 +68,12 @@ void MultiCopter::update(const struct sitl_input &input)
     // estimate voltage and current
     frame->current_and_voltage(input, battery_voltage, battery_current);
 
+    // report the modelled speed of the first two rotors as RPM
+    if (sitl && sitl->motor.rpm_max > 0) {
+        rpm1 = frame->motors[0].rotor_speed * sitl->motor.rpm_max;
+        rpm2 = frame->motors[1].rotor_speed * sitl->motor.rpm_max;
+    }
+
     update_dynamics(rot_accel);
     update_external_payload(input);
 
@@ -0,0 +1,39 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  base class for simulated devices on a simulated SPI bus
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+namespace SITL {
+
+class SPIDevice {
+public:
+    /*
+      a transfer with chip select held for its whole length: send_len
+      bytes are clocked out, then recv_len bytes are clocked in.
+      time_usec is the simulation time at which the transfer starts on
+      the bus, which may be later than the current time if the bus is
+      busy with earlier transfers
+     */
+    virtual bool transfer(uint64_t time_usec,
+                          const uint8_t *send, uint32_t send_len,
+                          uint8_t *recv, uint32_t recv_len) = 0;
+};
+
+}  // namespace SITL
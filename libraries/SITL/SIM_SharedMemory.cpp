@@ -0,0 +1,190 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  simulator connection to an external physics engine over shared memory
+*/
+
+#include "SIM_SharedMemory.h"
+
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+namespace SITL {
+
+using namespace SHM_FDM;
+
+SharedMemory::SharedMemory(const char *frame_str) :
+    Aircraft(frame_str),
+    segment(nullptr),
+    frame(0),
+    last_timestamp(0),
+    last_report_us(0)
+{
+    // the physics engine sets the pace
+    use_time_sync = false;
+
+    segment_name[0] = 0;
+    const char *colon = strchr(frame_str, ':');
+    if (colon != nullptr && colon[1] != 0) {
+        strncpy(segment_name, colon+1, sizeof(segment_name)-1);
+        segment_name[sizeof(segment_name)-1] = 0;
+    }
+}
+
+/*
+  create the shared memory segment, or reuse it if the physics engine
+  has already attached to one left by an earlier run
+ */
+bool SharedMemory::open_segment(void)
+{
+    if (segment_name[0] == 0) {
+        snprintf(segment_name, sizeof(segment_name), "/ardupilot_fdm%u", (unsigned)instance);
+    }
+    const int fd = shm_open(segment_name, O_RDWR | O_CREAT, 0666);
+    if (fd == -1) {
+        ::fprintf(stderr, "SharedMemory: shm_open(%s) failed\n", segment_name);
+        return false;
+    }
+    if (ftruncate(fd, sizeof(Segment)) != 0) {
+        ::fprintf(stderr, "SharedMemory: ftruncate(%s) failed\n", segment_name);
+        close(fd);
+        return false;
+    }
+    void *p = mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        ::fprintf(stderr, "SharedMemory: mmap(%s) failed\n", segment_name);
+        return false;
+    }
+    segment = (Segment *)p;
+
+    if (segment->magic != MAGIC || segment->version != VERSION) {
+        __atomic_store_n(&segment->magic, 0, __ATOMIC_RELAXED);
+        memset(&segment->servos, 0, sizeof(segment->servos));
+        memset(&segment->state, 0, sizeof(segment->state));
+        segment->version = VERSION;
+        __atomic_store_n(&segment->magic, MAGIC, __ATOMIC_RELEASE);
+    } else {
+        // drop any state left from an earlier run
+        __atomic_store_n(&segment->state.tail,
+                         __atomic_load_n(&segment->state.head, __ATOMIC_ACQUIRE),
+                         __ATOMIC_RELEASE);
+    }
+    // carry on the frame count so an attached client sees new frames
+    frame = segment->servos.head;
+
+    ::printf("SharedMemory: waiting for physics engine on %s\n", segment_name);
+    return true;
+}
+
+/*
+  write a servo frame. In lockstep the ring can only be full if the
+  physics engine has stopped, and we are about to wait for it anyway
+ */
+void SharedMemory::send_servos(const struct sitl_input &input)
+{
+    Ring<ServoFrame> &ring = segment->servos;
+    const uint32_t head = ring.head;
+    if (head - __atomic_load_n(&ring.tail, __ATOMIC_ACQUIRE) >= RING_SIZE) {
+        return;
+    }
+    ServoFrame &f = ring.frames[head % RING_SIZE];
+    f.frame = frame;
+    f.time_us = time_now_us;
+    for (uint8_t i=0; i<NUM_SERVOS; i++) {
+        f.pwm[i] = input.servos[i];
+    }
+    __atomic_store_n(&ring.head, head+1, __ATOMIC_RELEASE);
+}
+
+/*
+  wait for the state which follows the current servo frame, spinning
+  briefly before sleeping so a fast physics engine isn't held up by
+  the scheduler. Older states are discarded
+ */
+void SharedMemory::recv_state(void)
+{
+    Ring<StateFrame> &ring = segment->state;
+    const uint64_t start_us = get_wall_time_us();
+    while (true) {
+        const uint32_t head = __atomic_load_n(&ring.head, __ATOMIC_ACQUIRE);
+        uint32_t tail = ring.tail;
+        bool have_state = false;
+        StateFrame state;
+        for (; tail != head; tail++) {
+            const StateFrame &s = ring.frames[tail % RING_SIZE];
+            if (s.frame >= frame) {
+                state = s;
+                have_state = true;
+            }
+        }
+        __atomic_store_n(&ring.tail, tail, __ATOMIC_RELEASE);
+
+        if (have_state) {
+            accel_body = Vector3f(state.accel[0], state.accel[1], state.accel[2]);
+            gyro = Vector3f(state.gyro[0], state.gyro[1], state.gyro[2]);
+            Quaternion quat(state.quaternion[0], state.quaternion[1],
+                            state.quaternion[2], state.quaternion[3]);
+            quat.rotation_matrix(dcm);
+            velocity_ef = Vector3f(state.velocity[0], state.velocity[1], state.velocity[2]);
+            position = Vector3f(state.position[0], state.position[1], state.position[2]);
+
+            // auto-adjust to the physics frame rate. A physics engine
+            // which restarts goes back in time, in which case the step
+            // falls back to the last frame time
+            const double deltat = state.timestamp - last_timestamp;
+            if (deltat > 0 && deltat < 0.1) {
+                time_now_us += static_cast<uint64_t>(deltat * 1.0e6);
+                adjust_frame_time(static_cast<float>(1.0/deltat));
+            }
+            last_timestamp = state.timestamp;
+            return;
+        }
+
+        const uint64_t now_us = get_wall_time_us();
+        if (now_us - start_us > spin_us) {
+            usleep(10);
+        }
+        if (now_us - start_us > 1000000 && now_us - last_report_us > 5000000) {
+            last_report_us = now_us;
+            ::printf("SharedMemory: no reply to frame %llu on %s\n",
+                     (unsigned long long)frame, segment_name);
+        }
+    }
+}
+
+/*
+  update the simulation by one time step
+ */
+void SharedMemory::update(const struct sitl_input &input)
+{
+    if (segment == nullptr && !open_segment()) {
+        ::fprintf(stderr, "Aborting launch...\n");
+        exit(1);
+    }
+
+    send_servos(input);
+    recv_state();
+    frame++;
+
+    update_position();
+    time_advance();
+    // update magnetic field
+    update_mag_field_bf();
+}
+
+}  // namespace SITL
@@ -0,0 +1,67 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  simulator connection to an external physics engine over shared memory
+*/
+
+#pragma once
+
+#include "SIM_Aircraft.h"
+#include "SIM_SharedMemory_Protocol.h"
+
+namespace SITL {
+
+/*
+  Exchanges servo outputs and vehicle state with a physics engine on
+  the same machine through a POSIX shared memory segment, so the two
+  can run in lockstep at kHz rates without a socket round trip per
+  frame. Each step writes a servo frame and waits for the state frame
+  which follows it; the physics engine sets the step time through the
+  state timestamps. See SIM_SharedMemory_Protocol.h for the layout and
+  examples/SharedMemory for a reference client.
+
+  The model is selected with --model shm[:NAME], where NAME is the
+  segment name, by default /ardupilot_fdm<instance>.
+ */
+class SharedMemory : public Aircraft {
+public:
+    SharedMemory(const char *frame_str);
+
+    /* update model by one time step */
+    void update(const struct sitl_input &input) override;
+
+    /* static object creator */
+    static Aircraft *create(const char *frame_str) {
+        return new SharedMemory(frame_str);
+    }
+
+private:
+    // create the segment
+    bool open_segment(void);
+
+    void send_servos(const struct sitl_input &input);
+    void recv_state(void);
+
+    char segment_name[32];
+    SHM_FDM::Segment *segment;
+    uint64_t frame;
+    double last_timestamp;
+    uint64_t last_report_us;
+
+    // wall time to spin waiting for a reply before sleeping
+    static const uint32_t spin_us = 100;
+};
+
+}  // namespace SITL
@@ -0,0 +1,86 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  layout of the shared memory segment used by the shm simulator
+  backend. This header has no ArduPilot dependencies so that external
+  physics engines can include it directly.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+namespace SITL {
+namespace SHM_FDM {
+
+static const uint32_t MAGIC = 0x4d444653;     // "SFDM"
+static const uint32_t VERSION = 1;
+
+// frames in each ring, a power of 2
+static const uint32_t RING_SIZE = 16;
+
+static const uint8_t NUM_SERVOS = 16;
+
+/*
+  servo outputs from ArduPilot, one per physics step
+ */
+struct ServoFrame {
+    uint64_t frame;             // increments by one every step
+    uint64_t time_us;           // ArduPilot simulation time
+    uint16_t pwm[NUM_SERVOS];   // microseconds
+};
+
+/*
+  vehicle state from the physics engine, in reply to a servo frame
+ */
+struct StateFrame {
+    uint64_t frame;             // the servo frame this state follows
+    double timestamp;           // physics time, seconds
+    double gyro[3];             // body rates, FRD, rad/s
+    double accel[3];            // specific force, FRD, m/s/s
+    double quaternion[4];       // attitude, body to NED, w x y z
+    double velocity[3];         // NED, m/s
+    double position[3];         // NED relative to the start location, m
+};
+
+/*
+  a single producer, single consumer ring. The producer writes
+  frames[head % RING_SIZE] and then increments head, the consumer
+  reads frames[tail % RING_SIZE] and then increments tail. Both
+  counters only ever increase, and each is written by one side only,
+  with release ordering, and read by the other with acquire ordering.
+ */
+template <typename T>
+struct Ring {
+    uint32_t head;
+    uint32_t tail;
+    T frames[RING_SIZE];
+};
+
+/*
+  ArduPilot creates the segment and sets magic last, once the rest of
+  it is valid. ArduPilot waits for a reply to each servo frame, so a
+  client attaching to a running ArduPilot should skip any older frames
+  by setting servos.tail to servos.head - 1, then reply to the newest.
+ */
+struct Segment {
+    uint32_t magic;
+    uint32_t version;
+    Ring<ServoFrame> servos;    // ArduPilot to physics engine
+    Ring<StateFrame> state;     // physics engine to ArduPilot
+};
+
+}  // namespace SHM_FDM
+}  // namespace SITL
@@ -0,0 +1,275 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  traffic view shared between SITL instances on one machine
+*/
+
+#include "SIM_SharedTraffic.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace SITL {
+
+SharedTraffic *SharedTraffic::exit_traffic;
+
+// release the slot when the process exits
+void SharedTraffic::detach_at_exit(void)
+{
+    if (exit_traffic != nullptr) {
+        exit_traffic->detach();
+    }
+}
+
+/*
+  open the named segment and lock it against other instances attaching
+  or detaching. The lock must be released with close_locked(), as a
+  mapping of the segment keeps the lock held after a plain close()
+ */
+int SharedTraffic::open_locked(bool create) const
+{
+    // an instance which is detaching may remove the segment while we
+    // wait for the lock, in which case we open it again
+    for (uint8_t i=0; i<10; i++) {
+        const int fd = shm_open(name, create ? (O_RDWR | O_CREAT) : O_RDWR, 0666);
+        if (fd == -1) {
+            return -1;
+        }
+        struct stat st;
+        if (flock(fd, LOCK_EX) == 0 && fstat(fd, &st) == 0 && st.st_nlink > 0) {
+            return fd;
+        }
+        close_locked(fd);
+    }
+    return -1;
+}
+
+void SharedTraffic::close_locked(int fd)
+{
+    flock(fd, LOCK_UN);
+    close(fd);
+}
+
+/*
+  true if a slot other than ours is owned by a live process
+ */
+bool SharedTraffic::others_alive(void) const
+{
+    for (uint8_t i=0; i<max_vehicles; i++) {
+        const pid_t pid = segment->slots[i].pid;
+        if (i == instance || pid <= 0) {
+            continue;
+        }
+        if (kill(pid, 0) == 0 || errno == EPERM) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+  attach to the named shared memory segment, creating it if this is
+  the first instance
+ */
+bool SharedTraffic::init(const char *_name, uint8_t _instance)
+{
+    if (_instance >= max_vehicles) {
+        ::fprintf(stderr, "SharedTraffic: instance %u too large\n", (unsigned)_instance);
+        return false;
+    }
+    // a forked copy attaching again as a new instance leaves the slot
+    // of the process it was forked from alone
+    if (segment != nullptr) {
+        munmap(segment, sizeof(Segment));
+        segment = nullptr;
+    }
+    free(name);
+
+    instance = _instance;
+    name = strdup(_name);
+    if (name == nullptr) {
+        return false;
+    }
+
+    const int fd = open_locked(true);
+    if (fd == -1) {
+        ::fprintf(stderr, "SharedTraffic: shm_open(%s) failed\n", name);
+        return false;
+    }
+    // every instance sets the same size so there is no race in creating it
+    if (ftruncate(fd, sizeof(Segment)) != 0) {
+        ::fprintf(stderr, "SharedTraffic: ftruncate(%s) failed\n", name);
+        close_locked(fd);
+        return false;
+    }
+    void *p = mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        ::fprintf(stderr, "SharedTraffic: mmap(%s) failed\n", name);
+        close_locked(fd);
+        return false;
+    }
+    segment = (Segment *)p;
+
+    if (!others_alive()) {
+        // new, or left behind by instances which were killed
+        memset((void *)segment, 0, sizeof(Segment));
+        segment->version = version;
+        segment->magic = magic;
+    } else if (segment->magic != magic || segment->version != version) {
+        ::fprintf(stderr, "SharedTraffic: %s has an incompatible layout\n", name);
+        munmap(p, sizeof(Segment));
+        segment = nullptr;
+        close_locked(fd);
+        return false;
+    }
+
+    Slot &slot = segment->slots[instance];
+    if (slot.pid > 0 && slot.pid != getpid() && (kill(slot.pid, 0) == 0 || errno == EPERM)) {
+        ::fprintf(stderr, "SharedTraffic: instance %u is already used in %s\n", (unsigned)instance, name);
+        munmap(p, sizeof(Segment));
+        segment = nullptr;
+        close_locked(fd);
+        return false;
+    }
+    __atomic_store_n(&slot.seq, 0, __ATOMIC_RELEASE);
+    slot.pid = getpid();
+    struct stat st;
+    if (fstat(fd, &st) == 0) {
+        inode = st.st_ino;
+    }
+    close_locked(fd);
+
+    exit_traffic = this;
+    atexit(detach_at_exit);
+
+    ::printf("SharedTraffic: instance %u using %s\n", (unsigned)instance, name);
+    return true;
+}
+
+/*
+  release our slot and unmap the segment, removing it if no other
+  instance is using it
+ */
+void SharedTraffic::detach(void)
+{
+    if (exit_traffic == this) {
+        exit_traffic = nullptr;
+    }
+    if (segment == nullptr) {
+        return;
+    }
+    const int fd = open_locked(false);
+    struct stat st;
+    // only remove the name if it is still our segment
+    const bool ours = fd != -1 && fstat(fd, &st) == 0 && st.st_ino == inode;
+    Slot &slot = segment->slots[instance];
+    // a forked copy of this instance doesn't own the slot
+    if (slot.pid == getpid()) {
+        __atomic_store_n(&slot.seq, 0, __ATOMIC_RELEASE);
+        slot.pid = 0;
+        if (ours && !others_alive()) {
+            shm_unlink(name);
+        }
+    }
+    munmap(segment, sizeof(Segment));
+    segment = nullptr;
+    if (fd != -1) {
+        close_locked(fd);
+    }
+    free(name);
+    name = nullptr;
+}
+
+/*
+  publish this instance's state
+ */
+void SharedTraffic::update(const struct sitl_fdm &fdm)
+{
+    if (segment == nullptr) {
+        return;
+    }
+    Slot &slot = segment->slots[instance];
+
+    const uint32_t seq = slot.seq;
+    __atomic_store_n(&slot.seq, seq+1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    slot.time_us = fdm.timestamp_us;
+    slot.vehicle.instance = instance;
+    slot.vehicle.lat = fdm.latitude * 1.0e7;
+    slot.vehicle.lng = fdm.longitude * 1.0e7;
+    slot.vehicle.alt_m = fdm.altitude;
+    slot.vehicle.velocity_ef = Vector3f(fdm.speedN, fdm.speedE, fdm.speedD);
+    slot.vehicle.yaw_deg = fdm.yawDeg;
+
+    // skip zero, which marks an unused slot
+    __atomic_store_n(&slot.seq, (seq+2 == 0) ? 2 : seq+2, __ATOMIC_RELEASE);
+}
+
+/*
+  copy out the state of the other instances which are still
+  publishing, returning the number copied. Instances run at their own
+  speed, so an instance is judged by whether its state has changed
+  within the last timeout_us of our simulated time
+ */
+uint8_t SharedTraffic::get_others(Vehicle *vehicles, uint8_t max, uint64_t now_us)
+{
+    if (segment == nullptr) {
+        return 0;
+    }
+    uint8_t count = 0;
+    for (uint8_t i=0; i<max_vehicles && count<max; i++) {
+        if (i == instance) {
+            continue;
+        }
+        const Slot &slot = segment->slots[i];
+        Vehicle v;
+        uint32_t seq = 0;
+        bool valid = false;
+        // retry a few times if the owner was writing the slot while
+        // we read it. An owner which died while writing leaves the
+        // sequence odd, so give up rather than wait for it
+        for (uint8_t attempt=0; attempt<read_attempts && !valid; attempt++) {
+            seq = __atomic_load_n(&slot.seq, __ATOMIC_ACQUIRE);
+            if (seq & 1U) {
+                continue;
+            }
+            v = slot.vehicle;
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            valid = (seq == __atomic_load_n(&slot.seq, __ATOMIC_RELAXED));
+        }
+        if (!valid || seq == 0) {
+            continue;
+        }
+        if (seq != last_seq[i]) {
+            last_seq[i] = seq;
+            last_change_us[i] = now_us;
+        } else if (now_us - last_change_us[i] > timeout_us) {
+            continue;
+        }
+        vehicles[count++] = v;
+    }
+    return count;
+}
+
+}  // namespace SITL
@@ -0,0 +1,116 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  traffic view shared between SITL instances on one machine
+*/
+
+#pragma once
+
+#include "SITL.h"
+
+#include <sys/types.h>
+
+namespace SITL {
+
+/*
+  Each SITL instance publishes its simulated position and velocity in
+  its own slot of a shared memory segment every physics step, and reads
+  the slots of the other instances to present them as ADS-B traffic.
+  Slots are written by one instance only and are read without locks,
+  using a sequence counter to detect a read that overlapped a write.
+
+  Every vehicle is still its own process with its own physics model:
+  the vehicle code, the HAL and the AP:: singletons allow only one
+  vehicle per process. Vehicles exchange MAVLink over the mcast: serial
+  device, and --lockstep lets many of them run unthrottled on one
+  machine.
+
+  The segment is removed by the last instance to exit. A segment left
+  behind by instances which were killed is reset by the next instance
+  to attach.
+*/
+class SharedTraffic {
+public:
+    static const uint8_t max_vehicles = 64;
+
+    struct Vehicle {
+        uint8_t instance;
+        int32_t lat;            // 1e-7 degrees
+        int32_t lng;            // 1e-7 degrees
+        float alt_m;            // MSL
+        Vector3f velocity_ef;   // NED m/s
+        float yaw_deg;
+    };
+
+    ~SharedTraffic(void) { detach(); }
+
+    // attach to (creating if needed) the named segment
+    bool init(const char *name, uint8_t instance);
+
+    // publish this instance's state
+    void update(const struct sitl_fdm &fdm);
+
+    // get the other instances whose state has changed within the
+    // last timeout_us of this instance's simulated time, now_us
+    uint8_t get_others(Vehicle *vehicles, uint8_t max, uint64_t now_us);
+
+private:
+    static const uint32_t magic = 0x53545246;   // "STRF"
+    static const uint32_t version = 2;
+
+    // instances whose state hasn't changed for this long in simulated time are ignored
+    static const uint64_t timeout_us = 3000000;
+
+    // attempts to read a slot which is being written before skipping it
+    static const uint8_t read_attempts = 4;
+
+    struct Slot {
+        uint32_t seq;           // odd while the slot is being written, zero if unused
+        int32_t pid;            // process owning the slot, zero if none
+        uint64_t time_us;       // owner's simulated time when the slot was last written
+        Vehicle vehicle;
+    };
+
+    struct Segment {
+        uint32_t magic;
+        uint32_t version;
+        Slot slots[max_vehicles];
+    };
+
+    // open the segment with an exclusive lock held, returns -1 on failure
+    int open_locked(bool create) const;
+    static void close_locked(int fd);
+
+    // true if another live process owns a slot
+    bool others_alive(void) const;
+
+    // release our slot, removing the segment if no other instance uses it
+    void detach(void);
+
+    static SharedTraffic *exit_traffic;
+    static void detach_at_exit(void);
+
+    Segment *segment;
+    char *name;
+    ino_t inode;        // of the segment we attached to
+    uint8_t instance;
+
+    // sequence of each slot when we last saw it change, and our
+    // simulated time then, used to spot instances which have stopped
+    uint32_t last_seq[max_vehicles];
+    uint64_t last_change_us[max_vehicles];
+};
+
+}  // namespace SITL
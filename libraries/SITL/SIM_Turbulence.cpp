@@ -0,0 +1,175 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  Dryden turbulence model
+*/
+
+#include "SIM_Turbulence.h"
+
+#include <stdio.h>
+
+namespace SITL {
+
+/*
+  normally distributed random numbers from a fixed seed, so that every
+  run sees the same turbulence
+ */
+class NormalNoise {
+public:
+    float next(void) {
+        if (have_spare) {
+            have_spare = false;
+            return spare;
+        }
+        float x, y, r;
+        do {
+            x = 2 * uniform() - 1;
+            y = 2 * uniform() - 1;
+            r = x*x + y*y;
+        } while (is_zero(r) || r >= 1);
+        const float d = sqrtf(-2 * logf(r) / r);
+        spare = y * d;
+        have_spare = true;
+        return x * d;
+    }
+
+private:
+    // xorshift32
+    float uniform(void) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state * (1.0f / UINT32_MAX);
+    }
+
+    uint32_t state = 0x12345678;
+    float spare;
+    bool have_spare = false;
+};
+
+/*
+  generate the noise tables by filtering white noise with the Dryden
+  shaping filters in the distance domain, with unit scale length:
+    longitudinal: 1/(1+s)
+    lateral and vertical: (1+sqrt(3)s)/(1+s)^2
+  The end of each table is blended into its start so the tables can be
+  sampled in a loop, and each is scaled to unit variance.
+ */
+bool Turbulence::init(void)
+{
+    // extra entries generated past the end of the table, blended into the start
+    const uint16_t blend = 256;
+    // steps to run the filters before recording, so they have settled
+    const uint16_t settle = 10 / table_step;
+
+    NormalNoise noise;
+    const float noise_scale = sqrtf(table_step);
+
+    for (uint8_t axis=0; axis<3; axis++) {
+        float *table = new float[table_size + blend];
+        if (table == nullptr) {
+            return false;
+        }
+        float x1 = 0, x2 = 0;
+        for (int32_t i=-settle; i<table_size + blend; i++) {
+            const float x1_dot = noise.next() / noise_scale - x1;
+            const float x2_dot = x1 - x2;
+            x1 += x1_dot * table_step;
+            x2 += x2_dot * table_step;
+            if (i >= 0) {
+                table[i] = (axis == 0) ? x1 : (x2 + sqrtf(3) * x2_dot);
+            }
+        }
+        for (uint16_t i=0; i<blend; i++) {
+            // the start of the table continues from the end
+            const float w = float(i) / blend;
+            table[i] = table[i] * w + table[table_size + i] * (1 - w);
+        }
+
+        // remove the mean and scale to unit variance
+        double sum = 0, sum_sq = 0;
+        for (uint16_t i=0; i<table_size; i++) {
+            sum += table[i];
+            sum_sq += sq(table[i]);
+        }
+        const float mean = sum / table_size;
+        const float std_dev = sqrtf(MAX(sum_sq / table_size - sq(mean), 1.0e-6));
+        for (uint16_t i=0; i<table_size; i++) {
+            table[i] = (table[i] - mean) / std_dev;
+        }
+        tables[axis] = table;
+    }
+    return true;
+}
+
+/*
+  interpolate a table at a distance in scale lengths
+ */
+float Turbulence::lookup(const float *table, float distance) const
+{
+    const float pos = distance / table_step;
+    const uint16_t i = uint16_t(pos) % table_size;
+    const float frac = pos - floorf(pos);
+    return table[i] * (1 - frac) + table[(i + 1) % table_size] * frac;
+}
+
+/*
+  advance by dt seconds and return the turbulence in earth frame
+ */
+Vector3f Turbulence::update(float dt, const Vector3f &velocity_air_ef, float height, float sigma_w)
+{
+    if (tables[0] == nullptr) {
+        if (init_failed) {
+            return Vector3f();
+        }
+        if (!init()) {
+            ::printf("Turbulence: failed to allocate tables\n");
+            init_failed = true;
+            return Vector3f();
+        }
+    }
+
+    /*
+      MIL-F-8785C low altitude model, in feet. Heights are limited to
+      10 to 1000 feet, above which the turbulence is isotropic
+     */
+    const float h_ft = constrain_float(height * 3.28084f, 10, 1000);
+    const float k = 0.177f + 0.000823f * h_ft;
+    const float length_uv = (h_ft / powf(k, 1.2f)) * 0.3048f;
+    const float length_w = h_ft * 0.3048f;
+    const float sigma_uv = sigma_w / powf(k, 0.4f);
+
+    // advance through the frozen turbulence field
+    const float table_length = table_size * table_step;
+    const float ds = MAX(velocity_air_ef.length(), min_speed) * dt;
+    distance_uv = fmodf(distance_uv + ds / length_uv, table_length);
+    distance_w = fmodf(distance_w + ds / length_w, table_length);
+
+    // longitudinal and lateral turbulence follow the horizontal flow
+    if (norm(velocity_air_ef.x, velocity_air_ef.y) > min_speed) {
+        heading = atan2f(velocity_air_ef.y, velocity_air_ef.x);
+    }
+    const float u = lookup(tables[0], distance_uv) * sigma_uv;
+    const float v = lookup(tables[1], distance_uv) * sigma_uv;
+    const float w = lookup(tables[2], distance_w) * sigma_w;
+    const float cos_hdg = cosf(heading);
+    const float sin_hdg = sinf(heading);
+
+    return Vector3f(u * cos_hdg - v * sin_hdg,
+                    u * sin_hdg + v * cos_hdg,
+                    w);
+}
+
+}  // namespace SITL
@@ -0,0 +1,67 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  Dryden turbulence model
+*/
+
+#pragma once
+
+#include <AP_Math/AP_Math.h>
+
+namespace SITL {
+
+/*
+  Turbulence is treated as a field frozen in the air mass which the
+  vehicle moves through (Taylor's hypothesis), with the Dryden spectra
+  and the MIL-F-8785C low altitude intensities and scale lengths.
+
+  One table of unit variance noise per axis is generated once by
+  filtering white noise with the Dryden shaping filters, with distance
+  measured in scale lengths. Sampling is then a table lookup at the
+  distance travelled through the air divided by the scale length at the
+  current height, so the per step cost doesn't depend on the filters.
+*/
+class Turbulence {
+public:
+    /*
+      advance by dt seconds and return the turbulence in earth frame
+      velocity_air_ef: velocity relative to the mean wind, m/s
+      height: height above ground, m
+      sigma_w: vertical turbulence intensity, m/s
+     */
+    Vector3f update(float dt, const Vector3f &velocity_air_ef, float height, float sigma_w);
+
+private:
+    static const uint16_t table_size = 16384;
+    static constexpr float table_step = 0.02;    // scale lengths between table entries
+
+    // the mean wind carries the turbulence past a hovering vehicle, so
+    // never sample it at less than this speed
+    static constexpr float min_speed = 1.0;
+
+    // generate the noise tables
+    bool init(void);
+
+    // interpolate a table at a distance in scale lengths
+    float lookup(const float *table, float distance) const;
+
+    float *tables[3] {};        // longitudinal, lateral and vertical
+    float distance_uv = 0;      // distance travelled in horizontal scale lengths
+    float distance_w = 0;       // distance travelled in vertical scale lengths
+    float heading = 0;          // direction of the horizontal air flow, radians
+    bool init_failed = false;
+};
+
+}  // namespace SITL
@@ -0,0 +1,183 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  gridded, time varying wind field loaded from a file
+*/
+
+#include "SIM_WindField.h"
+
+#include <stdio.h>
+#include <string.h>
+
+namespace SITL {
+
+/*
+  read the next line which isn't blank or a comment
+ */
+static bool next_line(FILE *f, char *line, uint16_t len)
+{
+    while (fgets(line, len, f) != nullptr) {
+        const char *p = line;
+        while (*p == ' ' || *p == '\t') {
+            p++;
+        }
+        if (*p != '#' && *p != '\n' && *p != '\r' && *p != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+  load a wind field file
+ */
+bool WindField::load(const char *filename)
+{
+    FILE *f = fopen(filename, "r");
+    if (f == nullptr) {
+        ::printf("WindField: failed to open %s\n", filename);
+        return false;
+    }
+
+    char line[128];
+    unsigned x, y, z, t = 1;
+    float dt = 0;
+    char loop_str[8] {};
+    bool ok = next_line(f, line, sizeof(line)) &&
+        sscanf(line, "grid %u %u %u %f %f %f", &x, &y, &z, &spacing.x, &spacing.y, &spacing.z) == 6 &&
+        next_line(f, line, sizeof(line)) &&
+        sscanf(line, "origin %f %f %f", &origin.x, &origin.y, &origin.z) == 3 &&
+        next_line(f, line, sizeof(line));
+    if (ok && strncmp(line, "time", 4) == 0) {
+        ok = sscanf(line, "time %u %f %7s", &t, &dt, loop_str) >= 2 &&
+            next_line(f, line, sizeof(line));
+    }
+    if (!ok || x == 0 || y == 0 || z == 0 || t == 0 ||
+        x > UINT16_MAX || y > UINT16_MAX || z > UINT16_MAX || t > UINT16_MAX ||
+        !is_positive(spacing.x) || !is_positive(spacing.y) || !is_positive(spacing.z) ||
+        (t > 1 && !is_positive(dt))) {
+        ::printf("WindField: bad header in %s\n", filename);
+        fclose(f);
+        return false;
+    }
+
+    const uint32_t count = uint32_t(x) * y * z * t;
+    Vector3f *new_data = new Vector3f[count];
+    if (new_data == nullptr) {
+        fclose(f);
+        return false;
+    }
+    for (uint32_t i=0; i<count; i++) {
+        // the first data line was read while looking for the time line
+        if ((i > 0 && !next_line(f, line, sizeof(line))) ||
+            sscanf(line, "%f %f %f", &new_data[i].x, &new_data[i].y, &new_data[i].z) != 3) {
+            ::printf("WindField: expected %u points in %s, bad point %u\n",
+                     (unsigned)count, filename, (unsigned)i);
+            delete[] new_data;
+            fclose(f);
+            return false;
+        }
+    }
+    fclose(f);
+
+    nx = x;
+    ny = y;
+    nz = z;
+    nt = t;
+    time_step = dt;
+    loop = strcmp(loop_str, "loop") == 0;
+    delete[] data;
+    data = new_data;
+
+    ::printf("WindField: loaded %ux%ux%u grid with %u times from %s\n",
+             (unsigned)nx, (unsigned)ny, (unsigned)nz, (unsigned)nt, filename);
+    return true;
+}
+
+/*
+  find the lower grid index and the fraction towards the next index,
+  limited to the grid
+ */
+static void grid_index(float pos, uint16_t n, uint16_t &idx, float &frac)
+{
+    if (n < 2 || pos <= 0) {
+        idx = 0;
+        frac = 0;
+        return;
+    }
+    if (pos >= n - 1) {
+        idx = n - 2;
+        frac = 1;
+        return;
+    }
+    idx = uint16_t(pos);
+    frac = pos - idx;
+}
+
+/*
+  trilinear interpolation within the grid of one time
+ */
+Vector3f WindField::sample_grid(uint16_t t, const uint16_t idx[3], const float frac[3]) const
+{
+    // the upper index stays on the lower one for an axis with a single point
+    const uint16_t x1 = MIN(idx[0] + 1, nx - 1);
+    const uint16_t y1 = MIN(idx[1] + 1, ny - 1);
+    const uint16_t z1 = MIN(idx[2] + 1, nz - 1);
+
+    const Vector3f c00 = at(t, idx[0], idx[1], idx[2]) * (1 - frac[0]) + at(t, x1, idx[1], idx[2]) * frac[0];
+    const Vector3f c10 = at(t, idx[0], y1, idx[2]) * (1 - frac[0]) + at(t, x1, y1, idx[2]) * frac[0];
+    const Vector3f c01 = at(t, idx[0], idx[1], z1) * (1 - frac[0]) + at(t, x1, idx[1], z1) * frac[0];
+    const Vector3f c11 = at(t, idx[0], y1, z1) * (1 - frac[0]) + at(t, x1, y1, z1) * frac[0];
+
+    const Vector3f c0 = c00 * (1 - frac[1]) + c10 * frac[1];
+    const Vector3f c1 = c01 * (1 - frac[1]) + c11 * frac[1];
+
+    return c0 * (1 - frac[2]) + c1 * frac[2];
+}
+
+/*
+  sample the wind at a NED position relative to the origin and a time
+ */
+Vector3f WindField::sample(const Vector3f &position, float time_s) const
+{
+    if (data == nullptr) {
+        return Vector3f();
+    }
+
+    const Vector3f pos = position - origin;
+    uint16_t idx[3];
+    float frac[3];
+    grid_index(pos.x / spacing.x, nx, idx[0], frac[0]);
+    grid_index(pos.y / spacing.y, ny, idx[1], frac[1]);
+    grid_index(pos.z / spacing.z, nz, idx[2], frac[2]);
+
+    if (nt < 2) {
+        return sample_grid(0, idx, frac);
+    }
+
+    float t = time_s / time_step;
+    if (loop) {
+        // the last grid blends back into the first
+        t = fmodf(MAX(t, 0), nt);
+    }
+    uint16_t t0;
+    float tfrac;
+    grid_index(t, loop ? nt + 1 : nt, t0, tfrac);
+    const uint16_t t1 = (t0 + 1) % nt;
+
+    return sample_grid(t0, idx, frac) * (1 - tfrac) + sample_grid(t1, idx, frac) * tfrac;
+}
+
+}  // namespace SITL
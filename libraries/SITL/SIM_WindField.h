@@ -0,0 +1,70 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  gridded, time varying wind field loaded from a file
+*/
+
+#pragma once
+
+#include <AP_Math/AP_Math.h>
+
+namespace SITL {
+
+/*
+  The field is a regular grid of NED wind vectors, positioned relative
+  to the simulation origin, with one grid for each of a sequence of
+  equally spaced times. It is sampled by trilinear interpolation in
+  space and linear interpolation in time. Outside the grid the nearest
+  edge value is used, and after the last time the last grid is used,
+  unless the field is set to loop.
+
+  The file is text. Blank lines and lines starting with # are ignored.
+  The header gives the grid size and spacing, the position of the first
+  grid point and the time step:
+
+    grid NX NY NZ DX DY DZ
+    origin N E D
+    time NT DT [loop]
+
+  followed by NT*NZ*NY*NX lines of "VN VE VD" in m/s, with X (north)
+  varying fastest and time slowest. The time line may be left out for a
+  steady field.
+*/
+class WindField {
+public:
+    // load a wind field, returning false on error
+    bool load(const char *filename);
+
+    // sample the wind at a NED position relative to the origin (m) and time (s)
+    Vector3f sample(const Vector3f &position, float time_s) const;
+
+private:
+    // wind at one grid point of one time
+    const Vector3f &at(uint16_t t, uint16_t x, uint16_t y, uint16_t z) const {
+        return data[((uint32_t(t) * nz + z) * ny + y) * nx + x];
+    }
+
+    // trilinear interpolation within the grid of one time
+    Vector3f sample_grid(uint16_t t, const uint16_t idx[3], const float frac[3]) const;
+
+    uint16_t nx, ny, nz, nt;
+    Vector3f spacing;
+    Vector3f origin;
+    float time_step;
+    bool loop;
+    Vector3f *data = nullptr;
+};
+
+}  // namespace SITL
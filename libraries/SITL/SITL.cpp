@@ -186,10 +186,41 @@ const AP_Param::GroupInfo SITL::var_info2[] = {
     AP_GROUPINFO("OPOS_ALT",    53, SITL,  opos.alt, 584.0f),
     AP_GROUPINFO("OPOS_HDG",    54, SITL,  opos.hdg, 353.0f),
 
+    // set to 1 to fork a paused copy of the simulation which can be branched from later, needs --lockstep
+    AP_GROUPINFO("CHECKPOINT",  55, SITL,  checkpoint, 0),
+
+    // multicopter motor model. The defaults give the original instant, linear motors
+    AP_GROUPINFO("MOT_TCONST",  56, SITL,  motor.tconst, 0),
+    AP_GROUPINFO("MOT_EXPO",    57, SITL,  motor.expo, 0),
+    AP_GROUPINFO("MOT_RPM_MAX", 58, SITL,  motor.rpm_max, 0),
+    AP_GROUPINFO("MOT_VIBE",    59, SITL,  motor.vibe, 0),
+    AP_GROUPINFO("MOT_RIPPLE",  60, SITL,  motor.ripple, 0),
+    AP_GROUPINFO("MOT_PROP_DIA",61, SITL,  motor.prop_dia, 0),
+
+    // turbulence model used with SIM_WIND_TURB, see TurbulenceType
+    AP_GROUPINFO("WIND_TURB_T", 62, SITL,  wind_turb_type, SITL::TURB_TYPE_RANDOM),
+
+    AP_SUBGROUPEXTENSION("",      63, SITL,  var_info3),
     AP_GROUPEND
 
 };
 
+// third table of user settable parameters for SITL.
+const AP_Param::GroupInfo SITL::var_info3[] = {
+    // set to 1 to read the first IMU through the Invensense driver from
+    // a simulated MPU6000 on the simulated SPI bus
+    AP_GROUPINFO("IMU_SPI",      1, SITL,  imu_spi, 0),
+
+    // extra time in microseconds taken by every simulated bus transfer
+    AP_GROUPINFO("BUS_DELAY",    2, SITL,  bus_delay, 0),
+
+    // set to 1 to read the first baro through the MS5611 driver from a
+    // simulated MS5611 sharing the simulated SPI bus with the MPU6000
+    AP_GROUPINFO("BARO_SPI",     3, SITL,  baro_spi, 0),
+
+    AP_GROUPEND
+};
+
 
 /* report SITL state via MAVLink */
 void SITL::simstate_send(mavlink_channel_t chan)
@@ -64,6 +64,7 @@ public:
         mag_ofs.set(Vector3f(5, 13, -18));
         AP_Param::setup_object_defaults(this, var_info);
         AP_Param::setup_object_defaults(this, var_info2);
+        AP_Param::setup_object_defaults(this, var_info3);
         if (_singleton != nullptr) {
             AP_HAL::panic("Too many SITL instances");
         }
@@ -109,6 +110,7 @@ public:
     
     static const struct AP_Param::GroupInfo var_info[];
     static const struct AP_Param::GroupInfo var_info2[];
+    static const struct AP_Param::GroupInfo var_info3[];
 
     // noise levels for simulated sensors
     AP_Float baro_noise;  // in metres
@@ -196,6 +198,12 @@ public:
     AP_Float wind_type_alt;
     AP_Float wind_type_coef;
 
+    enum TurbulenceType {
+        TURB_TYPE_RANDOM = 0,
+        TURB_TYPE_DRYDEN = 1,
+    };
+    AP_Int8  wind_turb_type; // enum TurbulenceType
+
     AP_Int16  baro_delay; // barometer data delay in ms
     AP_Int16  mag_delay; // magnetometer data delay in ms
     AP_Int16  wind_delay; // windspeed data delay in ms
@@ -276,6 +284,24 @@ public:
         AP_Float hdg; // 0 to 360
     } opos;
 
+    // take a checkpoint of the whole simulation when set
+    AP_Int8 checkpoint;
+
+    // multicopter motor model
+    struct {
+        AP_Float tconst;    // rotor spin up time constant, seconds, 0 for instant
+        AP_Float expo;      // thrust curve expo, 0 for thrust proportional to demand
+        AP_Float rpm_max;   // rotor speed at full demand, 0 to disable harmonic vibration
+        AP_Float vibe;      // lateral vibration from rotor imbalance at full speed, m/s/s
+        AP_Float ripple;    // blade passing thrust ripple as a fraction of thrust
+        AP_Float prop_dia;  // propeller diameter for ground effect, metres, 0 to disable
+    } motor;
+
+    // simulated bus devices
+    AP_Int8 imu_spi;        // use the MPU6000 on the simulated SPI bus as the first IMU
+    AP_Int16 bus_delay;     // extra time taken by every bus transfer, microseconds
+    AP_Int8 baro_spi;       // use the MS5611 on the simulated SPI bus as the first baro
+
     uint16_t irlock_port;
 
     void simstate_send(mavlink_channel_t chan);
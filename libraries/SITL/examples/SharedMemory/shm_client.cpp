@@ -0,0 +1,242 @@
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  reference physics engine for the shm simulator backend: a rigid body
+  quad X, stepped in lockstep with ArduPilot. It has no dependencies
+  beyond the protocol header, build it with:
+
+    g++ -O2 -o shm_client shm_client.cpp -lrt
+
+  then start ArduCopter with --model shm and run ./shm_client
+*/
+
+#include "../../SIM_SharedMemory_Protocol.h"
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace SITL::SHM_FDM;
+
+static const double GRAVITY = 9.80665;
+static const double RATE_HZ = 1000;
+
+// vehicle
+static const double MASS = 1.5;                     // kg
+static const double HOVER_THROTTLE = 0.5;
+static const double ARM_LENGTH = 0.18;              // m, along each axis
+static const double YAW_TORQUE_PER_THRUST = 0.02;   // m
+static const double INERTIA[3] = { 0.015, 0.015, 0.03 };
+static const double DRAG = 0.2;                     // N per m/s
+static const double ANGULAR_DRAG = 0.01;            // Nm per rad/s
+
+/*
+  ArduCopter quad X motors, FRD: position and yaw torque direction
+ */
+static const struct {
+    double x, y;
+    double yaw;
+} motors[4] = {
+    {  1,  1,  1 },     // front right, CCW
+    { -1, -1,  1 },     // back left, CCW
+    {  1, -1, -1 },     // front left, CW
+    { -1,  1, -1 },     // back right, CW
+};
+
+struct State {
+    double q[4] = { 1, 0, 0, 0 };   // body to NED
+    double gyro[3] {};
+    double velocity[3] {};
+    double position[3] {};
+    double accel_body[3] {};
+    double time_s = 0;
+};
+
+// rotate v by q, body to earth
+static void rotate(const double q[4], const double v[3], double out[3])
+{
+    const double w = q[0], x = q[1], y = q[2], z = q[3];
+    out[0] = (1-2*(y*y+z*z))*v[0] + 2*(x*y-w*z)*v[1] + 2*(x*z+w*y)*v[2];
+    out[1] = 2*(x*y+w*z)*v[0] + (1-2*(x*x+z*z))*v[1] + 2*(y*z-w*x)*v[2];
+    out[2] = 2*(x*z-w*y)*v[0] + 2*(y*z+w*x)*v[1] + (1-2*(x*x+y*y))*v[2];
+}
+
+// rotate v by the inverse of q, earth to body
+static void rotate_inverse(const double q[4], const double v[3], double out[3])
+{
+    const double qi[4] = { q[0], -q[1], -q[2], -q[3] };
+    rotate(qi, v, out);
+}
+
+static void step(State &s, const ServoFrame &servos, double dt)
+{
+    // motor thrusts and the resulting body force and torques
+    const double max_thrust = MASS * GRAVITY / (4 * HOVER_THROTTLE);
+    double thrust = 0;
+    double torque[3] {};
+    for (uint8_t i=0; i<4; i++) {
+        double throttle = (servos.pwm[i] - 1000) / 1000.0;
+        throttle = throttle < 0 ? 0 : (throttle > 1 ? 1 : throttle);
+        const double t = throttle * max_thrust;
+        thrust += t;
+        torque[0] -= motors[i].y * ARM_LENGTH * t;
+        torque[1] += motors[i].x * ARM_LENGTH * t;
+        torque[2] += motors[i].yaw * YAW_TORQUE_PER_THRUST * t;
+    }
+
+    // rotational dynamics
+    double *w = s.gyro;
+    const double Iw[3] = { INERTIA[0]*w[0], INERTIA[1]*w[1], INERTIA[2]*w[2] };
+    const double gyroscopic[3] = { w[1]*Iw[2] - w[2]*Iw[1],
+                                   w[2]*Iw[0] - w[0]*Iw[2],
+                                   w[0]*Iw[1] - w[1]*Iw[0] };
+    for (uint8_t i=0; i<3; i++) {
+        w[i] += (torque[i] - gyroscopic[i] - ANGULAR_DRAG * w[i]) / INERTIA[i] * dt;
+    }
+    double *q = s.q;
+    const double dq[4] = { -q[1]*w[0] - q[2]*w[1] - q[3]*w[2],
+                            q[0]*w[0] + q[2]*w[2] - q[3]*w[1],
+                            q[0]*w[1] - q[1]*w[2] + q[3]*w[0],
+                            q[0]*w[2] + q[1]*w[1] - q[2]*w[0] };
+    double norm = 0;
+    for (uint8_t i=0; i<4; i++) {
+        q[i] += 0.5 * dq[i] * dt;
+        norm += q[i]*q[i];
+    }
+    norm = sqrt(norm);
+    for (uint8_t i=0; i<4; i++) {
+        q[i] /= norm;
+    }
+
+    // translational dynamics, with specific force measured in body frame
+    const double force_body[3] = { 0, 0, -thrust };
+    double force_ef[3];
+    rotate(q, force_body, force_ef);
+    double accel_ef[3];
+    for (uint8_t i=0; i<3; i++) {
+        accel_ef[i] = (force_ef[i] - DRAG * s.velocity[i]) / MASS;
+    }
+    accel_ef[2] += GRAVITY;
+
+    for (uint8_t i=0; i<3; i++) {
+        s.velocity[i] += accel_ef[i] * dt;
+        s.position[i] += s.velocity[i] * dt;
+    }
+
+    // sitting on the ground
+    if (s.position[2] >= 0 && s.velocity[2] >= 0) {
+        s.position[2] = 0;
+        for (uint8_t i=0; i<3; i++) {
+            s.velocity[i] = 0;
+            accel_ef[i] = 0;
+        }
+        w[0] = w[1] = 0;
+        if (thrust < MASS * GRAVITY * 0.5) {
+            w[2] = 0;
+        }
+    }
+
+    const double specific_force_ef[3] = { accel_ef[0], accel_ef[1], accel_ef[2] - GRAVITY };
+    rotate_inverse(q, specific_force_ef, s.accel_body);
+
+    s.time_s += dt;
+}
+
+static Segment *attach(const char *name)
+{
+    bool reported = false;
+    while (true) {
+        const int fd = shm_open(name, O_RDWR, 0);
+        if (fd != -1) {
+            struct stat st;
+            if (fstat(fd, &st) == 0 && size_t(st.st_size) >= sizeof(Segment)) {
+                void *p = mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                close(fd);
+                if (p == MAP_FAILED) {
+                    perror("mmap");
+                    exit(1);
+                }
+                Segment *segment = (Segment *)p;
+                if (__atomic_load_n(&segment->magic, __ATOMIC_ACQUIRE) == MAGIC &&
+                    segment->version == VERSION) {
+                    return segment;
+                }
+                munmap(p, sizeof(Segment));
+            } else {
+                close(fd);
+            }
+        }
+        if (!reported) {
+            printf("Waiting for ArduPilot on %s\n", name);
+            reported = true;
+        }
+        usleep(100000);
+    }
+}
+
+int main(int argc, const char *argv[])
+{
+    const char *name = argc > 1 ? argv[1] : "/ardupilot_fdm0";
+    Segment *segment = attach(name);
+    printf("Attached to %s\n", name);
+
+    // skip servo frames left from before we attached, but reply to the newest
+    Ring<ServoFrame> &servos = segment->servos;
+    Ring<StateFrame> &state = segment->state;
+    const uint32_t head = __atomic_load_n(&servos.head, __ATOMIC_ACQUIRE);
+    if (head != servos.tail) {
+        __atomic_store_n(&servos.tail, head-1, __ATOMIC_RELEASE);
+    }
+
+    State s;
+    const double dt = 1.0 / RATE_HZ;
+    uint64_t frames = 0;
+    while (true) {
+        // wait for the next servo frame, using the newest if several are queued
+        uint32_t servo_head;
+        while ((servo_head = __atomic_load_n(&servos.head, __ATOMIC_ACQUIRE)) == servos.tail) {
+            usleep(1);
+        }
+        const ServoFrame input = servos.frames[(servo_head-1) % RING_SIZE];
+        __atomic_store_n(&servos.tail, servo_head, __ATOMIC_RELEASE);
+
+        step(s, input, dt);
+
+        // reply, waiting if ArduPilot has fallen behind
+        uint32_t state_head = state.head;
+        while (state_head - __atomic_load_n(&state.tail, __ATOMIC_ACQUIRE) >= RING_SIZE) {
+            usleep(1);
+        }
+        StateFrame &out = state.frames[state_head % RING_SIZE];
+        out.frame = input.frame;
+        out.timestamp = s.time_s;
+        memcpy(out.gyro, s.gyro, sizeof(out.gyro));
+        memcpy(out.accel, s.accel_body, sizeof(out.accel));
+        memcpy(out.quaternion, s.q, sizeof(out.quaternion));
+        memcpy(out.velocity, s.velocity, sizeof(out.velocity));
+        memcpy(out.position, s.position, sizeof(out.position));
+        __atomic_store_n(&state.head, state_head+1, __ATOMIC_RELEASE);
+
+        if (++frames % 10000 == 0) {
+            printf("t=%.1f alt=%.2f\n", s.time_s, -s.position[2]);
+        }
+    }
+    return 0;
+}